@@ -13,7 +13,7 @@
 # You should have received a copy of the GNU General Public License
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
-#include $(TMK_PATH)/protocol.mk
+include $(TMK_PATH)/protocol.mk
 
 TEST_PATH=tests/$(TEST)
 
@@ -25,9 +25,11 @@ $(TEST)_SRC= \
 	tests/test_common/matrix.c \
 	tests/test_common/test_driver.cpp \
 	tests/test_common/keyboard_report_util.cpp \
+	tests/test_common/report_recorder.cpp \
 	tests/test_common/test_fixture.cpp
 $(TEST)_SRC += $(patsubst $(ROOTDIR)/%,%,$(wildcard $(TEST_PATH)/*.cpp))
 
-$(TEST)_DEFS=$(TMK_COMMON_DEFS) $(OPT_DEFS)
+$(TEST)_DEFS=$(TMK_COMMON_DEFS) $(OPT_DEFS) -DPROTOCOL_TEST
 $(TEST)_CONFIG=$(TEST_PATH)/config.h
-VPATH+=$(TOP_DIR)/tests/test_common
\ No newline at end of file
+VPATH+=$(TOP_DIR)/tests/test_common
+VPATH+=$(TOP_DIR)/$(TEST_PATH)
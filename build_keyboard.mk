@@ -366,3 +366,9 @@ objs-size: build
 
 include show_options.mk
 include $(TMK_PATH)/rules.mk
+
+ifeq ($(strip $(KEYMAP_COMPRESSION_ENABLE)), yes)
+# Generate the compressed keymap from the compiled keymap.c
+$(KEYMAP_OUTPUT)/src/keymap_compressed_data.c: $(KEYMAP_OUTPUT)/$(patsubst %.c,%.o,$(KEYMAP_C))
+	bin/qmk compress-keymap --quiet --output $@ $<
+endif
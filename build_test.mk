@@ -50,6 +50,9 @@ endif
 include common_features.mk
 include $(TMK_PATH)/common.mk
 include $(QUANTUM_PATH)/serial_link/tests/rules.mk
+include $(QUANTUM_PATH)/tests/rules.mk
+include $(TMK_PATH)/common/test/rules.mk
+include $(DRIVER_PATH)/eeprom/tests/rules.mk
 ifneq ($(filter $(FULL_TESTS),$(TEST)),)
 include build_full_test.mk
 endif
@@ -350,6 +350,18 @@ ifeq ($(strip $(DYNAMIC_KEYMAP_ENABLE)), yes)
     SRC += $(QUANTUM_DIR)/dynamic_keymap.c
 endif
 
+ifeq ($(strip $(KEYMAP_COMPRESSION_ENABLE)), yes)
+    ifeq ($(strip $(DYNAMIC_KEYMAP_ENABLE)), yes)
+        $(error KEYMAP_COMPRESSION_ENABLE can't be used with DYNAMIC_KEYMAP_ENABLE, which reads the dense keymap)
+    endif
+    ifneq ($(filter yes,$(strip $(LTO_ENABLE)) $(strip $(LINK_TIME_OPTIMIZATION_ENABLE))),)
+        $(error KEYMAP_COMPRESSION_ENABLE can't be used with LTO_ENABLE, the keymap is read from the compiled keymap.c)
+    endif
+    OPT_DEFS += -DKEYMAP_COMPRESSION_ENABLE
+    SRC += $(QUANTUM_DIR)/keymap_compressed.c
+    SRC += $(KEYMAP_OUTPUT)/src/keymap_compressed_data.c
+endif
+
 ifeq ($(strip $(DIP_SWITCH_ENABLE)), yes)
     OPT_DEFS += -DDIP_SWITCH_ENABLE
     SRC += $(QUANTUM_DIR)/dip_switch.c
@@ -392,6 +404,11 @@ ifeq ($(strip $(SPLIT_KEYBOARD)), yes)
     # Include files used by all split keyboards
     QUANTUM_SRC += $(QUANTUM_DIR)/split_common/split_util.c
 
+    ifeq ($(strip $(SPLIT_STATS_ENABLE)), yes)
+        OPT_DEFS += -DSPLIT_STATS_ENABLE
+        QUANTUM_SRC += $(QUANTUM_DIR)/split_common/split_stats.c
+    endif
+
     # Determine which (if any) transport files are required
     ifneq ($(strip $(SPLIT_TRANSPORT)), custom)
         QUANTUM_SRC += $(QUANTUM_DIR)/split_common/transport.c
@@ -43,7 +43,8 @@ void eeprom_write_word(uint16_t *addr, uint16_t value) { eeprom_write_block(&val
 
 void eeprom_write_dword(uint32_t *addr, uint32_t value) { eeprom_write_block(&value, addr, 4); }
 
-void eeprom_update_block(const void *buf, void *addr, size_t len) {
+// Drivers can provide a more efficient implementation
+__attribute__((weak)) void eeprom_update_block(const void *buf, void *addr, size_t len) {
     uint8_t read_buf[len];
     eeprom_read_block(read_buf, addr, len);
     if (memcmp(buf, read_buf, len) != 0) {
@@ -15,6 +15,7 @@
  */
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 
 /*
@@ -31,6 +32,7 @@
 */
 
 #include "wait.h"
+#include "timer.h"
 #include "i2c_master.h"
 #include "eeprom.h"
 #include "eeprom_i2c.h"
@@ -41,6 +43,16 @@
 #    include "print.h"
 #endif  // DEBUG_EEPROM_OUTPUT
 
+#if EXTERNAL_EEPROM_READ_AHEAD_SIZE > 0
+static uint8_t  read_ahead[EXTERNAL_EEPROM_READ_AHEAD_SIZE];
+static intptr_t read_ahead_addr = -1;
+#endif
+
+// The EEPROM doesn't respond while it is committing a page, so instead of
+// stalling after every write, only wait when it is accessed again too early.
+static bool     write_pending = false;
+static uint16_t write_started;
+
 static inline void init_i2c_if_required(void) {
     static int done = 0;
     if (!done) {
@@ -49,6 +61,17 @@ static inline void init_i2c_if_required(void) {
     }
 }
 
+static inline void wait_for_write_cycle(void) {
+    if (write_pending) {
+        // One extra millisecond, as the timer may have ticked just after the write started
+        uint16_t elapsed = timer_elapsed(write_started);
+        if (elapsed <= EXTERNAL_EEPROM_WRITE_TIME) {
+            wait_ms(EXTERNAL_EEPROM_WRITE_TIME + 1 - elapsed);
+        }
+        write_pending = false;
+    }
+}
+
 static inline void fill_target_address(uint8_t *buffer, const void *addr) {
     intptr_t p = (intptr_t)addr;
     for (int i = 0; i < EXTERNAL_EEPROM_ADDRESS_SIZE; ++i) {
@@ -57,23 +80,49 @@ static inline void fill_target_address(uint8_t *buffer, const void *addr) {
     }
 }
 
+static bool read_from_device(void *buf, intptr_t addr, size_t len) {
+    uint8_t complete_packet[EXTERNAL_EEPROM_ADDRESS_SIZE];
+    fill_target_address(complete_packet, (const void *)addr);
+
+    init_i2c_if_required();
+    wait_for_write_cycle();
+    if (i2c_transmit(EXTERNAL_EEPROM_I2C_ADDRESS(addr), complete_packet, EXTERNAL_EEPROM_ADDRESS_SIZE, 100) != I2C_STATUS_SUCCESS) {
+        return false;
+    }
+    return i2c_receive(EXTERNAL_EEPROM_I2C_ADDRESS(addr), buf, len, 100) == I2C_STATUS_SUCCESS;
+}
+
 void eeprom_driver_init(void) {}
 
 void eeprom_driver_erase(void) {
     uint8_t buf[EXTERNAL_EEPROM_PAGE_SIZE];
     memset(buf, 0x00, EXTERNAL_EEPROM_PAGE_SIZE);
     for (intptr_t addr = 0; addr < EXTERNAL_EEPROM_BYTE_COUNT; addr += EXTERNAL_EEPROM_PAGE_SIZE) {
-        eeprom_write_block(buf, (void *)addr, EXTERNAL_EEPROM_PAGE_SIZE);
+        eeprom_update_block(buf, (void *)addr, EXTERNAL_EEPROM_PAGE_SIZE);
     }
 }
 
 void eeprom_read_block(void *buf, const void *addr, size_t len) {
-    uint8_t complete_packet[EXTERNAL_EEPROM_ADDRESS_SIZE];
-    fill_target_address(complete_packet, addr);
+    intptr_t target_addr = (intptr_t)addr;
+    bool     read        = false;
 
-    init_i2c_if_required();
-    i2c_transmit(EXTERNAL_EEPROM_I2C_ADDRESS((intptr_t)addr), complete_packet, EXTERNAL_EEPROM_ADDRESS_SIZE, 100);
-    i2c_receive(EXTERNAL_EEPROM_I2C_ADDRESS((intptr_t)addr), buf, len, 100);
+#if EXTERNAL_EEPROM_READ_AHEAD_SIZE > 0
+    intptr_t line = target_addr - target_addr % EXTERNAL_EEPROM_READ_AHEAD_SIZE;
+    if (len > 0 && target_addr + len <= line + EXTERNAL_EEPROM_READ_AHEAD_SIZE) {
+        if (line != read_ahead_addr) {
+            read_ahead_addr = read_from_device(read_ahead, line, EXTERNAL_EEPROM_READ_AHEAD_SIZE) ? line : -1;
+        }
+        // After a failed read, the buffer still holds the previous line
+        if (line == read_ahead_addr) {
+            memcpy(buf, &read_ahead[target_addr - line], len);
+            read = true;
+        }
+    }
+#endif
+    if (!read && !read_from_device(buf, target_addr, len)) {
+        // Rather than returning what was in the buffer
+        memset(buf, 0x00, len);
+    }
 
 #ifdef DEBUG_EEPROM_OUTPUT
     dprintf("[EEPROM R] 0x%04X: ", ((int)addr));
@@ -110,11 +159,54 @@ void eeprom_write_block(const void *buf, void *addr, size_t len) {
         dprintf("\n");
 #endif  // DEBUG_EEPROM_OUTPUT
 
-        i2c_transmit(EXTERNAL_EEPROM_I2C_ADDRESS((intptr_t)addr), complete_packet, EXTERNAL_EEPROM_ADDRESS_SIZE + write_length, 100);
-        wait_ms(EXTERNAL_EEPROM_WRITE_TIME);
+        wait_for_write_cycle();
+        i2c_status_t status = i2c_transmit(EXTERNAL_EEPROM_I2C_ADDRESS(target_addr), complete_packet, EXTERNAL_EEPROM_ADDRESS_SIZE + write_length, 100);
+        write_pending       = true;
+        write_started       = timer_read();
+
+#if EXTERNAL_EEPROM_READ_AHEAD_SIZE > 0
+        if (status != I2C_STATUS_SUCCESS) {
+            // Whether any of it was written is unknown, so the line is read again
+            if (target_addr < read_ahead_addr + EXTERNAL_EEPROM_READ_AHEAD_SIZE && target_addr + write_length > read_ahead_addr) {
+                read_ahead_addr = -1;
+            }
+        } else {
+            // Keep the read-ahead cache coherent with what was just written
+            for (uint8_t i = 0; i < write_length; i++) {
+                if (target_addr + i >= read_ahead_addr && target_addr + i < read_ahead_addr + EXTERNAL_EEPROM_READ_AHEAD_SIZE) {
+                    read_ahead[target_addr + i - read_ahead_addr] = read_buf[i];
+                }
+            }
+        }
+#else
+        (void)status;
+#endif
 
         read_buf += write_length;
         target_addr += write_length;
         len -= write_length;
     }
 }
+
+// Compares a page at a time, and only writes the pages that changed
+void eeprom_update_block(const void *buf, void *addr, size_t len) {
+    uint8_t        current[EXTERNAL_EEPROM_PAGE_SIZE];
+    const uint8_t *src         = (const uint8_t *)buf;
+    intptr_t       target_addr = (intptr_t)addr;
+
+    while (len > 0) {
+        size_t length = EXTERNAL_EEPROM_PAGE_SIZE - target_addr % EXTERNAL_EEPROM_PAGE_SIZE;
+        if (length > len) {
+            length = len;
+        }
+
+        eeprom_read_block(current, (const void *)target_addr, length);
+        if (memcmp(current, src, length) != 0) {
+            eeprom_write_block(src, (void *)target_addr, length);
+        }
+
+        src += length;
+        target_addr += length;
+        len -= length;
+    }
+}
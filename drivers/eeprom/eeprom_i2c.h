@@ -113,3 +113,13 @@
 #ifndef EXTERNAL_EEPROM_WRITE_TIME
 #    define EXTERNAL_EEPROM_WRITE_TIME 5
 #endif
+
+/*
+    The number of bytes fetched at once when reading small amounts of data, and
+    kept in RAM for the following reads. Lookups of neighbouring keycodes or
+    config bytes are then served without an I2C transaction. Set to 0 to
+    disable the read-ahead cache.
+*/
+#ifndef EXTERNAL_EEPROM_READ_AHEAD_SIZE
+#    define EXTERNAL_EEPROM_READ_AHEAD_SIZE 32
+#endif
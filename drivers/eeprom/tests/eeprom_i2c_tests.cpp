@@ -0,0 +1,155 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "eeprom.h"
+#include "eeprom_i2c.h"
+#include "i2c_eeprom_mock.h"
+#include "timer.h"
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+#define ADDRESS(a) ((uint8_t *)(uintptr_t)(a))
+
+class EepromI2C : public testing::Test {
+   public:
+    EepromI2C() {
+        i2c_eeprom_mock_reset();
+        // Let any write of the previous test finish, and drop its read-ahead data
+        advance_time(100);
+        uint8_t dummy;
+        eeprom_read_block(&dummy, ADDRESS(EXTERNAL_EEPROM_BYTE_COUNT - 1), 1);
+        i2c_eeprom_mock_reset_stats();
+    }
+
+    static void fill(uint8_t *data, size_t len, uint8_t seed) {
+        for (size_t i = 0; i < len; i++) {
+            data[i] = seed + i * 7;
+        }
+    }
+};
+
+TEST_F(EepromI2C, splits_writes_on_page_boundaries) {
+    uint8_t data[100];
+    fill(data, sizeof(data), 1);
+    eeprom_write_block(data, ADDRESS(20), sizeof(data));
+
+    i2c_eeprom_mock_stats_t stats = i2c_eeprom_mock_get_stats();
+    // 20-31, 32-63, 64-95 and 96-119
+    EXPECT_EQ(stats.page_writes, 4);
+    EXPECT_EQ(stats.page_wraps, 0);
+    EXPECT_EQ(stats.nacks, 0);
+    EXPECT_EQ(memcmp(i2c_eeprom_mock_memory() + 20, data, sizeof(data)), 0);
+}
+
+TEST_F(EepromI2C, skips_unchanged_pages_when_updating) {
+    uint8_t data[4 * EXTERNAL_EEPROM_PAGE_SIZE];
+    fill(data, sizeof(data), 3);
+    eeprom_update_block(data, ADDRESS(0), sizeof(data));
+    EXPECT_EQ(i2c_eeprom_mock_get_stats().page_writes, 4);
+
+    i2c_eeprom_mock_reset_stats();
+    eeprom_update_block(data, ADDRESS(0), sizeof(data));
+    EXPECT_EQ(i2c_eeprom_mock_get_stats().page_writes, 0);
+
+    data[2 * EXTERNAL_EEPROM_PAGE_SIZE + 5]++;
+    eeprom_update_block(data, ADDRESS(0), sizeof(data));
+    EXPECT_EQ(i2c_eeprom_mock_get_stats().page_writes, 1);
+    EXPECT_EQ(memcmp(i2c_eeprom_mock_memory(), data, sizeof(data)), 0);
+}
+
+TEST_F(EepromI2C, serves_neighbouring_reads_from_the_read_ahead_cache) {
+    fill(i2c_eeprom_mock_memory() + 64, EXTERNAL_EEPROM_READ_AHEAD_SIZE, 5);
+    for (uint8_t i = 0; i < EXTERNAL_EEPROM_READ_AHEAD_SIZE; i += 2) {
+        EXPECT_EQ(eeprom_read_word((const uint16_t *)ADDRESS(64 + i)), i2c_eeprom_mock_memory()[64 + i] | (i2c_eeprom_mock_memory()[65 + i] << 8));
+    }
+    // Setting the address and reading the data
+    EXPECT_EQ(i2c_eeprom_mock_get_stats().transactions, 2);
+}
+
+TEST_F(EepromI2C, keeps_the_read_ahead_cache_coherent) {
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(10)), 0xFF);
+    eeprom_write_byte(ADDRESS(10), 0x42);
+    eeprom_update_byte(ADDRESS(11), 0x43);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(10)), 0x42);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(11)), 0x43);
+    EXPECT_EQ(i2c_eeprom_mock_memory()[11], 0x43);
+}
+
+TEST_F(EepromI2C, does_not_return_the_previous_line_when_a_read_fails) {
+    memset(i2c_eeprom_mock_memory(), 0x11, EXTERNAL_EEPROM_READ_AHEAD_SIZE);
+    memset(i2c_eeprom_mock_memory() + EXTERNAL_EEPROM_READ_AHEAD_SIZE, 0x22, EXTERNAL_EEPROM_READ_AHEAD_SIZE);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(0)), 0x11);
+
+    i2c_eeprom_mock_set_connected(false);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(EXTERNAL_EEPROM_READ_AHEAD_SIZE)), 0x00);
+
+    i2c_eeprom_mock_set_connected(true);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(EXTERNAL_EEPROM_READ_AHEAD_SIZE)), 0x22);
+}
+
+TEST_F(EepromI2C, drops_the_read_ahead_cache_when_a_write_fails) {
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(10)), 0xFF);
+    i2c_eeprom_mock_set_connected(false);
+    eeprom_write_byte(ADDRESS(10), 0x42);
+    i2c_eeprom_mock_set_connected(true);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(10)), 0xFF);
+    EXPECT_EQ(i2c_eeprom_mock_memory()[10], 0xFF);
+}
+
+TEST_F(EepromI2C, only_waits_for_the_write_cycle_when_needed) {
+    eeprom_write_byte(ADDRESS(0), 1);
+    uint32_t start = timer_read32();
+    eeprom_write_byte(ADDRESS(1), 2);
+    EXPECT_GE(timer_read32() - start, EXTERNAL_EEPROM_WRITE_TIME);
+    EXPECT_EQ(i2c_eeprom_mock_get_stats().nacks, 0);
+
+    advance_time(EXTERNAL_EEPROM_WRITE_TIME + 1);
+    start = timer_read32();
+    eeprom_write_byte(ADDRESS(2), 3);
+    EXPECT_EQ(timer_read32(), start);
+}
+
+TEST_F(EepromI2C, updates_a_keymap_sized_buffer_in_page_writes) {
+    // A VIA keymap upload of 4 layers of 70 keys
+    const size_t size = 4 * 70 * 2;
+    uint8_t      data[size];
+    fill(data, size, 9);
+
+    uint32_t start = timer_read32();
+    for (size_t i = 0; i < size; i++) {
+        eeprom_update_byte(ADDRESS(100 + i), data[i]);
+    }
+    i2c_eeprom_mock_stats_t bytewise      = i2c_eeprom_mock_get_stats();
+    uint32_t                bytewise_time = timer_read32() - start;
+
+    fill(data, size, 10);
+    i2c_eeprom_mock_reset_stats();
+    start = timer_read32();
+    eeprom_update_block(data, ADDRESS(100), size);
+    i2c_eeprom_mock_stats_t block      = i2c_eeprom_mock_get_stats();
+    uint32_t                block_time = timer_read32() - start;
+
+    // Every byte that differs from the erased EEPROM takes its own write cycle
+    EXPECT_GT(bytewise.page_writes, size * 9 / 10);
+    EXPECT_EQ(block.page_writes, size / EXTERNAL_EEPROM_PAGE_SIZE + 1);
+    EXPECT_LT(block_time * 10, bytewise_time);
+    EXPECT_LT(block.bus_time_us * 2, bytewise.bus_time_us);
+    EXPECT_EQ(memcmp(i2c_eeprom_mock_memory() + 100, data, size), 0);
+}
@@ -0,0 +1,108 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <stdbool.h>
+#include "timer.h"
+#include "i2c_master.h"
+#include "eeprom_i2c.h"
+#include "i2c_eeprom_mock.h"
+
+// About 9 clocks per byte at 400kHz
+#define BYTE_TIME_US 23
+
+static uint8_t                 memory[EXTERNAL_EEPROM_BYTE_COUNT];
+static uint32_t                pointer;
+static uint32_t                busy_until;
+static bool                    busy;
+static bool                    connected;
+static i2c_eeprom_mock_stats_t stats;
+
+void i2c_eeprom_mock_reset(void) {
+    memset(memory, 0xFF, sizeof(memory));
+    pointer = 0;
+    busy      = false;
+    connected = true;
+    i2c_eeprom_mock_reset_stats();
+}
+
+i2c_eeprom_mock_stats_t i2c_eeprom_mock_get_stats(void) { return stats; }
+
+void i2c_eeprom_mock_reset_stats(void) { memset(&stats, 0, sizeof(stats)); }
+
+uint8_t* i2c_eeprom_mock_memory(void) { return memory; }
+
+void i2c_eeprom_mock_set_connected(bool value) { connected = value; }
+
+// A new transaction, returns false if the EEPROM doesn't acknowledge it
+static bool start(uint8_t address, uint16_t length) {
+    stats.transactions++;
+    stats.bus_time_us += (length + 1) * BYTE_TIME_US;
+    if (!connected) {
+        return false;
+    }
+    if (busy && timer_read32() >= busy_until) {
+        busy = false;
+    }
+    if (busy || address != EXTERNAL_EEPROM_I2C_BASE_ADDRESS) {
+        stats.nacks++;
+        return false;
+    }
+    return true;
+}
+
+void i2c_init(void) {}
+
+i2c_status_t i2c_transmit(uint8_t address, const uint8_t* data, uint16_t length, uint16_t timeout) {
+    if (!start(address, length) || length < EXTERNAL_EEPROM_ADDRESS_SIZE) {
+        return I2C_STATUS_ERROR;
+    }
+    pointer = 0;
+    for (uint8_t i = 0; i < EXTERNAL_EEPROM_ADDRESS_SIZE; i++) {
+        pointer = (pointer << 8) | data[i];
+    }
+    pointer %= EXTERNAL_EEPROM_BYTE_COUNT;
+    data += EXTERNAL_EEPROM_ADDRESS_SIZE;
+    length -= EXTERNAL_EEPROM_ADDRESS_SIZE;
+    if (length == 0) {
+        // Only setting the address for a read
+        return I2C_STATUS_SUCCESS;
+    }
+
+    // Like the real thing, the address wraps around within the page
+    uint32_t page = pointer - pointer % EXTERNAL_EEPROM_PAGE_SIZE;
+    if (pointer % EXTERNAL_EEPROM_PAGE_SIZE + length > EXTERNAL_EEPROM_PAGE_SIZE) {
+        stats.page_wraps++;
+    }
+    for (uint16_t i = 0; i < length; i++) {
+        memory[page + (pointer - page + i) % EXTERNAL_EEPROM_PAGE_SIZE] = data[i];
+    }
+    stats.page_writes++;
+    busy       = true;
+    busy_until = timer_read32() + EXTERNAL_EEPROM_WRITE_TIME;
+    return I2C_STATUS_SUCCESS;
+}
+
+i2c_status_t i2c_receive(uint8_t address, uint8_t* data, uint16_t length, uint16_t timeout) {
+    if (!start(address, length)) {
+        return I2C_STATUS_ERROR;
+    }
+    for (uint16_t i = 0; i < length; i++) {
+        data[i] = memory[pointer];
+        pointer = (pointer + 1) % EXTERNAL_EEPROM_BYTE_COUNT;
+    }
+    return I2C_STATUS_SUCCESS;
+}
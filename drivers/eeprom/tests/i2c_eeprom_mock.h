@@ -0,0 +1,38 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t page_writes;
+    // Transactions the EEPROM didn't acknowledge because it was still writing
+    uint32_t nacks;
+    // Page writes that ran past the end of a page and wrapped around
+    uint32_t page_wraps;
+    // Time spent transferring data on a 400kHz bus
+    uint32_t bus_time_us;
+} i2c_eeprom_mock_stats_t;
+
+void                    i2c_eeprom_mock_reset(void);
+i2c_eeprom_mock_stats_t i2c_eeprom_mock_get_stats(void);
+void                    i2c_eeprom_mock_reset_stats(void);
+uint8_t*                i2c_eeprom_mock_memory(void);
+// While disconnected, the EEPROM acknowledges no transaction
+void i2c_eeprom_mock_set_connected(bool connected);
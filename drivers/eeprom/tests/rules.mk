@@ -0,0 +1,7 @@
+eeprom_i2c_INC := $(DRIVER_PATH)/eeprom/tests $(DRIVER_PATH)/eeprom
+eeprom_i2c_SRC := \
+	$(DRIVER_PATH)/eeprom/tests/eeprom_i2c_tests.cpp \
+	$(DRIVER_PATH)/eeprom/tests/i2c_eeprom_mock.c \
+	$(DRIVER_PATH)/eeprom/eeprom_i2c.c \
+	$(DRIVER_PATH)/eeprom/eeprom_driver.c \
+	$(TMK_PATH)/common/test/timer.c
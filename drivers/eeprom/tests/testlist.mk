@@ -0,0 +1 @@
+TEST_LIST += eeprom_i2c
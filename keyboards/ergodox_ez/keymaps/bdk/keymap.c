@@ -102,9 +102,9 @@ struct tap_start_info {
 
 static struct tap_start_info tap_start_infos[5];
 
-// Quick check to see if a key is down.  Note that this requires NKRO enabled
+// Quick check to see if a key is down.
 static bool key_down(uint8_t code) {
-    return (keyboard_report->nkro.bits[code>>3] & 1<<(code&7)) != 0;
+    return has_key(code);
 }
 
 static bool handle_lt(uint16_t keycode, keyrecord_t *record, uint8_t layer, uint8_t index) {
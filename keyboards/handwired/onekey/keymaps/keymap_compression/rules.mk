@@ -0,0 +1 @@
+KEYMAP_COMPRESSION_ENABLE = yes
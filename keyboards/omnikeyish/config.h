@@ -59,5 +59,6 @@
 #define DYNAMIC_MACRO_COUNT 12
 #define DYNAMIC_MACRO_SIZE 48
 #define DYNAMIC_MACRO_EEPROM_STORAGE
-#define DYNAMIC_MACRO_EEPROM_MAGIC_ADDR (uint16_t*)32
-#define DYNAMIC_MACRO_EEPROM_BLOCK0_ADDR (uint8_t*)34
+// Right behind the eeconfig block, which ends at EECONFIG_SIZE (37)
+#define DYNAMIC_MACRO_EEPROM_MAGIC_ADDR (uint16_t*)37
+#define DYNAMIC_MACRO_EEPROM_BLOCK0_ADDR (uint8_t*)39
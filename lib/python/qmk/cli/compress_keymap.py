@@ -0,0 +1,41 @@
+"""Compress the keymap of a compiled keymap.c.
+"""
+from milc import cli
+
+import qmk.keymap_compression
+import qmk.path
+
+
+@cli.argument('-o', '--output', arg_only=True, type=qmk.path.normpath, help='File to write to')
+@cli.argument('-q', '--quiet', arg_only=True, action='store_true', help="Quiet mode, only output error messages")
+@cli.argument('filename', type=qmk.path.normpath, arg_only=True, help='Object file compiled from keymap.c')
+@cli.subcommand('Creates a compressed keymap from a compiled keymap.c.')
+def compress_keymap(cli):
+    """Compress the keymap of a compiled keymap.c.
+
+    This command reads `keymaps[][MATRIX_ROWS][MATRIX_COLS]` out of the object file compiled from a keymap.c, and writes it in the sparse format used by KEYMAP_COMPRESSION_ENABLE. The result is written to stdout, or to a file if -o is provided.
+    """
+    if not cli.args.filename.exists():
+        cli.log.error('Object file does not exist!')
+        cli.print_usage()
+        exit(1)
+
+    try:
+        keycodes = qmk.keymap_compression.read_keycodes(cli.args.filename.read_bytes())
+    except ValueError as e:
+        cli.log.error('Could not read the keymap: %s', e)
+        exit(1)
+
+    keymap_c = qmk.keymap_compression.generate(keycodes, cli.args.filename.name)
+
+    if cli.args.output and cli.args.output.name != '-':
+        cli.args.output.parent.mkdir(parents=True, exist_ok=True)
+        cli.args.output.write_text(keymap_c)
+
+        if not cli.args.quiet:
+            bitmap, rank, packed = qmk.keymap_compression.compress(keycodes)
+            compressed_size = len(bitmap) * 4 + len(rank) * 2 + len(packed) * 2
+            cli.log.info('Compressed %d keys from %d to %d bytes, wrote %s.', len(keycodes), len(keycodes) * 2, compressed_size, cli.args.output)
+
+    else:
+        print(keymap_c)
@@ -0,0 +1,126 @@
+"""Functions that compress a compiled keymap into the sparse format read by quantum/keymap_compressed.c.
+"""
+import struct
+
+# Keys holding this keycode are left out of the compressed keymap
+KC_TRNS = 0x0001
+
+# Number of keys covered by each bitmap word
+WORD_BITS = 32
+
+# The C file that holds the compressed keymap
+KEYMAP_COMPRESSED_C = """/* THIS FILE WAS GENERATED!
+ *
+ * This file was generated by qmk compress-keymap from %(source)s.
+ * Do not edit it directly.
+ */
+
+#include "keymap_compressed.h"
+
+const uint16_t PROGMEM keymap_compressed_key_count = %(key_count)d;
+
+const uint32_t PROGMEM keymap_compressed_bitmap[] = {%(bitmap)s};
+
+const uint16_t PROGMEM keymap_compressed_rank[] = {%(rank)s};
+
+const uint16_t PROGMEM keymap_compressed_keycodes[] = {%(keycodes)s};
+"""
+
+
+def _section_headers(elf):
+    """Yields (type, offset, size, link) for each section of an ELF object.
+    """
+    elf_class, elf_data = elf[4], elf[5]
+    if elf[:4] != b'\x7fELF' or elf_data != 1:
+        raise ValueError('Not a little endian ELF object')
+
+    if elf_class == 1:
+        shoff, = struct.unpack_from('<I', elf, 0x20)
+        shentsize, shnum = struct.unpack_from('<HH', elf, 0x2E)
+        header = '<IIIIIIIIII'
+    else:
+        shoff, = struct.unpack_from('<Q', elf, 0x28)
+        shentsize, shnum = struct.unpack_from('<HH', elf, 0x3A)
+        header = '<IIQQQQIIQQ'
+
+    for i in range(shnum):
+        fields = struct.unpack_from(header, elf, shoff + i * shentsize)
+        yield fields[1], fields[4], fields[5], fields[6]
+
+
+def read_symbol(elf, name):
+    """Returns the initial contents of a data symbol in an ELF object file.
+
+    Args:
+        elf
+            The contents of the object file.
+
+        name
+            The name of the symbol, e.g. `keymaps`.
+    """
+    sections = list(_section_headers(elf))
+    symbol_format = '<IIIBBH' if elf[4] == 1 else '<IBBHQQ'
+    symbol_size = struct.calcsize(symbol_format)
+
+    for section_type, offset, size, link in sections:
+        # SHT_SYMTAB
+        if section_type != 2:
+            continue
+
+        strtab_offset = sections[link][1]
+        for entry in range(offset, offset + size, symbol_size):
+            fields = struct.unpack_from(symbol_format, elf, entry)
+            if elf[4] == 1:
+                st_name, st_value, st_size, _, _, st_shndx = fields
+            else:
+                st_name, _, _, st_shndx, st_value, st_size = fields
+
+            end = elf.index(b'\0', strtab_offset + st_name)
+            if elf[strtab_offset + st_name:end].decode() == name and 0 < st_shndx < len(sections):
+                data_offset = sections[st_shndx][1] + st_value
+                return elf[data_offset:data_offset + st_size]
+
+    raise ValueError('Symbol %s not found, is the object built with LTO?' % name)
+
+
+def read_keycodes(elf):
+    """Returns the keycodes of `keymaps[][MATRIX_ROWS][MATRIX_COLS]` in order, from an ELF object file.
+    """
+    data = read_symbol(elf, 'keymaps')
+    return list(struct.unpack('<%dH' % (len(data) // 2), data))
+
+
+def compress(keycodes):
+    """Compresses a flat list of keycodes.
+
+    Returns a tuple of the bitmap words (bit n set if keycode n isn't KC_TRNS), the number of set bits before each word, and the keycodes of the set bits.
+    """
+    bitmap = []
+    rank = []
+    packed = []
+
+    for start in range(0, len(keycodes), WORD_BITS):
+        word = 0
+        rank.append(len(packed))
+        for bit, keycode in enumerate(keycodes[start:start + WORD_BITS]):
+            if keycode != KC_TRNS:
+                word |= 1 << bit
+                packed.append(keycode)
+        bitmap.append(word)
+
+    return bitmap, rank, packed
+
+
+def generate(keycodes, source='keymap.c'):
+    """Returns the C file holding the compressed keymap.
+    """
+    bitmap, rank, packed = compress(keycodes)
+
+    return KEYMAP_COMPRESSED_C % {
+        'source': source,
+        'key_count': len(keycodes),
+        'bitmap': ', '.join('0x%08X' % word for word in bitmap),
+        'rank': ', '.join('%d' % count for count in rank),
+        # An empty array isn't valid C
+        'keycodes': ', '.join('0x%04X' % keycode for keycode in packed) or '0',
+    }
@@ -1,4 +1,6 @@
 import subprocess
+from pathlib import Path
+
 from qmk.commands import run
 
 
@@ -16,6 +18,26 @@ def test_compile():
     assert check_subcommand('compile', '-kb', 'handwired/onekey/pytest', '-km', 'default').returncode == 0
 
 
+def test_compile_keymap_compression():
+    assert check_subcommand('compile', '-kb', 'handwired/onekey/pytest', '-km', 'keymap_compression').returncode == 0
+
+
+def test_compress_keymap():
+    # the same object as in the comment of the test keymap, but compiled for the host
+    keymap_o = '.build/test/keymap_compressed_test_keymap.o'
+    compile = ['cc', '-c', '-DMATRIX_ROWS=3', '-DMATRIX_COLS=5', '-Itmk_core/common', 'quantum/tests/keymap_compressed_test_keymap.c', '-o', keymap_o]
+    Path(keymap_o).parent.mkdir(parents=True, exist_ok=True)
+    assert run(compile).returncode == 0
+
+    result = check_subcommand('compress-keymap', keymap_o)
+    assert result.returncode == 0
+    assert result.stdout == Path('quantum/tests/keymap_compressed_test_data.c').read_text() + '\n'
+
+
+def test_compress_keymap_missing_object():
+    assert check_subcommand('compress-keymap', '.build/test/missing.o').returncode == 1
+
+
 def test_flash():
     assert check_subcommand('flash', '-b').returncode == 1
     assert check_subcommand('flash').returncode == 1
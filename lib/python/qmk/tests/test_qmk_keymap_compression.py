@@ -0,0 +1,28 @@
+import qmk.keymap_compression
+
+
+def test_compress_skips_transparent():
+    keycodes = [0x04, 0x01, 0x05, 0x01] + [0x01] * 28 + [0x00, 0x06]
+    bitmap, rank, packed = qmk.keymap_compression.compress(keycodes)
+    assert bitmap == [0b101, 0b11]
+    assert rank == [0, 2]
+    assert packed == [0x04, 0x05, 0x00, 0x06]
+
+
+def test_compress_all_transparent():
+    bitmap, rank, packed = qmk.keymap_compression.compress([0x01] * 40)
+    assert bitmap == [0, 0]
+    assert rank == [0, 0]
+    assert packed == []
+
+
+def test_generate():
+    keymap_c = qmk.keymap_compression.generate([0x04, 0x01, 0x5101], 'keymap.o')
+    assert 'keymap_compressed_key_count = 3;' in keymap_c
+    assert 'keymap_compressed_bitmap[] = {0x00000005};' in keymap_c
+    assert 'keymap_compressed_keycodes[] = {0x0004, 0x5101};' in keymap_c
+
+
+def test_generate_all_transparent():
+    keymap_c = qmk.keymap_compression.generate([0x01] * 4)
+    assert 'keymap_compressed_keycodes[] = {0};' in keymap_c
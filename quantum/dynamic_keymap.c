@@ -17,6 +17,7 @@
 #include "config.h"
 #include "keymap.h"  // to get keymaps[][][]
 #include "tmk_core/common/eeprom.h"
+#include "tmk_core/common/eeprom_cache.h"
 #include "progmem.h"  // to read default from flash
 #include "quantum.h"  // for send_string()
 #include "dynamic_keymap.h"
@@ -30,12 +31,12 @@
 #    define DYNAMIC_KEYMAP_MACRO_COUNT 16
 #endif
 
-// This is the default EEPROM max address to use for dynamic keymaps.
-// The default is the ATmega32u4 EEPROM max address.
-// Explicitly override it if the keyboard uses a microcontroller with
-// more EEPROM *and* it makes sense to increase it.
-#ifndef DYNAMIC_KEYMAP_EEPROM_MAX_ADDR
-#    define DYNAMIC_KEYMAP_EEPROM_MAX_ADDR 1023
+// The size of the EEPROM emulated in STM32 flash can be changed, see eeprom_stm32.h
+#ifdef STM32_EEPROM_ENABLE
+#    include "eeprom_stm32.h"
+#    if DYNAMIC_KEYMAP_EEPROM_MAX_ADDR >= FEE_DENSITY_BYTES
+#        error DYNAMIC_KEYMAP_EEPROM_MAX_ADDR is beyond the emulated EEPROM, lower it below FEE_DENSITY_BYTES.
+#    endif
 #endif
 
 // If DYNAMIC_KEYMAP_EEPROM_ADDR not explicitly defined in config.h,
@@ -48,49 +49,303 @@
 #    endif
 #endif
 
+#ifdef DYNAMIC_KEYMAP_TRANSACTIONS
+// The keymaps and macros are kept twice, in slots A and B, behind a byte that
+// says which slot is live. Writes go to the other slot, which is made live by
+// rewriting that byte when the transaction is committed, so that a write cut
+// short by a power loss leaves the live slot as it was.
+#    define DYNAMIC_KEYMAP_COMMIT_ADDR DYNAMIC_KEYMAP_EEPROM_ADDR
+#    define DYNAMIC_KEYMAP_SLOT_ADDR (DYNAMIC_KEYMAP_EEPROM_ADDR + 1)
+#else
+#    define DYNAMIC_KEYMAP_SLOT_ADDR DYNAMIC_KEYMAP_EEPROM_ADDR
+#endif
+
 // Dynamic macro starts after dynamic keymaps
 #ifndef DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR
-#    define DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR (DYNAMIC_KEYMAP_EEPROM_ADDR + (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2))
+#    define DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR (DYNAMIC_KEYMAP_SLOT_ADDR + (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2))
 #endif
 
+#ifndef DYNAMIC_KEYMAP_TRANSACTIONS
 // Sanity check that dynamic keymaps fit in available EEPROM
 // If there's not 100 bytes available for macros, then something is wrong.
 // The keyboard should override DYNAMIC_KEYMAP_LAYER_COUNT to reduce it,
 // or DYNAMIC_KEYMAP_EEPROM_MAX_ADDR to increase it, *only if* the microcontroller has
 // more than the default.
-#if DYNAMIC_KEYMAP_EEPROM_MAX_ADDR - DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR < 100
-#    error Dynamic keymaps are configured to use more EEPROM than is available.
-#endif
+#    if DYNAMIC_KEYMAP_EEPROM_MAX_ADDR - DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR < 100
+#        error Dynamic keymaps are configured to use more EEPROM than is available.
+#    endif
 
 // Dynamic macros are stored after the keymaps and use what is available
 // up to and including DYNAMIC_KEYMAP_EEPROM_MAX_ADDR.
-#ifndef DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE
-#    define DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE (DYNAMIC_KEYMAP_EEPROM_MAX_ADDR - DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + 1)
+#    ifndef DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE
+#        define DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE (DYNAMIC_KEYMAP_EEPROM_MAX_ADDR - DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + 1)
+#    endif
+#else
+// Dynamic macros are stored after the keymaps and use what is available
+// in half of the space up to and including DYNAMIC_KEYMAP_EEPROM_MAX_ADDR.
+#    ifndef DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE
+#        define DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE ((DYNAMIC_KEYMAP_EEPROM_MAX_ADDR + 1 - DYNAMIC_KEYMAP_SLOT_ADDR) / 2 - (DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR - DYNAMIC_KEYMAP_SLOT_ADDR))
+#    endif
+
+// Both slots have to fit, with at least 100 bytes for macros in each, see above.
+#    if DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE < 100
+#        error Dynamic keymaps are configured to use more EEPROM than is available, each slot needs room for 100 bytes of macros.
+#    endif
 #endif
 
-uint8_t dynamic_keymap_get_layer_count(void) { return DYNAMIC_KEYMAP_LAYER_COUNT; }
+// Size of one copy of the keymaps and macros, offsets below are relative to the start of it
+#define DYNAMIC_KEYMAP_SLOT_SIZE (DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR - DYNAMIC_KEYMAP_SLOT_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE)
+#define DYNAMIC_KEYMAP_MACRO_OFFSET (DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR - DYNAMIC_KEYMAP_SLOT_ADDR)
+
+#if defined(DYNAMIC_KEYMAP_TRANSACTIONS) && DYNAMIC_KEYMAP_SLOT_ADDR + 2 * DYNAMIC_KEYMAP_SLOT_SIZE - 1 > DYNAMIC_KEYMAP_EEPROM_MAX_ADDR
+#    error Dynamic keymaps are configured to use more EEPROM than is available for two slots.
+#endif
+
+// Number of macros that can be waiting to be sent behind the current one
+#ifndef DYNAMIC_KEYMAP_MACRO_QUEUE_SIZE
+#    define DYNAMIC_KEYMAP_MACRO_QUEUE_SIZE 4
+#endif
+
+// Macro bodies are read from EEPROM in blocks of this many bytes
+#ifndef DYNAMIC_KEYMAP_MACRO_READ_SIZE
+#    define DYNAMIC_KEYMAP_MACRO_READ_SIZE 16
+#endif
+
+// Number of layers, starting from layer 0, that are mirrored in RAM so that
+// lookups don't go through the EEPROM driver. Every cached layer costs
+// MATRIX_ROWS * MATRIX_COLS * 2 bytes of RAM, which existing keyboards may
+// not have to spare, so the cache is off unless a keyboard turns it on.
+#ifndef DYNAMIC_KEYMAP_CACHE_LAYERS
+#    define DYNAMIC_KEYMAP_CACHE_LAYERS 0
+#endif
+
+#if DYNAMIC_KEYMAP_CACHE_LAYERS > DYNAMIC_KEYMAP_LAYER_COUNT
+#    error DYNAMIC_KEYMAP_CACHE_LAYERS must not be larger than DYNAMIC_KEYMAP_LAYER_COUNT
+#endif
+
+#if DYNAMIC_KEYMAP_CACHE_LAYERS > 0
+#    define DYNAMIC_KEYMAP_CACHE_SIZE (DYNAMIC_KEYMAP_CACHE_LAYERS * MATRIX_ROWS * MATRIX_COLS)
+
+static uint16_t keymap_cache[DYNAMIC_KEYMAP_CACHE_SIZE];
+static bool     keymap_cache_loaded = false;
 
-void *dynamic_keymap_key_to_eeprom_address(uint8_t layer, uint8_t row, uint8_t column) {
-    // TODO: optimize this with some left shifts
-    return ((void *)DYNAMIC_KEYMAP_EEPROM_ADDR) + (layer * MATRIX_ROWS * MATRIX_COLS * 2) + (row * MATRIX_COLS * 2) + (column * 2);
+static inline uint16_t keymap_cache_index(uint8_t layer, uint8_t row, uint8_t column) { return (layer * MATRIX_ROWS + row) * MATRIX_COLS + column; }
+
+// Patches one byte of a cached keycode, once the cache holds the other half of it
+static void keymap_cache_patch(uint16_t offset, uint8_t value) {
+    if (keymap_cache_loaded && offset < DYNAMIC_KEYMAP_CACHE_SIZE * 2) {
+        uint16_t *keycode = &keymap_cache[offset >> 1];
+        if (offset & 1) {
+            *keycode = (*keycode & 0xFF00) | value;
+        } else {
+            *keycode = (*keycode & 0x00FF) | (value << 8);
+        }
+    }
+}
+#endif
+
+static void macro_invalidate(void);
+
+#ifdef DYNAMIC_KEYMAP_TRANSACTIONS
+static bool    slot_loaded      = false;
+static uint8_t slot_live        = 0;
+static bool    transaction_open = false;
+
+// Bytes written to the staging slot since the transaction began
+static uint16_t dirty_start;
+static uint16_t dirty_end;
+
+// Bytes in which the staging slot may differ from the live one, which are
+// copied over when the next transaction begins. That is all of them until
+// the first transaction after a reset.
+static uint16_t stale_start;
+static uint16_t stale_end;
+
+static void slot_load(void) {
+    if (!slot_loaded) {
+        slot_live   = eeprom_cached_read_byte((uint8_t *)DYNAMIC_KEYMAP_COMMIT_ADDR) == 1 ? 1 : 0;
+        stale_start = 0;
+        stale_end   = DYNAMIC_KEYMAP_SLOT_SIZE;
+        slot_loaded = true;
+    }
+}
+
+static inline uint8_t *slot_address(uint8_t slot, uint16_t offset) { return (uint8_t *)(uintptr_t)(DYNAMIC_KEYMAP_SLOT_ADDR + slot * DYNAMIC_KEYMAP_SLOT_SIZE + offset); }
+
+static uint8_t *live_address(uint16_t offset) {
+    slot_load();
+    return slot_address(slot_live, offset);
 }
 
+// Only called within a transaction, the write becomes visible on commit
+static void slot_update_byte(uint16_t offset, uint8_t value) {
+    eeprom_cached_update_byte(slot_address(slot_live ^ 1, offset), value);
+    if (offset < dirty_start) {
+        dirty_start = offset;
+    }
+    if (offset >= dirty_end) {
+        dirty_end = offset + 1;
+    }
+}
+
+void dynamic_keymap_transaction_begin(void) {
+    if (transaction_open) {
+        return;
+    }
+    slot_load();
+
+    // Bring the staging slot up to date, so that only what changes has to be written
+    uint8_t buffer[16];
+    for (uint16_t offset = stale_start; offset < stale_end; offset += sizeof(buffer)) {
+        uint16_t size = stale_end - offset;
+        if (size > sizeof(buffer)) {
+            size = sizeof(buffer);
+        }
+        eeprom_cached_read_block(buffer, slot_address(slot_live, offset), size);
+        eeprom_cached_update_block(buffer, slot_address(slot_live ^ 1, offset), size);
+    }
+    stale_start      = DYNAMIC_KEYMAP_SLOT_SIZE;
+    stale_end        = 0;
+    dirty_start      = DYNAMIC_KEYMAP_SLOT_SIZE;
+    dirty_end        = 0;
+    transaction_open = true;
+}
+
+void dynamic_keymap_transaction_commit(void) {
+    if (!transaction_open) {
+        return;
+    }
+    transaction_open = false;
+    if (dirty_start >= dirty_end) {
+        // Nothing to make live, save the commit byte a write
+        return;
+    }
+
+    // The staging slot has to be complete in EEPROM before it is made live
+    eeprom_cache_flush();
+    slot_live ^= 1;
+    eeprom_cached_update_byte((uint8_t *)DYNAMIC_KEYMAP_COMMIT_ADDR, slot_live);
+    eeprom_cache_flush();
+
+    // The slot that was live is behind on what was just written
+    stale_start = dirty_start;
+    stale_end   = dirty_end;
+#    if DYNAMIC_KEYMAP_CACHE_LAYERS > 0
+    for (uint16_t offset = dirty_start; offset < dirty_end && offset < DYNAMIC_KEYMAP_CACHE_SIZE * 2; offset++) {
+        keymap_cache_patch(offset, eeprom_cached_read_byte(slot_address(slot_live, offset)));
+    }
+#    endif
+    if (dirty_end > DYNAMIC_KEYMAP_MACRO_OFFSET) {
+        macro_invalidate();
+    }
+}
+
+void dynamic_keymap_transaction_abort(void) {
+    if (!transaction_open) {
+        return;
+    }
+    transaction_open = false;
+    // The live slot is untouched, the staging one has to be brought back in line
+    stale_start = dirty_start;
+    stale_end   = dirty_end;
+}
+
+// Writes made outside of a transaction are committed on their own.
+// Returns true if the caller has to commit.
+static bool transaction_auto_begin(void) {
+    if (transaction_open) {
+        return false;
+    }
+    dynamic_keymap_transaction_begin();
+    return true;
+}
+#else
+static inline uint8_t *live_address(uint16_t offset) { return (uint8_t *)(uintptr_t)(DYNAMIC_KEYMAP_SLOT_ADDR + offset); }
+
+// Written in place, so cached keycodes and the macro offsets have to follow
+static void slot_update_byte(uint16_t offset, uint8_t value) {
+    eeprom_cached_update_byte(live_address(offset), value);
+#    if DYNAMIC_KEYMAP_CACHE_LAYERS > 0
+    keymap_cache_patch(offset, value);
+#    endif
+    if (offset >= DYNAMIC_KEYMAP_MACRO_OFFSET) {
+        macro_invalidate();
+    }
+}
+
+void dynamic_keymap_transaction_begin(void) {}
+void dynamic_keymap_transaction_commit(void) {}
+void dynamic_keymap_transaction_abort(void) {}
+
+static inline bool transaction_auto_begin(void) { return false; }
+#endif
+
+#if DYNAMIC_KEYMAP_CACHE_LAYERS > 0
+static void keymap_cache_fill(void) {
+    for (uint16_t i = 0; i < DYNAMIC_KEYMAP_CACHE_SIZE; i++) {
+        keymap_cache[i] = eeprom_cached_read_byte(live_address(i * 2)) << 8;
+        keymap_cache[i] |= eeprom_cached_read_byte(live_address(i * 2 + 1));
+    }
+    keymap_cache_loaded = true;
+}
+
+static inline void keymap_cache_ensure_loaded(void) {
+    if (!keymap_cache_loaded) {
+        keymap_cache_fill();
+    }
+}
+#endif
+
+void dynamic_keymap_cache_load(void) {
+#ifdef DYNAMIC_KEYMAP_TRANSACTIONS
+    // Which slot is live is reread, and an open transaction is dropped
+    slot_loaded      = false;
+    transaction_open = false;
+    macro_invalidate();
+#endif
+#if DYNAMIC_KEYMAP_CACHE_LAYERS > 0
+    keymap_cache_fill();
+#endif
+}
+
+uint8_t dynamic_keymap_get_layer_count(void) { return DYNAMIC_KEYMAP_LAYER_COUNT; }
+
+static inline uint16_t keymap_key_offset(uint8_t layer, uint8_t row, uint8_t column) { return (layer * MATRIX_ROWS * MATRIX_COLS * 2) + (row * MATRIX_COLS * 2) + (column * 2); }
+
+void *dynamic_keymap_key_to_eeprom_address(uint8_t layer, uint8_t row, uint8_t column) { return live_address(keymap_key_offset(layer, row, column)); }
+
 uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t column) {
-    void *address = dynamic_keymap_key_to_eeprom_address(layer, row, column);
+#if DYNAMIC_KEYMAP_CACHE_LAYERS > 0
+    if (layer < DYNAMIC_KEYMAP_CACHE_LAYERS) {
+        keymap_cache_ensure_loaded();
+        return keymap_cache[keymap_cache_index(layer, row, column)];
+    }
+#endif
+    uint8_t *address = dynamic_keymap_key_to_eeprom_address(layer, row, column);
     // Big endian, so we can read/write EEPROM directly from host if we want
-    uint16_t keycode = eeprom_read_byte(address) << 8;
-    keycode |= eeprom_read_byte(address + 1);
+    uint16_t keycode = eeprom_cached_read_byte(address) << 8;
+    keycode |= eeprom_cached_read_byte(address + 1);
     return keycode;
 }
 
 void dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t column, uint16_t keycode) {
-    void *address = dynamic_keymap_key_to_eeprom_address(layer, row, column);
+    bool     commit = transaction_auto_begin();
+    uint16_t offset = keymap_key_offset(layer, row, column);
     // Big endian, so we can read/write EEPROM directly from host if we want
-    eeprom_update_byte(address, (uint8_t)(keycode >> 8));
-    eeprom_update_byte(address + 1, (uint8_t)(keycode & 0xFF));
+    slot_update_byte(offset, (uint8_t)(keycode >> 8));
+    slot_update_byte(offset + 1, (uint8_t)(keycode & 0xFF));
+#if DYNAMIC_KEYMAP_CACHE_LAYERS > 0 && !defined(DYNAMIC_KEYMAP_TRANSACTIONS)
+    if (layer < DYNAMIC_KEYMAP_CACHE_LAYERS) {
+        keymap_cache[keymap_cache_index(layer, row, column)] = keycode;
+    }
+#endif
+    if (commit) {
+        dynamic_keymap_transaction_commit();
+    }
 }
 
 void dynamic_keymap_reset(void) {
+    bool commit = transaction_auto_begin();
     // Reset the keymaps in EEPROM to what is in flash.
     // All keyboards using dynamic keymaps should define a layout
     // for the same number of layers as DYNAMIC_KEYMAP_LAYER_COUNT.
@@ -101,34 +356,192 @@ void dynamic_keymap_reset(void) {
             }
         }
     }
+#if DYNAMIC_KEYMAP_CACHE_LAYERS > 0 && !defined(DYNAMIC_KEYMAP_TRANSACTIONS)
+    // Every cached key has just been written through
+    keymap_cache_loaded = true;
+#endif
+    if (commit) {
+        dynamic_keymap_transaction_commit();
+    }
 }
 
 void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
     uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
-    void *   source                     = (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
     uint8_t *target                     = data;
     for (uint16_t i = 0; i < size; i++) {
         if (offset + i < dynamic_keymap_eeprom_size) {
-            *target = eeprom_read_byte(source);
+#if DYNAMIC_KEYMAP_CACHE_LAYERS > 0
+            if (offset + i < DYNAMIC_KEYMAP_CACHE_SIZE * 2) {
+                keymap_cache_ensure_loaded();
+                uint16_t keycode = keymap_cache[(offset + i) >> 1];
+                *target          = ((offset + i) & 1) ? (uint8_t)(keycode & 0xFF) : (uint8_t)(keycode >> 8);
+            } else
+#endif
+            {
+                *target = eeprom_cached_read_byte(live_address(offset + i));
+            }
         } else {
             *target = 0x00;
         }
-        source++;
         target++;
     }
 }
 
 void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
     uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
-    void *   target                     = (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
     uint8_t *source                     = data;
+    bool     commit                     = transaction_auto_begin();
     for (uint16_t i = 0; i < size; i++) {
         if (offset + i < dynamic_keymap_eeprom_size) {
-            eeprom_update_byte(target, *source);
+            slot_update_byte(offset + i, *source);
         }
         source++;
-        target++;
     }
+    if (commit) {
+        dynamic_keymap_transaction_commit();
+    }
+}
+
+#define DYNAMIC_KEYMAP_KEY_COUNT (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS)
+
+// Bulk transfer token types, see dynamic_keymap.h
+#define BULK_TOKEN_DEFAULT 0x00
+#define BULK_TOKEN_REPEAT 0x40
+#define BULK_TOKEN_LITERAL 0x80
+#define BULK_TOKEN_TYPE_MASK 0xC0
+#define BULK_TOKEN_MAX_RUN 64
+
+static uint16_t keymap_default_at(uint16_t key_index) {
+    uint8_t layer  = key_index / (MATRIX_ROWS * MATRIX_COLS);
+    uint8_t row    = (key_index / MATRIX_COLS) % MATRIX_ROWS;
+    uint8_t column = key_index % MATRIX_COLS;
+    return pgm_read_word(&keymaps[layer][row][column]);
+}
+
+static uint16_t keymap_keycode_at(uint16_t key_index, bool flash_default) {
+    if (flash_default) {
+        return keymap_default_at(key_index);
+    }
+    uint8_t layer  = key_index / (MATRIX_ROWS * MATRIX_COLS);
+    uint8_t row    = (key_index / MATRIX_COLS) % MATRIX_ROWS;
+    uint8_t column = key_index % MATRIX_COLS;
+    return dynamic_keymap_get_keycode(layer, row, column);
+}
+
+static void keymap_set_keycode_at(uint16_t key_index, uint16_t keycode) {
+    uint8_t layer  = key_index / (MATRIX_ROWS * MATRIX_COLS);
+    uint8_t row    = (key_index / MATRIX_COLS) % MATRIX_ROWS;
+    uint8_t column = key_index % MATRIX_COLS;
+    dynamic_keymap_set_keycode(layer, row, column, keycode);
+}
+
+uint8_t dynamic_keymap_encode_buffer(uint16_t *key_index, uint16_t end, bool flash_default, uint8_t *data, uint8_t size) {
+    uint16_t index  = *key_index;
+    uint8_t  length = 0;
+    if (end > DYNAMIC_KEYMAP_KEY_COUNT) {
+        end = DYNAMIC_KEYMAP_KEY_COUNT;
+    }
+    while (index < end) {
+        uint16_t keycode = keymap_keycode_at(index, flash_default);
+        uint8_t  max_run = (end - index < BULK_TOKEN_MAX_RUN) ? end - index : BULK_TOKEN_MAX_RUN;
+        uint8_t  run     = 1;
+        if (!flash_default && keycode == keymap_default_at(index)) {
+            if (length + 1 > size) {
+                break;
+            }
+            while (run < max_run && keymap_keycode_at(index + run, false) == keymap_default_at(index + run)) {
+                run++;
+            }
+            data[length++] = BULK_TOKEN_DEFAULT | (run - 1);
+        } else {
+            if (length + 3 > size) {
+                break;
+            }
+            while (run < max_run && keymap_keycode_at(index + run, flash_default) == keycode) {
+                run++;
+            }
+            uint8_t *token = &data[length++];
+            data[length++] = keycode >> 8;
+            data[length++] = keycode & 0xFF;
+            if (run > 1) {
+                *token = BULK_TOKEN_REPEAT | (run - 1);
+            } else {
+                // Extend the literal until a key that is better encoded by another token
+                while (run < max_run && length + 2 <= size) {
+                    uint16_t next = keymap_keycode_at(index + run, flash_default);
+                    if (!flash_default && next == keymap_default_at(index + run)) {
+                        break;
+                    }
+                    if (run + 1 < max_run && keymap_keycode_at(index + run + 1, flash_default) == next) {
+                        break;
+                    }
+                    data[length++] = next >> 8;
+                    data[length++] = next & 0xFF;
+                    run++;
+                }
+                *token = BULK_TOKEN_LITERAL | (run - 1);
+            }
+        }
+        index += run;
+    }
+    *key_index = index;
+    return length;
+}
+
+bool dynamic_keymap_decode_buffer(uint16_t *key_index, const uint8_t *data, uint8_t size) {
+    uint16_t index  = *key_index;
+    uint8_t  i      = 0;
+    bool     valid  = true;
+    bool     commit = transaction_auto_begin();
+    while (i < size) {
+        uint8_t token = data[i];
+        uint8_t run   = (token & ~BULK_TOKEN_TYPE_MASK) + 1;
+        // Validate the whole token first, so that a bad one is never partially applied
+        if (index + run > DYNAMIC_KEYMAP_KEY_COUNT) {
+            valid = false;
+            break;
+        }
+        uint8_t token_size = 1;
+        switch (token & BULK_TOKEN_TYPE_MASK) {
+            case BULK_TOKEN_DEFAULT:
+                break;
+            case BULK_TOKEN_REPEAT:
+                token_size += 2;
+                break;
+            case BULK_TOKEN_LITERAL:
+                token_size += run * 2;
+                break;
+            default:
+                valid = false;
+                break;
+        }
+        if (!valid || token_size > size - i) {
+            valid = false;
+            break;
+        }
+        for (uint8_t j = 0; j < run; j++) {
+            uint16_t keycode;
+            switch (token & BULK_TOKEN_TYPE_MASK) {
+                case BULK_TOKEN_DEFAULT:
+                    keycode = keymap_default_at(index + j);
+                    break;
+                case BULK_TOKEN_REPEAT:
+                    keycode = (data[i + 1] << 8) | data[i + 2];
+                    break;
+                default:
+                    keycode = (data[i + 1 + j * 2] << 8) | data[i + 2 + j * 2];
+                    break;
+            }
+            keymap_set_keycode_at(index + j, keycode);
+        }
+        index += run;
+        i += token_size;
+    }
+    if (commit) {
+        dynamic_keymap_transaction_commit();
+    }
+    *key_index = index;
+    return valid;
 }
 
 // This overrides the one in quantum/keymap_common.c
@@ -140,98 +553,174 @@ uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key) {
     }
 }
 
+// Offsets of the macros in the buffer, found by a single scan the first
+// time a macro is sent after the buffer changed.
+static uint16_t macro_offsets[DYNAMIC_KEYMAP_MACRO_COUNT];
+static uint8_t  macro_offsets_count = 0;
+static bool     macro_offsets_valid = false;
+
+// Macro sending state, the body is read DYNAMIC_KEYMAP_MACRO_READ_SIZE bytes
+// at a time and sent one character per dynamic_keymap_macro_task() call.
+// keyboard_task() holds back matrix events until it is done.
+static uint8_t  macro_queue[DYNAMIC_KEYMAP_MACRO_QUEUE_SIZE + 1];
+static uint8_t  macro_queue_head = 0;
+static uint8_t  macro_queue_tail = 0;
+static bool     macro_sending    = false;
+static uint16_t macro_read_offset;
+static uint8_t  macro_chunk[DYNAMIC_KEYMAP_MACRO_READ_SIZE];
+static uint8_t  macro_chunk_pos = 0;
+static uint8_t  macro_chunk_len = 0;
+
+static void macro_invalidate(void) {
+    macro_offsets_valid = false;
+    // The offsets of whatever is being sent are stale now
+    macro_sending    = false;
+    macro_queue_head = macro_queue_tail;
+}
+
 uint8_t dynamic_keymap_macro_get_count(void) { return DYNAMIC_KEYMAP_MACRO_COUNT; }
 
 uint16_t dynamic_keymap_macro_get_buffer_size(void) { return DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE; }
 
 void dynamic_keymap_macro_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
-    void *   source = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset);
     uint8_t *target = data;
     for (uint16_t i = 0; i < size; i++) {
         if (offset + i < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
-            *target = eeprom_read_byte(source);
+            *target = eeprom_cached_read_byte(live_address(DYNAMIC_KEYMAP_MACRO_OFFSET + offset + i));
         } else {
             *target = 0x00;
         }
-        source++;
         target++;
     }
 }
 
 void dynamic_keymap_macro_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
-    void *   target = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset);
     uint8_t *source = data;
+    bool     commit = transaction_auto_begin();
     for (uint16_t i = 0; i < size; i++) {
         if (offset + i < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
-            eeprom_update_byte(target, *source);
+            slot_update_byte(DYNAMIC_KEYMAP_MACRO_OFFSET + offset + i, *source);
         }
         source++;
-        target++;
+    }
+    if (commit) {
+        dynamic_keymap_transaction_commit();
     }
 }
 
 void dynamic_keymap_macro_reset(void) {
-    void *p   = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR);
-    void *end = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE);
-    while (p != end) {
-        eeprom_update_byte(p, 0);
-        ++p;
+    bool commit = transaction_auto_begin();
+    for (uint16_t offset = 0; offset < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE; offset++) {
+        slot_update_byte(DYNAMIC_KEYMAP_MACRO_OFFSET + offset, 0);
+    }
+    if (commit) {
+        dynamic_keymap_transaction_commit();
+    }
+}
+
+static void macro_offsets_build(void) {
+    macro_offsets_count = 0;
+    macro_offsets_valid = true;
+
+    // Check the last byte of the buffer.
+    // If it's not zero, then we are in the middle
+    // of buffer writing, possibly an aborted buffer
+    // write. So no macros can be sent.
+    if (eeprom_cached_read_byte(live_address(DYNAMIC_KEYMAP_MACRO_OFFSET + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - 1)) != 0) {
+        return;
+    }
+
+    // Each null ends a macro, the next one starts after it.
+    // If there are fewer than DYNAMIC_KEYMAP_MACRO_COUNT nulls in the buffer,
+    // the contents are garbage from that point on.
+    uint16_t start = 0;
+    for (uint16_t offset = 0; offset < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE && macro_offsets_count < DYNAMIC_KEYMAP_MACRO_COUNT; offset += sizeof(macro_chunk)) {
+        uint16_t size = DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - offset;
+        if (size > sizeof(macro_chunk)) {
+            size = sizeof(macro_chunk);
+        }
+        eeprom_cached_read_block(macro_chunk, live_address(DYNAMIC_KEYMAP_MACRO_OFFSET + offset), size);
+        for (uint16_t i = 0; i < size && macro_offsets_count < DYNAMIC_KEYMAP_MACRO_COUNT; i++) {
+            if (macro_chunk[i] == 0) {
+                macro_offsets[macro_offsets_count++] = start;
+                start                                = offset + i + 1;
+            }
+        }
     }
 }
 
+static uint8_t macro_read_next(void) {
+    if (macro_chunk_pos == macro_chunk_len) {
+        // The buffer ended with a null when the offsets were found, but it may
+        // have been changed behind our back since, so stop at its end
+        if (macro_read_offset >= DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
+            return 0;
+        }
+        uint16_t size = DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - macro_read_offset;
+        if (size > sizeof(macro_chunk)) {
+            size = sizeof(macro_chunk);
+        }
+        eeprom_cached_read_block(macro_chunk, live_address(DYNAMIC_KEYMAP_MACRO_OFFSET + macro_read_offset), size);
+        macro_read_offset += size;
+        macro_chunk_pos = 0;
+        macro_chunk_len = size;
+    }
+    return macro_chunk[macro_chunk_pos++];
+}
+
 void dynamic_keymap_macro_send(uint8_t id) {
     if (id >= DYNAMIC_KEYMAP_MACRO_COUNT) {
         return;
     }
 
-    // Check the last byte of the buffer.
-    // If it's not zero, then we are in the middle
-    // of buffer writing, possibly an aborted buffer
-    // write. So do nothing.
-    void *p = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - 1);
-    if (eeprom_read_byte(p) != 0) {
+    uint8_t next = (macro_queue_tail + 1) % (DYNAMIC_KEYMAP_MACRO_QUEUE_SIZE + 1);
+    if (next == macro_queue_head) {
+        // Already too far behind, drop it
         return;
     }
+    macro_queue[macro_queue_tail] = id;
+    macro_queue_tail              = next;
+}
+
+bool dynamic_keymap_macro_is_sending(void) { return macro_sending || macro_queue_head != macro_queue_tail; }
 
-    // Skip N null characters
-    // p will then point to the Nth macro
-    p         = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR);
-    void *end = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE);
-    while (id > 0) {
-        // If we are past the end of the buffer, then the buffer
-        // contents are garbage, i.e. there were not DYNAMIC_KEYMAP_MACRO_COUNT
-        // nulls in the buffer.
-        if (p == end) {
+void dynamic_keymap_macro_task(void) {
+    while (!macro_sending) {
+        if (macro_queue_head == macro_queue_tail) {
             return;
         }
-        if (eeprom_read_byte(p) == 0) {
-            --id;
+        uint8_t id       = macro_queue[macro_queue_head];
+        macro_queue_head = (macro_queue_head + 1) % (DYNAMIC_KEYMAP_MACRO_QUEUE_SIZE + 1);
+        if (!macro_offsets_valid) {
+            macro_offsets_build();
+        }
+        if (id < macro_offsets_count) {
+            macro_read_offset = macro_offsets[id];
+            macro_chunk_pos   = 0;
+            macro_chunk_len   = 0;
+            macro_sending     = true;
         }
-        ++p;
     }
 
     // Send the macro string one or three chars at a time
     // by making temporary 1 or 3 char strings
     char data[4] = {0, 0, 0, 0};
-    // We already checked there was a null at the end of
-    // the buffer, so this cannot go past the end
-    while (1) {
-        data[0] = eeprom_read_byte(p++);
-        data[1] = 0;
-        // Stop at the null terminator of this macro string
-        if (data[0] == 0) {
-            break;
-        }
-        // If the char is magic (tap, down, up),
-        // add the next char (key to use) and send a 3 char string.
-        if (data[0] == SS_TAP_CODE || data[0] == SS_DOWN_CODE || data[0] == SS_UP_CODE) {
-            data[1] = data[0];
-            data[0] = SS_QMK_PREFIX;
-            data[2] = eeprom_read_byte(p++);
-            if (data[2] == 0) {
-                break;
-            }
+    data[0]      = macro_read_next();
+    // Stop at the null terminator of this macro string
+    if (data[0] == 0) {
+        macro_sending = false;
+        return;
+    }
+    // If the char is magic (tap, down, up),
+    // add the next char (key to use) and send a 3 char string.
+    if (data[0] == SS_TAP_CODE || data[0] == SS_DOWN_CODE || data[0] == SS_UP_CODE) {
+        data[1] = data[0];
+        data[0] = SS_QMK_PREFIX;
+        data[2] = macro_read_next();
+        if (data[2] == 0) {
+            macro_sending = false;
+            return;
         }
-        send_string(data);
     }
+    send_string(data);
 }
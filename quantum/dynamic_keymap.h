@@ -18,11 +18,37 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// This is the default EEPROM max address to use for dynamic keymaps.
+// The default is the ATmega32u4 EEPROM max address.
+// Explicitly override it if the keyboard uses a microcontroller with
+// more EEPROM *and* it makes sense to increase it.
+#ifndef DYNAMIC_KEYMAP_EEPROM_MAX_ADDR
+#    define DYNAMIC_KEYMAP_EEPROM_MAX_ADDR 1023
+#endif
+
 uint8_t  dynamic_keymap_get_layer_count(void);
 void *   dynamic_keymap_key_to_eeprom_address(uint8_t layer, uint8_t row, uint8_t column);
 uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t column);
 void     dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t column, uint16_t keycode);
 void     dynamic_keymap_reset(void);
+// Reloads the RAM copy of the cached layers (see DYNAMIC_KEYMAP_CACHE_LAYERS)
+// from EEPROM. Only needed if the EEPROM was changed behind dynamic_keymap's back.
+// With DYNAMIC_KEYMAP_TRANSACTIONS, the live slot is reread and an open
+// transaction is dropped as well.
+void dynamic_keymap_cache_load(void);
+
+// With DYNAMIC_KEYMAP_TRANSACTIONS defined, the keymaps and macros are kept
+// in two slots, and every write goes to the one that isn't live. Writes made
+// between dynamic_keymap_transaction_begin() and _commit() all become visible
+// at once when the commit switches the live slot with a single byte write.
+// Until then, and if power is lost before then, the old keymaps and macros
+// are used. _abort() drops the writes instead. Writes made outside of a
+// transaction are committed on their own. Without DYNAMIC_KEYMAP_TRANSACTIONS
+// these do nothing, and writes are made in place.
+void dynamic_keymap_transaction_begin(void);
+void dynamic_keymap_transaction_commit(void);
+void dynamic_keymap_transaction_abort(void);
+
 // These get/set the keycodes as stored in the EEPROM buffer
 // Data is big-endian 16-bit values (the keycodes)
 // Order is by layer/row/column
@@ -34,6 +60,24 @@ void     dynamic_keymap_reset(void);
 void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data);
 void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data);
 
+// These encode/decode runs of keycodes for bulk transfers, so that a whole
+// keymap can be streamed in a handful of raw HID reports.
+// Keys are addressed by index, i.e. the offset in the buffer above divided by two.
+// The encoding is a sequence of tokens, each describing consecutive keys:
+//   0b00nnnnnn                 n+1 keys are set to the keycodes in the flash keymap
+//   0b01nnnnnn hi lo           n+1 keys are set to the keycode hi:lo
+//   0b10nnnnnn (hi lo)*(n+1)   n+1 keys are set to the keycodes that follow
+// dynamic_keymap_encode_buffer() encodes from *key_index up to end, or until
+// size bytes of data are used, advances *key_index past the keys it encoded and
+// returns the number of bytes written. With flash_default set, the flash keymap
+// itself is encoded (without the first token type), so that the host can fetch
+// the defaults once and cache them.
+// dynamic_keymap_decode_buffer() applies the tokens starting at *key_index and
+// advances it. It returns false, having applied only the tokens before it, on
+// a truncated or out of range token.
+uint8_t dynamic_keymap_encode_buffer(uint16_t *key_index, uint16_t end, bool flash_default, uint8_t *data, uint8_t size);
+bool    dynamic_keymap_decode_buffer(uint16_t *key_index, const uint8_t *data, uint8_t size);
+
 // This overrides the one in quantum/keymap_common.c
 // uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key);
 
@@ -57,4 +101,10 @@ void     dynamic_keymap_macro_get_buffer(uint16_t offset, uint16_t size, uint8_t
 void     dynamic_keymap_macro_set_buffer(uint16_t offset, uint16_t size, uint8_t *data);
 void     dynamic_keymap_macro_reset(void);
 
+// Queues the macro to be sent by dynamic_keymap_macro_task(), which sends
+// one character per call so that long macros don't hold up matrix scanning.
+// Key events wait while a macro is being sent, so that they are not typed
+// in the middle of it.
 void dynamic_keymap_macro_send(uint8_t id);
+bool dynamic_keymap_macro_is_sending(void);
+void dynamic_keymap_macro_task(void);
@@ -0,0 +1,55 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "keymap_compressed.h"
+#include "keycode.h"
+
+// Bit of the key in keymap_compressed_bitmap, or -1 past the last layer
+static int32_t keymap_compressed_bit(uint8_t layer, keypos_t key) {
+    uint32_t bit = ((uint32_t)layer * MATRIX_ROWS + key.row) * MATRIX_COLS + key.col;
+    if (key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS || bit >= pgm_read_word(&keymap_compressed_key_count)) {
+        return -1;
+    }
+    return bit;
+}
+
+bool keymap_compressed_is_transparent(uint8_t layer, keypos_t key) {
+    int32_t bit = keymap_compressed_bit(layer, key);
+    if (bit < 0) {
+        return true;
+    }
+    uint32_t word = pgm_read_dword(&keymap_compressed_bitmap[bit / KEYMAP_COMPRESSED_WORD_BITS]);
+    return !(word & (1UL << (bit % KEYMAP_COMPRESSED_WORD_BITS)));
+}
+
+// translates key to keycode
+uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key) {
+    int32_t bit = keymap_compressed_bit(layer, key);
+    if (bit < 0) {
+        return KC_TRNS;
+    }
+
+    uint16_t index = bit / KEYMAP_COMPRESSED_WORD_BITS;
+    uint32_t mask  = 1UL << (bit % KEYMAP_COMPRESSED_WORD_BITS);
+    uint32_t word  = pgm_read_dword(&keymap_compressed_bitmap[index]);
+    if (!(word & mask)) {
+        return KC_TRNS;
+    }
+
+    // keycodes of the keys before this one in the same word come first
+    uint16_t rank = pgm_read_word(&keymap_compressed_rank[index]) + __builtin_popcountl(word & (mask - 1));
+    return pgm_read_word(&keymap_compressed_keycodes[rank]);
+}
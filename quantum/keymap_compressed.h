@@ -0,0 +1,39 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "progmem.h"
+#include "keyboard.h"
+
+/* Sparse keymap generated by `qmk compress-keymap` from the compiled keymap.c.
+ *
+ * Every key of every layer gets one bit, numbered
+ * layer * MATRIX_ROWS * MATRIX_COLS + row * MATRIX_COLS + col, which is set
+ * unless the key is KC_TRNS. Only the keycodes of the set bits are stored, in
+ * bit order. keymap_compressed_rank[n] is the number of set bits in the words
+ * before keymap_compressed_bitmap[n], so finding a keycode takes one popcount.
+ */
+#define KEYMAP_COMPRESSED_WORD_BITS 32
+
+extern const uint16_t PROGMEM keymap_compressed_key_count;
+extern const uint32_t PROGMEM keymap_compressed_bitmap[];
+extern const uint16_t PROGMEM keymap_compressed_rank[];
+extern const uint16_t PROGMEM keymap_compressed_keycodes[];
+
+bool keymap_compressed_is_transparent(uint8_t layer, keypos_t key);
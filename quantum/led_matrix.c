@@ -24,6 +24,7 @@
 #include "progmem.h"
 #include "config.h"
 #include "eeprom.h"
+#include "eeprom_cache.h"
 #include <string.h>
 #include <math.h>
 
@@ -64,9 +65,9 @@ uint8_t g_key_hit[LED_DRIVER_LED_COUNT];
 // Ticks since any key was last hit.
 uint32_t g_any_key_hit = 0;
 
-uint32_t eeconfig_read_led_matrix(void) { return eeprom_read_dword(EECONFIG_LED_MATRIX); }
+uint32_t eeconfig_read_led_matrix(void) { return eeconfig_read_dword(EECONFIG_LED_MATRIX); }
 
-void eeconfig_update_led_matrix(uint32_t config_value) { eeprom_update_dword(EECONFIG_LED_MATRIX, config_value); }
+void eeconfig_update_led_matrix(uint32_t config_value) { eeconfig_update_dword(EECONFIG_LED_MATRIX, config_value); }
 
 void eeconfig_update_led_matrix_default(void) {
     dprintf("eeconfig_update_led_matrix_default\n");
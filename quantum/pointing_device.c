@@ -31,7 +31,7 @@ __attribute__((weak)) void pointing_device_init(void) {
 
 __attribute__((weak)) void pointing_device_send(void) {
     // If you need to do other things, like debugging, this is the place to do it.
-    host_mouse_send(&mouseReport);
+    host_mouse_send_from(MOUSE_SOURCE_POINTING_DEVICE, &mouseReport);
     // send it and 0 it out except for buttons, so those stay until they are explicity over-ridden using update_pointing_device
     mouseReport.x = 0;
     mouseReport.y = 0;
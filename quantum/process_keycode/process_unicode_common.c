@@ -29,7 +29,7 @@ static uint8_t selected_index;
 #endif
 
 void unicode_input_mode_init(void) {
-    unicode_config.raw = eeprom_read_byte(EECONFIG_UNICODEMODE);
+    unicode_config.raw = eeconfig_read_byte(EECONFIG_UNICODEMODE);
 #if UNICODE_SELECTED_MODES != -1
 #    if UNICODE_CYCLE_PERSIST
     // Find input_mode in selected modes
@@ -71,7 +71,7 @@ void cycle_unicode_input_mode(uint8_t offset) {
 #endif
 }
 
-void persist_unicode_input_mode(void) { eeprom_update_byte(EECONFIG_UNICODEMODE, unicode_config.input_mode); }
+void persist_unicode_input_mode(void) { eeconfig_update_byte(EECONFIG_UNICODEMODE, unicode_config.input_mode); }
 
 __attribute__((weak)) void unicode_input_start(void) {
     unicode_saved_mods = get_mods();  // Save current mods
@@ -94,6 +94,7 @@ __attribute__((weak)) void unicode_input_start(void) {
             break;
     }
 
+    flush_keyboard_report();
     wait_ms(UNICODE_TYPE_DELAY);
 }
 
@@ -16,6 +16,7 @@
 
 #include <ctype.h>
 #include "quantum.h"
+#include "eeprom_cache.h"
 
 #ifdef PROTOCOL_LUFA
 #    include "outputselect.h"
@@ -109,6 +110,7 @@ void unregister_code16(uint16_t code) {
 void tap_code16(uint16_t code) {
     register_code16(code);
 #if TAP_CODE_DELAY > 0
+    flush_keyboard_report();
     wait_ms(TAP_CODE_DELAY);
 #endif
     unregister_code16(code);
@@ -145,6 +147,7 @@ void reset_keyboard(void) {
 #ifdef HAPTIC_ENABLE
     haptic_shutdown();
 #endif
+    eeprom_cache_flush();
     bootloader_jump();
 }
 
@@ -461,6 +464,7 @@ void send_string_with_delay(const char *str, uint8_t interval) {
                     ms += keycode - '0';
                     keycode = *(++str);
                 }
+                flush_keyboard_report();
                 while (ms--) wait_ms(1);
             }
         } else {
@@ -470,6 +474,7 @@ void send_string_with_delay(const char *str, uint8_t interval) {
         // interval
         {
             uint8_t ms = interval;
+            flush_keyboard_report();
             while (ms--) wait_ms(1);
         }
     }
@@ -503,6 +508,7 @@ void send_string_with_delay_P(const char *str, uint8_t interval) {
                     ms += keycode - '0';
                     keycode = pgm_read_byte(++str);
                 }
+                flush_keyboard_report();
                 while (ms--) wait_ms(1);
             }
         } else {
@@ -512,6 +518,7 @@ void send_string_with_delay_P(const char *str, uint8_t interval) {
         // interval
         {
             uint8_t ms = interval;
+            flush_keyboard_report();
             while (ms--) wait_ms(1);
         }
     }
@@ -674,6 +681,10 @@ void matrix_scan_quantum() {
     dip_switch_read(false);
 #endif
 
+#ifdef DYNAMIC_KEYMAP_ENABLE
+    dynamic_keymap_macro_task();
+#endif
+
     matrix_scan_kb();
 }
 
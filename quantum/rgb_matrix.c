@@ -20,6 +20,8 @@
 #include "progmem.h"
 #include "config.h"
 #include "eeprom.h"
+#include "eeprom_cache.h"
+#include "power_state.h"
 #include <string.h>
 #include <math.h>
 
@@ -127,9 +129,9 @@ last_hit_t        g_last_hit_tracker;
 static last_hit_t last_hit_buffer;
 #endif  // RGB_MATRIX_KEYREACTIVE_ENABLED
 
-void eeconfig_read_rgb_matrix(void) { eeprom_read_block(&rgb_matrix_config, EECONFIG_RGB_MATRIX, sizeof(rgb_matrix_config)); }
+void eeconfig_read_rgb_matrix(void) { eeconfig_read_block(&rgb_matrix_config, EECONFIG_RGB_MATRIX, sizeof(rgb_matrix_config)); }
 
-void eeconfig_update_rgb_matrix(void) { eeprom_update_block(&rgb_matrix_config, EECONFIG_RGB_MATRIX, sizeof(rgb_matrix_config)); }
+void eeconfig_update_rgb_matrix(void) { eeconfig_update_block(&rgb_matrix_config, EECONFIG_RGB_MATRIX, sizeof(rgb_matrix_config)); }
 
 void eeconfig_update_rgb_matrix_default(void) {
     dprintf("eeconfig_update_rgb_matrix_default\n");
@@ -402,8 +404,15 @@ __attribute__((weak)) void rgb_matrix_indicators_kb(void) {}
 
 __attribute__((weak)) void rgb_matrix_indicators_user(void) {}
 
+static void rgb_matrix_suspend(void) { rgb_matrix_set_suspend_state(true); }
+
+static void rgb_matrix_resume(void) { rgb_matrix_set_suspend_state(false); }
+
+static power_callbacks_t rgb_matrix_power_callbacks = {.suspend = rgb_matrix_suspend, .resume = rgb_matrix_resume, .priority = POWER_PRIORITY_LIGHTING};
+
 void rgb_matrix_init(void) {
     rgb_matrix_driver.init();
+    power_state_register(&rgb_matrix_power_callbacks);
 
     // TODO: put the 1 second startup delay here?
 
@@ -21,6 +21,7 @@
 #endif
 #ifdef EEPROM_ENABLE
 #    include "eeprom.h"
+#    include "eeprom_cache.h"
 #endif
 #ifdef STM32_EEPROM_ENABLE
 #    include "hal.h"
@@ -33,6 +34,7 @@
 #include "color.h"
 #include "debug.h"
 #include "led_tables.h"
+#include "power_state.h"
 #include "lib/lib8tion/lib8tion.h"
 #ifdef VELOCIKEY_ENABLE
 #    include "velocikey.h"
@@ -159,7 +161,7 @@ void rgblight_check_config(void) {
 
 uint32_t eeconfig_read_rgblight(void) {
 #ifdef EEPROM_ENABLE
-    return eeprom_read_dword(EECONFIG_RGBLIGHT);
+    return eeconfig_read_dword(EECONFIG_RGBLIGHT);
 #else
     return 0;
 #endif
@@ -168,7 +170,7 @@ uint32_t eeconfig_read_rgblight(void) {
 void eeconfig_update_rgblight(uint32_t val) {
 #ifdef EEPROM_ENABLE
     rgblight_check_config();
-    eeprom_update_dword(EECONFIG_RGBLIGHT, val);
+    eeconfig_update_dword(EECONFIG_RGBLIGHT, val);
 #endif
 }
 
@@ -195,6 +197,28 @@ void eeconfig_debug_rgblight(void) {
     dprintf("rgblight_config.speed = %d\n", rgblight_config.speed);
 }
 
+#ifdef RGBLIGHT_SLEEP
+static bool rgblight_enabled_before_suspend;
+
+static void rgblight_suspend(void) {
+    rgblight_timer_disable();
+    rgblight_enabled_before_suspend = rgblight_config.enable;
+    rgblight_disable_noeeprom();
+}
+
+static void rgblight_resume(void) {
+    if (rgblight_enabled_before_suspend) {
+#    ifdef BOOTLOADER_TEENSY
+        wait_ms(10);
+#    endif
+        rgblight_enable_noeeprom();
+    }
+    rgblight_timer_enable();
+}
+
+static power_callbacks_t rgblight_power_callbacks = {.suspend = rgblight_suspend, .resume = rgblight_resume, .priority = POWER_PRIORITY_LIGHTING};
+#endif
+
 void rgblight_init(void) {
     /* if already initialized, don't do it again.
        If you must do it again, extern this and set to false, first.
@@ -227,6 +251,10 @@ void rgblight_init(void) {
         rgblight_mode_noeeprom(rgblight_config.mode);
     }
 
+#ifdef RGBLIGHT_SLEEP
+    power_state_register(&rgblight_power_callbacks);
+#endif
+
     is_rgblight_initialized = true;
 }
 
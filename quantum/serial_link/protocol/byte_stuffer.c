@@ -26,6 +26,7 @@ SOFTWARE.
 #include "serial_link/protocol/frame_validator.h"
 #include "serial_link/protocol/physical.h"
 #include <stdbool.h>
+#include <string.h>
 
 // This implements the "Consistent overhead byte stuffing protocol"
 // https://en.wikipedia.org/wiki/Consistent_Overhead_Byte_Stuffing
@@ -97,39 +98,52 @@ void byte_stuffer_recv_byte(uint8_t link, uint8_t data) {
     }
 }
 
-static void send_block(uint8_t link, uint8_t* start, uint8_t* end, uint8_t num_non_zero) {
-    send_data(link, &num_non_zero, 1);
-    if (end > start) {
-        send_data(link, start, end - start);
+// There's only one sender, so all links can share the same tx buffer
+static byte_stuffer_encoder_t tx_encoder;
+
+// Sends all completed blocks and moves the block that is still open to the start of the buffer
+void byte_stuffer_flush(byte_stuffer_encoder_t* encoder) {
+    send_data(encoder->link, encoder->buffer, encoder->code_pos);
+    encoder->pos -= encoder->code_pos;
+    memmove(encoder->buffer, encoder->buffer + encoder->code_pos, encoder->pos);
+    encoder->code_pos = 0;
+}
+
+void byte_stuffer_close_block(byte_stuffer_encoder_t* encoder) {
+    encoder->buffer[encoder->code_pos] = encoder->code;
+    if (encoder->pos == BYTE_STUFFER_TX_BUFFER_SIZE) {
+        send_data(encoder->link, encoder->buffer, encoder->pos);
+        encoder->pos = 0;
+    }
+    encoder->code_pos = encoder->pos++;
+    encoder->code     = 1;
+}
+
+byte_stuffer_encoder_t* byte_stuffer_begin_frame(uint8_t link) {
+    tx_encoder.link     = link;
+    tx_encoder.code     = 1;
+    tx_encoder.code_pos = 0;
+    tx_encoder.pos      = 1;
+    return &tx_encoder;
+}
+
+void byte_stuffer_end_frame(byte_stuffer_encoder_t* encoder) {
+    encoder->buffer[encoder->code_pos] = encoder->code;
+    if (encoder->pos == BYTE_STUFFER_TX_BUFFER_SIZE) {
+        send_data(encoder->link, encoder->buffer, encoder->pos);
+        encoder->pos = 0;
     }
+    encoder->buffer[encoder->pos++] = 0;
+    send_data(encoder->link, encoder->buffer, encoder->pos);
 }
 
-void byte_stuffer_send_frame(uint8_t link, uint8_t* data, uint16_t size) {
-    const uint8_t zero = 0;
+void byte_stuffer_send_frame(uint8_t link, const uint8_t* data, uint16_t size) {
     if (size > 0) {
-        uint16_t num_non_zero = 1;
-        uint8_t* end          = data + size;
-        uint8_t* start        = data;
+        byte_stuffer_encoder_t* encoder = byte_stuffer_begin_frame(link);
+        const uint8_t*          end     = data + size;
         while (data < end) {
-            if (num_non_zero == 0xFF) {
-                // There's more data after big non-zero block
-                // So send it, and start a new block
-                send_block(link, start, data, num_non_zero);
-                start        = data;
-                num_non_zero = 1;
-            } else {
-                if (*data == 0) {
-                    // A zero encountered, so send the block
-                    send_block(link, start, data, num_non_zero);
-                    start        = data + 1;
-                    num_non_zero = 1;
-                } else {
-                    num_non_zero++;
-                }
-                ++data;
-            }
+            byte_stuffer_put(encoder, *data++);
         }
-        send_block(link, start, data, num_non_zero);
-        send_data(link, &zero, 1);
+        byte_stuffer_end_frame(encoder);
     }
 }
@@ -27,11 +27,53 @@ SOFTWARE.
 
 #include <stdint.h>
 
-#define MAX_FRAME_SIZE 1024
+#ifndef MAX_FRAME_SIZE
+#    define MAX_FRAME_SIZE 1024
+#endif
 #define NUM_LINKS 2
 
-void init_byte_stuffer(void);
-void byte_stuffer_recv_byte(uint8_t link, uint8_t data);
-void byte_stuffer_send_frame(uint8_t link, uint8_t* data, uint16_t size);
+// The encoded frame is built here before it's handed to the physical layer
+// It needs room for at least one full block including the block code
+#ifndef BYTE_STUFFER_TX_BUFFER_SIZE
+#    define BYTE_STUFFER_TX_BUFFER_SIZE 256
+#endif
+
+#if BYTE_STUFFER_TX_BUFFER_SIZE < 256
+#    error "BYTE_STUFFER_TX_BUFFER_SIZE needs to be at least 256"
+#endif
+
+typedef struct byte_stuffer_encoder {
+    uint8_t  link;
+    uint8_t  code;
+    uint16_t code_pos;
+    uint16_t pos;
+    uint8_t  buffer[BYTE_STUFFER_TX_BUFFER_SIZE];
+} byte_stuffer_encoder_t;
+
+void byte_stuffer_close_block(byte_stuffer_encoder_t* encoder);
+void byte_stuffer_flush(byte_stuffer_encoder_t* encoder);
+
+// Encodes a single byte directly into the tx buffer, so that the layers above
+// can stream a frame from several places without first copying it together
+static inline void byte_stuffer_put(byte_stuffer_encoder_t* encoder, uint8_t data) {
+    if (encoder->code == 0xFF) {
+        byte_stuffer_close_block(encoder);
+    }
+    if (data == 0) {
+        byte_stuffer_close_block(encoder);
+    } else {
+        if (encoder->pos == BYTE_STUFFER_TX_BUFFER_SIZE) {
+            byte_stuffer_flush(encoder);
+        }
+        encoder->buffer[encoder->pos++] = data;
+        encoder->code++;
+    }
+}
+
+void                    init_byte_stuffer(void);
+void                    byte_stuffer_recv_byte(uint8_t link, uint8_t data);
+byte_stuffer_encoder_t* byte_stuffer_begin_frame(uint8_t link);
+void                    byte_stuffer_end_frame(byte_stuffer_encoder_t* encoder);
+void                    byte_stuffer_send_frame(uint8_t link, const uint8_t* data, uint16_t size);
 
 #endif
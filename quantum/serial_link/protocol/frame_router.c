@@ -26,22 +26,88 @@ SOFTWARE.
 #include "serial_link/protocol/transport.h"
 #include "serial_link/protocol/frame_validator.h"
 
+#include "timer.h"
+
 static bool is_master;
 
+// Frames without any payload are used for discovering the nodes of the chain
+// Going down, the header is the hop count instead of a destination mask
+// Going up, the header is always the hop count
+static uint8_t  known_nodes;
+static uint8_t  discovered_nodes;
+static bool     discovering;
+static uint16_t discovery_time;
+static uint16_t node_latency[ROUTER_MAX_NODES];
+
+// Until the first discovery all nodes are assumed to be there
+void init_frame_router(void) {
+    known_nodes      = ROUTER_BROADCAST;
+    discovered_nodes = 0;
+    discovering      = false;
+}
+
 void router_set_master(bool master) { is_master = master; }
 
+// Nodes that answer are added immediately, but nodes only disappear when the next discovery is started
+void router_discover(void) {
+    if (!is_master) {
+        return;
+    }
+    known_nodes      = discovering ? discovered_nodes : 0;
+    discovering      = true;
+    discovered_nodes = 0;
+    discovery_time   = timer_read();
+    uint8_t header   = 1;
+    validator_send_frame(DOWN_LINK, &header, 1);
+}
+
+uint8_t router_get_nodes(void) { return known_nodes; }
+
+uint16_t router_get_node_latency(uint8_t node) {
+    if (node >= ROUTER_MAX_NODES) {
+        return ROUTER_LATENCY_UNKNOWN;
+    }
+    return node_latency[node];
+}
+
+static void discovery_reply(uint8_t hops) {
+    if (hops == 0 || hops > ROUTER_MAX_NODES) {
+        return;
+    }
+    uint8_t node = 1 << (hops - 1);
+    if (!(discovered_nodes & node)) {
+        discovered_nodes |= node;
+        known_nodes |= node;
+        node_latency[hops - 1] = timer_elapsed(discovery_time);
+    }
+}
+
 void route_incoming_frame(uint8_t link, uint8_t* data, uint16_t size) {
     if (is_master) {
         if (link == DOWN_LINK) {
-            transport_recv_frame(data[size - 1], data, size - 1);
+            if (size == 1) {
+                discovery_reply(data[0]);
+            } else {
+                transport_recv_frame(data[size - 1], data, size - 1);
+            }
         }
     } else {
         if (link == UP_LINK) {
+            if (size == 1) {
+                uint8_t reply = 1;
+                validator_send_frame(UP_LINK, &reply, 1);
+                data[0]++;
+                validator_send_frame(DOWN_LINK, data, 1);
+                return;
+            }
             if (data[size - 1] & 1) {
                 transport_recv_frame(0, data, size - 1);
             }
             data[size - 1] >>= 1;
-            validator_send_frame(DOWN_LINK, data, size);
+            // There's no point in forwarding it if there are no destinations further down
+            if (data[size - 1]) {
+                validator_send_frame(DOWN_LINK, data, size);
+            }
         } else {
             data[size - 1]++;
             validator_send_frame(UP_LINK, data, size);
@@ -49,16 +115,39 @@ void route_incoming_frame(uint8_t link, uint8_t* data, uint16_t size) {
     }
 }
 
-void router_send_frame(uint8_t destination, uint8_t* data, uint16_t size) {
+void router_send_frame(uint8_t destination, const uint8_t* data, uint16_t size) {
+    frame_segment_t segment = {data, size};
+    router_send_segments(destination, &segment, 1);
+}
+
+void router_send_segments(uint8_t destination, const frame_segment_t* segments, uint8_t num_segments) {
+    frame_segment_t routed[MAX_FRAME_SEGMENTS + 1];
+    uint8_t         i;
+    uint8_t         link;
+    uint8_t         header;
     if (destination == 0) {
-        if (!is_master) {
-            data[size] = 1;
-            validator_send_frame(UP_LINK, data, size + 1);
+        if (is_master) {
+            return;
         }
+        link   = UP_LINK;
+        header = 1;
     } else {
-        if (is_master) {
-            data[size] = destination;
-            validator_send_frame(DOWN_LINK, data, size + 1);
+        if (!is_master) {
+            return;
         }
+        link   = DOWN_LINK;
+        header = destination & known_nodes;
+        if (!header) {
+            return;
+        }
+    }
+    if (num_segments > MAX_FRAME_SEGMENTS) {
+        return;
+    }
+    for (i = 0; i < num_segments; i++) {
+        routed[i] = segments[i];
     }
+    routed[num_segments].data = &header;
+    routed[num_segments].size = 1;
+    validator_send_segments(link, routed, num_segments + 1);
 }
@@ -27,12 +27,28 @@ SOFTWARE.
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "serial_link/protocol/frame_validator.h"
 
 #define UP_LINK 0
 #define DOWN_LINK 1
 
-void router_set_master(bool master);
+// Destinations are bitmasks, where bit n is the node n + 1 hops down the chain
+#define ROUTER_MAX_NODES 8
+#define ROUTER_BROADCAST 0xFF
+
+// router_get_node_latency(n) is the round trip time of the last discovery to
+// the node n + 1 hops down, in milliseconds, as that's what the timer counts.
+// Nodes less than a millisecond away read 0, and nodes past ROUTER_MAX_NODES
+// read ROUTER_LATENCY_UNKNOWN.
+#define ROUTER_LATENCY_UNKNOWN 0xFFFF
+
+void     init_frame_router(void);
+void     router_set_master(bool master);
+void     router_discover(void);
+uint8_t  router_get_nodes(void);
+uint16_t router_get_node_latency(uint8_t node);
 void route_incoming_frame(uint8_t link, uint8_t* data, uint16_t size);
-void router_send_frame(uint8_t destination, uint8_t* data, uint16_t size);
+void router_send_frame(uint8_t destination, const uint8_t* data, uint16_t size);
+void router_send_segments(uint8_t destination, const frame_segment_t* segments, uint8_t num_segments);
 
 #endif
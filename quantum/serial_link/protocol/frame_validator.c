@@ -39,19 +39,54 @@ static uint32_t crc32_byte(uint8_t* p, uint32_t bytelength) {
     return (crc ^ 0xffffffff);
 }
 
+static link_stats_t link_stats[NUM_LINKS];
+
+const link_stats_t* validator_get_link_stats(uint8_t link) { return &link_stats[link]; }
+
+void validator_reset_link_stats(void) { memset(link_stats, 0, sizeof(link_stats)); }
+
 void validator_recv_frame(uint8_t link, uint8_t* data, uint16_t size) {
     if (size > 4) {
         uint32_t frame_crc;
         memcpy(&frame_crc, data + size - 4, 4);
         uint32_t expected_crc = crc32_byte(data, size - 4);
         if (frame_crc == expected_crc) {
+            link_stats[link].frames_received++;
+            link_stats[link].bytes_received += size;
             route_incoming_frame(link, data, size - 4);
+            return;
         }
     }
+    link_stats[link].crc_errors++;
+}
+
+void validator_send_frame(uint8_t link, const uint8_t* data, uint16_t size) {
+    frame_segment_t segment = {data, size};
+    validator_send_segments(link, &segment, 1);
 }
 
-void validator_send_frame(uint8_t link, uint8_t* data, uint16_t size) {
-    uint32_t crc = crc32_byte(data, size);
-    memcpy(data + size, &crc, 4);
-    byte_stuffer_send_frame(link, data, size + 4);
+void validator_send_segments(uint8_t link, const frame_segment_t* segments, uint8_t num_segments) {
+    // The crc is calculated while the data is stuffed, so every byte is only touched once
+    byte_stuffer_encoder_t* encoder = byte_stuffer_begin_frame(link);
+    uint32_t                crc     = 0xffffffff;
+    uint16_t                size    = 4;
+    uint8_t                 i;
+    for (i = 0; i < num_segments; i++) {
+        size += segments[i].size;
+        const uint8_t* p   = segments[i].data;
+        const uint8_t* end = p + segments[i].size;
+        while (p < end) {
+            crc = poly8_lookup[((uint8_t)crc ^ *p)] ^ (crc >> 8);
+            byte_stuffer_put(encoder, *p++);
+        }
+    }
+    crc ^= 0xffffffff;
+    uint8_t crc_bytes[4];
+    memcpy(crc_bytes, &crc, 4);
+    for (i = 0; i < 4; i++) {
+        byte_stuffer_put(encoder, crc_bytes[i]);
+    }
+    byte_stuffer_end_frame(encoder);
+    link_stats[link].frames_sent++;
+    link_stats[link].bytes_sent += size;
 }
@@ -27,8 +27,28 @@ SOFTWARE.
 
 #include <stdint.h>
 
+#define MAX_FRAME_SEGMENTS 4
+
+// A frame can be sent from several non-contiguous buffers, which are
+// checksummed and encoded in order without being copied together first
+typedef struct {
+    const uint8_t* data;
+    uint16_t       size;
+} frame_segment_t;
+
+typedef struct {
+    uint32_t frames_sent;
+    uint32_t bytes_sent;
+    uint32_t frames_received;
+    uint32_t bytes_received;
+    uint32_t crc_errors;
+} link_stats_t;
+
+const link_stats_t* validator_get_link_stats(uint8_t link);
+void                validator_reset_link_stats(void);
+
 void validator_recv_frame(uint8_t link, uint8_t* data, uint16_t size);
-// The buffer pointed to by the data needs 4 additional bytes
-void validator_send_frame(uint8_t link, uint8_t* data, uint16_t size);
+void validator_send_frame(uint8_t link, const uint8_t* data, uint16_t size);
+void validator_send_segments(uint8_t link, const frame_segment_t* segments, uint8_t num_segments);
 
 #endif
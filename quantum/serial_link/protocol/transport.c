@@ -25,20 +25,57 @@ SOFTWARE.
 #include "serial_link/protocol/transport.h"
 #include "serial_link/protocol/frame_router.h"
 #include "serial_link/protocol/triple_buffered_object.h"
+#include "timer.h"
 #include <string.h>
 
 #define MAX_REMOTE_OBJECTS 16
 static remote_object_t* remote_objects[MAX_REMOTE_OBJECTS];
 static uint32_t         num_remote_objects = 0;
 
-void reinitialize_serial_link_transport(void) { num_remote_objects = 0; }
+static transport_stats_t stats;
+
+// Set on the object id of acknowledgement frames
+#define RELIABLE_ACK_FLAG 0x80
+#define RELIABLE_SLOT(seq) ((seq) & (RELIABLE_WINDOW_SIZE - 1))
+
+#if (RELIABLE_WINDOW_SIZE & (RELIABLE_WINDOW_SIZE - 1)) != 0 || RELIABLE_WINDOW_SIZE > 128
+#    error "RELIABLE_WINDOW_SIZE needs to be a power of two, and at most 128"
+#endif
+
+void reinitialize_serial_link_transport(void) {
+    num_remote_objects = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+const transport_stats_t* transport_get_stats(void) { return &stats; }
+
+static bool is_event_object(remote_object_t* obj) { return obj->object_type == MASTER_TO_SINGLE_SLAVE_EVENTS || obj->object_type == SLAVE_TO_MASTER_EVENTS; }
+
+static uint8_t num_tx_channels(remote_object_t* obj) { return obj->object_type == MASTER_TO_SINGLE_SLAVE_EVENTS ? NUM_SLAVES : 1; }
+
+static uint8_t num_rx_channels(remote_object_t* obj) { return obj->object_type == SLAVE_TO_MASTER_EVENTS ? NUM_SLAVES : 1; }
+
+static reliable_tx_channel_t* get_tx_channel(remote_object_t* obj, uint8_t channel) {
+    uint8_t* start = obj->buffer + channel * RELIABLE_TX_CHANNEL_SIZE(obj->object_size);
+    return (reliable_tx_channel_t*)start;
+}
+
+static reliable_rx_channel_t* get_rx_channel(remote_object_t* obj, uint8_t channel) {
+    uint8_t* start = obj->buffer + num_tx_channels(obj) * RELIABLE_TX_CHANNEL_SIZE(obj->object_size);
+    start += channel * RELIABLE_RX_CHANNEL_SIZE(obj->object_size);
+    return (reliable_rx_channel_t*)start;
+}
 
 void add_remote_objects(remote_object_t** _remote_objects, uint32_t _num_remote_objects) {
     unsigned int i;
     for (i = 0; i < _num_remote_objects; i++) {
         remote_object_t* obj                 = _remote_objects[i];
         remote_objects[num_remote_objects++] = obj;
-        if (obj->object_type == MASTER_TO_ALL_SLAVES) {
+        if (is_event_object(obj)) {
+            uint16_t size = num_tx_channels(obj) * RELIABLE_TX_CHANNEL_SIZE(obj->object_size);
+            size += num_rx_channels(obj) * RELIABLE_RX_CHANNEL_SIZE(obj->object_size);
+            memset(obj->buffer, 0, size);
+        } else if (obj->object_type == MASTER_TO_ALL_SLAVES) {
             triple_buffer_object_t* tb = (triple_buffer_object_t*)obj->buffer;
             triple_buffer_init(tb);
             uint8_t* start = obj->buffer + LOCAL_OBJECT_SIZE(obj->object_size);
@@ -69,11 +106,103 @@ void add_remote_objects(remote_object_t** _remote_objects, uint32_t _num_remote_
     }
 }
 
+bool transport_send_event(remote_object_t* obj, uint8_t channel, const void* event) {
+    reliable_tx_channel_t* tx = get_tx_channel(obj, channel);
+    serial_link_lock();
+    uint8_t seq = tx->base_seq + tx->count;
+    // The slot being sent stays taken even when an acknowledgement frees it meanwhile
+    if (tx->count == RELIABLE_WINDOW_SIZE || tx->streaming == RELIABLE_SLOT(seq) + 1) {
+        serial_link_unlock();
+        return false;
+    }
+    memcpy(tx->buffer + RELIABLE_SLOT(seq) * obj->object_size, event, obj->object_size);
+    tx->count++;
+    serial_link_unlock();
+    signal_data_written();
+    return true;
+}
+
+bool transport_receive_event(remote_object_t* obj, uint8_t channel, void* event) {
+    reliable_rx_channel_t* rx = get_rx_channel(obj, channel);
+    serial_link_lock();
+    if (rx->count == 0) {
+        serial_link_unlock();
+        return false;
+    }
+    memcpy(event, rx->buffer + rx->head * obj->object_size, obj->object_size);
+    rx->head = RELIABLE_SLOT(rx->head + 1);
+    rx->count--;
+    serial_link_unlock();
+    return true;
+}
+
+static void recv_event(uint8_t from, remote_object_t* obj, uint8_t* data, uint16_t size) {
+    if (size != obj->object_size + 1) {
+        return;
+    }
+    uint8_t channel = 0;
+    if (obj->object_type == SLAVE_TO_MASTER_EVENTS) {
+        if (from == 0 || from > NUM_SLAVES) {
+            return;
+        }
+        channel = from - 1;
+    }
+    reliable_rx_channel_t* rx  = get_rx_channel(obj, channel);
+    uint8_t                seq = data[obj->object_size];
+    serial_link_lock();
+    if (seq == rx->expected_seq) {
+        // When the queue is full the event is dropped without acknowledging it,
+        // so the sender has to wait for the reader to catch up
+        if (rx->count < RELIABLE_WINDOW_SIZE) {
+            memcpy(rx->buffer + RELIABLE_SLOT(rx->head + rx->count) * obj->object_size, data, obj->object_size);
+            rx->count++;
+            rx->expected_seq++;
+            stats.events_received++;
+        }
+    } else {
+        stats.duplicates++;
+    }
+    rx->ack_pending = true;
+    serial_link_unlock();
+}
+
+static void recv_ack(uint8_t from, uint8_t id, uint8_t* data, uint16_t size) {
+    if (id >= num_remote_objects || size != 1) {
+        return;
+    }
+    remote_object_t* obj = remote_objects[id];
+    if (!is_event_object(obj)) {
+        return;
+    }
+    uint8_t channel = 0;
+    if (obj->object_type == MASTER_TO_SINGLE_SLAVE_EVENTS) {
+        if (from == 0 || from > NUM_SLAVES) {
+            return;
+        }
+        channel = from - 1;
+    }
+    reliable_tx_channel_t* tx = get_tx_channel(obj, channel);
+    // The acknowledgement is cumulative, and contains the next sequence number the receiver expects
+    serial_link_lock();
+    uint8_t acked = data[0] - tx->base_seq;
+    if (acked <= tx->count) {
+        tx->base_seq = data[0];
+        tx->count -= acked;
+        tx->sent = acked < tx->sent ? tx->sent - acked : 0;
+        stats.acks_received++;
+    }
+    serial_link_unlock();
+}
+
 void transport_recv_frame(uint8_t from, uint8_t* data, uint16_t size) {
     uint8_t id = data[size - 1];
-    if (id < num_remote_objects) {
+    if (id & RELIABLE_ACK_FLAG) {
+        recv_ack(from, id & ~RELIABLE_ACK_FLAG, data, size - 1);
+    } else if (id < num_remote_objects) {
         remote_object_t* obj = remote_objects[id];
-        if (obj->object_size == size - 1) {
+        if (is_event_object(obj)) {
+            recv_event(from, obj, data, size - 1);
+        } else if (obj->object_size == size - 1) {
             uint8_t* start;
             if (obj->object_type == MASTER_TO_ALL_SLAVES) {
                 start = obj->buffer + LOCAL_OBJECT_SIZE(obj->object_size);
@@ -91,28 +220,90 @@ void transport_recv_frame(uint8_t from, uint8_t* data, uint16_t size) {
     }
 }
 
+// The object is sent straight from the triple buffer, with the id as a separate segment
+static void send_object(uint8_t destination, const uint8_t* data, uint16_t size, uint8_t id) {
+    frame_segment_t segments[] = {
+        {data, size},
+        {&id, 1},
+    };
+    router_send_segments(destination, segments, 2);
+}
+
+static void update_event_object(remote_object_t* obj, uint8_t id) {
+    unsigned int i;
+    for (i = 0; i < num_tx_channels(obj); i++) {
+        reliable_tx_channel_t* tx   = get_tx_channel(obj, i);
+        uint8_t                dest = obj->object_type == MASTER_TO_SINGLE_SLAVE_EVENTS ? 1 << i : 0;
+        // recv_ack() moves the window from the receive path, so every change of
+        // it is made under the lock, and only the sending is done outside it.
+        // Only this function sets last_send, and the timer isn't read locked.
+        uint16_t now       = timer_read();
+        bool     timed_out = TIMER_DIFF_16(now, tx->last_send) >= RELIABLE_RETRANSMIT_TIMEOUT;
+        serial_link_lock();
+        if (tx->sent > 0 && timed_out) {
+            // Go back and send everything that hasn't been acknowledged again
+            stats.retransmissions += tx->sent;
+            tx->sent = 0;
+        }
+        while (tx->sent < tx->count) {
+            uint8_t seq = tx->base_seq + tx->sent;
+            tx->sent++;
+            tx->last_send = now;
+            stats.events_sent++;
+            tx->streaming = RELIABLE_SLOT(seq) + 1;
+            serial_link_unlock();
+            frame_segment_t segments[] = {
+                {tx->buffer + RELIABLE_SLOT(seq) * obj->object_size, obj->object_size},
+                {&seq, 1},
+                {&id, 1},
+            };
+            router_send_segments(dest, segments, 3);
+            serial_link_lock();
+            tx->streaming = 0;
+        }
+        serial_link_unlock();
+    }
+    for (i = 0; i < num_rx_channels(obj); i++) {
+        reliable_rx_channel_t* rx = get_rx_channel(obj, i);
+        serial_link_lock();
+        bool    ack_pending  = rx->ack_pending;
+        uint8_t expected_seq = rx->expected_seq;
+        rx->ack_pending      = false;
+        serial_link_unlock();
+        if (ack_pending) {
+            uint8_t         ack_id     = id | RELIABLE_ACK_FLAG;
+            uint8_t         dest       = obj->object_type == SLAVE_TO_MASTER_EVENTS ? 1 << i : 0;
+            frame_segment_t segments[] = {
+                {&expected_seq, 1},
+                {&ack_id, 1},
+            };
+            router_send_segments(dest, segments, 2);
+            stats.acks_sent++;
+        }
+    }
+}
+
 void update_transport(void) {
     unsigned int i;
     for (i = 0; i < num_remote_objects; i++) {
         remote_object_t* obj = remote_objects[i];
-        if (obj->object_type == MASTER_TO_ALL_SLAVES || obj->object_type == SLAVE_TO_MASTER) {
+        if (is_event_object(obj)) {
+            update_event_object(obj, i);
+        } else if (obj->object_type == MASTER_TO_ALL_SLAVES || obj->object_type == SLAVE_TO_MASTER) {
             triple_buffer_object_t* tb  = (triple_buffer_object_t*)obj->buffer;
-            uint8_t*                ptr = (uint8_t*)triple_buffer_read_internal(obj->object_size + LOCAL_OBJECT_EXTRA, tb);
+            uint8_t*                ptr = (uint8_t*)triple_buffer_read_internal(obj->object_size, tb);
             if (ptr) {
-                ptr[obj->object_size] = i;
-                uint8_t dest          = obj->object_type == MASTER_TO_ALL_SLAVES ? 0xFF : 0;
-                router_send_frame(dest, ptr, obj->object_size + 1);
+                uint8_t dest = obj->object_type == MASTER_TO_ALL_SLAVES ? ROUTER_BROADCAST : 0;
+                send_object(dest, ptr, obj->object_size, i);
             }
         } else {
             uint8_t*     start = obj->buffer;
             unsigned int j;
             for (j = 0; j < NUM_SLAVES; j++) {
                 triple_buffer_object_t* tb  = (triple_buffer_object_t*)start;
-                uint8_t*                ptr = (uint8_t*)triple_buffer_read_internal(obj->object_size + LOCAL_OBJECT_EXTRA, tb);
+                uint8_t*                ptr = (uint8_t*)triple_buffer_read_internal(obj->object_size, tb);
                 if (ptr) {
-                    ptr[obj->object_size] = i;
-                    uint8_t dest          = j + 1;
-                    router_send_frame(dest, ptr, obj->object_size + 1);
+                    send_object(1 << j, ptr, obj->object_size, i);
                 }
                 start += LOCAL_OBJECT_SIZE(obj->object_size);
             }
@@ -27,27 +27,70 @@ SOFTWARE.
 
 #include "serial_link/protocol/triple_buffered_object.h"
 #include "serial_link/system/serial_link.h"
+#include <stdbool.h>
 
 #define NUM_SLAVES 8
-#define LOCAL_OBJECT_EXTRA 16
+
+// Number of unacknowledged events that can be in flight per channel
+#ifndef RELIABLE_WINDOW_SIZE
+#    define RELIABLE_WINDOW_SIZE 4
+#endif
+
+// Time in milliseconds before unacknowledged events are sent again
+#ifndef RELIABLE_RETRANSMIT_TIMEOUT
+#    define RELIABLE_RETRANSMIT_TIMEOUT 20
+#endif
 
 // master -> slave = 1 local(target all), 1 remote object
 // slave -> master = 1 local(target 0), multiple remote objects
 // master -> single slave (multiple local, target id), 1 remote object
+// The event variants use the same topology, but queue every event and
+// retransmit it until it has been acknowledged by the other end
 typedef enum {
     MASTER_TO_ALL_SLAVES,
     MASTER_TO_SINGLE_SLAVE,
     SLAVE_TO_MASTER,
+    MASTER_TO_SINGLE_SLAVE_EVENTS,
+    SLAVE_TO_MASTER_EVENTS,
 } remote_object_type;
 
 typedef struct {
     remote_object_type object_type;
     uint16_t           object_size;
-    uint8_t            buffer[] __attribute__((aligned(4)));
+    uint8_t            buffer[0] __attribute__((aligned(4)));
 } remote_object_t;
 
+typedef struct {
+    uint8_t  base_seq;
+    uint8_t  count;
+    uint8_t  sent;
+    uint8_t  streaming;  // 1 + the slot being sent outside the lock, or 0
+    uint16_t last_send;
+    uint8_t  buffer[0] __attribute__((aligned(4)));
+} reliable_tx_channel_t;
+
+typedef struct {
+    uint8_t expected_seq;
+    uint8_t head;
+    uint8_t count;
+    bool    ack_pending;
+    uint8_t buffer[0] __attribute__((aligned(4)));
+} reliable_rx_channel_t;
+
+typedef struct {
+    uint32_t events_sent;
+    uint32_t events_received;
+    uint32_t retransmissions;
+    uint32_t duplicates;
+    uint32_t acks_sent;
+    uint32_t acks_received;
+} transport_stats_t;
+
 #define REMOTE_OBJECT_SIZE(objectsize) (sizeof(triple_buffer_object_t) + objectsize * 3)
-#define LOCAL_OBJECT_SIZE(objectsize) (sizeof(triple_buffer_object_t) + (objectsize + LOCAL_OBJECT_EXTRA) * 3)
+#define LOCAL_OBJECT_SIZE(objectsize) (sizeof(triple_buffer_object_t) + objectsize * 3)
+#define RELIABLE_ALIGN(size) (((size) + 3) & ~3)
+#define RELIABLE_TX_CHANNEL_SIZE(objectsize) RELIABLE_ALIGN(sizeof(reliable_tx_channel_t) + objectsize * RELIABLE_WINDOW_SIZE)
+#define RELIABLE_RX_CHANNEL_SIZE(objectsize) RELIABLE_ALIGN(sizeof(reliable_rx_channel_t) + objectsize * RELIABLE_WINDOW_SIZE)
 
 #define REMOTE_OBJECT_HELPER(name, type, num_local, num_remote)                                                              \
     typedef struct {                                                                                                         \
@@ -64,7 +107,7 @@ typedef struct {
     type*                    begin_write_##name(void) {                                                             \
         remote_object_t*        obj = (remote_object_t*)&remote_object_##name;                   \
         triple_buffer_object_t* tb  = (triple_buffer_object_t*)obj->buffer;                      \
-        return (type*)triple_buffer_begin_write_internal(sizeof(type) + LOCAL_OBJECT_EXTRA, tb); \
+        return (type*)triple_buffer_begin_write_internal(sizeof(type), tb);                      \
     }                                                                                                               \
     void end_write_##name(void) {                                                                                   \
         remote_object_t*        obj = (remote_object_t*)&remote_object_##name;                                      \
@@ -90,7 +133,7 @@ typedef struct {
         uint8_t*         start = obj->buffer;                                                    \
         start += slave * LOCAL_OBJECT_SIZE(obj->object_size);                                    \
         triple_buffer_object_t* tb = (triple_buffer_object_t*)start;                             \
-        return (type*)triple_buffer_begin_write_internal(sizeof(type) + LOCAL_OBJECT_EXTRA, tb); \
+        return (type*)triple_buffer_begin_write_internal(sizeof(type), tb);                      \
     }                                                                                                               \
     void end_write_##name(uint8_t slave) {                                                                          \
         remote_object_t* obj   = (remote_object_t*)&remote_object_##name;                                           \
@@ -116,7 +159,7 @@ typedef struct {
     type*                    begin_write_##name(void) {                                                             \
         remote_object_t*        obj = (remote_object_t*)&remote_object_##name;                   \
         triple_buffer_object_t* tb  = (triple_buffer_object_t*)obj->buffer;                      \
-        return (type*)triple_buffer_begin_write_internal(sizeof(type) + LOCAL_OBJECT_EXTRA, tb); \
+        return (type*)triple_buffer_begin_write_internal(sizeof(type), tb);                      \
     }                                                                                                               \
     void end_write_##name(void) {                                                                                   \
         remote_object_t*        obj = (remote_object_t*)&remote_object_##name;                                      \
@@ -132,11 +175,40 @@ typedef struct {
         return (type*)triple_buffer_read_internal(obj->object_size, tb);                                            \
     }
 
+#define EVENT_OBJECT_HELPER(name, type, num_local, num_remote)                                                                                   \
+    typedef struct {                                                                                                                             \
+        remote_object_t object;                                                                                                                  \
+        uint8_t         buffer[num_local * RELIABLE_TX_CHANNEL_SIZE(sizeof(type)) + num_remote * RELIABLE_RX_CHANNEL_SIZE(sizeof(type))]; \
+    } remote_object_##name##_t;
+
+// The send functions return false when the window is full, in which case the event has to be sent again later
+// The receive functions return the events in order, one at a time
+#define MASTER_TO_SINGLE_SLAVE_EVENT_OBJECT(name, type)                                                                  \
+    EVENT_OBJECT_HELPER(name, type, NUM_SLAVES, 1)                                                                       \
+    remote_object_##name##_t remote_object_##name = {.object = {                                                         \
+                                                         .object_type = MASTER_TO_SINGLE_SLAVE_EVENTS,                   \
+                                                         .object_size = sizeof(type),                                    \
+                                                     }};                                                                 \
+    bool send_##name(uint8_t slave, const type* event) { return transport_send_event(REMOTE_OBJECT(name), slave, event); } \
+    bool receive_##name(type* event) { return transport_receive_event(REMOTE_OBJECT(name), 0, event); }
+
+#define SLAVE_TO_MASTER_EVENT_OBJECT(name, type)                                                                         \
+    EVENT_OBJECT_HELPER(name, type, 1, NUM_SLAVES)                                                                       \
+    remote_object_##name##_t remote_object_##name = {.object = {                                                         \
+                                                         .object_type = SLAVE_TO_MASTER_EVENTS,                          \
+                                                         .object_size = sizeof(type),                                    \
+                                                     }};                                                                 \
+    bool send_##name(const type* event) { return transport_send_event(REMOTE_OBJECT(name), 0, event); }                  \
+    bool receive_##name(uint8_t slave, type* event) { return transport_receive_event(REMOTE_OBJECT(name), slave, event); }
+
 #define REMOTE_OBJECT(name) (remote_object_t*)&remote_object_##name
 
-void add_remote_objects(remote_object_t** remote_objects, uint32_t num_remote_objects);
-void reinitialize_serial_link_transport(void);
-void transport_recv_frame(uint8_t from, uint8_t* data, uint16_t size);
-void update_transport(void);
+void                     add_remote_objects(remote_object_t** remote_objects, uint32_t num_remote_objects);
+void                     reinitialize_serial_link_transport(void);
+void                     transport_recv_frame(uint8_t from, uint8_t* data, uint16_t size);
+void                     update_transport(void);
+bool                     transport_send_event(remote_object_t* obj, uint8_t channel, const void* event);
+bool                     transport_receive_event(remote_object_t* obj, uint8_t channel, void* event);
+const transport_stats_t* transport_get_stats(void);
 
 #endif
@@ -54,6 +54,10 @@ host_driver_t serial_driver = {keyboard_leds, send_keyboard, send_mouse, send_sy
 #    error "Serial link thread priority not set"
 #endif
 
+#ifndef SERIAL_LINK_DISCOVERY_INTERVAL
+#    define SERIAL_LINK_DISCOVERY_INTERVAL 1000
+#endif
+
 static SerialConfig config = {.sc_speed = SERIAL_LINK_BAUD};
 
 //#define DEBUG_LINK_ERRORS
@@ -114,7 +118,8 @@ static THD_FUNCTION(serialThread, arg) {
     eventflags_t events = CHN_INPUT_AVAILABLE | SD_PARITY_ERROR | SD_FRAMING_ERROR | SD_OVERRUN_ERROR | SD_NOISE_ERROR | SD_BREAK_DETECTED;
     chEvtRegisterMaskWithFlags(chnGetEventSource(&SD1), &sd1_listener, EVENT_MASK(1), events);
     chEvtRegisterMaskWithFlags(chnGetEventSource(&SD2), &sd2_listener, EVENT_MASK(2), events);
-    bool need_wait = false;
+    bool      need_wait      = false;
+    systime_t last_discovery = 0;
     while (true) {
         eventflags_t flags1 = 0;
         eventflags_t flags2 = 0;
@@ -133,6 +138,10 @@ static THD_FUNCTION(serialThread, arg) {
         // Always stay as master, even if the USB goes into sleep mode
         is_master |= usbGetDriverStateI(&USBD1) == USB_ACTIVE;
         router_set_master(is_master);
+        if (is_master && chVTTimeElapsedSinceX(last_discovery) > TIME_MS2I(SERIAL_LINK_DISCOVERY_INTERVAL)) {
+            last_discovery = chVTGetSystemTimeX();
+            router_discover();
+        }
 
         need_wait = true;
         need_wait &= read_from_serial(&SD2, UP_LINK) == 0;
@@ -170,6 +179,7 @@ void init_serial_link(void) {
     init_serial_link_hal();
     add_remote_objects(remote_objects, sizeof(remote_objects) / sizeof(remote_object_t*));
     init_byte_stuffer();
+    init_frame_router();
     sdStart(&SD1, &config);
     sdStart(&SD2, &config);
     chEvtObjectInit(&new_data_event);
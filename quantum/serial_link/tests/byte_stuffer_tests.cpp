@@ -47,8 +47,12 @@ class ByteStuffer : public ::testing::Test {
 
     MOCK_METHOD3(validator_recv_frame, void(uint8_t link, uint8_t* data, uint16_t size));
 
-    void                 send_data(uint8_t link, const uint8_t* data, uint16_t size) { std::copy(data, data + size, std::back_inserter(sent_data)); }
+    void send_data(uint8_t link, const uint8_t* data, uint16_t size) {
+        std::copy(data, data + size, std::back_inserter(sent_data));
+        num_writes++;
+    }
     std::vector<uint8_t> sent_data;
+    int                  num_writes = 0;
 
     static ByteStuffer* Instance;
 };
@@ -448,3 +452,23 @@ TEST_F(ByteStuffer, sends_and_receives_full_roundtrip_254_bytes_and_then_zero) {
         byte_stuffer_recv_byte(1, d);
     }
 }
+
+TEST_F(ByteStuffer, sends_small_frame_with_a_single_write) {
+    uint8_t data[] = {9, 0, 0x68, 0, 0};
+    byte_stuffer_send_frame(0, data, 5);
+    EXPECT_EQ(num_writes, 1);
+}
+
+TEST_F(ByteStuffer, sends_long_frame_with_one_write_per_block) {
+    uint8_t original_data[1000];
+    int     i;
+    for (i = 0; i < 1000; i++) {
+        original_data[i] = (i % 255) + 1;
+    }
+    byte_stuffer_send_frame(1, original_data, sizeof(original_data));
+    EXPECT_EQ(num_writes, 4);
+    EXPECT_CALL(*this, validator_recv_frame(_, _, _)).With(Args<1, 2>(ElementsAreArray(original_data)));
+    for (auto& d : sent_data) {
+        byte_stuffer_recv_byte(1, d);
+    }
+}
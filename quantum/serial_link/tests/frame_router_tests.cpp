@@ -29,6 +29,8 @@ extern "C" {
 #include "serial_link/protocol/transport.h"
 #include "serial_link/protocol/byte_stuffer.h"
 #include "serial_link/protocol/frame_router.h"
+#include "timer.h"
+void advance_time(uint32_t ms);
 }
 
 using testing::_;
@@ -40,6 +42,8 @@ class FrameRouter : public testing::Test {
     FrameRouter() : current_router_buffer(nullptr) {
         Instance = this;
         init_byte_stuffer();
+        init_frame_router();
+        timer_clear();
     }
 
     ~FrameRouter() { Instance = nullptr; }
@@ -70,6 +74,30 @@ class FrameRouter : public testing::Test {
         }
     }
 
+    // Moves all data through a chain of virtual links, until no node has anything more to send
+    void run_chain(uint8_t num_nodes) {
+        bool pending = true;
+        while (pending) {
+            pending = false;
+            for (uint8_t i = 0; i < num_nodes; i++) {
+                std::vector<uint8_t> down;
+                std::vector<uint8_t> up;
+                down.swap(router_buffers[i].send_buffers[DOWN_LINK]);
+                up.swap(router_buffers[i].send_buffers[UP_LINK]);
+                if (down.size() > 0 && i + 1 < num_nodes) {
+                    pending = true;
+                    activate_router(i + 1);
+                    receive_data(UP_LINK, down.data(), down.size());
+                }
+                if (up.size() > 0 && i > 0) {
+                    pending = true;
+                    activate_router(i - 1);
+                    receive_data(DOWN_LINK, up.data(), up.size());
+                }
+            }
+        }
+    }
+
     MOCK_METHOD3(transport_recv_frame, void(uint8_t from, uint8_t* data, uint16_t size));
 
     std::vector<uint8_t> received_data;
@@ -78,7 +106,7 @@ class FrameRouter : public testing::Test {
         std::vector<uint8_t> send_buffers[2];
     };
 
-    router_buffer  router_buffers[8];
+    router_buffer  router_buffers[ROUTER_MAX_NODES + 1];
     router_buffer* current_router_buffer;
 
     static FrameRouter* Instance;
@@ -134,7 +162,7 @@ TEST_F(FrameRouter, master_send_is_received_by_targets) {
 
     EXPECT_CALL(*this, transport_recv_frame(0, _, _)).With(Args<1, 2>(ElementsAreArray(data.data)));
     simulate_transport(2, 3);
-    EXPECT_GT(router_buffers[3].send_buffers[DOWN_LINK].size(), 0);
+    EXPECT_EQ(router_buffers[3].send_buffers[DOWN_LINK].size(), 0);
     EXPECT_EQ(router_buffers[3].send_buffers[UP_LINK].size(), 0);
 }
 
@@ -202,3 +230,79 @@ TEST_F(FrameRouter, master_receives_on_uplink_does_nothing) {
     EXPECT_EQ(router_buffers[0].send_buffers[UP_LINK].size(), 0);
     EXPECT_EQ(router_buffers[0].send_buffers[DOWN_LINK].size(), 0);
 }
+
+TEST_F(FrameRouter, discovers_all_nodes_in_the_chain) {
+    activate_router(0);
+    router_discover();
+    run_chain(4);
+    EXPECT_EQ(router_get_nodes(), 0x07);
+}
+
+TEST_F(FrameRouter, discovers_the_maximum_number_of_nodes) {
+    activate_router(0);
+    router_discover();
+    run_chain(9);
+    EXPECT_EQ(router_get_nodes(), 0xFF);
+}
+
+TEST_F(FrameRouter, removes_disconnected_nodes_on_the_next_discovery) {
+    activate_router(0);
+    router_discover();
+    run_chain(4);
+    activate_router(0);
+    router_discover();
+    run_chain(2);
+    EXPECT_EQ(router_get_nodes(), 0x07);
+    activate_router(0);
+    router_discover();
+    EXPECT_EQ(router_get_nodes(), 0x01);
+}
+
+TEST_F(FrameRouter, measures_the_latency_of_each_node) {
+    activate_router(0);
+    router_discover();
+    advance_time(3);
+    run_chain(3);
+    EXPECT_EQ(router_get_node_latency(0), 3);
+    EXPECT_EQ(router_get_node_latency(1), 3);
+    EXPECT_EQ(router_get_node_latency(ROUTER_MAX_NODES), ROUTER_LATENCY_UNKNOWN);
+    EXPECT_EQ(router_get_node_latency(0xFF), ROUTER_LATENCY_UNKNOWN);
+}
+
+TEST_F(FrameRouter, broadcast_is_not_forwarded_past_the_last_node) {
+    activate_router(0);
+    router_discover();
+    run_chain(3);
+
+    frame_buffer_t data;
+    data.data = {0xAB, 0x70, 0x55, 0xBB};
+    activate_router(0);
+    router_send_frame(ROUTER_BROADCAST, (uint8_t*)&data, 4);
+    EXPECT_CALL(*this, transport_recv_frame(0, _, _)).With(Args<1, 2>(ElementsAreArray(data.data)));
+    simulate_transport(0, 1);
+    EXPECT_GT(router_buffers[1].send_buffers[DOWN_LINK].size(), 0);
+    EXPECT_CALL(*this, transport_recv_frame(0, _, _)).With(Args<1, 2>(ElementsAreArray(data.data)));
+    simulate_transport(1, 2);
+    EXPECT_EQ(router_buffers[2].send_buffers[DOWN_LINK].size(), 0);
+}
+
+TEST_F(FrameRouter, master_does_not_send_to_unknown_nodes) {
+    activate_router(0);
+    router_discover();
+    run_chain(3);
+
+    frame_buffer_t data;
+    data.data = {0xAB, 0x70, 0x55, 0xBB};
+    activate_router(0);
+    router_send_frame(1 << 4, (uint8_t*)&data, 4);
+    EXPECT_EQ(router_buffers[0].send_buffers[DOWN_LINK].size(), 0);
+}
+
+TEST_F(FrameRouter, last_node_sends_to_master_through_the_chain) {
+    frame_buffer_t data;
+    data.data = {0xAB, 0x70, 0x55, 0xBB};
+    activate_router(8);
+    router_send_frame(0, (uint8_t*)&data, 4);
+    EXPECT_CALL(*this, transport_recv_frame(8, _, _)).With(Args<1, 2>(ElementsAreArray(data.data)));
+    run_chain(9);
+}
@@ -26,7 +26,10 @@ SOFTWARE.
 #include "gmock/gmock.h"
 extern "C" {
 #include "serial_link/protocol/frame_validator.h"
+#include "serial_link/protocol/byte_stuffer.h"
+#include "serial_link/protocol/physical.h"
 }
+#include <vector>
 
 using testing::_;
 using testing::Args;
@@ -39,7 +42,9 @@ class FrameValidator : public testing::Test {
     ~FrameValidator() { Instance = nullptr; }
 
     MOCK_METHOD3(route_incoming_frame, void(uint8_t link, uint8_t* data, uint16_t size));
-    MOCK_METHOD3(byte_stuffer_send_frame, void(uint8_t link, uint8_t* data, uint16_t size));
+    void send_data(uint8_t link, const uint8_t* data, uint16_t size) { std::copy(data, data + size, std::back_inserter(sent_data)); }
+
+    std::vector<uint8_t> sent_data;
 
     static FrameValidator* Instance;
 };
@@ -49,7 +54,7 @@ FrameValidator* FrameValidator::Instance = nullptr;
 extern "C" {
 void route_incoming_frame(uint8_t link, uint8_t* data, uint16_t size) { FrameValidator::Instance->route_incoming_frame(link, data, size); }
 
-void byte_stuffer_send_frame(uint8_t link, uint8_t* data, uint16_t size) { FrameValidator::Instance->byte_stuffer_send_frame(link, data, size); }
+void send_data(uint8_t link, const uint8_t* data, uint16_t size) { FrameValidator::Instance->send_data(link, data, size); }
 }
 
 TEST_F(FrameValidator, doesnt_validate_frames_under_5_bytes) {
@@ -73,6 +78,16 @@ TEST_F(FrameValidator, does_not_validate_one_byte_frame_with_incorrect_crc) {
     validator_recv_frame(1, data, 5);
 }
 
+TEST_F(FrameValidator, counts_crc_errors_per_link) {
+    validator_reset_link_stats();
+    uint8_t data[] = {0x44, 0, 0, 0, 0};
+    EXPECT_CALL(*this, route_incoming_frame(_, _, _)).Times(0);
+    validator_recv_frame(1, data, 5);
+    EXPECT_EQ(validator_get_link_stats(0)->crc_errors, 0);
+    EXPECT_EQ(validator_get_link_stats(1)->crc_errors, 1);
+    EXPECT_EQ(validator_get_link_stats(1)->frames_received, 0);
+}
+
 TEST_F(FrameValidator, validates_four_byte_frame_with_correct_crc) {
     uint8_t data[] = {0x44, 0x10, 0xFF, 0x00, 0x74, 0x4E, 0x30, 0xBA};
     EXPECT_CALL(*this, route_incoming_frame(_, _, _)).With(Args<1, 2>(ElementsAreArray(data, 4)));
@@ -86,15 +101,24 @@ TEST_F(FrameValidator, validates_five_byte_frame_with_correct_crc) {
 }
 
 TEST_F(FrameValidator, sends_one_byte_with_correct_crc) {
-    uint8_t original[] = {0x44, 0, 0, 0, 0};
-    uint8_t expected[] = {0x44, 0x04, 0x6A, 0xB3, 0xA3};
-    EXPECT_CALL(*this, byte_stuffer_send_frame(_, _, _)).With(Args<1, 2>(ElementsAreArray(expected)));
+    uint8_t original[] = {0x44};
+    uint8_t expected[] = {6, 0x44, 0x04, 0x6A, 0xB3, 0xA3, 0};
     validator_send_frame(0, original, 1);
+    EXPECT_THAT(sent_data, ElementsAreArray(expected));
 }
 
 TEST_F(FrameValidator, sends_five_bytes_with_correct_crc) {
-    uint8_t original[] = {1, 2, 3, 4, 5, 0, 0, 0, 0};
-    uint8_t expected[] = {1, 2, 3, 4, 5, 0xF4, 0x99, 0x0B, 0x47};
-    EXPECT_CALL(*this, byte_stuffer_send_frame(_, _, _)).With(Args<1, 2>(ElementsAreArray(expected)));
+    uint8_t original[] = {1, 2, 3, 4, 5};
+    uint8_t expected[] = {10, 1, 2, 3, 4, 5, 0xF4, 0x99, 0x0B, 0x47, 0};
     validator_send_frame(0, original, 5);
+    EXPECT_THAT(sent_data, ElementsAreArray(expected));
+}
+
+TEST_F(FrameValidator, sends_segments_as_one_frame) {
+    uint8_t         first[]    = {1, 2};
+    uint8_t         second[]   = {3, 4, 5};
+    frame_segment_t segments[] = {{first, 2}, {second, 3}};
+    uint8_t         expected[] = {10, 1, 2, 3, 4, 5, 0xF4, 0x99, 0x0B, 0x47, 0};
+    validator_send_segments(0, segments, 2);
+    EXPECT_THAT(sent_data, ElementsAreArray(expected));
 }
@@ -4,13 +4,15 @@ serial_link_byte_stuffer_SRC :=\
 
 serial_link_frame_validator_SRC := \
 	$(SERIAL_PATH)/tests/frame_validator_tests.cpp \
-	$(SERIAL_PATH)/protocol/frame_validator.c 
+	$(SERIAL_PATH)/protocol/byte_stuffer.c \
+	$(SERIAL_PATH)/protocol/frame_validator.c
 
 serial_link_frame_router_SRC := \
 	$(SERIAL_PATH)/tests/frame_router_tests.cpp \
 	$(SERIAL_PATH)/protocol/byte_stuffer.c \
 	$(SERIAL_PATH)/protocol/frame_validator.c \
-	$(SERIAL_PATH)/protocol/frame_router.c
+	$(SERIAL_PATH)/protocol/frame_router.c \
+	$(TMK_PATH)/common/test/timer.c
 
 serial_link_triple_buffered_object_SRC := \
 	$(SERIAL_PATH)/tests/triple_buffered_object_tests.cpp \
@@ -19,4 +21,5 @@ serial_link_triple_buffered_object_SRC := \
 serial_link_transport_SRC := \
 	$(SERIAL_PATH)/tests/transport_tests.cpp \
 	$(SERIAL_PATH)/protocol/transport.c \
-	$(SERIAL_PATH)/protocol/triple_buffered_object.c 
+	$(SERIAL_PATH)/protocol/triple_buffered_object.c \
+	$(TMK_PATH)/common/test/timer.c
@@ -31,6 +31,9 @@ using testing::ElementsAreArray;
 
 extern "C" {
 #include "serial_link/protocol/transport.h"
+#include "serial_link/protocol/frame_router.h"
+#include "timer.h"
+void advance_time(uint32_t ms);
 }
 
 struct test_object1 {
@@ -45,17 +48,22 @@ struct test_object2 {
 MASTER_TO_ALL_SLAVES_OBJECT(master_to_slave, test_object1);
 MASTER_TO_SINGLE_SLAVE_OBJECT(master_to_single_slave, test_object1);
 SLAVE_TO_MASTER_OBJECT(slave_to_master, test_object1);
+SLAVE_TO_MASTER_EVENT_OBJECT(slave_to_master_events, test_object2);
+MASTER_TO_SINGLE_SLAVE_EVENT_OBJECT(master_to_single_slave_events, test_object1);
 
 static remote_object_t* test_remote_objects[] = {
     REMOTE_OBJECT(master_to_slave),
     REMOTE_OBJECT(master_to_single_slave),
     REMOTE_OBJECT(slave_to_master),
+    REMOTE_OBJECT(slave_to_master_events),
+    REMOTE_OBJECT(master_to_single_slave_events),
 };
 
 class Transport : public testing::Test {
    public:
     Transport() {
         Instance = this;
+        timer_clear();
         add_remote_objects(test_remote_objects, sizeof(test_remote_objects) / sizeof(remote_object_t*));
     }
 
@@ -67,9 +75,11 @@ class Transport : public testing::Test {
     MOCK_METHOD0(signal_data_written, void());
     MOCK_METHOD1(router_send_frame, void(uint8_t destination));
 
-    void router_send_frame(uint8_t destination, uint8_t* data, uint16_t size) {
+    void router_send_segments(uint8_t destination, const frame_segment_t* segments, uint8_t num_segments) {
         router_send_frame(destination);
-        std::copy(data, data + size, std::back_inserter(sent_data));
+        for (uint8_t i = 0; i < num_segments; i++) {
+            std::copy(segments[i].data, segments[i].data + segments[i].size, std::back_inserter(sent_data));
+        }
     }
 
     static Transport* Instance;
@@ -82,7 +92,7 @@ Transport* Transport::Instance = nullptr;
 extern "C" {
 void signal_data_written(void) { Transport::Instance->signal_data_written(); }
 
-void router_send_frame(uint8_t destination, uint8_t* data, uint16_t size) { Transport::Instance->router_send_frame(destination, data, size); }
+void router_send_segments(uint8_t destination, const frame_segment_t* segments, uint8_t num_segments) { Transport::Instance->router_send_segments(destination, segments, num_segments); }
 }
 
 TEST_F(Transport, write_to_local_signals_an_event) {
@@ -132,7 +142,7 @@ TEST_F(Transport, writes_from_master_to_single_slave) {
     obj->test         = 7;
     EXPECT_CALL(*this, signal_data_written());
     end_write_master_to_single_slave(3);
-    EXPECT_CALL(*this, router_send_frame(4));
+    EXPECT_CALL(*this, router_send_frame(8));
     update_transport();
     transport_recv_frame(0, sent_data.data(), sent_data.size());
     test_object1* obj2 = read_master_to_single_slave();
@@ -146,7 +156,7 @@ TEST_F(Transport, ignores_object_with_invalid_id) {
     obj->test         = 7;
     EXPECT_CALL(*this, signal_data_written());
     end_write_master_to_single_slave(3);
-    EXPECT_CALL(*this, router_send_frame(4));
+    EXPECT_CALL(*this, router_send_frame(8));
     update_transport();
     sent_data[sent_data.size() - 1] = 44;
     transport_recv_frame(0, sent_data.data(), sent_data.size());
@@ -182,3 +192,153 @@ TEST_F(Transport, ignores_object_with_size_too_big) {
     test_object1* obj2 = read_master_to_slave();
     EXPECT_EQ(obj2, nullptr);
 }
+
+TEST_F(Transport, sends_event_from_slave_to_master) {
+    test_object2 event = {1, 2};
+    EXPECT_CALL(*this, signal_data_written());
+    EXPECT_TRUE(send_slave_to_master_events(&event));
+    EXPECT_CALL(*this, router_send_frame(0));
+    update_transport();
+    transport_recv_frame(2, sent_data.data(), sent_data.size());
+    test_object2 received;
+    EXPECT_FALSE(receive_slave_to_master_events(0, &received));
+    EXPECT_TRUE(receive_slave_to_master_events(1, &received));
+    EXPECT_EQ(received.test1, 1);
+    EXPECT_EQ(received.test2, 2);
+    EXPECT_FALSE(receive_slave_to_master_events(1, &received));
+}
+
+TEST_F(Transport, sends_event_from_master_to_single_slave) {
+    test_object1 event = {9};
+    EXPECT_CALL(*this, signal_data_written());
+    EXPECT_TRUE(send_master_to_single_slave_events(3, &event));
+    EXPECT_CALL(*this, router_send_frame(8));
+    update_transport();
+    transport_recv_frame(0, sent_data.data(), sent_data.size());
+    test_object1 received;
+    EXPECT_TRUE(receive_master_to_single_slave_events(&received));
+    EXPECT_EQ(received.test, 9);
+}
+
+TEST_F(Transport, acknowledged_event_is_not_sent_again) {
+    test_object2 event = {1, 2};
+    EXPECT_CALL(*this, signal_data_written());
+    send_slave_to_master_events(&event);
+    EXPECT_CALL(*this, router_send_frame(0));
+    update_transport();
+    transport_recv_frame(1, sent_data.data(), sent_data.size());
+    sent_data.clear();
+    EXPECT_CALL(*this, router_send_frame(1));
+    update_transport();
+    transport_recv_frame(0, sent_data.data(), sent_data.size());
+    EXPECT_EQ(transport_get_stats()->acks_received, 1);
+    advance_time(RELIABLE_RETRANSMIT_TIMEOUT);
+    EXPECT_CALL(*this, router_send_frame(_)).Times(0);
+    update_transport();
+}
+
+TEST_F(Transport, unacknowledged_event_is_sent_again_after_timeout) {
+    test_object2 event = {1, 2};
+    EXPECT_CALL(*this, signal_data_written());
+    send_slave_to_master_events(&event);
+    EXPECT_CALL(*this, router_send_frame(0));
+    update_transport();
+    sent_data.clear();
+    advance_time(RELIABLE_RETRANSMIT_TIMEOUT - 1);
+    EXPECT_CALL(*this, router_send_frame(_)).Times(0);
+    update_transport();
+    advance_time(1);
+    EXPECT_CALL(*this, router_send_frame(0));
+    update_transport();
+    EXPECT_EQ(transport_get_stats()->retransmissions, 1);
+    transport_recv_frame(1, sent_data.data(), sent_data.size());
+    test_object2 received;
+    EXPECT_TRUE(receive_slave_to_master_events(0, &received));
+    EXPECT_EQ(received.test2, 2);
+}
+
+TEST_F(Transport, acknowledgement_received_while_sending_moves_the_window) {
+    test_object2 first  = {1, 2};
+    test_object2 second = {3, 4};
+    EXPECT_CALL(*this, signal_data_written()).Times(2);
+    send_slave_to_master_events(&first);
+    send_slave_to_master_events(&second);
+    // The receiver acknowledges the first event while the sender is still sending
+    uint8_t ack[] = {1, 3 | 0x80};
+    EXPECT_CALL(*this, router_send_frame(0)).WillOnce(testing::InvokeWithoutArgs([&]() { transport_recv_frame(0, ack, sizeof(ack)); })).WillOnce(testing::Return());
+    update_transport();
+    const size_t frame_size = sizeof(test_object2) + 2;
+    ASSERT_EQ(sent_data.size(), 2 * frame_size);
+    EXPECT_EQ(sent_data[sizeof(test_object2)], 0);
+    EXPECT_EQ(sent_data[frame_size + sizeof(test_object2)], 1);
+    EXPECT_EQ(transport_get_stats()->events_sent, 2);
+}
+
+TEST_F(Transport, slot_being_sent_is_not_reused_by_a_late_acknowledgement) {
+    EXPECT_CALL(*this, signal_data_written()).Times(RELIABLE_WINDOW_SIZE);
+    for (uint32_t i = 0; i < RELIABLE_WINDOW_SIZE; i++) {
+        test_object2 event = {i, 0};
+        EXPECT_TRUE(send_slave_to_master_events(&event));
+    }
+    // An acknowledgement of an earlier transmission frees the slot of the first
+    // event while it is being sent, and a new event would take that slot
+    uint8_t      ack[]     = {1, 3 | 0x80};
+    test_object2 new_event = {100, 0};
+    bool         accepted  = true;
+    EXPECT_CALL(*this, router_send_frame(0))
+        .WillOnce(testing::InvokeWithoutArgs([&]() {
+            transport_recv_frame(0, ack, sizeof(ack));
+            accepted = send_slave_to_master_events(&new_event);
+        }))
+        .WillRepeatedly(testing::Return());
+    update_transport();
+    EXPECT_FALSE(accepted);
+    ASSERT_GE(sent_data.size(), sizeof(test_object2));
+    EXPECT_EQ(sent_data[0], 0);
+
+    // Once it has been sent, the slot can be used again
+    EXPECT_CALL(*this, signal_data_written());
+    EXPECT_TRUE(send_slave_to_master_events(&new_event));
+}
+
+TEST_F(Transport, duplicate_event_is_received_only_once) {
+    test_object2 event = {1, 2};
+    EXPECT_CALL(*this, signal_data_written());
+    send_slave_to_master_events(&event);
+    EXPECT_CALL(*this, router_send_frame(0));
+    update_transport();
+    transport_recv_frame(1, sent_data.data(), sent_data.size());
+    transport_recv_frame(1, sent_data.data(), sent_data.size());
+    EXPECT_EQ(transport_get_stats()->duplicates, 1);
+    test_object2 received;
+    EXPECT_TRUE(receive_slave_to_master_events(0, &received));
+    EXPECT_FALSE(receive_slave_to_master_events(0, &received));
+}
+
+TEST_F(Transport, events_are_received_in_order) {
+    EXPECT_CALL(*this, signal_data_written()).Times(3);
+    for (uint32_t i = 0; i < 3; i++) {
+        test_object2 event = {i, i};
+        send_slave_to_master_events(&event);
+    }
+    EXPECT_CALL(*this, router_send_frame(0)).Times(3);
+    update_transport();
+    uint16_t frame_size = sent_data.size() / 3;
+    for (int i = 0; i < 3; i++) {
+        transport_recv_frame(1, sent_data.data() + i * frame_size, frame_size);
+    }
+    for (uint32_t i = 0; i < 3; i++) {
+        test_object2 received;
+        EXPECT_TRUE(receive_slave_to_master_events(0, &received));
+        EXPECT_EQ(received.test1, i);
+    }
+}
+
+TEST_F(Transport, send_fails_when_the_window_is_full) {
+    test_object2 event = {1, 2};
+    EXPECT_CALL(*this, signal_data_written()).Times(RELIABLE_WINDOW_SIZE);
+    for (int i = 0; i < RELIABLE_WINDOW_SIZE; i++) {
+        EXPECT_TRUE(send_slave_to_master_events(&event));
+    }
+    EXPECT_FALSE(send_slave_to_master_events(&event));
+}
@@ -16,6 +16,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include "util.h"
 #include "matrix.h"
 #include "debounce.h"
@@ -23,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "split_util.h"
 #include "config.h"
 #include "transport.h"
+#include "split_stats.h"
 
 #ifdef ENCODER_ENABLE
 #    include "encoder.h"
@@ -238,9 +240,17 @@ void matrix_init(void) {
 void matrix_post_scan(void) {
     if (is_keyboard_master()) {
         static uint8_t error_count;
+#ifdef SPLIT_STATS_ENABLE
+        matrix_row_t previous[ROWS_PER_HAND];
+        memcpy(previous, matrix + thatHand, sizeof(previous));
+#endif
 
         if (!transport_master(matrix + thatHand)) {
-            error_count++;
+            // Scans skipped while the transport waits to try again keep the
+            // rows of the last transfer, and only real failures are counted
+            if (!transport_master_skipped()) {
+                error_count++;
+            }
 
             if (error_count > ERROR_DISCONNECT_COUNT) {
                 // reset other half if disconnected
@@ -250,6 +260,11 @@ void matrix_post_scan(void) {
             }
         } else {
             error_count = 0;
+#ifdef SPLIT_STATS_ENABLE
+            if (memcmp(previous, matrix + thatHand, sizeof(previous)) != 0) {
+                split_stats_record_key_latency();
+            }
+#endif
         }
 
         matrix_scan_quantum();
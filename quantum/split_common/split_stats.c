@@ -0,0 +1,121 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "split_stats.h"
+#include "timer.h"
+#include "util.h"
+#include "print.h"
+
+#if defined(PROTOCOL_CHIBIOS)
+#    include "ch.h"
+#elif defined(__AVR__)
+#    include <avr/io.h>
+#endif
+
+static split_stats_t stats;
+static uint32_t      transaction_start;
+static uint32_t      last_success;
+static uint32_t      previous_success;
+
+static uint32_t stats_now(void) {
+#if defined(PROTOCOL_CHIBIOS)
+    return chVTGetSystemTimeX();
+#elif defined(__AVR__)
+    // Combine the millisecond counter with the hardware counter for sub millisecond resolution
+    uint32_t ms;
+    uint8_t  raw;
+    do {
+        ms  = timer_read32();
+        raw = TIMER_RAW;
+    } while (ms != timer_read32());
+    return ms * 1000 + (uint32_t)raw * 1000 / TIMER_RAW_TOP;
+#else
+    return timer_read32() * 1000;
+#endif
+}
+
+static uint16_t stats_elapsed_us(uint32_t start) {
+#if defined(PROTOCOL_CHIBIOS)
+    uint32_t us = TIME_I2US(chVTTimeElapsedSinceX(start));
+#else
+    uint32_t us = stats_now() - start;
+#endif
+    return us > UINT16_MAX ? UINT16_MAX : us;
+}
+
+static void add_sample(uint16_t *histogram, uint16_t *max, uint16_t value) {
+    uint8_t bucket = value < 64 ? 0 : biton16(value) - 5;
+    if (bucket >= SPLIT_STATS_BUCKETS) {
+        bucket = SPLIT_STATS_BUCKETS - 1;
+    }
+    if (histogram[bucket] < UINT16_MAX) {
+        histogram[bucket]++;
+    }
+    if (value > *max) {
+        *max = value;
+    }
+}
+
+void split_stats_begin_transaction(void) { transaction_start = stats_now(); }
+
+void split_stats_end_transaction(split_transaction_result_t result) {
+    add_sample(stats.duration_histogram, &stats.max_duration, stats_elapsed_us(transaction_start));
+    stats.transactions++;
+    if (result == SPLIT_TRANSACTION_OK) {
+        previous_success = last_success;
+        last_success     = stats_now();
+    } else if (result == SPLIT_TRANSACTION_TIMEOUT) {
+        stats.timeouts++;
+    } else {
+        stats.errors++;
+    }
+}
+
+// The halves don't share a clock, so the latency of a change on the slave is
+// estimated by the time between the last two successful transactions, which
+// is the longest it could have been waiting before the master got it
+void split_stats_record_key_latency(void) { add_sample(stats.key_latency_histogram, &stats.max_key_latency, stats_elapsed_us(previous_success)); }
+
+const split_stats_t *split_stats_get(void) { return &stats; }
+
+void split_stats_reset(void) { memset(&stats, 0, sizeof(stats)); }
+
+/** \brief Copies the statistics for a raw HID report
+ *
+ * Copies up to length bytes of split_stats_t, little endian as on every
+ * supported MCU, starting at offset, and returns how many were copied. A
+ * report too small for all of it can read the rest from a larger offset.
+ */
+uint8_t split_stats_read(uint8_t offset, uint8_t *data, uint8_t length) {
+    if (offset >= sizeof(stats)) {
+        return 0;
+    }
+    if (length > sizeof(stats) - offset) {
+        length = sizeof(stats) - offset;
+    }
+    memcpy(data, (const uint8_t *)&stats + offset, length);
+    return length;
+}
+
+void split_stats_print(void) {
+    xprintf("split: %lu transactions, %lu errors, %lu timeouts\n", stats.transactions, stats.errors, stats.timeouts);
+    xprintf("split: max duration %u us, max key latency %u us\n", stats.max_duration, stats.max_key_latency);
+    for (uint8_t i = 0; i < SPLIT_STATS_BUCKETS; i++) {
+        xprintf("split: <%6lu us %5u %5u\n", 64UL << i, stats.duration_histogram[i], stats.key_latency_histogram[i]);
+    }
+}
@@ -0,0 +1,55 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Link health statistics for the split transports, enabled with SPLIT_STATS_ENABLE = yes
+// All times are in microseconds, the resolution depends on the platform timer
+
+// Bucket n counts the values in [32 << n, 64 << n), the first and last buckets are open ended
+#define SPLIT_STATS_BUCKETS 10
+
+typedef enum {
+    SPLIT_TRANSACTION_OK,
+    SPLIT_TRANSACTION_ERROR,
+    SPLIT_TRANSACTION_TIMEOUT,
+} split_transaction_result_t;
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t errors;
+    uint32_t timeouts;
+    uint16_t max_duration;
+    uint16_t max_key_latency;
+    uint16_t duration_histogram[SPLIT_STATS_BUCKETS];
+    uint16_t key_latency_histogram[SPLIT_STATS_BUCKETS];
+} split_stats_t;
+
+#ifdef SPLIT_STATS_ENABLE
+void                 split_stats_begin_transaction(void);
+void                 split_stats_end_transaction(split_transaction_result_t result);
+void                 split_stats_record_key_latency(void);
+const split_stats_t *split_stats_get(void);
+void                 split_stats_reset(void);
+void                 split_stats_print(void);
+uint8_t              split_stats_read(uint8_t offset, uint8_t *data, uint8_t length);
+#else
+#    define split_stats_begin_transaction()
+#    define split_stats_end_transaction(result)
+#    define split_stats_record_key_latency()
+#endif
@@ -4,6 +4,7 @@
 #include "config.h"
 #include "matrix.h"
 #include "quantum.h"
+#include "split_stats.h"
 
 #define ROWS_PER_HAND (MATRIX_ROWS / 2)
 
@@ -26,15 +27,21 @@ static pin_t encoders_pad[] = ENCODERS_PAD_A;
 #    include "i2c_master.h"
 #    include "i2c_slave.h"
 
-typedef struct _I2C_slave_buffer_t {
+// Everything the master reads from the slave is kept together at the start
+// of the buffer, so that it can be fetched with a single transfer
+typedef struct _I2C_slave_to_master_t {
     matrix_row_t smatrix[ROWS_PER_HAND];
-    uint8_t      backlight_level;
-#    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
-    rgblight_syncinfo_t rgblight_sync;
-#    endif
 #    ifdef ENCODER_ENABLE
     uint8_t encoder_state[NUMBER_OF_ENCODERS];
 #    endif
+} I2C_slave_to_master_t;
+
+typedef struct _I2C_slave_buffer_t {
+    I2C_slave_to_master_t s2m;
+    uint8_t               backlight_level;
+#    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
+    rgblight_syncinfo_t rgblight_sync;
+#    endif
 #    ifdef WPM_ENABLE
     uint8_t current_wpm;
 #    endif
@@ -42,27 +49,65 @@ typedef struct _I2C_slave_buffer_t {
 
 static I2C_slave_buffer_t *const i2c_buffer = (I2C_slave_buffer_t *)i2c_slave_reg;
 
+#    define I2C_S2M_START offsetof(I2C_slave_buffer_t, s2m)
 #    define I2C_BACKLIGHT_START offsetof(I2C_slave_buffer_t, backlight_level)
 #    define I2C_RGB_START offsetof(I2C_slave_buffer_t, rgblight_sync)
-#    define I2C_KEYMAP_START offsetof(I2C_slave_buffer_t, smatrix)
-#    define I2C_ENCODER_START offsetof(I2C_slave_buffer_t, encoder_state)
 #    define I2C_WPM_START offsetof(I2C_slave_buffer_t, current_wpm)
 
-#    define TIMEOUT 100
+#    ifndef SPLIT_I2C_TIMEOUT
+#        define SPLIT_I2C_TIMEOUT 5
+#    endif
+
+#    ifndef SPLIT_I2C_MAX_BACKOFF
+#        define SPLIT_I2C_MAX_BACKOFF 1024
+#    endif
 
 #    ifndef SLAVE_I2C_ADDRESS
 #        define SLAVE_I2C_ADDRESS 0x32
 #    endif
 
+// After a failed transfer the slave is left alone for a while, doubling the
+// delay on every failure, so a missing half doesn't slow down the scan rate
+static uint16_t backoff_timer;
+static uint16_t backoff_delay = 0;
+static bool     skipped       = false;
+
+static bool i2c_backoff_active(void) { return backoff_delay && timer_elapsed(backoff_timer) < backoff_delay; }
+
+static bool i2c_check(i2c_status_t status) {
+    if (status < 0) {
+        backoff_delay = backoff_delay ? backoff_delay * 2 : 1;
+        if (backoff_delay > SPLIT_I2C_MAX_BACKOFF) {
+            backoff_delay = SPLIT_I2C_MAX_BACKOFF;
+        }
+        backoff_timer = timer_read();
+        return false;
+    }
+    backoff_delay = 0;
+    return true;
+}
+
 // Get rows from other half over i2c
 bool transport_master(matrix_row_t matrix[]) {
-    i2c_readReg(SLAVE_I2C_ADDRESS, I2C_KEYMAP_START, (void *)matrix, sizeof(i2c_buffer->smatrix), TIMEOUT);
+    skipped = i2c_backoff_active();
+    if (skipped) {
+        return false;
+    }
+
+    I2C_slave_to_master_t s2m;
+    split_stats_begin_transaction();
+    i2c_status_t status = i2c_readReg(SLAVE_I2C_ADDRESS, I2C_S2M_START, (void *)&s2m, sizeof(s2m), SPLIT_I2C_TIMEOUT);
+    split_stats_end_transaction(status == I2C_STATUS_TIMEOUT ? SPLIT_TRANSACTION_TIMEOUT : status < 0 ? SPLIT_TRANSACTION_ERROR : SPLIT_TRANSACTION_OK);
+    if (!i2c_check(status)) {
+        return false;
+    }
+    memcpy((void *)matrix, (void *)s2m.smatrix, sizeof(s2m.smatrix));
 
     // write backlight info
 #    ifdef BACKLIGHT_ENABLE
     uint8_t level = is_backlight_enabled() ? get_backlight_level() : 0;
     if (level != i2c_buffer->backlight_level) {
-        if (i2c_writeReg(SLAVE_I2C_ADDRESS, I2C_BACKLIGHT_START, (void *)&level, sizeof(level), TIMEOUT) >= 0) {
+        if (i2c_check(i2c_writeReg(SLAVE_I2C_ADDRESS, I2C_BACKLIGHT_START, (void *)&level, sizeof(level), SPLIT_I2C_TIMEOUT))) {
             i2c_buffer->backlight_level = level;
         }
     }
@@ -72,21 +117,20 @@ bool transport_master(matrix_row_t matrix[]) {
     if (rgblight_get_change_flags()) {
         rgblight_syncinfo_t rgblight_sync;
         rgblight_get_syncinfo(&rgblight_sync);
-        if (i2c_writeReg(SLAVE_I2C_ADDRESS, I2C_RGB_START, (void *)&rgblight_sync, sizeof(rgblight_sync), TIMEOUT) >= 0) {
+        if (i2c_check(i2c_writeReg(SLAVE_I2C_ADDRESS, I2C_RGB_START, (void *)&rgblight_sync, sizeof(rgblight_sync), SPLIT_I2C_TIMEOUT))) {
             rgblight_clear_change_flags();
         }
     }
 #    endif
 
 #    ifdef ENCODER_ENABLE
-    i2c_readReg(SLAVE_I2C_ADDRESS, I2C_ENCODER_START, (void *)i2c_buffer->encoder_state, sizeof(i2c_buffer->encoder_state), TIMEOUT);
-    encoder_update_raw(i2c_buffer->encoder_state);
+    encoder_update_raw(s2m.encoder_state);
 #    endif
 
 #    ifdef WPM_ENABLE
     uint8_t current_wpm = get_current_wpm();
     if (current_wpm != i2c_buffer->current_wpm) {
-        if (i2c_writeReg(SLAVE_I2C_ADDRESS, I2C_WPM_START, (void *)&current_wpm, sizeof(current_wpm), TIMEOUT) >= 0) {
+        if (i2c_check(i2c_writeReg(SLAVE_I2C_ADDRESS, I2C_WPM_START, (void *)&current_wpm, sizeof(current_wpm), SPLIT_I2C_TIMEOUT))) {
             i2c_buffer->current_wpm = current_wpm;
         }
     }
@@ -96,7 +140,7 @@ bool transport_master(matrix_row_t matrix[]) {
 
 void transport_slave(matrix_row_t matrix[]) {
     // Copy matrix to I2C buffer
-    memcpy((void *)i2c_buffer->smatrix, (void *)matrix, sizeof(i2c_buffer->smatrix));
+    memcpy((void *)i2c_buffer->s2m.smatrix, (void *)matrix, sizeof(i2c_buffer->s2m.smatrix));
 
 // Read Backlight Info
 #    ifdef BACKLIGHT_ENABLE
@@ -112,7 +156,7 @@ void transport_slave(matrix_row_t matrix[]) {
 #    endif
 
 #    ifdef ENCODER_ENABLE
-    encoder_state_raw(i2c_buffer->encoder_state);
+    encoder_state_raw(i2c_buffer->s2m.encoder_state);
 #    endif
 
 #    ifdef WPM_ENABLE
@@ -120,6 +164,8 @@ void transport_slave(matrix_row_t matrix[]) {
 #    endif
 }
 
+bool transport_master_skipped(void) { return skipped; }
+
 void transport_master_init(void) { i2c_init(); }
 
 void transport_slave_init(void) { i2c_slave_init(SLAVE_I2C_ADDRESS); }
@@ -192,6 +238,8 @@ SSTD_t transactions[] = {
 #    endif
 };
 
+bool transport_master_skipped(void) { return false; }
+
 void transport_master_init(void) { soft_serial_initiator_init(transactions, TID_LIMIT(transactions)); }
 
 void transport_slave_init(void) { soft_serial_target_init(transactions, TID_LIMIT(transactions)); }
@@ -223,15 +271,17 @@ void transport_rgblight_slave(void) {
 
 bool transport_master(matrix_row_t matrix[]) {
 #    ifndef SERIAL_USE_MULTI_TRANSACTION
-    if (soft_serial_transaction() != TRANSACTION_END) {
-        return false;
-    }
+    split_stats_begin_transaction();
+    int status = soft_serial_transaction();
 #    else
     transport_rgblight_master();
-    if (soft_serial_transaction(GET_SLAVE_MATRIX) != TRANSACTION_END) {
+    split_stats_begin_transaction();
+    int status = soft_serial_transaction(GET_SLAVE_MATRIX);
+#    endif
+    split_stats_end_transaction(status == TRANSACTION_END ? SPLIT_TRANSACTION_OK : status == TRANSACTION_NO_RESPONSE ? SPLIT_TRANSACTION_TIMEOUT : SPLIT_TRANSACTION_ERROR);
+    if (status != TRANSACTION_END) {
         return false;
     }
-#    endif
 
     // TODO:  if MATRIX_COLS > 8 change to unpack()
     for (int i = 0; i < ROWS_PER_HAND; ++i) {
@@ -7,4 +7,7 @@ void transport_slave_init(void);
 
 // returns false if valid data not received from slave
 bool transport_master(matrix_row_t matrix[]);
+// true if the last transport_master() didn't try to reach the slave, as it is
+// waiting after a failure, and left the rows as they were
+bool transport_master_skipped(void);
 void transport_slave(matrix_row_t matrix[]);
@@ -0,0 +1,15 @@
+/* THIS FILE WAS GENERATED!
+ *
+ * This file was generated by qmk compress-keymap from keymap_compressed_test_keymap.o.
+ * Do not edit it directly.
+ */
+
+#include "keymap_compressed.h"
+
+const uint16_t PROGMEM keymap_compressed_key_count = 60;
+
+const uint32_t PROGMEM keymap_compressed_bitmap[] = {0x1C4FFFFF, 0x08002000};
+
+const uint16_t PROGMEM keymap_compressed_rank[] = {0, 24};
+
+const uint16_t PROGMEM keymap_compressed_keycodes[] = {0x0029, 0x001E, 0x001F, 0x0020, 0x002A, 0x002B, 0x0014, 0x001A, 0x0008, 0x0028, 0x00E1, 0x0004, 0x0016, 0x0007, 0x5101, 0x0035, 0x003A, 0x003B, 0x003C, 0x004C, 0x0052, 0x0050, 0x0051, 0x004F, 0x0000, 0x00A8};
@@ -0,0 +1,49 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include "progmem.h"
+#include "keycode.h"
+
+/* Dense keymap that keymap_compressed_test_data.c was generated from, with
+ *
+ *   gcc -c -DMATRIX_ROWS=3 -DMATRIX_COLS=5 -Itmk_core/common quantum/tests/keymap_compressed_test_keymap.c
+ *   qmk compress-keymap keymap_compressed_test_keymap.o
+ *
+ * The keymaps span more than one bitmap word, and the upper layers are mostly KC_TRNS.
+ */
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    {
+        {KC_ESC, KC_1, KC_2, KC_3, KC_BSPC},
+        {KC_TAB, KC_Q, KC_W, KC_E, KC_ENT},
+        {KC_LSFT, KC_A, KC_S, KC_D, 0x5101},
+    },
+    {
+        {KC_GRV, KC_F1, KC_F2, KC_F3, KC_DEL},
+        {KC_TRNS, KC_TRNS, KC_UP, KC_TRNS, KC_TRNS},
+        {KC_TRNS, KC_LEFT, KC_DOWN, KC_RGHT, KC_TRNS},
+    },
+    {
+        {KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS},
+        {KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS},
+        {KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS},
+    },
+    {
+        {KC_NO, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS},
+        {KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS},
+        {KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_MUTE},
+    },
+};
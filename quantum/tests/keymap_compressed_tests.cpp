@@ -0,0 +1,82 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "keymap_compressed.h"
+#include "keycode.h"
+
+extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
+uint16_t              keymap_key_to_keycode(uint8_t layer, keypos_t key);
+}
+
+#define LAYERS 4
+
+static keypos_t key(uint8_t row, uint8_t col) {
+    keypos_t key = {.col = col, .row = row};
+    return key;
+}
+
+TEST(KeymapCompressed, MatchesDenseKeymap) {
+    for (uint8_t layer = 0; layer < LAYERS; layer++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                EXPECT_EQ(keymap_key_to_keycode(layer, key(row, col)), keymaps[layer][row][col]) << "layer " << (int)layer << " row " << (int)row << " col " << (int)col;
+            }
+        }
+    }
+}
+
+TEST(KeymapCompressed, TransparentMatchesDenseKeymap) {
+    for (uint8_t layer = 0; layer < LAYERS; layer++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                EXPECT_EQ(keymap_compressed_is_transparent(layer, key(row, col)), keymaps[layer][row][col] == KC_TRNS);
+            }
+        }
+    }
+}
+
+TEST(KeymapCompressed, KeyNoIsNotTransparent) {
+    EXPECT_FALSE(keymap_compressed_is_transparent(3, key(0, 0)));
+    EXPECT_EQ(keymap_key_to_keycode(3, key(0, 0)), KC_NO);
+}
+
+TEST(KeymapCompressed, OutOfRangeIsTransparent) {
+    EXPECT_TRUE(keymap_compressed_is_transparent(LAYERS, key(0, 0)));
+    EXPECT_TRUE(keymap_compressed_is_transparent(31, key(2, 4)));
+    EXPECT_TRUE(keymap_compressed_is_transparent(0, key(MATRIX_ROWS, 0)));
+    EXPECT_TRUE(keymap_compressed_is_transparent(0, key(0, MATRIX_COLS)));
+    EXPECT_EQ(keymap_key_to_keycode(LAYERS, key(0, 0)), KC_TRNS);
+    EXPECT_EQ(keymap_key_to_keycode(0, key(0, MATRIX_COLS)), KC_TRNS);
+}
+
+TEST(KeymapCompressed, StoresOnlyNonTransparentKeys) {
+    size_t keys = 0;
+    for (uint8_t layer = 0; layer < LAYERS; layer++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                keys += keymaps[layer][row][col] != KC_TRNS;
+            }
+        }
+    }
+    size_t words = (LAYERS * MATRIX_ROWS * MATRIX_COLS + KEYMAP_COMPRESSED_WORD_BITS - 1) / KEYMAP_COMPRESSED_WORD_BITS;
+
+    EXPECT_EQ(keymap_compressed_key_count, LAYERS * MATRIX_ROWS * MATRIX_COLS);
+    EXPECT_EQ(keymap_compressed_rank[words - 1] + __builtin_popcountl(keymap_compressed_bitmap[words - 1]), keys);
+    EXPECT_LT(words * sizeof(uint32_t) + words * sizeof(uint16_t) + keys * sizeof(uint16_t), sizeof(uint16_t) * LAYERS * MATRIX_ROWS * MATRIX_COLS);
+}
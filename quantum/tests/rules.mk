@@ -0,0 +1,14 @@
+keymap_compressed_DEFS := -DMATRIX_ROWS=3 -DMATRIX_COLS=5
+keymap_compressed_SRC := \
+	$(QUANTUM_PATH)/tests/keymap_compressed_tests.cpp \
+	$(QUANTUM_PATH)/tests/keymap_compressed_test_keymap.c \
+	$(QUANTUM_PATH)/tests/keymap_compressed_test_data.c \
+	$(QUANTUM_PATH)/keymap_compressed.c
+
+split_stats_DEFS := -DSPLIT_STATS_ENABLE -DNO_PRINT
+split_stats_INC := $(QUANTUM_PATH)/split_common
+split_stats_SRC := \
+	$(QUANTUM_PATH)/tests/split_stats_tests.cpp \
+	$(QUANTUM_PATH)/split_common/split_stats.c \
+	$(TMK_PATH)/common/util.c \
+	$(TMK_PATH)/common/test/timer.c
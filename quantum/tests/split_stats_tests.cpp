@@ -0,0 +1,101 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "split_stats.h"
+#include "timer.h"
+void advance_time(uint32_t ms);
+}
+
+class SplitStats : public testing::Test {
+   public:
+    SplitStats() {
+        timer_clear();
+        split_stats_reset();
+    }
+
+    void transaction(split_transaction_result_t result, uint32_t ms = 0) {
+        split_stats_begin_transaction();
+        advance_time(ms);
+        split_stats_end_transaction(result);
+    }
+};
+
+TEST_F(SplitStats, CountsTransactionsByResult) {
+    transaction(SPLIT_TRANSACTION_OK);
+    transaction(SPLIT_TRANSACTION_ERROR);
+    transaction(SPLIT_TRANSACTION_TIMEOUT);
+    transaction(SPLIT_TRANSACTION_TIMEOUT);
+    const split_stats_t *stats = split_stats_get();
+    EXPECT_EQ(stats->transactions, 4u);
+    EXPECT_EQ(stats->errors, 1u);
+    EXPECT_EQ(stats->timeouts, 2u);
+}
+
+TEST_F(SplitStats, SortsDurationsIntoBuckets) {
+    // The test timer counts milliseconds, so durations are multiples of 1000 us
+    transaction(SPLIT_TRANSACTION_OK, 0);
+    transaction(SPLIT_TRANSACTION_OK, 1);
+    transaction(SPLIT_TRANSACTION_OK, 2);
+    transaction(SPLIT_TRANSACTION_OK, 70);
+    const split_stats_t *stats = split_stats_get();
+    EXPECT_EQ(stats->duration_histogram[0], 1);
+    // [512, 1024) and [1024, 2048)
+    EXPECT_EQ(stats->duration_histogram[4], 1);
+    EXPECT_EQ(stats->duration_histogram[5], 1);
+    // Longer than the last bucket, and than a uint16_t holds
+    EXPECT_EQ(stats->duration_histogram[SPLIT_STATS_BUCKETS - 1], 1);
+    EXPECT_EQ(stats->max_duration, UINT16_MAX);
+}
+
+TEST_F(SplitStats, KeyLatencyIsTheTimeBetweenTheLastTwoSuccesses) {
+    transaction(SPLIT_TRANSACTION_OK);
+    advance_time(3);
+    transaction(SPLIT_TRANSACTION_ERROR);
+    transaction(SPLIT_TRANSACTION_OK);
+    split_stats_record_key_latency();
+    const split_stats_t *stats = split_stats_get();
+    EXPECT_EQ(stats->max_key_latency, 3000);
+    // [2048, 4096)
+    EXPECT_EQ(stats->key_latency_histogram[6], 1);
+}
+
+TEST_F(SplitStats, ResetClearsEverything) {
+    transaction(SPLIT_TRANSACTION_ERROR, 1);
+    split_stats_reset();
+    split_stats_t zero = {};
+    EXPECT_EQ(memcmp(split_stats_get(), &zero, sizeof(zero)), 0);
+}
+
+TEST_F(SplitStats, ReadCopiesTheStatisticsInPieces) {
+    transaction(SPLIT_TRANSACTION_TIMEOUT, 1);
+    uint8_t expected[sizeof(split_stats_t)];
+    memcpy(expected, split_stats_get(), sizeof(expected));
+
+    // As read by VIA, 29 bytes per report
+    uint8_t data[sizeof(split_stats_t)] = {};
+    uint8_t offset                      = 0;
+    while (uint8_t copied = split_stats_read(offset, data + offset, 29)) {
+        EXPECT_LE(copied, 29);
+        offset += copied;
+    }
+    EXPECT_EQ(offset, sizeof(split_stats_t));
+    EXPECT_EQ(memcmp(data, expected, sizeof(expected)), 0);
+    EXPECT_EQ(split_stats_read(sizeof(split_stats_t), data, 29), 0);
+    EXPECT_EQ(split_stats_read(0xFF, data, 29), 0);
+}
@@ -0,0 +1,3 @@
+TEST_LIST +=\
+	keymap_compressed\
+	split_stats
@@ -44,7 +44,11 @@
 
 #include "raw_hid.h"
 #include "dynamic_keymap.h"
+#ifdef SPLIT_STATS_ENABLE
+#    include "split_stats.h"
+#endif
 #include "tmk_core/common/eeprom.h"
+#include "tmk_core/common/eeprom_cache.h"
 #include "version.h"  // for QMK_BUILDDATE used in EEPROM magic
 
 // Forward declare some helpers.
@@ -109,14 +113,19 @@ void via_init(void) {
     // If the EEPROM has the magic, the data is good.
     // OK to load from EEPROM.
     if (via_eeprom_is_valid()) {
+        // Mirror the keymaps into RAM now rather than on the first keypress.
+        dynamic_keymap_cache_load();
     } else {
         // This resets the layout options
         via_set_layout_options(VIA_EEPROM_LAYOUT_OPTIONS_DEFAULT);
+        dynamic_keymap_transaction_begin();
         // This resets the keymaps in EEPROM to what is in flash.
         dynamic_keymap_reset();
         // This resets the macros in EEPROM to nothing.
         dynamic_keymap_macro_reset();
+        dynamic_keymap_transaction_commit();
         // Save the magic number last, in case saving was interrupted
+        eeprom_cache_flush();
         via_eeprom_set_valid(true);
     }
 }
@@ -184,6 +193,55 @@ bool process_record_via(uint16_t keycode, keyrecord_t *record) {
     return true;
 }
 
+// Returns the end of the requested macro buffer range, less any trailing zeros.
+static uint16_t via_macro_buffer_trim(uint16_t offset, uint16_t end) {
+    uint8_t value = 0;
+    while (end > offset) {
+        dynamic_keymap_macro_get_buffer(end - 1, 1, &value);
+        if (value != 0) {
+            break;
+        }
+        end--;
+    }
+    return end;
+}
+
+// A write that spans several reports is made as one dynamic keymap transaction,
+// so that the keyboard keeps using the old keymap or macros until the last
+// report is in, and a power loss doesn't leave them half written. That is a
+// bulk set stream, or with the older commands, a keymap buffer written from
+// its start to its end, or a macro buffer write, which VIA Configurator
+// brackets by setting the last byte of the buffer to non-zero and back to zero.
+// A stream that was cut off is dropped by the next command that doesn't
+// continue it, including the start of a new one.
+static uint8_t via_set_stream = id_unhandled;  // Command ID of the open stream
+
+static void via_set_stream_abort(void) {
+    if (via_set_stream != id_unhandled) {
+        dynamic_keymap_transaction_abort();
+        via_set_stream = id_unhandled;
+    }
+}
+
+static void via_set_stream_begin(uint8_t command_id, bool stream_start) {
+    if (stream_start) {
+        via_set_stream_abort();
+    }
+    if (via_set_stream == id_unhandled) {
+        dynamic_keymap_transaction_begin();
+        via_set_stream = command_id;
+    }
+}
+
+static void via_set_stream_end(bool commit) {
+    if (commit) {
+        dynamic_keymap_transaction_commit();
+    } else {
+        dynamic_keymap_transaction_abort();
+    }
+    via_set_stream = id_unhandled;
+}
+
 // Keyboard level code can override this to handle custom messages from VIA.
 // See raw_hid_receive() implementation.
 // DO NOT call raw_hid_send() in the overide function.
@@ -198,10 +256,14 @@ __attribute__((weak)) void raw_hid_receive_kb(uint8_t *data, uint8_t length) {
 // specifically.
 //
 // raw_hid_send() is called at the end, with the same buffer, which was
-// possibly modified with returned values.
+// possibly modified with returned values. Bulk transfers are the exception,
+// bulk gets stream several reports and most bulk sets are not answered.
 void raw_hid_receive(uint8_t *data, uint8_t length) {
     uint8_t *command_id   = &(data[0]);
     uint8_t *command_data = &(data[1]);
+    if (*command_id != via_set_stream) {
+        via_set_stream_abort();
+    }
     switch (*command_id) {
         case id_get_protocol_version: {
             command_data[0] = VIA_PROTOCOL_VERSION >> 8;
@@ -245,6 +307,14 @@ void raw_hid_receive(uint8_t *data, uint8_t length) {
 #endif
                     break;
                 }
+#ifdef SPLIT_STATS_ENABLE
+                case id_split_stats: {
+                    // command_data[1] is the offset into split_stats_t, which is
+                    // larger than a report
+                    split_stats_read(command_data[1], &command_data[2], length - 3);
+                    break;
+                }
+#endif
                 default: {
                     raw_hid_receive_kb(data, length);
                     break;
@@ -347,7 +417,14 @@ void raw_hid_receive(uint8_t *data, uint8_t length) {
         case id_dynamic_keymap_macro_set_buffer: {
             uint16_t offset = (command_data[0] << 8) | command_data[1];
             uint16_t size   = command_data[2];  // size <= 28
+            bool     last   = size > 0 && offset + size == dynamic_keymap_macro_get_buffer_size();
+            if (last && command_data[3 + size - 1] != 0) {
+                via_set_stream_begin(*command_id, true);
+            }
             dynamic_keymap_macro_set_buffer(offset, size, &command_data[3]);
+            if (last && command_data[3 + size - 1] == 0 && via_set_stream == *command_id) {
+                via_set_stream_end(true);
+            }
             break;
         }
         case id_dynamic_keymap_macro_reset: {
@@ -367,7 +444,93 @@ void raw_hid_receive(uint8_t *data, uint8_t length) {
         case id_dynamic_keymap_set_buffer: {
             uint16_t offset = (command_data[0] << 8) | command_data[1];
             uint16_t size   = command_data[2];  // size <= 28
+            if (offset == 0) {
+                via_set_stream_begin(*command_id, true);
+            }
             dynamic_keymap_set_buffer(offset, size, &command_data[3]);
+            if (offset + size >= dynamic_keymap_get_layer_count() * MATRIX_ROWS * MATRIX_COLS * 2 && via_set_stream == *command_id) {
+                via_set_stream_end(true);
+            }
+            break;
+        }
+        case id_dynamic_keymap_get_buffer_bulk: {
+            uint16_t index         = (command_data[0] << 8) | command_data[1];
+            uint16_t end           = index + ((command_data[2] << 8) | command_data[3]);
+            bool     flash_default = command_data[4] == VIA_BULK_KEYMAP_FLASH_DEFAULT;
+            // Send reports back-to-back, the last one is sent below
+            while (true) {
+                command_data[0] = index >> 8;
+                command_data[1] = index & 0xFF;
+                command_data[2] = dynamic_keymap_encode_buffer(&index, end, flash_default, &command_data[3], length - 4);
+                // Stop at the end of the keymap, even if more keys were requested
+                if (index >= end || command_data[2] == 0) {
+                    command_data[2] |= VIA_BULK_LAST;
+                    break;
+                }
+                raw_hid_send(data, length);
+            }
+            break;
+        }
+        case id_dynamic_keymap_set_buffer_bulk: {
+            uint16_t index = (command_data[0] << 8) | command_data[1];
+            uint8_t  flags = command_data[2] & ~VIA_BULK_LENGTH_MASK;
+            uint8_t  size  = command_data[2] & VIA_BULK_LENGTH_MASK;
+            via_set_stream_begin(*command_id, index == 0);
+            if (size > length - 4 || !dynamic_keymap_decode_buffer(&index, &command_data[3], size)) {
+                flags |= VIA_BULK_ERROR;
+            } else if (!(flags & VIA_BULK_LAST)) {
+                // Not the end of the stream, so the host isn't waiting on a reply
+                return;
+            }
+            via_set_stream_end(!(flags & VIA_BULK_ERROR));
+            command_data[0] = index >> 8;
+            command_data[1] = index & 0xFF;
+            command_data[2] = flags;
+            break;
+        }
+        case id_dynamic_keymap_macro_get_buffer_bulk: {
+            uint16_t offset = (command_data[0] << 8) | command_data[1];
+            uint16_t size   = dynamic_keymap_macro_get_buffer_size();
+            uint16_t end    = offset + ((command_data[2] << 8) | command_data[3]);
+            if (end > size) {
+                end = size;
+            }
+            end = via_macro_buffer_trim(offset, end);
+            // Send reports back-to-back, the last one is sent below
+            while (true) {
+                uint8_t chunk = (end > offset) ? ((end - offset < length - 4) ? end - offset : length - 4) : 0;
+                command_data[0] = offset >> 8;
+                command_data[1] = offset & 0xFF;
+                command_data[2] = chunk;
+                dynamic_keymap_macro_get_buffer(offset, chunk, &command_data[3]);
+                offset += chunk;
+                if (offset >= end) {
+                    command_data[2] |= VIA_BULK_LAST;
+                    break;
+                }
+                raw_hid_send(data, length);
+            }
+            break;
+        }
+        case id_dynamic_keymap_macro_set_buffer_bulk: {
+            uint16_t offset = (command_data[0] << 8) | command_data[1];
+            uint8_t  flags  = command_data[2] & ~VIA_BULK_LENGTH_MASK;
+            uint8_t  size   = command_data[2] & VIA_BULK_LENGTH_MASK;
+            via_set_stream_begin(*command_id, offset == 0);
+            if (size > length - 4 || offset + size > dynamic_keymap_macro_get_buffer_size()) {
+                flags |= VIA_BULK_ERROR;
+            } else {
+                dynamic_keymap_macro_set_buffer(offset, size, &command_data[3]);
+                offset += size;
+                if (!(flags & VIA_BULK_LAST)) {
+                    // Not the end of the stream, so the host isn't waiting on a reply
+                    return;
+                }
+            }
+            via_set_stream_end(!(flags & VIA_BULK_ERROR));
+            command_data[0] = offset >> 8;
+            command_data[1] = offset & 0xFF;
+            command_data[2] = flags;
             break;
         }
         case id_eeprom_reset: {
@@ -380,6 +543,7 @@ void raw_hid_receive(uint8_t *data, uint8_t length) {
             raw_hid_send(data, length);
             // Give host time to read it
             wait_ms(100);
+            eeprom_cache_flush();
             bootloader_jump();
             break;
         }
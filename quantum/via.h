@@ -56,6 +56,9 @@
 
 // This is changed only when the command IDs change,
 // so VIA Configurator can detect compatible firmware.
+// The bulk commands are an extension outside of the range VIA Configurator
+// allocates from, so they don't change the version. Hosts probe for them by
+// sending one and checking for an id_unhandled answer.
 #define VIA_PROTOCOL_VERSION 0x0009
 
 enum via_command_id {
@@ -78,13 +81,43 @@ enum via_command_id {
     id_dynamic_keymap_get_layer_count       = 0x11,
     id_dynamic_keymap_get_buffer            = 0x12,
     id_dynamic_keymap_set_buffer            = 0x13,
+    // Not used by VIA Configurator, which counts up from 0x01
+    id_dynamic_keymap_get_buffer_bulk       = 0x40,
+    id_dynamic_keymap_set_buffer_bulk       = 0x41,
+    id_dynamic_keymap_macro_get_buffer_bulk = 0x42,
+    id_dynamic_keymap_macro_set_buffer_bulk = 0x43,
     id_unhandled                            = 0xFF,
 };
 
+// Bulk transfer reports carry a position (key index or macro buffer offset)
+// in command_data[0..1], flags and the payload length in command_data[2],
+// and the payload from command_data[3] on.
+//
+// A bulk get request carries the position in command_data[0..1] and the
+// number of keys/bytes in command_data[2..3], and is answered by a stream of
+// reports, the last of which has VIA_BULK_LAST set. Keymap payloads are
+// encoded as described in dynamic_keymap.h. A keymap get request with
+// command_data[4] set to VIA_BULK_KEYMAP_FLASH_DEFAULT streams the flash
+// keymap instead. A macro stream stops early if the rest of the requested
+// range is all zeros.
+//
+// Bulk set reports are not answered, so the host can send them back-to-back,
+// except for the one with VIA_BULK_LAST set, or one that failed, which is
+// answered with VIA_BULK_ERROR set. The answer carries the position
+// following the data that was written.
+#define VIA_BULK_LAST 0x80
+#define VIA_BULK_ERROR 0x40
+#define VIA_BULK_LENGTH_MASK 0x3F
+
+#define VIA_BULK_KEYMAP_CURRENT 0x00
+#define VIA_BULK_KEYMAP_FLASH_DEFAULT 0x01
+
 enum via_keyboard_value_id {
     id_uptime              = 0x01,  //
     id_layout_options      = 0x02,
-    id_switch_matrix_state = 0x03
+    id_switch_matrix_state = 0x03,
+    // Not used by VIA Configurator, which counts up from 0x01
+    id_split_stats         = 0x80,
 };
 
 enum via_lighting_value {
@@ -169,13 +169,13 @@ TEST_F(KeyPress, PressPlusEqualDontReleaseBeforePress) {
 
     release_key(1, 1);  // KC_PLS
     // BUG: Should really still return KC_EQL, but this is fine too
-    // It's also called twice for some reason
-    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(2);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
     run_one_scan_loop();
     testing::Mock::VerifyAndClearExpectations(&driver);
 
     release_key(0, 1);  // KC_EQL
-    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    // The host already got an empty report
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
     run_one_scan_loop();
     testing::Mock::VerifyAndClearExpectations(&driver);
 }
@@ -232,8 +232,6 @@ TEST_F(KeyPress, PressEqualPlusDontReleaseBeforePress) {
     testing::Mock::VerifyAndClearExpectations(&driver);
 
     release_key(1, 1);  // KC_PLUS
-    // This report is not needed
-    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
     run_one_scan_loop();
     testing::Mock::VerifyAndClearExpectations(&driver);
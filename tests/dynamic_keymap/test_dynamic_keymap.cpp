@@ -0,0 +1,209 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "dynamic_keymap.h"
+#include "tmk_core/common/eeprom.h"
+#include "tmk_core/common/test/eeprom_test.h"
+}
+
+using testing::_;
+using testing::AnyNumber;
+
+class DynamicKeymap : public TestFixture {
+   public:
+    void SetUp() override { dynamic_keymap_reset(); }
+
+    // Taps a key and returns the number of EEPROM bytes read while doing so
+    uint32_t eeprom_reads_for_tap(uint8_t col, uint8_t row) {
+        eeprom_test_reset_stats();
+        press_key(col, row);
+        keyboard_task();
+        release_key(col, row);
+        keyboard_task();
+        return eeprom_test_get_stats().reads;
+    }
+};
+
+TEST_F(DynamicKeymap, KeypressOnCachedLayerDoesNotReadEeprom) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_EQ(eeprom_reads_for_tap(0, 0), 0);
+}
+
+TEST_F(DynamicKeymap, KeypressOnUncachedLayerReadsEeprom) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    press_key(2, 0);
+    keyboard_task();
+    // Two bytes per lookup, and the press and release both look up the key
+    EXPECT_GE(eeprom_reads_for_tap(0, 0), 4);
+    release_key(2, 0);
+    keyboard_task();
+}
+
+TEST_F(DynamicKeymap, SetKeycodeUpdatesCacheAndEeprom) {
+    dynamic_keymap_set_keycode(0, 0, 0, KC_Z);
+    dynamic_keymap_set_keycode(2, 0, 0, KC_Y);
+    keypos_t key = {.col = 0, .row = 0};
+    EXPECT_EQ(keymap_key_to_keycode(0, key), KC_Z);
+    EXPECT_EQ(keymap_key_to_keycode(2, key), KC_Y);
+
+    dynamic_keymap_cache_load();
+    EXPECT_EQ(keymap_key_to_keycode(0, key), KC_Z);
+
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Z)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    eeprom_reads_for_tap(0, 0);
+}
+
+TEST_F(DynamicKeymap, SetBufferUpdatesCache) {
+    // Write a keycode split over two transfers, starting on an odd offset
+    uint16_t offset = (MATRIX_ROWS * MATRIX_COLS + 3) * 2;
+    uint8_t  high   = LCTL(KC_X) >> 8;
+    uint8_t  low    = LCTL(KC_X) & 0xFF;
+    uint8_t  first[3] = {0x00, KC_W, high};
+    dynamic_keymap_set_buffer(offset - 2, sizeof(first), first);
+    dynamic_keymap_set_buffer(offset + 1, 1, &low);
+
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 0, 2), KC_W);
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 0, 3), LCTL(KC_X));
+
+    uint8_t cached[4];
+    dynamic_keymap_get_buffer(offset - 2, sizeof(cached), cached);
+    dynamic_keymap_cache_load();
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 0, 3), LCTL(KC_X));
+    uint8_t expected[4] = {0x00, KC_W, high, low};
+    for (uint8_t i = 0; i < sizeof(expected); i++) {
+        EXPECT_EQ(cached[i], expected[i]);
+    }
+}
+
+TEST_F(DynamicKeymap, ResetRestoresDefaultKeymap) {
+    dynamic_keymap_set_keycode(0, 0, 0, KC_Z);
+    dynamic_keymap_reset();
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_A);
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 0, 0), KC_B);
+    EXPECT_EQ(dynamic_keymap_get_keycode(2, 0, 0), KC_C);
+}
+
+TEST_F(DynamicKeymap, MacroIsSentOneCharacterPerScan) {
+    uint8_t macros[] = {'a', 'b', 0, 'c', 'd', 0};
+    dynamic_keymap_macro_set_buffer(0, sizeof(macros), macros);
+
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    dynamic_keymap_macro_send(1);
+    EXPECT_TRUE(dynamic_keymap_macro_is_sending());
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_D)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    keyboard_task();
+    EXPECT_FALSE(dynamic_keymap_macro_is_sending());
+}
+
+TEST_F(DynamicKeymap, MacroLookupDoesNotRescanBuffer) {
+    // Fill all but the last macro with long strings
+    uint8_t macros[15 * 40 + 2];
+    for (uint16_t i = 0; i < 15 * 40; i++) {
+        macros[i] = (i % 40 == 39) ? 0 : 'a';
+    }
+    macros[15 * 40]     = 'z';
+    macros[15 * 40 + 1] = 0;
+    dynamic_keymap_macro_set_buffer(0, sizeof(macros), macros);
+
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Z))).Times(2);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(2);
+
+    dynamic_keymap_macro_send(15);
+    eeprom_test_reset_stats();
+    while (dynamic_keymap_macro_is_sending()) {
+        keyboard_task();
+    }
+    EXPECT_GT(eeprom_test_get_stats().reads, sizeof(macros));
+
+    // The second time only the body is read
+    dynamic_keymap_macro_send(15);
+    eeprom_test_reset_stats();
+    while (dynamic_keymap_macro_is_sending()) {
+        keyboard_task();
+    }
+    EXPECT_LE(eeprom_test_get_stats().reads, 16);
+}
+
+TEST_F(DynamicKeymap, KeysWaitUntilMacroIsSent) {
+    uint8_t macros[] = {'b', 'c', 0};
+    dynamic_keymap_macro_set_buffer(0, sizeof(macros), macros);
+
+    TestDriver driver;
+    testing::InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+
+    dynamic_keymap_macro_send(0);
+    press_key(0, 0);
+    keyboard_task();
+    keyboard_task();
+    keyboard_task();
+    keyboard_task();
+    EXPECT_FALSE(dynamic_keymap_macro_is_sending());
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release_key(0, 0);
+    keyboard_task();
+}
+
+TEST_F(DynamicKeymap, MacroStopsAtEndOfBuffer) {
+    // Macros 0 to 14 are empty, macro 15 fills the rest of the buffer
+    const uint16_t size = dynamic_keymap_macro_get_buffer_size();
+    for (uint16_t i = 0; i < size; i++) {
+        uint8_t value = (i < 15 || i == size - 1) ? 0 : 'a';
+        dynamic_keymap_macro_set_buffer(i, 1, &value);
+    }
+
+    testing::NiceMock<TestDriver> driver;
+    dynamic_keymap_macro_send(15);
+    keyboard_task();
+    EXPECT_TRUE(dynamic_keymap_macro_is_sending());
+
+    // Lose the terminator without the macro module noticing
+    uint16_t macro_addr = DYNAMIC_KEYMAP_EEPROM_ADDR + DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
+    eeprom_update_byte((uint8_t *)(uintptr_t)(macro_addr + size - 1), 'a');
+
+    for (uint16_t i = 15; i <= size && dynamic_keymap_macro_is_sending(); i++) {
+        keyboard_task();
+    }
+    EXPECT_FALSE(dynamic_keymap_macro_is_sending());
+}
@@ -0,0 +1,27 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#define MATRIX_ROWS 2
+#define MATRIX_COLS 4
+
+#define DYNAMIC_KEYMAP_LAYER_COUNT 2
+#define DYNAMIC_KEYMAP_CACHE_LAYERS 1
+#define DYNAMIC_KEYMAP_TRANSACTIONS
+#define DYNAMIC_KEYMAP_EEPROM_ADDR 64
+// Room for two slots of 32 bytes of keymaps and 100 bytes of macros
+#define DYNAMIC_KEYMAP_EEPROM_MAX_ADDR (64 + 1 + 2 * (32 + 100) - 1)
@@ -0,0 +1,200 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "dynamic_keymap.h"
+#include "tmk_core/common/test/eeprom_test.h"
+}
+
+#include <vector>
+
+using testing::_;
+using testing::AnyNumber;
+
+#define KEYMAP_SIZE (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2)
+
+class DynamicKeymapTransaction : public TestFixture {
+   public:
+    void SetUp() override {
+        reboot();
+        dynamic_keymap_transaction_begin();
+        dynamic_keymap_reset();
+        dynamic_keymap_macro_reset();
+        dynamic_keymap_transaction_commit();
+    }
+
+    void TearDown() override { eeprom_test_cut_power_after(-1); }
+
+    // Drops everything dynamic_keymap holds in RAM, and restores the power
+    void reboot() {
+        eeprom_test_cut_power_after(-1);
+        dynamic_keymap_cache_load();
+    }
+
+    std::vector<uint8_t> keymap() {
+        std::vector<uint8_t> data(KEYMAP_SIZE);
+        dynamic_keymap_get_buffer(0, data.size(), data.data());
+        return data;
+    }
+
+    std::vector<uint8_t> macros() {
+        std::vector<uint8_t> data(dynamic_keymap_macro_get_buffer_size());
+        dynamic_keymap_macro_get_buffer(0, data.size(), data.data());
+        return data;
+    }
+};
+
+TEST_F(DynamicKeymapTransaction, WritesAreInvisibleUntilCommit) {
+    dynamic_keymap_transaction_begin();
+    dynamic_keymap_set_keycode(0, 0, 0, KC_Z);
+    dynamic_keymap_set_keycode(1, 0, 0, KC_Y);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_A);
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 0, 0), KC_1);
+
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    press_key(0, 0);
+    keyboard_task();
+    release_key(0, 0);
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    dynamic_keymap_transaction_commit();
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_Z);
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 0, 0), KC_Y);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Z)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    press_key(0, 0);
+    keyboard_task();
+    release_key(0, 0);
+    keyboard_task();
+}
+
+TEST_F(DynamicKeymapTransaction, AbortDropsWrites) {
+    dynamic_keymap_transaction_begin();
+    dynamic_keymap_set_keycode(0, 0, 0, KC_Z);
+    dynamic_keymap_transaction_abort();
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_A);
+
+    // The dropped write must not come back with the next commit
+    dynamic_keymap_set_keycode(0, 0, 1, KC_Y);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_A);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 1), KC_Y);
+    reboot();
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_A);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 1), KC_Y);
+}
+
+TEST_F(DynamicKeymapTransaction, WriteOutsideTransactionOnlyWritesWhatChanged) {
+    dynamic_keymap_set_keycode(1, 1, 3, KC_Z);
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 1, 3), KC_Z);
+
+    // Two bytes to catch the staging slot up with the previous write, two for
+    // the keycode and one to switch slots
+    EepromTraffic traffic;
+    dynamic_keymap_set_keycode(1, 1, 2, KC_Y);
+    EXPECT_LE(traffic.writes(), 5u);
+    EXPECT_EQ(traffic.writes_at(DYNAMIC_KEYMAP_EEPROM_ADDR), 1u);
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 1, 3), KC_Z);
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 1, 2), KC_Y);
+}
+
+TEST_F(DynamicKeymapTransaction, MacrosAreSwitchedOnCommit) {
+    uint8_t old_macros[] = {'a', 0};
+    dynamic_keymap_macro_set_buffer(0, sizeof(old_macros), old_macros);
+
+    uint8_t new_macros[] = {'b', 0};
+    dynamic_keymap_transaction_begin();
+    dynamic_keymap_macro_set_buffer(0, sizeof(new_macros), new_macros);
+
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    dynamic_keymap_macro_send(0);
+    while (dynamic_keymap_macro_is_sending()) {
+        keyboard_task();
+    }
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    dynamic_keymap_transaction_commit();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    dynamic_keymap_macro_send(0);
+    while (dynamic_keymap_macro_is_sending()) {
+        keyboard_task();
+    }
+}
+
+TEST_F(DynamicKeymapTransaction, PowerLossAtAnyWriteKeepsOldOrNewState) {
+    std::vector<uint8_t> new_keymap(KEYMAP_SIZE);
+    for (uint16_t i = 0; i < new_keymap.size(); i++) {
+        new_keymap[i] = (i & 1) ? KC_Q + i / 2 : 0;
+    }
+    uint8_t new_macros[] = {'n', 'e', 'w', 0, 'm', 0};
+
+    auto upload = [&]() {
+        dynamic_keymap_transaction_begin();
+        dynamic_keymap_set_buffer(0, new_keymap.size(), new_keymap.data());
+        dynamic_keymap_macro_set_buffer(0, sizeof(new_macros), new_macros);
+        dynamic_keymap_transaction_commit();
+    };
+    auto restore = [&]() {
+        reboot();
+        eeprom_test_erase();
+        SetUp();
+        // Start from an unknown staging slot, as after a real reset
+        reboot();
+    };
+
+    restore();
+    std::vector<uint8_t> old_keymap = keymap();
+    std::vector<uint8_t> old_macros = macros();
+    std::vector<uint8_t> expected_macros(old_macros.size());
+    std::copy(new_macros, new_macros + sizeof(new_macros), expected_macros.begin());
+
+    eeprom_test_reset_stats();
+    upload();
+    uint32_t writes = eeprom_test_get_stats().writes;
+    ASSERT_EQ(keymap(), new_keymap);
+    ASSERT_EQ(macros(), expected_macros);
+
+    uint32_t kept_old = 0;
+    for (uint32_t cut = 0; cut <= writes; cut++) {
+        restore();
+        eeprom_test_cut_power_after(cut);
+        upload();
+        reboot();
+
+        bool is_old = keymap() == old_keymap && macros() == old_macros;
+        bool is_new = keymap() == new_keymap && macros() == expected_macros;
+        EXPECT_TRUE(is_old || is_new) << "power lost after " << cut << " of " << writes << " writes";
+        if (cut == writes) {
+            EXPECT_TRUE(is_new);
+        }
+        kept_old += is_old;
+
+        // The next upload has to go through in full
+        upload();
+        EXPECT_EQ(keymap(), new_keymap) << "retry after power lost after " << cut << " writes";
+        EXPECT_EQ(macros(), expected_macros) << "retry after power lost after " << cut << " writes";
+    }
+    // Only the final write, to the commit byte, switches over
+    EXPECT_EQ(kept_old, writes);
+}
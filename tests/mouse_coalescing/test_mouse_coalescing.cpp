@@ -0,0 +1,172 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "pointing_device.h"
+}
+
+#include <vector>
+
+using testing::_;
+using testing::Invoke;
+
+class MouseCoalescing : public TestFixture {
+   public:
+    MouseCoalescing() {
+        ON_CALL(driver, send_mouse_mock(_)).WillByDefault(Invoke([this](report_mouse_t& report) { reports.push_back(report); }));
+        EXPECT_CALL(driver, send_mouse_mock(_)).Times(testing::AnyNumber());
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(testing::AnyNumber());
+        // so that the first report can go straight away
+        idle_for(MOUSE_REPORT_INTERVAL_MS);
+    }
+
+    ~MouseCoalescing() { pointing_device_set_report({}); }
+
+    // Makes the pointing device report motion and buttons in the next scan
+    void point(int8_t x, uint8_t buttons = 0) {
+        report_mouse_t report = pointing_device_get_report();
+        report.x              = x;
+        report.buttons        = buttons;
+        pointing_device_set_report(report);
+    }
+
+    int sent_x() {
+        int x = 0;
+        for (auto& report : reports) {
+            x += report.x;
+        }
+        return x;
+    }
+
+    TestDriver                  driver;
+    std::vector<report_mouse_t> reports;
+};
+
+TEST_F(MouseCoalescing, MergesSources) {
+    point(10, MOUSE_BTN2);
+    press_key(0, 0);
+    run_one_scan_loop();
+    ASSERT_EQ(reports.size(), 1u);
+    EXPECT_EQ(reports[0].buttons, MOUSE_BTN1 | MOUSE_BTN2);
+    EXPECT_EQ(reports[0].x, 10);
+
+    release_key(0, 0);
+    point(0);
+    idle_for(MOUSE_REPORT_INTERVAL_MS);
+    ASSERT_EQ(reports.size(), 2u);
+    EXPECT_EQ(reports[1].buttons, 0);
+}
+
+TEST_F(MouseCoalescing, SendsOnceAnInterval) {
+    for (int i = 0; i < 4 * MOUSE_REPORT_INTERVAL_MS; i++) {
+        point(10);
+        run_one_scan_loop();
+    }
+    idle_for(MOUSE_REPORT_INTERVAL_MS);
+    EXPECT_LE(reports.size(), 5u);
+    EXPECT_EQ(sent_x(), 40 * MOUSE_REPORT_INTERVAL_MS);
+}
+
+TEST_F(MouseCoalescing, KeepsMotionThatDoesNotFit) {
+    for (int i = 0; i < 4; i++) {
+        point(100);
+        run_one_scan_loop();
+    }
+    idle_for(4 * MOUSE_REPORT_INTERVAL_MS);
+    EXPECT_EQ(sent_x(), 400);
+    for (auto& report : reports) {
+        EXPECT_LE(report.x, 127);
+    }
+}
+
+TEST_F(MouseCoalescing, KeepsQuickClicks) {
+    point(1);
+    run_one_scan_loop();
+    reports.clear();
+
+    press_key(0, 0);
+    run_one_scan_loop();
+    release_key(0, 0);
+    run_one_scan_loop();
+    idle_for(MOUSE_REPORT_INTERVAL_MS);
+    ASSERT_EQ(reports.size(), 2u);
+    EXPECT_EQ(reports[0].buttons, MOUSE_BTN1);
+    EXPECT_EQ(reports[1].buttons, 0);
+}
+
+TEST_F(MouseCoalescing, SendsMotionBeforeClick) {
+    point(1);
+    run_one_scan_loop();
+    reports.clear();
+
+    point(10);
+    run_one_scan_loop();
+    point(0);
+    press_key(0, 0);
+    run_one_scan_loop();
+    release_key(0, 0);
+    idle_for(2 * MOUSE_REPORT_INTERVAL_MS);
+
+    ASSERT_EQ(reports.size(), 3u);
+    EXPECT_EQ(reports[0].x, 10);
+    EXPECT_EQ(reports[0].buttons, 0);
+    EXPECT_EQ(reports[1].x, 0);
+    EXPECT_EQ(reports[1].buttons, MOUSE_BTN1);
+    EXPECT_EQ(reports[2].buttons, 0);
+}
+
+TEST_F(MouseCoalescing, KeepsButtonsOfOtherSources) {
+    point(0, MOUSE_BTN2);
+    run_one_scan_loop();
+    press_key(1, 0);
+    idle_for(MOUSE_REPORT_INTERVAL_MS);
+    release_key(1, 0);
+    idle_for(MOUSE_REPORT_INTERVAL_MS);
+
+    ASSERT_EQ(reports.size(), 3u);
+    EXPECT_EQ(reports[0].buttons, MOUSE_BTN2);
+    EXPECT_EQ(reports[1].buttons, MOUSE_BTN2 | MOUSE_BTN3);
+    EXPECT_EQ(reports[2].buttons, MOUSE_BTN2);
+
+    point(0);
+    idle_for(MOUSE_REPORT_INTERVAL_MS);
+}
+
+TEST_F(MouseCoalescing, KeepsMotionWhileDriverIsBusy) {
+    point(1);
+    run_one_scan_loop();
+    reports.clear();
+
+    driver.set_mouse_ready(false);
+    point(100);
+    run_one_scan_loop();
+    point(0);
+    idle_for(2 * MOUSE_REPORT_INTERVAL_MS);
+    // a click waits for the motion before it, which isn't sent either
+    press_key(0, 0);
+    run_one_scan_loop();
+    EXPECT_EQ(reports.size(), 0u);
+
+    driver.set_mouse_ready(true);
+    release_key(0, 0);
+    idle_for(2 * MOUSE_REPORT_INTERVAL_MS);
+    ASSERT_EQ(reports.size(), 2u);
+    EXPECT_EQ(reports[0].x, 100);
+    EXPECT_EQ(reports[0].buttons, MOUSE_BTN1);
+    EXPECT_EQ(reports[1].buttons, 0);
+}
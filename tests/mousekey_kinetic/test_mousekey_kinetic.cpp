@@ -0,0 +1,125 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "mousekey.h"
+void advance_time(uint32_t ms);
+}
+
+#include <vector>
+
+using testing::_;
+using testing::Invoke;
+
+class MousekeyKinetic : public TestFixture {
+   public:
+    MousekeyKinetic() {
+        ON_CALL(driver, send_mouse_mock(_)).WillByDefault(Invoke([this](report_mouse_t& report) { reports.push_back(report); }));
+        EXPECT_CALL(driver, send_mouse_mock(_)).Times(testing::AnyNumber());
+    }
+
+    // Holds the keys for the given time, running a scan every interval ms
+    void hold(std::vector<uint8_t> cols, uint16_t time, uint16_t interval = 1) {
+        for (uint8_t col : cols) {
+            press_key(col, 0);
+        }
+        keyboard_task();
+        for (uint16_t t = 0; t < time; t += interval) {
+            advance_time(interval);
+            keyboard_task();
+        }
+        for (uint8_t col : cols) {
+            release_key(col, 0);
+        }
+        keyboard_task();
+    }
+
+    int sent(int8_t report_mouse_t::*axis) {
+        int total = 0;
+        for (auto& report : reports) {
+            total += report.*axis;
+        }
+        return total;
+    }
+
+    TestDriver                  driver;
+    std::vector<report_mouse_t> reports;
+};
+
+TEST_F(MousekeyKinetic, DistanceDoesNotDependOnScanRate) {
+    hold({0}, 600);
+    int x = sent(&report_mouse_t::x);
+    // 1 pixel on the press, then 100 px/s up to 1000 px/s after a second
+    EXPECT_NEAR(x, 1 + 60 + 162, 2);
+
+    for (uint16_t interval : {3, 8, 20, 100}) {
+        reports.clear();
+        hold({0}, 600, interval);
+        EXPECT_EQ(sent(&report_mouse_t::x), x) << "scanning every " << interval << " ms";
+        for (auto& report : reports) {
+            EXPECT_EQ(report.y, 0);
+        }
+    }
+}
+
+TEST_F(MousekeyKinetic, MovesLessThanAPixelPerReport) {
+    hold({0}, 40);
+    EXPECT_EQ(reports[0].x, 1);
+    // 4.7 pixels at a little over 100 px/s, rather than one for each of the
+    // five reports that could have been sent
+    EXPECT_EQ(sent(&report_mouse_t::x), 1 + 4);
+    for (auto& report : reports) {
+        EXPECT_LE(report.x, 1);
+    }
+}
+
+TEST_F(MousekeyKinetic, DiagonalIsSlowerOnEachAxis) {
+    hold({0}, 600);
+    int straight = sent(&report_mouse_t::x);
+
+    reports.clear();
+    hold({0, 1}, 600);
+    EXPECT_EQ(sent(&report_mouse_t::x), sent(&report_mouse_t::y));
+    EXPECT_NEAR(sent(&report_mouse_t::x), 1 + (straight - 1) * 0.7071, 1);
+}
+
+TEST_F(MousekeyKinetic, AccelKeyMovesAtFixedSpeed) {
+    press_key(3, 0);
+    keyboard_task();
+    hold({0}, 100);
+    release_key(3, 0);
+    keyboard_task();
+    EXPECT_EQ(sent(&report_mouse_t::x), 1 + MK_KINETIC_MAX_SPEED / 10);
+}
+
+TEST_F(MousekeyKinetic, WheelScrollsPartSteps) {
+    hold({2}, 1000, 7);
+    // 10 steps/s, up to 80 steps/s after four seconds
+    EXPECT_NEAR(sent(&report_mouse_t::v), -(1 + 10 + 9), 1);
+    for (auto& report : reports) {
+        EXPECT_LE(report.v, 0);
+        EXPECT_EQ(report.x, 0);
+    }
+}
+
+TEST_F(MousekeyKinetic, StopsOnRelease) {
+    hold({0}, 100);
+    size_t count = reports.size();
+    idle_for(100);
+    EXPECT_EQ(reports.size(), count);
+}
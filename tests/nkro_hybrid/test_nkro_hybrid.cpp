@@ -0,0 +1,141 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::InSequence;
+
+class NkroHybrid : public TestFixture {
+   public:
+    // Presses the first keys of A to G, one report each
+    void press_keys(uint8_t count) {
+        for (uint8_t i = 0; i < count; i++) {
+            press_key(i % MATRIX_COLS, i / MATRIX_COLS);
+            run_one_scan_loop();
+        }
+    }
+
+    void release_keys(uint8_t count) {
+        for (uint8_t i = 0; i < count; i++) {
+            release_key(i % MATRIX_COLS, i / MATRIX_COLS);
+            run_one_scan_loop();
+        }
+    }
+};
+
+TEST_F(NkroHybrid, UpToSixKeysUseTheBootReport) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_nkro_mock(_)).Times(0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_C, KC_D)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_C, KC_D, KC_E)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_C, KC_D, KC_E, KC_F)));
+    press_keys(6);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(6);
+    release_keys(6);
+}
+
+TEST_F(NkroHybrid, SeventhKeySwitchesToNkroAndBack) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(6);
+    press_keys(6);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    {
+        InSequence s;
+        EXPECT_CALL(driver, send_nkro_mock(NkroReport(KC_A, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    }
+    press_key(2, 1);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    {
+        InSequence s;
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B, KC_C, KC_D, KC_E, KC_F, KC_G)));
+        EXPECT_CALL(driver, send_nkro_mock(NkroReport()));
+    }
+    release_key(0, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_nkro_mock(_)).Times(0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(6);
+    release_key(2, 1);
+    run_one_scan_loop();
+    for (uint8_t i = 1; i < 6; i++) {
+        release_key(i % MATRIX_COLS, i / MATRIX_COLS);
+        run_one_scan_loop();
+    }
+}
+
+TEST_F(NkroHybrid, ModsGoWithTheKeys) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(7);
+    press_key(3, 1);
+    run_one_scan_loop();
+    press_keys(6);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    {
+        InSequence s;
+        EXPECT_CALL(driver, send_nkro_mock(NkroReport(KC_LSFT, KC_A, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+        EXPECT_CALL(driver, send_nkro_mock(NkroReport(KC_A, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G)));
+    }
+    press_key(2, 1);
+    run_one_scan_loop();
+    release_key(3, 1);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    {
+        InSequence s;
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_C, KC_D, KC_E, KC_F)));
+        EXPECT_CALL(driver, send_nkro_mock(NkroReport()));
+    }
+    release_key(2, 1);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(6);
+    release_keys(6);
+}
+
+TEST_F(NkroHybrid, BootProtocolKeepsSixKeys) {
+    TestDriver driver;
+    keyboard_protocol = 0;
+    EXPECT_CALL(driver, send_nkro_mock(_)).Times(0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(6);
+    press_keys(6);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    press_key(2, 1);
+    run_one_scan_loop();
+    release_key(2, 1);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(6);
+    release_keys(6);
+    keyboard_protocol = 1;
+}
@@ -0,0 +1,196 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "suspend.h"
+#include "power_state.h"
+}
+
+#include <string>
+
+using testing::NiceMock;
+
+namespace {
+std::string calls;
+
+void lights_off(void) { calls += "lights off, "; }
+void lights_on(void) { calls += "lights on, "; }
+void keys_off(void) { calls += "keys off, "; }
+void keys_on(void) { calls += "keys on, "; }
+void user_off(void) { calls += "user off, "; }
+
+power_callbacks_t lights = {.suspend = lights_off, .resume = lights_on, .priority = POWER_PRIORITY_LIGHTING};
+power_callbacks_t keys   = {.suspend = keys_off, .resume = keys_on, .priority = POWER_PRIORITY_KEYBOARD};
+power_callbacks_t user   = {.suspend = user_off, .resume = nullptr, .priority = POWER_PRIORITY_USER};
+}  // namespace
+
+class PowerState : public TestFixture {
+   public:
+    void SetUp() override {
+        power_state_register(&lights);
+        power_state_register(&user);
+        power_state_register(&keys);
+        calls.clear();
+    }
+
+    void TearDown() override {
+        // Leaves the keyboard awake for the next test
+        NiceMock<TestDriver> driver;
+        suspend_wakeup_init();
+    }
+
+    // What the protocol does while the host is asleep
+    bool sleep() {
+        suspend_power_down();
+        return suspend_wakeup_condition();
+    }
+};
+
+TEST_F(PowerState, CallbacksRunOnceInPriorityOrder) {
+    NiceMock<TestDriver> driver;
+    power_state_register(&lights);
+    EXPECT_EQ(power_state_get(), POWER_STATE_ACTIVE);
+
+    sleep();
+    sleep();
+    EXPECT_EQ(power_state_get(), POWER_STATE_SUSPENDED);
+    EXPECT_EQ(calls, "user off, lights off, keys off, ");
+
+    calls.clear();
+    suspend_wakeup_init();
+    suspend_wakeup_init();
+    // not from the USB interrupt, but from the next keyboard task
+    EXPECT_EQ(calls, "");
+    run_one_scan_loop();
+    run_one_scan_loop();
+    EXPECT_EQ(power_state_get(), POWER_STATE_ACTIVE);
+    EXPECT_EQ(calls, "keys on, lights on, ");
+}
+
+TEST_F(PowerState, SuspendingBeforeResumingCallsNothing) {
+    NiceMock<TestDriver> driver;
+
+    sleep();
+    calls.clear();
+    suspend_wakeup_init();
+    sleep();
+    run_one_scan_loop();
+    EXPECT_EQ(power_state_get(), POWER_STATE_SUSPENDED);
+    EXPECT_EQ(calls, "");
+
+    suspend_wakeup_init();
+    run_one_scan_loop();
+    EXPECT_EQ(calls, "keys on, lights on, ");
+}
+
+TEST_F(PowerState, KeyTappedWhileTheHostWakesUpIsReplayed) {
+    NiceMock<TestDriver> driver;
+    ReportRecorder       recorder;
+
+    EXPECT_FALSE(sleep());
+    press_key(0, 0);
+    EXPECT_TRUE(sleep());
+    release_key(0, 0);
+    EXPECT_FALSE(sleep());
+
+    // Still asleep, so nothing is sent yet
+    idle_for(5);
+    EXPECT_EQ(recorder.dump(false), "");
+
+    // Waking up clears the keyboard first
+    suspend_wakeup_init();
+    idle_for(5);
+    EXPECT_EQ(recorder.dump(false),
+              "keyboard mods 0x0 keys\n"
+              "keyboard mods 0x0 keys 4\n"
+              "keyboard mods 0x0 keys\n");
+}
+
+TEST_F(PowerState, KeysAreReplayedInOrder) {
+    NiceMock<TestDriver> driver;
+    ReportRecorder       recorder;
+
+    sleep();
+    press_key(1, 0);
+    sleep();
+    press_key(0, 0);
+    sleep();
+    release_key(1, 0);
+    sleep();
+    release_key(0, 0);
+    sleep();
+    press_key(2, 0);
+    sleep();
+
+    suspend_wakeup_init();
+    idle_for(5);
+    EXPECT_EQ(recorder.dump(false),
+              "keyboard mods 0x0 keys\n"
+              "keyboard mods 0x0 keys 5\n"
+              "keyboard mods 0x0 keys 4 5\n"
+              "keyboard mods 0x0 keys 4\n"
+              "keyboard mods 0x0 keys\n"
+              "keyboard mods 0x0 keys 6\n");
+
+    release_key(2, 0);
+    idle_for(1);
+    EXPECT_EQ(recorder.reports().size(), 7u);
+}
+
+TEST_F(PowerState, KeyHeldThroughTheWakeUpIsReportedOnce) {
+    NiceMock<TestDriver> driver;
+    ReportRecorder       recorder;
+
+    sleep();
+    press_key(3, 0);
+    EXPECT_TRUE(sleep());
+    suspend_wakeup_init();
+    idle_for(5);
+    release_key(3, 0);
+    idle_for(5);
+    EXPECT_EQ(recorder.dump(false),
+              "keyboard mods 0x0 keys\n"
+              "keyboard mods 0x0 keys 7\n"
+              "keyboard mods 0x0 keys\n");
+}
+
+TEST_F(PowerState, KeyHeldWhenSuspendingIsReleasedAfterWakingUp) {
+    NiceMock<TestDriver> driver;
+
+    press_key(0, 0);
+    idle_for(5);
+    ReportRecorder recorder;
+    EXPECT_TRUE(sleep());
+    release_key(0, 0);
+    EXPECT_FALSE(sleep());
+    suspend_wakeup_init();
+    idle_for(5);
+    EXPECT_EQ(recorder.dump(false), "keyboard mods 0x0 keys\n");
+}
+
+TEST_F(PowerState, ScanningWhileAwakeReplaysNothing) {
+    NiceMock<TestDriver> driver;
+    ReportRecorder       recorder;
+
+    press_key(0, 0);
+    EXPECT_TRUE(suspend_wakeup_condition());
+    release_key(0, 0);
+    EXPECT_FALSE(suspend_wakeup_condition());
+    idle_for(5);
+    EXPECT_EQ(recorder.reports().size(), 0u);
+}
@@ -0,0 +1,81 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "ps2.h"
+#include "ps2_mouse.h"
+}
+
+#include <deque>
+#include <vector>
+
+using testing::_;
+using testing::Invoke;
+
+// Plays the part of the PS/2 mouse, which answers every read with a packet
+static std::deque<uint8_t> ps2_bytes;
+
+extern "C" {
+uint8_t ps2_error = PS2_ERR_NONE;
+
+void ps2_host_init(void) {}
+
+uint8_t ps2_host_send(uint8_t data) { return PS2_ACK; }
+
+uint8_t ps2_host_recv_response(void) {
+    if (ps2_bytes.empty()) {
+        return 0;
+    }
+    uint8_t byte = ps2_bytes.front();
+    ps2_bytes.pop_front();
+    return byte;
+}
+}
+
+class Ps2Mouse : public TestFixture {
+   public:
+    Ps2Mouse() {
+        ON_CALL(driver, send_mouse_mock(_)).WillByDefault(Invoke([this](report_mouse_t& report) { reports.push_back(report); }));
+        EXPECT_CALL(driver, send_mouse_mock(_)).Times(testing::AnyNumber());
+        idle_for(MOUSE_REPORT_INTERVAL_MS);
+    }
+
+    // Makes the mouse report buttons, without motion, in the next scan
+    void packet(uint8_t buttons) {
+        ps2_bytes.push_back((1 << 3) | buttons);
+        ps2_bytes.push_back(0);
+        ps2_bytes.push_back(0);
+    }
+
+    TestDriver                  driver;
+    std::vector<report_mouse_t> reports;
+};
+
+TEST_F(Ps2Mouse, ShortMiddleButtonTapIsClicked) {
+    packet(1 << PS2_MOUSE_BTN_MIDDLE);
+    run_one_scan_loop();
+    // pressed alone, the scroll button waits to see whether it's held to scroll
+    EXPECT_TRUE(reports.empty());
+
+    packet(0);
+    run_one_scan_loop();
+    idle_for(2 * MOUSE_REPORT_INTERVAL_MS);
+    ASSERT_EQ(reports.size(), 2u);
+    EXPECT_EQ(reports[0].buttons, MOUSE_BTN3);
+    EXPECT_EQ(reports[1].buttons, 0);
+}
@@ -0,0 +1,49 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+enum custom_keycodes {
+    SEND_HI = SAFE_RANGE,
+    WAIT_AB,
+};
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] =
+        {
+            {KC_A, KC_B, KC_LSFT, SEND_HI},
+            {KC_C, KC_LCTL, KC_PLUS, WAIT_AB},
+        },
+};
+
+bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    if (!record->event.pressed) {
+        return true;
+    }
+    switch (keycode) {
+        case SEND_HI:
+            send_string("Hi");
+            return false;
+        case WAIT_AB:
+            register_code(KC_A);
+            wait_ms(5);
+            register_code(KC_B);
+            unregister_code(KC_B);
+            unregister_code(KC_A);
+            return false;
+    }
+    return true;
+}
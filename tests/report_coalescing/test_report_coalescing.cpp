@@ -0,0 +1,121 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::InSequence;
+
+class ReportCoalescing : public TestFixture {};
+
+TEST_F(ReportCoalescing, KeysPressedInOneScanAreSentTogether) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(0, 0);
+    press_key(1, 0);
+    press_key(0, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_C)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(0, 0);
+    release_key(1, 0);
+    release_key(0, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(ReportCoalescing, KeyPressesAreNotSentWithModifierChanges) {
+    TestDriver driver;
+    InSequence s;
+
+    // KC_A is scanned before KC_LSFT, so it mustn't be shifted
+    press_key(0, 0);
+    press_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_LSFT)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(0, 0);
+    release_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // KC_LCTL is scanned before KC_PLUS, and both are sent before the key
+    press_key(1, 1);
+    press_key(2, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_LSFT, KC_EQL)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(1, 1);
+    release_key(2, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(ReportCoalescing, TapsAreNotMerged) {
+    TestDriver driver;
+    InSequence s;
+
+    // Each character needs the key pressed and released, without the shift
+    // of "H" over the "i". Sending each change on its own takes six reports.
+    press_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_H)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_I)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+}
+
+TEST_F(ReportCoalescing, ReportsAreNotHeldIntoTheNextMillisecond) {
+    TestDriver driver;
+    InSequence s;
+
+    // KC_A is pressed 5 ms before KC_B, then both are released at once
+    press_key(3, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(3, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+}
+
+TEST_F(ReportCoalescing, ClearingTheKeyboardIsAlwaysSent) {
+    TestDriver driver;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    clear_keyboard();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    send_keyboard_report();
+    flush_keyboard_report();
+}
@@ -0,0 +1,40 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+enum custom_keycodes {
+    SEND_HI = SAFE_RANGE,
+};
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] =
+        {
+            {KC_A, KC_B, LSFT_T(KC_C), SEND_HI, KC_VOLU, KC_D, KC_E, KC_BTN1},
+        },
+};
+
+const uint16_t PROGMEM de_combo[] = {KC_D, KC_E, COMBO_END};
+
+combo_t key_combos[COMBO_COUNT] = {COMBO(de_combo, KC_X)};
+
+bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    if (keycode == SEND_HI && record->event.pressed) {
+        send_string("Hi");
+        return false;
+    }
+    return true;
+}
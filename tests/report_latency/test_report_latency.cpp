@@ -0,0 +1,169 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::NiceMock;
+
+class ReportLatency : public TestFixture {
+   public:
+    // Taps the key, holding it for the given time
+    void tap_key(uint8_t col, unsigned hold = 1) {
+        press_key(col, 0);
+        idle_for(hold);
+        release_key(col, 0);
+        idle_for(1);
+    }
+};
+
+TEST_F(ReportLatency, RecordsEveryReportType) {
+    NiceMock<TestDriver> driver;
+    ReportRecorder       recorder;
+
+    tap_key(0);
+    tap_key(4);
+    tap_key(7);
+    EXPECT_EQ(recorder.dump(false),
+              "keyboard mods 0x0 keys 4\n"
+              "keyboard mods 0x0 keys\n"
+              "consumer 0xe9\n"
+              "consumer 0x0\n"
+              "mouse buttons 0x1 x 0 y 0 v 0 h 0\n"
+              "mouse buttons 0x0 x 0 y 0 v 0 h 0\n");
+    EXPECT_EQ(recorder.dump(),
+              "0 ms: keyboard mods 0x0 keys 4\n"
+              "1 ms: keyboard mods 0x0 keys\n"
+              "2 ms: consumer 0xe9\n"
+              "3 ms: consumer 0x0\n"
+              "4 ms: mouse buttons 0x1 x 0 y 0 v 0 h 0\n"
+              "5 ms: mouse buttons 0x0 x 0 y 0 v 0 h 0\n");
+    EXPECT_EQ(recorder.key_events().size(), 6u);
+}
+
+TEST_F(ReportLatency, PlainKeyIsReportedInTheSameScan) {
+    NiceMock<TestDriver> driver;
+    ReportRecorder       recorder;
+
+    tap_key(0, 10);
+    tap_key(1, 10);
+    EXPECT_EQ(recorder.press_latencies(0, 0), std::vector<uint32_t>{0});
+    EXPECT_EQ(recorder.release_latencies(0, 0), std::vector<uint32_t>{0});
+    EXPECT_EQ(recorder.press_latencies(1, 0), std::vector<uint32_t>{0});
+    EXPECT_EQ(recorder.max_latency(), 0u);
+    EXPECT_EQ(recorder.redundant_reports(), 0u);
+    // Four reports in 22 ms
+    EXPECT_NEAR(recorder.reports_per_second(), 4 * 1000.0 / 22, 0.01);
+}
+
+TEST_F(ReportLatency, TappedModTapIsReportedOnRelease) {
+    NiceMock<TestDriver> driver;
+    ReportRecorder       recorder;
+
+    tap_key(2, 50);
+    EXPECT_EQ(recorder.press_latencies(2, 0), std::vector<uint32_t>{50});
+    EXPECT_EQ(recorder.release_latencies(2, 0), std::vector<uint32_t>{0});
+    EXPECT_EQ(recorder.dump(false),
+              "keyboard mods 0x0 keys 6\n"
+              "keyboard mods 0x0 keys\n");
+}
+
+TEST_F(ReportLatency, HeldModTapIsReportedAfterTheTappingTerm) {
+    NiceMock<TestDriver> driver;
+    ReportRecorder       recorder;
+
+    tap_key(2, TAPPING_TERM + 10);
+    ASSERT_EQ(recorder.press_latencies(2, 0).size(), 1u);
+    EXPECT_NEAR(recorder.press_latencies(2, 0)[0], TAPPING_TERM, 1);
+    EXPECT_EQ(recorder.release_latencies(2, 0), std::vector<uint32_t>{0});
+}
+
+TEST_F(ReportLatency, ComboIsReportedWhenItsLastKeyIsPressed) {
+    NiceMock<TestDriver> driver;
+    ReportRecorder       recorder;
+
+    press_key(5, 0);
+    idle_for(5);
+    press_key(6, 0);
+    idle_for(5);
+    release_key(5, 0);
+    release_key(6, 0);
+    idle_for(COMBO_TERM);
+    EXPECT_EQ(recorder.press_latencies(6, 0), std::vector<uint32_t>{0});
+    EXPECT_LE(recorder.max_latency(), 5u);
+    EXPECT_EQ(recorder.dump(false),
+              "keyboard mods 0x0 keys 27\n"
+              "keyboard mods 0x0 keys\n");
+}
+
+TEST_F(ReportLatency, KeyOfAComboIsHeldBackForTheComboTerm) {
+    NiceMock<TestDriver> driver;
+    ReportRecorder       recorder;
+
+    press_key(5, 0);
+    idle_for(COMBO_TERM + 10);
+    release_key(5, 0);
+    idle_for(1);
+    ASSERT_EQ(recorder.press_latencies(5, 0).size(), 1u);
+    EXPECT_LE(recorder.press_latencies(5, 0)[0], COMBO_TERM + 1);
+    EXPECT_EQ(recorder.redundant_reports(), 0u);
+}
+
+TEST_F(ReportLatency, MacroIsSentWithoutRedundantReports) {
+    NiceMock<TestDriver> driver;
+    ReportRecorder       recorder;
+
+    tap_key(3);
+    EXPECT_EQ(recorder.press_latencies(3, 0), std::vector<uint32_t>{0});
+    EXPECT_EQ(recorder.redundant_reports(), 0u);
+    EXPECT_EQ(recorder.dump(false),
+              "keyboard mods 0x2 keys\n"
+              "keyboard mods 0x2 keys 11\n"
+              "keyboard mods 0x2 keys\n"
+              "keyboard mods 0x0 keys\n"
+              "keyboard mods 0x0 keys 12\n"
+              "keyboard mods 0x0 keys\n");
+}
+
+TEST_F(ReportLatency, StreamsCanBeComparedWithoutTimes) {
+    NiceMock<TestDriver> driver;
+    std::string          fast;
+    {
+        ReportRecorder recorder;
+        tap_key(0, 1);
+        tap_key(1, 1);
+        fast = recorder.dump(false);
+    }
+    ReportRecorder recorder;
+    tap_key(0, 30);
+    tap_key(1, 30);
+    EXPECT_EQ(recorder.dump(false), fast);
+    EXPECT_NE(recorder.dump(), recorder.dump(false));
+}
+
+TEST_F(ReportLatency, RepeatedReportsAreCountedAsRedundant) {
+    NiceMock<TestDriver> driver;
+    ReportRecorder       recorder;
+
+    // Sent straight to the host, without the checks of the callers
+    report_mouse_t mouse = {};
+    tap_key(0);
+    host_keyboard_send(keyboard_report);
+    host_mouse_send(&mouse);
+    EXPECT_EQ(recorder.reports().size(), 4u);
+    EXPECT_EQ(recorder.redundant_reports(), 2u);
+}
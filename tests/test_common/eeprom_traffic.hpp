@@ -0,0 +1,62 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+
+extern "C" {
+#include "tmk_core/common/test/eeprom_test.h"
+}
+
+// Counts the EEPROM accesses made while it is in scope, so that tests can
+// catch features that start reading or writing more than they should:
+//
+//     EepromTraffic traffic;
+//     tap_key(...);
+//     EXPECT_EQ(traffic.reads(), 0);
+class EepromTraffic {
+   public:
+    EepromTraffic() : start_(eeprom_test_get_stats()), start_writes_at_(eeprom_test_get_size()) {
+        for (uint16_t i = 0; i < start_writes_at_.size(); i++) {
+            start_writes_at_[i] = eeprom_test_get_address_stats(i).writes;
+        }
+    }
+
+    uint32_t reads() const { return eeprom_test_get_stats().reads - start_.reads; }
+    uint32_t writes() const { return eeprom_test_get_stats().writes - start_.writes; }
+    uint32_t erases() const { return eeprom_test_get_stats().erases - start_.erases; }
+    uint32_t out_of_range() const { return eeprom_test_get_stats().out_of_range - start_.out_of_range; }
+    // Time the ATmega32u4 EEPROM would have been busy for
+    uint32_t time_us() const { return eeprom_test_get_stats().time_us - start_.time_us; }
+
+    uint32_t writes_at(uintptr_t address) const { return address < start_writes_at_.size() ? eeprom_test_get_address_stats(address).writes - start_writes_at_[address] : 0; }
+
+    // The most writes to a single address, which is what wears EEPROM out
+    uint32_t max_writes_per_address() const {
+        uint32_t most = 0;
+        for (uint16_t i = 0; i < start_writes_at_.size(); i++) {
+            if (writes_at(i) > most) {
+                most = writes_at(i);
+            }
+        }
+        return most;
+    }
+
+   private:
+    eeprom_test_stats_t   start_;
+    std::vector<uint32_t> start_writes_at_;
+};
@@ -22,9 +22,7 @@ using namespace testing;
 namespace {
 std::vector<uint8_t> get_keys(const report_keyboard_t& report) {
     std::vector<uint8_t> result;
-#if defined(NKRO_ENABLE)
-#    error NKRO support not implemented yet
-#elif defined(USB_6KRO_ENABLE)
+#if defined(USB_6KRO_ENABLE)
 #    error 6KRO support not implemented yet
 #else
     for (size_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
@@ -36,6 +34,18 @@ std::vector<uint8_t> get_keys(const report_keyboard_t& report) {
     std::sort(result.begin(), result.end());
     return result;
 }
+
+#ifdef NKRO_ENABLE
+std::vector<uint8_t> get_nkro_keys(const report_keyboard_t& report) {
+    std::vector<uint8_t> result;
+    for (size_t i = 0; i < KEYBOARD_REPORT_BITS * 8; i++) {
+        if (report.nkro.bits[i >> 3] & 1 << (i & 7)) {
+            result.emplace_back(i);
+        }
+    }
+    return result;
+}
+#endif
 }  // namespace
 
 bool operator==(const report_keyboard_t& lhs, const report_keyboard_t& rhs) {
@@ -62,7 +72,7 @@ KeyboardReportMatcher::KeyboardReportMatcher(const std::vector<uint8_t>& keys) {
         if (IS_MOD(k)) {
             m_report.mods |= MOD_BIT(k);
         } else {
-            add_key_to_report(&m_report, k);
+            add_key_byte(&m_report, k);
         }
     }
 }
@@ -71,4 +81,34 @@ bool KeyboardReportMatcher::MatchAndExplain(report_keyboard_t& report, MatchResu
 
 void KeyboardReportMatcher::DescribeTo(::std::ostream* os) const { *os << "is equal to " << m_report; }
 
-void KeyboardReportMatcher::DescribeNegationTo(::std::ostream* os) const { *os << "is not equal to " << m_report; }
\ No newline at end of file
+void KeyboardReportMatcher::DescribeNegationTo(::std::ostream* os) const { *os << "is not equal to " << m_report; }
+#ifdef NKRO_ENABLE
+NkroReportMatcher::NkroReportMatcher(const std::vector<uint8_t>& keys) {
+    memset(m_report.raw, 0, sizeof(m_report.raw));
+    memset(m_report.nkro.bits, 0, sizeof(m_report.nkro.bits));
+    for (auto k : keys) {
+        if (IS_MOD(k)) {
+            m_report.nkro.mods |= MOD_BIT(k);
+        } else {
+            add_key_bit(&m_report, k);
+        }
+    }
+}
+
+bool NkroReportMatcher::MatchAndExplain(report_keyboard_t& report, MatchResultListener* listener) const {
+    *listener << "which has mods " << (uint32_t)report.nkro.mods << " and keys";
+    for (uint32_t k : get_nkro_keys(report)) {
+        *listener << " " << k;
+    }
+    return m_report.nkro.mods == report.nkro.mods && get_nkro_keys(m_report) == get_nkro_keys(report);
+}
+
+void NkroReportMatcher::DescribeTo(::std::ostream* os) const {
+    *os << "is an NKRO report with mods " << (uint32_t)m_report.nkro.mods << " and keys";
+    for (uint32_t k : get_nkro_keys(m_report)) {
+        *os << " " << k;
+    }
+}
+
+void NkroReportMatcher::DescribeNegationTo(::std::ostream* os) const { *os << "is not an NKRO report like that"; }
+#endif
@@ -36,4 +36,20 @@ private:
 template<typename... Ts>
 inline testing::Matcher<report_keyboard_t&> KeyboardReport(Ts... keys) {
     return testing::MakeMatcher(new KeyboardReportMatcher(std::vector<uint8_t>({keys...})));
-}
\ No newline at end of file
+}
+#ifdef NKRO_ENABLE
+class NkroReportMatcher : public testing::MatcherInterface<report_keyboard_t&> {
+ public:
+    NkroReportMatcher(const std::vector<uint8_t>& keys);
+    virtual bool MatchAndExplain(report_keyboard_t& report, testing::MatchResultListener* listener) const override;
+    virtual void DescribeTo(::std::ostream* os) const override;
+    virtual void DescribeNegationTo(::std::ostream* os) const override;
+private:
+    report_keyboard_t m_report;
+};
+
+template<typename... Ts>
+inline testing::Matcher<report_keyboard_t&> NkroReport(Ts... keys) {
+    return testing::MakeMatcher(new NkroReportMatcher(std::vector<uint8_t>({keys...})));
+}
+#endif
@@ -19,6 +19,7 @@
 #include <string.h>
 
 static matrix_row_t matrix[MATRIX_ROWS] = {};
+static void (*key_event_callback)(uint8_t col, uint8_t row, bool pressed);
 
 void matrix_init(void) {
     clear_all_keys();
@@ -38,10 +39,28 @@ void matrix_init_kb(void) {}
 
 void matrix_scan_kb(void) {}
 
-void press_key(uint8_t col, uint8_t row) { matrix[row] |= 1 << col; }
+void press_key(uint8_t col, uint8_t row) {
+    if (key_event_callback && !(matrix[row] & (1 << col))) {
+        key_event_callback(col, row, true);
+    }
+    matrix[row] |= 1 << col;
+}
+
+void release_key(uint8_t col, uint8_t row) {
+    if (key_event_callback && (matrix[row] & (1 << col))) {
+        key_event_callback(col, row, false);
+    }
+    matrix[row] &= ~(1 << col);
+}
 
-void release_key(uint8_t col, uint8_t row) { matrix[row] &= ~(1 << col); }
+void clear_all_keys(void) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            release_key(col, row);
+        }
+    }
+}
 
-void clear_all_keys(void) { memset(matrix, 0, sizeof(matrix)); }
+void set_key_event_callback(void (*callback)(uint8_t col, uint8_t row, bool pressed)) { key_event_callback = callback; }
 
 void led_set(uint8_t usb_led) {}
@@ -0,0 +1,185 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "report_recorder.hpp"
+#include <algorithm>
+#include <sstream>
+#include <string.h>
+
+extern "C" {
+#include "timer.h"
+#include "test_matrix.h"
+}
+
+namespace {
+std::vector<ReportRecorder*> recorders;
+uint32_t                     sequence = 0;
+// The last report of each type, which is what the host has
+ReportRecorder::Report last_sent[] = {{ReportRecorder::KEYBOARD}, {ReportRecorder::NKRO}, {ReportRecorder::MOUSE}, {ReportRecorder::SYSTEM}, {ReportRecorder::CONSUMER}};
+
+bool is_redundant(const ReportRecorder::Report& report, const ReportRecorder::Report& last) {
+    switch (report.type) {
+        case ReportRecorder::KEYBOARD:
+            return memcmp(report.keyboard.raw, last.keyboard.raw, KEYBOARD_REPORT_SIZE) == 0;
+        case ReportRecorder::NKRO:
+            return memcmp(&report.keyboard, &last.keyboard, sizeof(report_keyboard_t)) == 0;
+        case ReportRecorder::MOUSE:
+            return !report.mouse.x && !report.mouse.y && !report.mouse.v && !report.mouse.h && report.mouse.buttons == last.mouse.buttons;
+        default:
+            return report.usage == last.usage;
+    }
+}
+}  // namespace
+
+ReportRecorder::ReportRecorder() : start_time_(timer_read32()), last_before_(std::begin(last_sent), std::end(last_sent)) {
+    recorders.push_back(this);
+    set_key_event_callback(&ReportRecorder::record_key);
+}
+
+ReportRecorder::~ReportRecorder() {
+    recorders.erase(std::find(recorders.begin(), recorders.end(), this));
+    if (recorders.empty()) {
+        set_key_event_callback(nullptr);
+    }
+}
+
+void ReportRecorder::record(Report& report) {
+    report.time     = timer_read32();
+    report.sequence = sequence++;
+    for (auto recorder : recorders) {
+        recorder->reports_.push_back(report);
+    }
+    last_sent[report.type] = report;
+}
+
+void ReportRecorder::record_keyboard(const report_keyboard_t* keyboard, bool nkro) {
+    Report report   = {nkro ? NKRO : KEYBOARD};
+    report.keyboard = *keyboard;
+    record(report);
+}
+
+void ReportRecorder::record_mouse(const report_mouse_t* mouse) {
+    Report report = {MOUSE};
+    report.mouse  = *mouse;
+    record(report);
+}
+
+void ReportRecorder::record_usage(Type type, uint16_t usage) {
+    Report report = {type};
+    report.usage  = usage;
+    record(report);
+}
+
+void ReportRecorder::record_key(uint8_t col, uint8_t row, bool pressed) {
+    KeyEvent event = {timer_read32(), sequence++, col, row, pressed};
+    for (auto recorder : recorders) {
+        recorder->key_events_.push_back(event);
+    }
+}
+
+std::vector<uint32_t> ReportRecorder::latencies(uint8_t col, uint8_t row, bool pressed) const {
+    std::vector<uint32_t> result;
+    auto                  report = reports_.begin();
+    for (auto& event : key_events_) {
+        if (event.col != col || event.row != row || event.pressed != pressed) {
+            continue;
+        }
+        while (report != reports_.end() && report->sequence < event.sequence) {
+            report++;
+        }
+        if (report != reports_.end()) {
+            result.push_back(report->time - event.time);
+        }
+    }
+    return result;
+}
+
+uint32_t ReportRecorder::max_latency() const {
+    uint32_t longest = 0;
+    for (auto& event : key_events_) {
+        for (uint32_t latency : latencies(event.col, event.row, event.pressed)) {
+            longest = std::max(longest, latency);
+        }
+    }
+    return longest;
+}
+
+double ReportRecorder::reports_per_second() const {
+    uint32_t elapsed = timer_read32() - start_time_;
+    return elapsed ? reports_.size() * 1000.0 / elapsed : 0;
+}
+
+size_t ReportRecorder::redundant_reports() const {
+    std::vector<Report> last  = last_before_;
+    size_t              count = 0;
+    for (auto& report : reports_) {
+        count += is_redundant(report, last[report.type]);
+        last[report.type] = report;
+    }
+    return count;
+}
+
+std::string ReportRecorder::dump(bool with_time) const {
+    std::ostringstream stream;
+    for (auto& report : reports_) {
+        if (with_time) {
+            stream << report.time - start_time_ << " ms: ";
+        }
+        switch (report.type) {
+            case KEYBOARD:
+            case NKRO: {
+                std::vector<int> keys;
+#ifdef NKRO_ENABLE
+                if (report.type == NKRO) {
+                    for (int i = 0; i < KEYBOARD_REPORT_BITS * 8; i++) {
+                        if (report.keyboard.nkro.bits[i >> 3] & 1 << (i & 7)) {
+                            keys.push_back(i);
+                        }
+                    }
+                } else
+#endif
+                {
+                    for (int i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+                        if (report.keyboard.keys[i]) {
+                            keys.push_back(report.keyboard.keys[i]);
+                        }
+                    }
+                    std::sort(keys.begin(), keys.end());
+                }
+                uint8_t mods = report.keyboard.mods;
+#ifdef NKRO_ENABLE
+                if (report.type == NKRO) {
+                    mods = report.keyboard.nkro.mods;
+                }
+#endif
+                stream << (report.type == NKRO ? "nkro" : "keyboard") << " mods 0x" << std::hex << (int)mods << std::dec << " keys";
+                for (int key : keys) {
+                    stream << " " << key;
+                }
+                break;
+            }
+            case MOUSE:
+                stream << "mouse buttons 0x" << std::hex << (int)report.mouse.buttons << std::dec << " x " << (int)report.mouse.x << " y " << (int)report.mouse.y << " v " << (int)report.mouse.v << " h " << (int)report.mouse.h;
+                break;
+            case SYSTEM:
+            case CONSUMER:
+                stream << (report.type == SYSTEM ? "system" : "consumer") << " 0x" << std::hex << report.usage << std::dec;
+                break;
+        }
+        stream << std::endl;
+    }
+    return stream.str();
+}
@@ -0,0 +1,94 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "report.h"
+
+// Records every report sent to the host while it is in scope, and every key
+// pressed or released on the test matrix, with the time of the fake timer.
+// Tests can then check how long reports took, and how many there were:
+//
+//     ReportRecorder recorder;
+//     press_key(0, 0);
+//     idle_for(TAPPING_TERM);
+//     EXPECT_EQ(recorder.press_latencies(0, 0), std::vector<uint32_t>{0});
+//     EXPECT_EQ(recorder.redundant_reports(), 0u);
+class ReportRecorder {
+   public:
+    enum Type { KEYBOARD, NKRO, MOUSE, SYSTEM, CONSUMER };
+
+    struct Report {
+        Type     type;
+        uint32_t time;
+        uint32_t sequence;
+        union {
+            report_keyboard_t keyboard;
+            report_mouse_t    mouse;
+            uint16_t          usage;
+        };
+    };
+
+    struct KeyEvent {
+        uint32_t time;
+        uint32_t sequence;
+        uint8_t  col;
+        uint8_t  row;
+        bool     pressed;
+    };
+
+    ReportRecorder();
+    ~ReportRecorder();
+
+    const std::vector<Report>&   reports() const { return reports_; }
+    const std::vector<KeyEvent>& key_events() const { return key_events_; }
+
+    // Time from each press or release of the key to the first report sent
+    // after it. Events that no report followed are left out.
+    std::vector<uint32_t> press_latencies(uint8_t col, uint8_t row) const { return latencies(col, row, true); }
+    std::vector<uint32_t> release_latencies(uint8_t col, uint8_t row) const { return latencies(col, row, false); }
+    // The longest of those, over every key
+    uint32_t max_latency() const;
+
+    double reports_per_second() const;
+    // Reports that don't change what the host sees: the same keys or usage as
+    // the last report of their type, or a mouse report without motion or
+    // button changes
+    size_t redundant_reports() const;
+
+    // One line per report, such as "12 ms: keyboard mods 0x2 keys 4 5", to
+    // compare streams with
+    std::string dump(bool with_time = true) const;
+
+    // Called by TestDriver for every report it is sent
+    static void record_keyboard(const report_keyboard_t* report, bool nkro);
+    static void record_mouse(const report_mouse_t* report);
+    static void record_usage(Type type, uint16_t usage);
+
+   private:
+    static void    record(Report& report);
+    static void    record_key(uint8_t col, uint8_t row, bool pressed);
+    std::vector<uint32_t> latencies(uint8_t col, uint8_t row, bool pressed) const;
+
+    uint32_t              start_time_;
+    std::vector<Report>   reports_;
+    std::vector<KeyEvent> key_events_;
+    // What the host had before the first report
+    std::vector<Report> last_before_;
+};
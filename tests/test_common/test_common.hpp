@@ -24,3 +24,5 @@ extern "C" {
 #include "test_matrix.h"
 #include "keyboard_report_util.hpp"
 #include "test_fixture.hpp"
+#include "eeprom_traffic.hpp"
+#include "report_recorder.hpp"
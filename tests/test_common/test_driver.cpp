@@ -15,10 +15,13 @@
  */
 
 #include "test_driver.hpp"
+#include "report_recorder.hpp"
 
 TestDriver* TestDriver::m_this = nullptr;
 
-TestDriver::TestDriver() : m_driver{&TestDriver::keyboard_leds, &TestDriver::send_keyboard, &TestDriver::send_mouse, &TestDriver::send_system, &TestDriver::send_consumer} {
+uint8_t keyboard_protocol = 1;
+
+TestDriver::TestDriver() : m_driver{&TestDriver::keyboard_leds, &TestDriver::send_keyboard, &TestDriver::send_mouse, &TestDriver::send_system, &TestDriver::send_consumer, &TestDriver::mouse_ready} {
     host_set_driver(&m_driver);
     m_this = this;
 }
@@ -27,10 +30,28 @@ TestDriver::~TestDriver() { m_this = nullptr; }
 
 uint8_t TestDriver::keyboard_leds(void) { return m_this->m_leds; }
 
-void TestDriver::send_keyboard(report_keyboard_t* report) { m_this->send_keyboard_mock(*report); }
+void TestDriver::send_keyboard(report_keyboard_t* report) {
+    ReportRecorder::record_keyboard(report, host_keyboard_nkro());
+    if (host_keyboard_nkro()) {
+        m_this->send_nkro_mock(*report);
+    } else {
+        m_this->send_keyboard_mock(*report);
+    }
+}
+
+void TestDriver::send_mouse(report_mouse_t* report) {
+    ReportRecorder::record_mouse(report);
+    m_this->send_mouse_mock(*report);
+}
 
-void TestDriver::send_mouse(report_mouse_t* report) { m_this->send_mouse_mock(*report); }
+bool TestDriver::mouse_ready(void) { return m_this->m_mouse_ready; }
 
-void TestDriver::send_system(uint16_t data) { m_this->send_system_mock(data); }
+void TestDriver::send_system(uint16_t data) {
+    ReportRecorder::record_usage(ReportRecorder::SYSTEM, data);
+    m_this->send_system_mock(data);
+}
 
-void TestDriver::send_consumer(uint16_t data) { m_this->send_consumer(data); }
+void TestDriver::send_consumer(uint16_t data) {
+    ReportRecorder::record_usage(ReportRecorder::CONSUMER, data);
+    m_this->send_consumer_mock(data);
+}
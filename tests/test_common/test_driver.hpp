@@ -28,8 +28,10 @@ public:
     TestDriver();
     ~TestDriver();
     void set_leds(uint8_t leds) { m_leds = leds; }
+    void set_mouse_ready(bool ready) { m_mouse_ready = ready; }
     
     MOCK_METHOD1(send_keyboard_mock, void (report_keyboard_t&));
+    MOCK_METHOD1(send_nkro_mock, void (report_keyboard_t&));
     MOCK_METHOD1(send_mouse_mock, void (report_mouse_t&));
     MOCK_METHOD1(send_system_mock, void (uint16_t));
     MOCK_METHOD1(send_consumer_mock, void (uint16_t));
@@ -39,8 +41,10 @@ private:
     static void send_mouse(report_mouse_t* report);
     static void send_system(uint16_t data);
     static void send_consumer(uint16_t data);
+    static bool mouse_ready(void);
     host_driver_t m_driver;
     uint8_t m_leds = 0;
+    bool m_mouse_ready = true;
     static TestDriver* m_this;
 };
 
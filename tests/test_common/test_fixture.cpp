@@ -8,6 +8,7 @@
 
 extern "C" {
 #include "action_layer.h"
+#include "action_util.h"
 }
 
 extern "C" {
@@ -23,6 +24,8 @@ using testing::Return;
 void TestFixture::SetUpTestCase() {
     TestDriver driver;
     EXPECT_CALL(driver, send_keyboard_mock(_));
+    // A real keyboard starts without having sent anything
+    forget_last_keyboard_report();
     keyboard_init();
 }
 
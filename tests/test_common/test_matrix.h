@@ -24,6 +24,8 @@ extern "C" {
 void press_key(uint8_t col, uint8_t row);
 void release_key(uint8_t col, uint8_t row);
 void clear_all_keys(void);
+// Called for every key that is pressed or released, for ReportRecorder
+void set_key_event_callback(void (*callback)(uint8_t col, uint8_t row, bool pressed));
 
 #ifdef __cplusplus
 }
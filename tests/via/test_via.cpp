@@ -0,0 +1,355 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <array>
+#include <vector>
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "via.h"
+#include "raw_hid.h"
+#include "dynamic_keymap.h"
+#include "eeconfig.h"
+#include "eeprom.h"
+#include "tmk_core/common/test/eeprom_test.h"
+}
+
+#define REPORT_SIZE 32
+#define PAYLOAD_SIZE (REPORT_SIZE - 4)
+#define KEY_COUNT (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS)
+
+typedef std::array<uint8_t, REPORT_SIZE> report_t;
+
+static std::vector<report_t> sent_reports;
+
+extern "C" void raw_hid_send(uint8_t *data, uint8_t length) {
+    report_t report{};
+    std::copy(data, data + length, report.begin());
+    sent_reports.push_back(report);
+}
+
+// Plays the part of the configurator, driving raw_hid_receive() directly
+// and counting the reports that go over the wire.
+class ViaHost {
+   public:
+    uint32_t round_trips = 0;
+    uint32_t out_reports = 0;
+    uint32_t in_reports  = 0;
+
+    // Sends a report and waits for the answer(s)
+    std::vector<report_t> request(report_t report) {
+        round_trips++;
+        return post(report);
+    }
+
+    // Sends a report without waiting
+    std::vector<report_t> post(report_t report) {
+        sent_reports.clear();
+        out_reports++;
+        raw_hid_receive(report.data(), REPORT_SIZE);
+        in_reports += sent_reports.size();
+        return sent_reports;
+    }
+
+    std::vector<uint16_t> read_keymap_legacy() {
+        std::vector<uint8_t> buffer;
+        for (uint16_t offset = 0; offset < KEY_COUNT * 2; offset += PAYLOAD_SIZE) {
+            report_t report{id_dynamic_keymap_get_buffer, (uint8_t)(offset >> 8), (uint8_t)(offset & 0xFF), PAYLOAD_SIZE};
+            report = request(report).at(0);
+            buffer.insert(buffer.end(), report.begin() + 4, report.end());
+        }
+        std::vector<uint16_t> keymap;
+        for (uint16_t i = 0; i < KEY_COUNT; i++) {
+            keymap.push_back((buffer[i * 2] << 8) | buffer[i * 2 + 1]);
+        }
+        return keymap;
+    }
+
+    std::vector<uint16_t> read_keymap_bulk(uint8_t source = VIA_BULK_KEYMAP_CURRENT) {
+        std::vector<uint16_t> keymap(KEY_COUNT, 0xFFFF);
+        report_t              report{id_dynamic_keymap_get_buffer_bulk, 0, 0, KEY_COUNT >> 8, KEY_COUNT & 0xFF, source};
+        std::vector<report_t> answers = request(report);
+        EXPECT_FALSE(answers.empty());
+        for (size_t i = 0; i < answers.size(); i++) {
+            EXPECT_EQ(answers[i][0], id_dynamic_keymap_get_buffer_bulk);
+            EXPECT_EQ((answers[i][3] & VIA_BULK_LAST) != 0, i == answers.size() - 1);
+            decode(keymap, answers[i]);
+        }
+        return keymap;
+    }
+
+    // Writes the keymap with as few reports as the encoding allows,
+    // only the last of which is answered
+    void write_keymap_bulk(const std::vector<uint16_t> &keymap) {
+        uint16_t index = 0;
+        while (index < KEY_COUNT) {
+            report_t report{id_dynamic_keymap_set_buffer_bulk, (uint8_t)(index >> 8), (uint8_t)(index & 0xFF)};
+            uint8_t  length = 0;
+            while (index < KEY_COUNT) {
+                uint8_t run = 1;
+                if (keymap[index] == defaults[index]) {
+                    if (length + 1 > PAYLOAD_SIZE) break;
+                    while (run < 64 && index + run < KEY_COUNT && keymap[index + run] == defaults[index + run]) run++;
+                    report[4 + length++] = run - 1;
+                } else {
+                    if (length + 3 > PAYLOAD_SIZE) break;
+                    uint8_t token = length++;
+                    report[4 + length++] = keymap[index] >> 8;
+                    report[4 + length++] = keymap[index] & 0xFF;
+                    while (run < 64 && index + run < KEY_COUNT && keymap[index + run] != defaults[index + run] && length + 2 <= PAYLOAD_SIZE) {
+                        report[4 + length++] = keymap[index + run] >> 8;
+                        report[4 + length++] = keymap[index + run] & 0xFF;
+                        run++;
+                    }
+                    report[4 + token] = 0x80 | (run - 1);
+                }
+                index += run;
+            }
+            report[3] = length | (index == KEY_COUNT ? VIA_BULK_LAST : 0);
+            if (index == KEY_COUNT) {
+                std::vector<report_t> answers = request(report);
+                ASSERT_EQ(answers.size(), 1u);
+                EXPECT_EQ(answers[0][3], VIA_BULK_LAST);
+                EXPECT_EQ((answers[0][1] << 8) | answers[0][2], KEY_COUNT);
+            } else {
+                EXPECT_TRUE(post(report).empty());
+            }
+        }
+    }
+
+    void fetch_defaults() { defaults = read_keymap_bulk(VIA_BULK_KEYMAP_FLASH_DEFAULT); }
+
+    std::vector<uint16_t> defaults;
+
+   private:
+    void decode(std::vector<uint16_t> &keymap, const report_t &report) {
+        uint16_t index  = (report[1] << 8) | report[2];
+        uint8_t  length = report[3] & VIA_BULK_LENGTH_MASK;
+        uint8_t  i      = 0;
+        ASSERT_LE(length, PAYLOAD_SIZE);
+        while (i < length) {
+            uint8_t token = report[4 + i++];
+            uint8_t run   = (token & 0x3F) + 1;
+            ASSERT_LE(index + run, KEY_COUNT);
+            for (uint8_t j = 0; j < run; j++) {
+                switch (token & 0xC0) {
+                    case 0x00:
+                        ASSERT_FALSE(defaults.empty());
+                        keymap[index + j] = defaults[index + j];
+                        break;
+                    case 0x40:
+                        keymap[index + j] = (report[4 + i] << 8) | report[5 + i];
+                        break;
+                    case 0x80:
+                        keymap[index + j] = (report[4 + i + j * 2] << 8) | report[5 + i + j * 2];
+                        break;
+                    default:
+                        FAIL() << "Reserved token";
+                }
+            }
+            i += (token & 0xC0) == 0x40 ? 2 : (token & 0xC0) == 0x80 ? run * 2 : 0;
+            index += run;
+        }
+    }
+};
+
+class Via : public TestFixture {
+   public:
+    void SetUp() override {
+        dynamic_keymap_reset();
+        dynamic_keymap_macro_reset();
+    }
+};
+
+TEST_F(Via, BulkReadOfDefaultKeymapIsOneReport) {
+    ViaHost host;
+    host.fetch_defaults();
+    uint32_t default_reports = host.in_reports;
+
+    host.in_reports = 0;
+    EXPECT_EQ(host.read_keymap_bulk(), host.defaults);
+    EXPECT_EQ(host.in_reports, 1u);
+
+    ViaHost legacy;
+    EXPECT_EQ(legacy.read_keymap_legacy(), host.defaults);
+    EXPECT_EQ(legacy.round_trips, (KEY_COUNT * 2 + PAYLOAD_SIZE - 1) / PAYLOAD_SIZE);
+    // Even the flash defaults, without deltas, take fewer reports
+    EXPECT_LT(default_reports, legacy.in_reports);
+}
+
+TEST_F(Via, BulkReadMatchesLegacyRead) {
+    dynamic_keymap_set_keycode(0, 0, 0, KC_GRV);
+    dynamic_keymap_set_keycode(1, 4, 19, KC_A);
+    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+        dynamic_keymap_set_keycode(2, 2, col, KC_F13 + (col % 3));
+        dynamic_keymap_set_keycode(3, 1, col, LCTL(KC_C));
+    }
+
+    ViaHost legacy;
+    std::vector<uint16_t> expected = legacy.read_keymap_legacy();
+
+    ViaHost host;
+    host.fetch_defaults();
+    host.round_trips = 0;
+    host.in_reports  = 0;
+    EXPECT_EQ(host.read_keymap_bulk(), expected);
+    EXPECT_EQ(host.round_trips, 1u);
+    EXPECT_LT(host.in_reports, legacy.round_trips / 4);
+}
+
+TEST_F(Via, BulkReadOfPartialRange) {
+    dynamic_keymap_set_keycode(1, 0, 5, KC_B);
+    ViaHost host;
+    host.fetch_defaults();
+    uint16_t index = MATRIX_ROWS * MATRIX_COLS + 5;
+    report_t report{id_dynamic_keymap_get_buffer_bulk, (uint8_t)(index >> 8), (uint8_t)(index & 0xFF), 0, 1};
+    std::vector<report_t> answers = host.request(report);
+    ASSERT_EQ(answers.size(), 1u);
+    EXPECT_EQ((answers[0][1] << 8) | answers[0][2], index);
+    // A single literal token
+    EXPECT_EQ(answers[0][3], VIA_BULK_LAST | 3);
+    EXPECT_EQ(answers[0][4], 0x80);
+    EXPECT_EQ((answers[0][5] << 8) | answers[0][6], KC_B);
+}
+
+TEST_F(Via, BulkWriteIsAnsweredOnce) {
+    ViaHost host;
+    host.fetch_defaults();
+    std::vector<uint16_t> keymap = host.defaults;
+    for (uint16_t i = 0; i < KEY_COUNT; i += 3) {
+        keymap[i] = KC_A + (i % 26);
+    }
+    host.round_trips = 0;
+    host.in_reports  = 0;
+    host.write_keymap_bulk(keymap);
+    EXPECT_EQ(host.round_trips, 1u);
+    EXPECT_GT(host.out_reports, 1u);
+    EXPECT_EQ(host.in_reports, 1u);
+
+    for (uint16_t i = 0; i < KEY_COUNT; i++) {
+        uint8_t layer = i / (MATRIX_ROWS * MATRIX_COLS);
+        uint8_t row   = (i / MATRIX_COLS) % MATRIX_ROWS;
+        uint8_t col   = i % MATRIX_COLS;
+        ASSERT_EQ(dynamic_keymap_get_keycode(layer, row, col), keymap[i]) << "key " << i;
+    }
+}
+
+TEST_F(Via, BulkWriteOfDefaultsResetsKeys) {
+    dynamic_keymap_set_keycode(0, 3, 3, KC_Z);
+    dynamic_keymap_set_keycode(3, 4, 19, KC_Z);
+    ViaHost host;
+    host.fetch_defaults();
+    host.write_keymap_bulk(host.defaults);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 3, 3), host.defaults[3 * MATRIX_COLS + 3]);
+    EXPECT_EQ(dynamic_keymap_get_keycode(3, 4, 19), KC_NO);
+}
+
+TEST_F(Via, BulkTransfersOnlyWriteChangedBytes) {
+    ViaHost host;
+    host.fetch_defaults();
+
+    EepromTraffic reading;
+    host.read_keymap_bulk();
+    EXPECT_EQ(reading.writes(), 0u);
+
+    std::vector<uint16_t> keymap = host.defaults;
+    keymap[1]                    = KC_Z;
+    keymap[KEY_COUNT - 1]        = LCTL(KC_Z);
+    EepromTraffic writing;
+    host.write_keymap_bulk(keymap);
+    // Keys that keep their keycode aren't written again
+    EXPECT_LE(writing.writes(), 4u);
+    EXPECT_LE(writing.max_writes_per_address(), 1u);
+    EXPECT_EQ(writing.out_of_range(), 0u);
+}
+
+TEST_F(Via, MalformedBulkWriteIsReported) {
+    ViaHost host;
+    // A literal of two keys, with only one keycode following
+    report_t report{id_dynamic_keymap_set_buffer_bulk, 0, 0, 6, 0x40, KC_X >> 8, KC_X & 0xFF, 0x81, KC_Y >> 8, KC_Y & 0xFF};
+    std::vector<report_t> answers = host.post(report);
+    ASSERT_EQ(answers.size(), 1u);
+    EXPECT_EQ(answers[0][3], VIA_BULK_ERROR);
+    // The first token was applied, the broken one was not
+    EXPECT_EQ((answers[0][1] << 8) | answers[0][2], 1);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_X);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 1), KC_F1);
+
+    // Past the end of the keymap
+    uint16_t index = KEY_COUNT - 1;
+    report_t past_end{id_dynamic_keymap_set_buffer_bulk, (uint8_t)(index >> 8), (uint8_t)(index & 0xFF), 1, 0x01};
+    answers = host.post(past_end);
+    ASSERT_EQ(answers.size(), 1u);
+    EXPECT_EQ(answers[0][3], VIA_BULK_ERROR);
+}
+
+TEST_F(Via, MacroBulkTransfer) {
+    ViaHost  host;
+    uint16_t size = dynamic_keymap_macro_get_buffer_size();
+    // 40 bytes of macros, in two reports
+    uint8_t macros[40];
+    for (uint8_t i = 0; i < sizeof(macros); i++) {
+        macros[i] = (i % 10 == 9) ? 0 : 'a' + i;
+    }
+    report_t first{id_dynamic_keymap_macro_set_buffer_bulk, 0, 0, PAYLOAD_SIZE};
+    std::copy(macros, macros + PAYLOAD_SIZE, first.begin() + 4);
+    EXPECT_TRUE(host.post(first).empty());
+    report_t last{id_dynamic_keymap_macro_set_buffer_bulk, 0, PAYLOAD_SIZE, VIA_BULK_LAST | (sizeof(macros) - PAYLOAD_SIZE)};
+    std::copy(macros + PAYLOAD_SIZE, macros + sizeof(macros), last.begin() + 4);
+    std::vector<report_t> answers = host.request(last);
+    ASSERT_EQ(answers.size(), 1u);
+    EXPECT_EQ(answers[0][3], VIA_BULK_LAST);
+    EXPECT_EQ((answers[0][1] << 8) | answers[0][2], sizeof(macros));
+
+    // The stream stops after the last non-zero byte, rather than at the end of the buffer
+    host.in_reports = 0;
+    report_t request{id_dynamic_keymap_macro_get_buffer_bulk, 0, 0, (uint8_t)(size >> 8), (uint8_t)(size & 0xFF)};
+    answers = host.request(request);
+    ASSERT_EQ(answers.size(), 2u);
+    EXPECT_EQ(answers[0][3], PAYLOAD_SIZE);
+    EXPECT_EQ(answers[1][3], VIA_BULK_LAST | (sizeof(macros) - 1 - PAYLOAD_SIZE));
+    std::vector<uint8_t> read(answers[0].begin() + 4, answers[0].end());
+    read.insert(read.end(), answers[1].begin() + 4, answers[1].begin() + 4 + (answers[1][3] & VIA_BULK_LENGTH_MASK));
+    read.resize(sizeof(macros), 0);
+    EXPECT_EQ(read, std::vector<uint8_t>(macros, macros + sizeof(macros)));
+
+    // Writing past the end of the buffer is refused
+    report_t past_end{id_dynamic_keymap_macro_set_buffer_bulk, (uint8_t)(size >> 8), (uint8_t)(size & 0xFF), VIA_BULK_LAST | 1, 'x'};
+    answers = host.request(past_end);
+    ASSERT_EQ(answers.size(), 1u);
+    EXPECT_EQ(answers[0][3], VIA_BULK_LAST | VIA_BULK_ERROR);
+}
+
+TEST_F(Via, LegacyEeconfigIsMigratedBeforeViaReadsItsData) {
+    eeconfig_update_user(0x12345678);
+    dynamic_keymap_set_keycode(0, 0, 0, KC_Z);
+
+    // What older firmware left behind: everything after the eeconfig block
+    // starts at EECONFIG_SIZE_LEGACY, and the block has no version or CRC
+    uint16_t size = eeprom_test_get_size();
+    for (uint16_t addr = EECONFIG_SIZE_LEGACY; addr < size - (EECONFIG_SIZE - EECONFIG_SIZE_LEGACY); addr++) {
+        eeprom_update_byte((uint8_t *)(uintptr_t)addr, eeprom_read_byte((uint8_t *)(uintptr_t)(addr + EECONFIG_SIZE - EECONFIG_SIZE_LEGACY)));
+    }
+    eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER_LEGACY);
+
+    keyboard_init();
+
+    EXPECT_TRUE(eeconfig_is_enabled());
+    EXPECT_EQ(eeconfig_read_user(), 0x12345678u);
+    EXPECT_TRUE(via_eeprom_is_valid());
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_Z);
+}
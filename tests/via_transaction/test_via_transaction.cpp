@@ -0,0 +1,129 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <array>
+#include <vector>
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "via.h"
+#include "raw_hid.h"
+#include "dynamic_keymap.h"
+}
+
+#define REPORT_SIZE 32
+#define PAYLOAD_SIZE (REPORT_SIZE - 4)
+#define KEYMAP_SIZE (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2)
+
+typedef std::array<uint8_t, REPORT_SIZE> report_t;
+
+extern "C" void raw_hid_send(uint8_t *data, uint8_t length) {}
+
+static void receive(report_t report) { raw_hid_receive(report.data(), REPORT_SIZE); }
+
+class ViaTransaction : public TestFixture {
+   public:
+    void SetUp() override {
+        dynamic_keymap_cache_load();
+        dynamic_keymap_reset();
+        dynamic_keymap_macro_reset();
+    }
+
+    std::vector<uint8_t> macros() {
+        std::vector<uint8_t> data(dynamic_keymap_macro_get_buffer_size());
+        dynamic_keymap_macro_get_buffer(0, data.size(), data.data());
+        return data;
+    }
+
+    // Writes the macro buffer the way VIA Configurator does, stopping after
+    // the given number of reports
+    void write_macros_legacy(const std::vector<uint8_t> &data, uint16_t reports = 0xFFFF) {
+        uint16_t last = dynamic_keymap_macro_get_buffer_size() - 1;
+        receive(report_t{id_dynamic_keymap_macro_set_buffer, (uint8_t)(last >> 8), (uint8_t)(last & 0xFF), 1, 0xFF});
+        for (uint16_t offset = 0; offset < data.size() && reports > 0; offset += PAYLOAD_SIZE, reports--) {
+            uint8_t  size = std::min<uint16_t>(PAYLOAD_SIZE, data.size() - offset);
+            report_t report{id_dynamic_keymap_macro_set_buffer, (uint8_t)(offset >> 8), (uint8_t)(offset & 0xFF), size};
+            std::copy(data.begin() + offset, data.begin() + offset + size, report.begin() + 4);
+            receive(report);
+        }
+        if (reports > 0) {
+            receive(report_t{id_dynamic_keymap_macro_set_buffer, (uint8_t)(last >> 8), (uint8_t)(last & 0xFF), 1, 0x00});
+        }
+    }
+
+    // Writes the whole keymap with the legacy command, setting every key to keycode
+    void write_keymap_legacy(uint16_t keycode, uint16_t reports = 0xFFFF) {
+        for (uint16_t offset = 0; offset < KEYMAP_SIZE && reports > 0; offset += PAYLOAD_SIZE, reports--) {
+            uint8_t  size = std::min<uint16_t>(PAYLOAD_SIZE, KEYMAP_SIZE - offset);
+            report_t report{id_dynamic_keymap_set_buffer, (uint8_t)(offset >> 8), (uint8_t)(offset & 0xFF), size};
+            for (uint8_t i = 0; i < size; i += 2) {
+                report[4 + i] = keycode >> 8;
+                report[5 + i] = keycode & 0xFF;
+            }
+            receive(report);
+        }
+    }
+};
+
+TEST_F(ViaTransaction, StaleBulkStreamIsDroppedByOtherCommands) {
+    // The start of a bulk write setting the first key, which is never finished
+    receive(report_t{id_dynamic_keymap_set_buffer_bulk, 0, 0, 3, 0x40, KC_X >> 8, KC_X & 0xFF});
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_A);
+
+    // A later single key write is applied right away, rather than staged
+    receive(report_t{id_dynamic_keymap_set_keycode, 0, 0, 1, KC_Y >> 8, KC_Y & 0xFF});
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 1), KC_Y);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_A);
+
+    // And stays applied after a reboot
+    dynamic_keymap_cache_load();
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 1), KC_Y);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_A);
+}
+
+TEST_F(ViaTransaction, LegacyKeymapWriteIsAppliedAtOnce) {
+    // All but the last report
+    write_keymap_legacy(KC_Z, (KEYMAP_SIZE - 1) / PAYLOAD_SIZE);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_A);
+
+    write_keymap_legacy(KC_Z);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_Z);
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 1, 3), KC_Z);
+}
+
+TEST_F(ViaTransaction, CutOffLegacyKeymapWriteIsDropped) {
+    write_keymap_legacy(KC_Z, 1);
+    receive(report_t{id_get_protocol_version});
+    dynamic_keymap_cache_load();
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_A);
+}
+
+TEST_F(ViaTransaction, LegacyMacroWriteIsAppliedAtOnce) {
+    std::vector<uint8_t> data(40, 'a');
+    data[9]  = 0;
+    data[39] = 0;
+    write_macros_legacy(data, 1);
+    EXPECT_EQ(macros(), std::vector<uint8_t>(dynamic_keymap_macro_get_buffer_size(), 0));
+
+    // Cut off and retried from the start
+    write_macros_legacy(data);
+    std::vector<uint8_t> expected(dynamic_keymap_macro_get_buffer_size(), 0);
+    std::copy(data.begin(), data.end(), expected.begin());
+    EXPECT_EQ(macros(), expected);
+    dynamic_keymap_cache_load();
+    EXPECT_EQ(macros(), expected);
+}
@@ -13,6 +13,9 @@ TMK_COMMON_SRC +=	$(COMMON_DIR)/host.c \
 	$(COMMON_DIR)/util.c \
 	$(COMMON_DIR)/eeconfig.c \
 	$(COMMON_DIR)/report.c \
+	$(COMMON_DIR)/report_queue.c \
+	$(COMMON_DIR)/sof_sync.c \
+	$(COMMON_DIR)/power_state.c \
 	$(PLATFORM_COMMON_DIR)/suspend.c \
 	$(PLATFORM_COMMON_DIR)/timer.c \
 	$(PLATFORM_COMMON_DIR)/bootloader.c \
@@ -78,6 +81,11 @@ ifeq ($(strip $(RAW_ENABLE)), yes)
     TMK_COMMON_DEFS += -DRAW_ENABLE
 endif
 
+ifeq ($(strip $(EEPROM_CACHE_ENABLE)), yes)
+    TMK_COMMON_SRC += $(COMMON_DIR)/eeprom_cache.c
+    TMK_COMMON_DEFS += -DEEPROM_CACHE_ENABLE
+endif
+
 ifeq ($(strip $(CONSOLE_ENABLE)), yes)
     TMK_COMMON_DEFS += -DCONSOLE_ENABLE
 else
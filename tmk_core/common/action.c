@@ -345,6 +345,7 @@ void process_action(keyrecord_t *record, action_t action) {
                         if (tap_count > 0) {
                             dprint("MODS_TAP: Tap: unregister_code\n");
                             if (action.layer_tap.code == KC_CAPS) {
+                                flush_keyboard_report();
                                 wait_ms(TAP_HOLD_CAPS_DELAY);
                             }
                             unregister_code(action.key.code);
@@ -547,6 +548,7 @@ void process_action(keyrecord_t *record, action_t action) {
                     } else {
                         if (tap_count > 0) {
                             dprint("KEYMAP_TAP_KEY: Tap: unregister_code\n");
+                            flush_keyboard_report();
                             if (action.layer_tap.code == KC_CAPS) {
                                 wait_ms(TAP_HOLD_CAPS_DELAY);
                             } else {
@@ -619,6 +621,7 @@ void process_action(keyrecord_t *record, action_t action) {
                         if (event.pressed) {
                             register_code(action.swap.code);
                         } else {
+                            flush_keyboard_report();
                             wait_ms(TAP_CODE_DELAY);
                             unregister_code(action.swap.code);
                             *record = (keyrecord_t){};  // hack: reset tap mode
@@ -710,6 +713,7 @@ void register_code(uint8_t code) {
 #    endif
         add_key(KC_CAPSLOCK);
         send_keyboard_report();
+        flush_keyboard_report();
         wait_ms(100);
         del_key(KC_CAPSLOCK);
         send_keyboard_report();
@@ -721,6 +725,7 @@ void register_code(uint8_t code) {
 #    endif
         add_key(KC_NUMLOCK);
         send_keyboard_report();
+        flush_keyboard_report();
         wait_ms(100);
         del_key(KC_NUMLOCK);
         send_keyboard_report();
@@ -732,6 +737,7 @@ void register_code(uint8_t code) {
 #    endif
         add_key(KC_SCROLLLOCK);
         send_keyboard_report();
+        flush_keyboard_report();
         wait_ms(100);
         del_key(KC_SCROLLLOCK);
         send_keyboard_report();
@@ -762,7 +768,7 @@ void register_code(uint8_t code) {
                 // Force a new key press if the key is already pressed
                 // without this, keys with the same keycode, but different
                 // modifiers will be reported incorrectly, see issue #1708
-                if (is_key_pressed(keyboard_report, code)) {
+                if (has_key(code)) {
                     del_key(code);
                     send_keyboard_report();
                 }
@@ -860,6 +866,7 @@ void unregister_code(uint8_t code) {
  */
 void tap_code(uint8_t code) {
     register_code(code);
+    flush_keyboard_report();
     if (code == KC_CAPS) {
         wait_ms(TAP_HOLD_CAPS_DELAY);
     } else {
@@ -917,6 +924,8 @@ void unregister_weak_mods(uint8_t mods) {
  * FIXME: Needs documentation.
  */
 void clear_keyboard(void) {
+    // the host may have missed reports, make sure it gets this one
+    forget_last_keyboard_report();
     clear_mods();
     clear_keyboard_but_mods();
 }
@@ -3,6 +3,9 @@
 #include "action.h"
 #include "util.h"
 #include "action_layer.h"
+#ifdef KEYMAP_COMPRESSION_ENABLE
+#    include "keymap_compressed.h"
+#endif
 
 #ifdef DEBUG_ACTION
 #    include "debug.h"
@@ -259,6 +262,12 @@ uint8_t layer_switch_get_layer(keypos_t key) {
     /* check top layer first */
     for (int8_t i = sizeof(layer_state_t) * 8 - 1; i >= 0; i--) {
         if (layers & (1UL << i)) {
+#    ifdef KEYMAP_COMPRESSION_ENABLE
+            // KC_TRNS keys are a bitmap test away, skip them without building the action
+            if (keymap_compressed_is_transparent(i, key)) {
+                continue;
+            }
+#    endif
             action = action_for_key(i, key);
             if (action.code != ACTION_TRANSPARENT) {
                 return i;
@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "action_layer.h"
 #include "timer.h"
 #include "keycode_config.h"
+#include <string.h>
 
 extern keymap_config_t keymap_config;
 
@@ -28,23 +29,28 @@ static uint8_t real_mods  = 0;
 static uint8_t weak_mods  = 0;
 static uint8_t macro_mods = 0;
 
-#ifdef USB_6KRO_ENABLE
-#    define RO_ADD(a, b) ((a + b) % KEYBOARD_REPORT_KEYS)
-#    define RO_SUB(a, b) ((a - b + KEYBOARD_REPORT_KEYS) % KEYBOARD_REPORT_KEYS)
-#    define RO_INC(a) RO_ADD(a, 1)
-#    define RO_DEC(a) RO_SUB(a, 1)
-static int8_t cb_head  = 0;
-static int8_t cb_tail  = 0;
-static int8_t cb_count = 0;
-#endif
+// keys of keyboard_report, which is written from them when it's sent
+static report_keys_t report_keys;
 
 // TODO: pointer variable is not needed
 // report_keyboard_t keyboard_report = {};
 report_keyboard_t *keyboard_report = &(report_keyboard_t){};
 
-extern inline void add_key(uint8_t key);
-extern inline void del_key(uint8_t key);
-extern inline void clear_keys(void);
+/** \brief Adds a key to the keyboard report
+ */
+void add_key(uint8_t key) { report_keys_add(&report_keys, key); }
+
+/** \brief Removes a key from the keyboard report
+ */
+void del_key(uint8_t key) { report_keys_del(&report_keys, key); }
+
+/** \brief Removes all keys from the keyboard report
+ */
+void clear_keys(void) { report_keys_clear(&report_keys); }
+
+/** \brief Checks if a key is in the keyboard report
+ */
+bool has_key(uint8_t key) { return report_keys_has(&report_keys, key); }
 
 #ifndef NO_ACTION_ONESHOT
 static uint8_t oneshot_mods        = 0;
@@ -130,11 +136,135 @@ void clear_oneshot_layer_state(oneshot_fullfillment_t state) {
 bool is_oneshot_layer_active(void) { return get_oneshot_layer_state(); }
 #endif
 
+// The last report given to the host, before host_keyboard_send() fills in the report ID
+static report_keyboard_t last_report;
+static bool              is_last_report_known = false;
+
+#ifdef COALESCE_KEYBOARD_REPORTS
+// Reports are sent from here, as the driver may still be reading it after host_keyboard_send() returns
+static report_keyboard_t sent_report;
+static report_keyboard_t pending_report;
+static bool              has_pending_report  = false;
+static uint16_t          pending_report_time = 0;
+
+/** \brief Checks if any key of one report is missing from another
+ */
+static bool has_key_missing_from(report_keyboard_t *from, report_keyboard_t *to) {
+#    ifdef NKRO_ENABLE
+    if (keyboard_protocol && keymap_config.nkro) {
+        for (uint8_t i = 0; i < KEYBOARD_REPORT_BITS; i++) {
+            if (from->nkro.bits[i] & ~to->nkro.bits[i]) {
+                return true;
+            }
+        }
+        return false;
+    }
+#    endif
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (from->keys[i] && !is_key_pressed(to, from->keys[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** \brief Checks if a key pressed or released from last_report to pending_report is changed back in report
+ */
+static bool has_key_changed_back(report_keyboard_t *report) {
+#    ifdef NKRO_ENABLE
+    if (keyboard_protocol && keymap_config.nkro) {
+        for (uint8_t i = 0; i < KEYBOARD_REPORT_BITS; i++) {
+            uint8_t changed = last_report.nkro.bits[i] ^ pending_report.nkro.bits[i];
+            if (changed & (pending_report.nkro.bits[i] ^ report->nkro.bits[i])) {
+                return true;
+            }
+        }
+        return false;
+    }
+#    endif
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        uint8_t key = pending_report.keys[i];
+        if (key && !is_key_pressed(&last_report, key) && !is_key_pressed(report, key)) {
+            return true;
+        }
+        key = last_report.keys[i];
+        if (key && !is_key_pressed(&pending_report, key) && is_key_pressed(report, key)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** \brief Checks if report can replace the pending report
+ *
+ * The host must see the same keys typed as if both had been sent. So nothing
+ * the pending report changes can be changed back, and a key press can't be
+ * sent together with a modifier change, as the host may apply them in either
+ * order. Releases are merged with anything else.
+ */
+static bool can_merge_keyboard_report(report_keyboard_t *report) {
+    uint8_t mods_changed  = last_report.mods ^ pending_report.mods;
+    uint8_t mods_changing = pending_report.mods ^ report->mods;
+    if (mods_changed & mods_changing) {
+        return false;
+    }
+    if ((mods_changed | mods_changing) && (has_key_missing_from(&pending_report, &last_report) || has_key_missing_from(report, &pending_report))) {
+        return false;
+    }
+    return !has_key_changed_back(report);
+}
+#endif
+
+/** \brief Sends a report to the host, unless it's the same as the last one
+ */
+static void send_keyboard_report_if_changed(report_keyboard_t *report) {
+    if (is_last_report_known && memcmp(report, &last_report, sizeof(report_keyboard_t)) == 0) {
+        return;
+    }
+    memcpy(&last_report, report, sizeof(report_keyboard_t));
+    is_last_report_known = true;
+#ifdef COALESCE_KEYBOARD_REPORTS
+    memcpy(&sent_report, report, sizeof(report_keyboard_t));
+    host_keyboard_send(&sent_report);
+#else
+    host_keyboard_send(report);
+#endif
+}
+
+/** \brief Send the pending keyboard report
+ *
+ * With COALESCE_KEYBOARD_REPORTS, send_keyboard_report() holds back a report
+ * until the next one can't be merged with it, or until this is called at the
+ * end of the keyboard task. Code that waits between reports should call this
+ * before waiting.
+ */
+void flush_keyboard_report(void) {
+#ifdef COALESCE_KEYBOARD_REPORTS
+    if (has_pending_report) {
+        has_pending_report = false;
+        send_keyboard_report_if_changed(&pending_report);
+    }
+#endif
+}
+
+/** \brief Forget the last keyboard report
+ *
+ * The next report is sent even if it's the same as the last one, for when the
+ * host may not know what the last one was.
+ */
+void forget_last_keyboard_report(void) {
+    flush_keyboard_report();
+    is_last_report_known = false;
+}
+
 /** \brief Send keyboard report
  *
- * FIXME: needs doc
+ * Reports that don't change anything aren't sent. With
+ * COALESCE_KEYBOARD_REPORTS, changes made within the same millisecond are
+ * merged into one report where the host can't tell the difference.
  */
 void send_keyboard_report(void) {
+    report_keys_write(&report_keys, keyboard_report);
     keyboard_report->mods = real_mods;
     keyboard_report->mods |= weak_mods;
     keyboard_report->mods |= macro_mods;
@@ -147,13 +277,30 @@ void send_keyboard_report(void) {
         }
 #    endif
         keyboard_report->mods |= oneshot_mods;
-        if (has_anykey(keyboard_report)) {
+        if (report_keys_count(&report_keys)) {
             clear_oneshot_mods();
         }
     }
 
 #endif
-    host_keyboard_send(keyboard_report);
+#ifdef COALESCE_KEYBOARD_REPORTS
+    if (has_pending_report) {
+        if (timer_read() == pending_report_time && can_merge_keyboard_report(keyboard_report)) {
+            memcpy(&pending_report, keyboard_report, sizeof(report_keyboard_t));
+            return;
+        }
+        flush_keyboard_report();
+    }
+    if (!is_last_report_known) {
+        send_keyboard_report_if_changed(keyboard_report);
+    } else if (memcmp(keyboard_report, &last_report, sizeof(report_keyboard_t)) != 0) {
+        memcpy(&pending_report, keyboard_report, sizeof(report_keyboard_t));
+        has_pending_report  = true;
+        pending_report_time = timer_read();
+    }
+#else
+    send_keyboard_report_if_changed(keyboard_report);
+#endif
 }
 
 /** \brief Get mods
@@ -2,6 +2,8 @@
 #include "i2c_master.h"
 #include "led_matrix.h"
 #include "suspend.h"
+#include "power_state.h"
+#include "eeprom_cache.h"
 
 /** \brief Suspend idle
  *
@@ -31,20 +33,12 @@ void suspend_power_down(void) {
     I2C3733_Control_Set(0);  // Disable LED driver
 #endif
 
+    power_state_suspend();
     suspend_power_down_kb();
+    eeprom_cache_flush();
 }
 
-__attribute__((weak)) void matrix_power_up(void) {}
-__attribute__((weak)) void matrix_power_down(void) {}
-bool                       suspend_wakeup_condition(void) {
-    matrix_power_up();
-    matrix_scan();
-    matrix_power_down();
-    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
-        if (matrix_get_row(r)) return true;
-    }
-    return false;
-}
+bool suspend_wakeup_condition(void) { return power_state_scan(); }
 
 /** \brief run user level code immediately after wakeup
  *
@@ -73,5 +67,6 @@ void suspend_wakeup_init(void) {
 #    endif
 #endif
 
+    power_state_resume();
     suspend_wakeup_init_kb();
 }
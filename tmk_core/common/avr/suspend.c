@@ -6,6 +6,8 @@
 #include "action.h"
 #include "suspend_avr.h"
 #include "suspend.h"
+#include "power_state.h"
+#include "eeprom_cache.h"
 #include "timer.h"
 #include "led.h"
 #include "host.h"
@@ -22,13 +24,6 @@
 #    include "audio.h"
 #endif /* AUDIO_ENABLE */
 
-#if defined(RGBLIGHT_SLEEP) && defined(RGBLIGHT_ENABLE)
-#    include "rgblight.h"
-extern rgblight_config_t rgblight_config;
-static bool              rgblight_enabled;
-static bool              is_suspended;
-#endif
-
 /** \brief Suspend idle
  *
  * FIXME: needs doc
@@ -103,14 +98,6 @@ static void power_down(uint8_t wdto) {
     // This sometimes disables the start-up noise, so it's been disabled
     // stop_all_notes();
 #    endif /* AUDIO_ENABLE */
-#    if defined(RGBLIGHT_SLEEP) && defined(RGBLIGHT_ENABLE)
-    rgblight_timer_disable();
-    if (!is_suspended) {
-        is_suspended     = true;
-        rgblight_enabled = rgblight_config.enable;
-        rgblight_disable_noeeprom();
-    }
-#    endif
     suspend_power_down_kb();
 
     // TODO: more power saving
@@ -135,24 +122,16 @@ static void power_down(uint8_t wdto) {
  * FIXME: needs doc
  */
 void suspend_power_down(void) {
+    power_state_suspend();
     suspend_power_down_kb();
+    eeprom_cache_flush();
 
 #ifndef NO_SUSPEND_POWER_DOWN
     power_down(WDTO_15MS);
 #endif
 }
 
-__attribute__((weak)) void matrix_power_up(void) {}
-__attribute__((weak)) void matrix_power_down(void) {}
-bool                       suspend_wakeup_condition(void) {
-    matrix_power_up();
-    matrix_scan();
-    matrix_power_down();
-    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
-        if (matrix_get_row(r)) return true;
-    }
-    return false;
-}
+bool suspend_wakeup_condition(void) { return power_state_scan(); }
 
 /** \brief run user level code immediately after wakeup
  *
@@ -176,16 +155,7 @@ void suspend_wakeup_init(void) {
     backlight_init();
 #endif
     led_set(host_keyboard_leds());
-#if defined(RGBLIGHT_SLEEP) && defined(RGBLIGHT_ENABLE)
-    is_suspended = false;
-    if (rgblight_enabled) {
-#    ifdef BOOTLOADER_TEENSY
-        wait_ms(10);
-#    endif
-        rgblight_enable_noeeprom();
-    }
-    rgblight_timer_enable();
-#endif
+    power_state_resume();
     suspend_wakeup_init_kb();
 }
 
@@ -18,22 +18,111 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <stdbool.h>
 #include "eeprom_stm32.h"
 /*****************************************************************************
  * Allows to use the internal flash to store non volatile data. To initialize
  * the functionality use the EEPROM_Init() function. Be sure that by reprogramming
  * of the controller just affected pages will be deleted. In other case the non
  * volatile data will be lost.
+ *
+ * Bank layout, all values are half-words:
+ *   magic | generation | snapshot of FEE_DENSITY_BYTES bytes | log of (address, value) records
+ * The magic is written last when a bank is filled, so a bank without it is
+ * incomplete and ignored. The value of a record is written after its address and
+ * never reads back as FEE_EMPTY_WORD, so a torn record is skipped as well.
+ * Flash without a valid bank may hold the previous layout in the pages of bank 1,
+ * which is migrated by writing its contents as a snapshot to bank 0 before
+ * erasing bank 1.
  ******************************************************************************/
 
-/* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
+static uint8_t  DataBuf[FEE_DENSITY_BYTES];
+static uint8_t  ActiveBank;
+static uint16_t ActiveGeneration;
+static uint16_t LogNext;
+
 /* Functions -----------------------------------------------------------------*/
 
-uint8_t DataBuf[FEE_PAGE_SIZE];
+static inline uint16_t FEE_ReadHalfWord(uint8_t bank, uint16_t offset) { return FLASH_READ_HALF_WORD(FEE_BANK_ADDRESS(bank) + offset); }
+
+static inline uint32_t FEE_LogRecordAddress(uint8_t bank, uint16_t record) { return FEE_BANK_ADDRESS(bank) + FEE_LOG_OFFSET + record * FEE_LOG_RECORD_SIZE; }
+
+// Generations wrap around, FEE_EMPTY_WORD is never used
+static uint16_t FEE_NextGeneration(uint16_t generation) { return generation >= FEE_EMPTY_WORD - 1 ? 0 : generation + 1; }
+
+static bool FEE_IsNewerGeneration(uint16_t a, uint16_t b) { return (int16_t)(a - b) > 0; }
+
+static bool FEE_IsBankValid(uint8_t bank) { return FEE_ReadHalfWord(bank, FEE_MAGIC_OFFSET) == FEE_MAGIC_WORD && FEE_ReadHalfWord(bank, FEE_GENERATION_OFFSET) != FEE_EMPTY_WORD; }
+
+static bool FEE_IsBankBlank(uint8_t bank) {
+    for (uint16_t offset = 0; offset < FEE_BANK_SIZE; offset += 2) {
+        if (FEE_ReadHalfWord(bank, offset) != FEE_EMPTY_WORD) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The first page holds the header, so erasing it first invalidates the bank at once
+static FLASH_Status FEE_EraseBank(uint8_t bank) {
+    FLASH_Status FlashStatus = FLASH_COMPLETE;
+    for (uint8_t page = 0; page < FEE_BANK_PAGES && FlashStatus == FLASH_COMPLETE; page++) {
+        FlashStatus = FLASH_ErasePage(FEE_BANK_ADDRESS(bank) + page * FEE_PAGE_SIZE);
+    }
+    return FlashStatus;
+}
+
 /*****************************************************************************
- *  Delete Flash Space used for user Data, deletes the whole space between
- *  RW_PAGE_BASE_ADDRESS and the last uC Flash Page
+ *  Writes the RAM copy as a snapshot to the spare bank, makes it the active one
+ *  and erases the previous bank.
+ ******************************************************************************/
+static FLASH_Status FEE_Compact(void) {
+    FLASH_Status FlashStatus = FLASH_COMPLETE;
+    uint8_t      bank        = ActiveBank ^ 1;
+    uint16_t     generation  = FEE_NextGeneration(ActiveGeneration);
+
+    if (!FEE_IsBankBlank(bank)) {
+        FlashStatus = FEE_EraseBank(bank);
+    }
+    for (uint16_t i = 0; i < FEE_DENSITY_BYTES && FlashStatus == FLASH_COMPLETE; i += 2) {
+        uint16_t data = DataBuf[i] | (DataBuf[i + 1] << 8);
+        if (data != FEE_EMPTY_WORD) {
+            FlashStatus = FLASH_ProgramHalfWord(FEE_BANK_ADDRESS(bank) + FEE_SNAPSHOT_OFFSET + i, data);
+        }
+    }
+    if (FlashStatus == FLASH_COMPLETE) {
+        FlashStatus = FLASH_ProgramHalfWord(FEE_BANK_ADDRESS(bank) + FEE_GENERATION_OFFSET, generation);
+    }
+    if (FlashStatus == FLASH_COMPLETE) {
+        FlashStatus = FLASH_ProgramHalfWord(FEE_BANK_ADDRESS(bank) + FEE_MAGIC_OFFSET, FEE_MAGIC_WORD);
+    }
+    if (FlashStatus != FLASH_COMPLETE) {
+        return FlashStatus;
+    }
+
+    ActiveBank       = bank;
+    ActiveGeneration = generation;
+    LogNext          = 0;
+    if (FEE_IsBankBlank(bank ^ 1)) {
+        return FLASH_COMPLETE;
+    }
+    return FEE_EraseBank(bank ^ 1);
+}
+
+/*****************************************************************************
+ *  Reads the bytes kept in the previous layout into the RAM copy, all of which
+ *  fit as eeprom_stm32.h checks. Erased flash reads as erased bytes.
+ ******************************************************************************/
+static void FEE_ReadLegacy(void) {
+    for (uint16_t i = 0; i < FEE_LEGACY_DENSITY_BYTES; i++) {
+        DataBuf[i] = FLASH_READ_HALF_WORD(FEE_LEGACY_ADDRESS(i)) & 0xFF;
+    }
+}
+
+/*****************************************************************************
+ *  Unlocks the flash and builds the RAM copy from the newest valid bank,
+ *  migrating or formatting the flash if none is found.
  ******************************************************************************/
 uint16_t EEPROM_Init(void) {
     // unlock flash
@@ -42,63 +131,86 @@ uint16_t EEPROM_Init(void) {
     // Clear Flags
     // FLASH_ClearFlag(FLASH_SR_EOP|FLASH_SR_PGERR|FLASH_SR_WRPERR);
 
+    bool valid[2] = {FEE_IsBankValid(0), FEE_IsBankValid(1)};
+
+    memset(DataBuf, 0xFF, sizeof(DataBuf));
+    LogNext = 0;
+
+    if (!valid[0] && !valid[1]) {
+        // Nothing stored yet, or stored in the previous layout, start from a
+        // snapshot in bank 0 so that bank 1 is only erased once it is written
+        FEE_ReadLegacy();
+        ActiveBank       = 1;
+        ActiveGeneration = FEE_EMPTY_WORD;
+        FEE_Compact();
+        return FEE_DENSITY_BYTES;
+    }
+
+    uint16_t generation[2] = {FEE_ReadHalfWord(0, FEE_GENERATION_OFFSET), FEE_ReadHalfWord(1, FEE_GENERATION_OFFSET)};
+    if (!valid[1]) {
+        ActiveBank = 0;
+    } else if (!valid[0]) {
+        ActiveBank = 1;
+    } else {
+        // Power was lost before the previous bank got erased after compacting
+        ActiveBank = FEE_IsNewerGeneration(generation[1], generation[0]) ? 1 : 0;
+        FEE_EraseBank(ActiveBank ^ 1);
+    }
+    ActiveGeneration = generation[ActiveBank];
+
+    for (uint16_t i = 0; i < FEE_DENSITY_BYTES; i += 2) {
+        uint16_t data  = FEE_ReadHalfWord(ActiveBank, FEE_SNAPSHOT_OFFSET + i);
+        DataBuf[i]     = data & 0xFF;
+        DataBuf[i + 1] = data >> 8;
+    }
+
+    for (; LogNext < FEE_LOG_RECORDS; LogNext++) {
+        uint32_t record  = FEE_LogRecordAddress(ActiveBank, LogNext);
+        uint16_t address = FLASH_READ_HALF_WORD(record);
+        uint16_t value   = FLASH_READ_HALF_WORD(record + 2);
+        if (address == FEE_EMPTY_WORD) {
+            break;
+        }
+        if (value != FEE_EMPTY_WORD && address < FEE_DENSITY_BYTES) {
+            DataBuf[address] = (uint8_t)value;
+        }
+    }
+
     return FEE_DENSITY_BYTES;
 }
 /*****************************************************************************
- *  Erase the whole reserved Flash Space used for user Data
+ *  Resets every byte to 0xFF. This writes an empty snapshot, so it is just as
+ *  safe against power loss as a regular write.
  ******************************************************************************/
 void EEPROM_Erase(void) {
-    int page_num = 0;
-
-    // delete all pages from specified start page to the last page
-    do {
-        FLASH_ErasePage(FEE_PAGE_BASE_ADDRESS + (page_num * FEE_PAGE_SIZE));
-        page_num++;
-    } while (page_num < FEE_DENSITY_PAGES);
+    memset(DataBuf, 0xFF, sizeof(DataBuf));
+    FEE_Compact();
 }
 /*****************************************************************************
- *  Writes once data byte to flash on specified address. If a byte is already
- *  written, the whole page must be copied to a buffer, the byte changed and
- *  the manipulated buffer written after PageErase.
+ *  Writes one data byte. Unchanged bytes are skipped, otherwise a record is
+ *  appended to the log, and a new snapshot is only written once it is full.
  *******************************************************************************/
 uint16_t EEPROM_WriteDataByte(uint16_t Address, uint8_t DataByte) {
     FLASH_Status FlashStatus = FLASH_COMPLETE;
 
-    uint32_t page;
-    int      i;
-
-    // exit if desired address is above the limit (e.G. under 2048 Bytes for 4 pages)
-    if (Address > FEE_DENSITY_BYTES) {
-        return 0;
+    // exit if desired address is above the limit
+    if (Address >= FEE_DENSITY_BYTES) {
+        return FLASH_BAD_ADDRESS;
     }
 
-    // calculate which page is affected (Pagenum1/Pagenum2...PagenumN)
-    page = FEE_ADDR_OFFSET(Address) / FEE_PAGE_SIZE;
-
-    // if current data is 0xFF, the byte is empty, just overwrite with the new one
-    if ((*(__IO uint16_t *)(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address))) == FEE_EMPTY_WORD) {
-        FlashStatus = FLASH_ProgramHalfWord(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address), (uint16_t)(0x00FF & DataByte));
-    } else {
-        // Copy Page to a buffer
-        memcpy(DataBuf, (uint8_t *)FEE_PAGE_BASE_ADDRESS + (page * FEE_PAGE_SIZE), FEE_PAGE_SIZE);  // !!! Calculate base address for the desired page
-
-        // check if new data is differ to current data, return if not, proceed if yes
-        if (DataByte == *(__IO uint8_t *)(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address))) {
-            return 0;
-        }
-
-        // manipulate desired data byte in temp data array if new byte is differ to the current
-        DataBuf[FEE_ADDR_OFFSET(Address) % FEE_PAGE_SIZE] = DataByte;
+    if (DataBuf[Address] == DataByte) {
+        return FlashStatus;
+    }
+    DataBuf[Address] = DataByte;
 
-        // Erase Page
-        FlashStatus = FLASH_ErasePage(FEE_PAGE_BASE_ADDRESS + (page * FEE_PAGE_SIZE));
+    if (LogNext >= FEE_LOG_RECORDS) {
+        return FEE_Compact();
+    }
 
-        // Write new data (whole page) to flash if data has been changed
-        for (i = 0; i < (FEE_PAGE_SIZE / 2); i++) {
-            if ((__IO uint16_t)(0xFF00 | DataBuf[FEE_ADDR_OFFSET(i)]) != 0xFFFF) {
-                FlashStatus = FLASH_ProgramHalfWord((FEE_PAGE_BASE_ADDRESS + (page * FEE_PAGE_SIZE)) + (i * 2), (uint16_t)(0xFF00 | DataBuf[FEE_ADDR_OFFSET(i)]));
-            }
-        }
+    uint32_t record = FEE_LogRecordAddress(ActiveBank, LogNext++);
+    FlashStatus     = FLASH_ProgramHalfWord(record, Address);
+    if (FlashStatus == FLASH_COMPLETE) {
+        FlashStatus = FLASH_ProgramHalfWord(record + 2, DataByte);
     }
     return FlashStatus;
 }
@@ -106,56 +218,54 @@ uint16_t EEPROM_WriteDataByte(uint16_t Address, uint8_t DataByte) {
  *  Read once data byte from a specified address.
  *******************************************************************************/
 uint8_t EEPROM_ReadDataByte(uint16_t Address) {
-    uint8_t DataByte = 0xFF;
-
-    // Get Byte from specified address
-    DataByte = (*(__IO uint8_t *)(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address)));
-
-    return DataByte;
+    if (Address >= FEE_DENSITY_BYTES) {
+        return 0xFF;
+    }
+    return DataBuf[Address];
 }
 
 /*****************************************************************************
  *  Wrap library in AVR style functions.
  *******************************************************************************/
 uint8_t eeprom_read_byte(const uint8_t *Address) {
-    const uint16_t p = (const uint32_t)Address;
+    const uint16_t p = (uintptr_t)Address;
     return EEPROM_ReadDataByte(p);
 }
 
 void eeprom_write_byte(uint8_t *Address, uint8_t Value) {
-    uint16_t p = (uint32_t)Address;
+    uint16_t p = (uintptr_t)Address;
     EEPROM_WriteDataByte(p, Value);
 }
 
 void eeprom_update_byte(uint8_t *Address, uint8_t Value) {
-    uint16_t p = (uint32_t)Address;
+    uint16_t p = (uintptr_t)Address;
     EEPROM_WriteDataByte(p, Value);
 }
 
 uint16_t eeprom_read_word(const uint16_t *Address) {
-    const uint16_t p = (const uint32_t)Address;
+    const uint16_t p = (uintptr_t)Address;
     return EEPROM_ReadDataByte(p) | (EEPROM_ReadDataByte(p + 1) << 8);
 }
 
 void eeprom_write_word(uint16_t *Address, uint16_t Value) {
-    uint16_t p = (uint32_t)Address;
+    uint16_t p = (uintptr_t)Address;
     EEPROM_WriteDataByte(p, (uint8_t)Value);
     EEPROM_WriteDataByte(p + 1, (uint8_t)(Value >> 8));
 }
 
 void eeprom_update_word(uint16_t *Address, uint16_t Value) {
-    uint16_t p = (uint32_t)Address;
+    uint16_t p = (uintptr_t)Address;
     EEPROM_WriteDataByte(p, (uint8_t)Value);
     EEPROM_WriteDataByte(p + 1, (uint8_t)(Value >> 8));
 }
 
 uint32_t eeprom_read_dword(const uint32_t *Address) {
-    const uint16_t p = (const uint32_t)Address;
+    const uint16_t p = (uintptr_t)Address;
     return EEPROM_ReadDataByte(p) | (EEPROM_ReadDataByte(p + 1) << 8) | (EEPROM_ReadDataByte(p + 2) << 16) | (EEPROM_ReadDataByte(p + 3) << 24);
 }
 
 void eeprom_write_dword(uint32_t *Address, uint32_t Value) {
-    uint16_t p = (const uint32_t)Address;
+    uint16_t p = (uintptr_t)Address;
     EEPROM_WriteDataByte(p, (uint8_t)Value);
     EEPROM_WriteDataByte(p + 1, (uint8_t)(Value >> 8));
     EEPROM_WriteDataByte(p + 2, (uint8_t)(Value >> 16));
@@ -163,7 +273,7 @@ void eeprom_write_dword(uint32_t *Address, uint32_t Value) {
 }
 
 void eeprom_update_dword(uint32_t *Address, uint32_t Value) {
-    uint16_t p             = (const uint32_t)Address;
+    uint16_t p             = (uintptr_t)Address;
     uint32_t existingValue = EEPROM_ReadDataByte(p) | (EEPROM_ReadDataByte(p + 1) << 8) | (EEPROM_ReadDataByte(p + 2) << 16) | (EEPROM_ReadDataByte(p + 3) << 24);
     if (Value != existingValue) {
         EEPROM_WriteDataByte(p, (uint8_t)Value);
@@ -15,17 +15,26 @@
  *
  * Modifications for QMK and STM32F303 by Yiancar
  *
- * This library assumes 8-bit data locations. To add a new MCU, please provide the flash
- * page size and the total flash size in Kb. The number of available pages must be a multiple
- * of 2. Only half of the pages account for the total EEPROM size.
+ * Writes are appended to a log of (address, value) records behind a snapshot of the
+ * whole EEPROM, and reads are served from a RAM copy built by EEPROM_Init(). The pages
+ * are split into two banks, and only when the log of the active bank is full is a new
+ * snapshot written to the other bank. To add a new MCU, please provide the flash page
+ * size and the total flash size in Kb. The number of pages used must be a multiple of 2.
  * This library also assumes that the pages are not used by the firmware.
+ *
+ * The previous layout stored one byte per half-word in the pages at the top of flash.
+ * Each bank now spans as many pages as that layout used altogether, so the EEPROM keeps
+ * its size: the pages of the previous layout become bank 1, and as many pages below
+ * them are taken for bank 0. Their contents are migrated by EEPROM_Init().
  */
 
 #ifndef __EEPROM_H
 #define __EEPROM_H
 
-#include "ch.h"
-#include "hal.h"
+#ifndef FLASH_STM32_MOCKED
+#    include "ch.h"
+#    include "hal.h"
+#endif
 #include "flash_stm32.h"
 
 // HACK ALERT. This definition may not match your processor
@@ -40,19 +49,35 @@
 #    error "not implemented."
 #endif
 
-#ifndef EEPROM_PAGE_SIZE
+#ifndef FEE_PAGE_SIZE
 #    if defined(MCU_STM32F103RB)
-#        define FEE_PAGE_SIZE (uint16_t)0x400  // Page size = 1KByte
-#        define FEE_DENSITY_PAGES 2            // How many pages are used
+#        define FEE_PAGE_SIZE 0x400  // Page size = 1KByte
 #    elif defined(MCU_STM32F103ZE) || defined(MCU_STM32F103RE) || defined(MCU_STM32F103RD) || defined(MCU_STM32F303CC) || defined(MCU_STM32F072CB)
-#        define FEE_PAGE_SIZE (uint16_t)0x800  // Page size = 2KByte
-#        define FEE_DENSITY_PAGES 4            // How many pages are used
+#        define FEE_PAGE_SIZE 0x800  // Page size = 2KByte
 #    else
 #        error "No MCU type specified. Add something like -DMCU_STM32F103RB to your compiler arguments (probably in a Makefile)."
 #    endif
 #endif
 
-#ifndef EEPROM_START_ADDRESS
+// How many pages the previous layout used at the top of flash, 0 if it never held data
+#ifndef FEE_LEGACY_PAGES
+#    if defined(MCU_STM32F103RB)
+#        define FEE_LEGACY_PAGES 2
+#    else
+#        define FEE_LEGACY_PAGES 4
+#    endif
+#endif
+
+// How many pages are used, changing this moves FEE_PAGE_BASE_ADDRESS and loses the stored data
+#ifndef FEE_DENSITY_PAGES
+#    if FEE_LEGACY_PAGES > 0
+#        define FEE_DENSITY_PAGES (FEE_LEGACY_PAGES * 2)
+#    else
+#        define FEE_DENSITY_PAGES 4
+#    endif
+#endif
+
+#ifndef FEE_PAGE_BASE_ADDRESS
 #    if defined(MCU_STM32F103RB) || defined(MCU_STM32F072CB)
 #        define FEE_MCU_FLASH_SIZE 128  // Size in Kb
 #    elif defined(MCU_STM32F103ZE) || defined(MCU_STM32F103RE)
@@ -64,15 +89,56 @@
 #    else
 #        error "No MCU type specified. Add something like -DMCU_STM32F103RB to your compiler arguments (probably in a Makefile)."
 #    endif
+// Choose location for the first EEPROM Page address on the top of flash
+#    define FEE_PAGE_BASE_ADDRESS ((uint32_t)(0x8000000 + FEE_MCU_FLASH_SIZE * 1024 - FEE_DENSITY_PAGES * FEE_PAGE_SIZE))
 #endif
 
-// DONT CHANGE
-// Choose location for the first EEPROM Page address on the top of flash
-#define FEE_PAGE_BASE_ADDRESS ((uint32_t)(0x8000000 + FEE_MCU_FLASH_SIZE * 1024 - FEE_DENSITY_PAGES * FEE_PAGE_SIZE))
-#define FEE_DENSITY_BYTES ((FEE_PAGE_SIZE / 2) * FEE_DENSITY_PAGES - 1)
-#define FEE_LAST_PAGE_ADDRESS (FEE_PAGE_BASE_ADDRESS + (FEE_PAGE_SIZE * FEE_DENSITY_PAGES))
+// Each bank holds a header, a snapshot of the EEPROM and then the write log
+#define FEE_BANK_PAGES (FEE_DENSITY_PAGES / 2)
+#define FEE_BANK_SIZE (FEE_PAGE_SIZE * FEE_BANK_PAGES)
+#define FEE_BANK_ADDRESS(bank) (FEE_PAGE_BASE_ADDRESS + (bank)*FEE_BANK_SIZE)
+
+// Size of the emulated EEPROM in bytes, by default half of a bank
+// (1024 bytes on STM32F103xB, 4096 bytes otherwise, as with the previous layout)
+#ifndef FEE_DENSITY_BYTES
+#    define FEE_DENSITY_BYTES (FEE_BANK_SIZE / 2)
+#endif
+
+// The header is the layout magic followed by the generation number
+#define FEE_MAGIC_WORD ((uint16_t)0x4546)
+#define FEE_MAGIC_OFFSET 0
+#define FEE_GENERATION_OFFSET 2
+#define FEE_HEADER_SIZE 4
+#define FEE_SNAPSHOT_OFFSET FEE_HEADER_SIZE
+#define FEE_LOG_OFFSET (FEE_SNAPSHOT_OFFSET + FEE_DENSITY_BYTES)
+#define FEE_LOG_RECORD_SIZE 4
+#define FEE_LOG_RECORDS ((FEE_BANK_SIZE - FEE_LOG_OFFSET) / FEE_LOG_RECORD_SIZE)
 #define FEE_EMPTY_WORD ((uint16_t)0xFFFF)
-#define FEE_ADDR_OFFSET(Address) (Address * 2)  // 1Byte per Word will be saved to preserve Flash
+
+// The previous layout stored one byte in the low half of every half-word of its pages,
+// which are the last ones, in bank 1
+#define FEE_LEGACY_DENSITY_BYTES (FEE_LEGACY_PAGES * FEE_PAGE_SIZE / 2)
+#define FEE_LEGACY_BASE_ADDRESS (FEE_PAGE_BASE_ADDRESS + (FEE_DENSITY_PAGES - FEE_LEGACY_PAGES) * FEE_PAGE_SIZE)
+#define FEE_LEGACY_ADDRESS(Address) (FEE_LEGACY_BASE_ADDRESS + (Address)*2)
+
+#if FEE_DENSITY_PAGES % 2 != 0
+#    error "FEE_DENSITY_PAGES must be a multiple of 2"
+#endif
+#if FEE_DENSITY_BYTES % 2 != 0
+#    error "FEE_DENSITY_BYTES must be even"
+#endif
+#if FEE_DENSITY_BYTES > FEE_BANK_SIZE / 2
+#    error "FEE_DENSITY_BYTES must be at most half of a bank"
+#endif
+#if FEE_LEGACY_PAGES > FEE_BANK_PAGES
+#    error "The pages of the previous layout must fit in bank 1, use at least twice as many pages"
+#endif
+#if FEE_DENSITY_BYTES < FEE_LEGACY_DENSITY_BYTES
+#    error "FEE_DENSITY_BYTES would drop data stored with the previous layout, define FEE_LEGACY_PAGES 0 if there is none"
+#endif
+#if FEE_LOG_OFFSET + 16 * FEE_LOG_RECORD_SIZE > FEE_BANK_SIZE
+#    error "FEE_DENSITY_BYTES leaves no room for the write log, lower it or use more pages"
+#endif
 
 // Use this function to initialize the functionality
 uint16_t EEPROM_Init(void);
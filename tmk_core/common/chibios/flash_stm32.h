@@ -23,8 +23,16 @@
 extern "C" {
 #endif
 
-#include "ch.h"
-#include "hal.h"
+#ifdef FLASH_STM32_MOCKED
+#    include <stdint.h>
+// Host builds program a RAM buffer instead, see tmk_core/common/test/flash_stm32_mock.c
+extern uint8_t FlashBuf[];
+#    define FLASH_READ_HALF_WORD(address) (*(uint16_t *)(FlashBuf + (address)))
+#else
+#    include "ch.h"
+#    include "hal.h"
+#    define FLASH_READ_HALF_WORD(address) (*(__IO uint16_t *)(address))
+#endif
 
 typedef enum { FLASH_BUSY = 1, FLASH_ERROR_PG, FLASH_ERROR_WRP, FLASH_ERROR_OPT, FLASH_COMPLETE, FLASH_TIMEOUT, FLASH_BAD_ADDRESS } FLASH_Status;
 
@@ -9,19 +9,14 @@
 #include "mousekey.h"
 #include "host.h"
 #include "suspend.h"
+#include "power_state.h"
+#include "eeprom_cache.h"
 #include "wait.h"
 
 #ifdef BACKLIGHT_ENABLE
 #    include "backlight.h"
 #endif
 
-#if defined(RGBLIGHT_SLEEP) && defined(RGBLIGHT_ENABLE)
-#    include "rgblight.h"
-extern rgblight_config_t rgblight_config;
-static bool              rgblight_enabled;
-static bool              is_suspended;
-#endif
-
 /** \brief suspend idle
  *
  * FIXME: needs doc
@@ -50,14 +45,8 @@ void suspend_power_down(void) {
     // TODO: figure out what to power down and how
     // shouldn't power down TPM/FTM if we want a breathing LED
     // also shouldn't power down USB
-#if defined(RGBLIGHT_SLEEP) && defined(RGBLIGHT_ENABLE)
-    rgblight_timer_disable();
-    if (!is_suspended) {
-        is_suspended     = true;
-        rgblight_enabled = rgblight_config.enable;
-        rgblight_disable_noeeprom();
-    }
-#endif
+    eeprom_cache_flush();
+    power_state_suspend();
 
     suspend_power_down_kb();
     // on AVR, this enables the watchdog for 15ms (max), and goes to
@@ -70,17 +59,7 @@ void suspend_power_down(void) {
  *
  * FIXME: needs doc
  */
-__attribute__((weak)) void matrix_power_up(void) {}
-__attribute__((weak)) void matrix_power_down(void) {}
-bool                       suspend_wakeup_condition(void) {
-    matrix_power_up();
-    matrix_scan();
-    matrix_power_down();
-    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
-        if (matrix_get_row(r)) return true;
-    }
-    return false;
-}
+bool suspend_wakeup_condition(void) { return power_state_scan(); }
 
 /** \brief run user level code immediately after wakeup
  *
@@ -119,12 +98,6 @@ void suspend_wakeup_init(void) {
 #ifdef BACKLIGHT_ENABLE
     backlight_init();
 #endif /* BACKLIGHT_ENABLE */
-#if defined(RGBLIGHT_SLEEP) && defined(RGBLIGHT_ENABLE)
-    is_suspended = false;
-    if (rgblight_enabled) {
-        rgblight_enable_noeeprom();
-    }
-    rgblight_timer_enable();
-#endif
+    power_state_resume();
     suspend_wakeup_init_kb();
 }
@@ -1,6 +1,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "eeprom.h"
+#include "eeprom_cache.h"
 #include "eeconfig.h"
 #include "action_layer.h"
 
@@ -13,6 +14,98 @@
 #    include "eeprom_driver.h"
 #endif
 
+#ifdef DYNAMIC_KEYMAP_ENABLE
+#    include "dynamic_keymap.h"
+#endif
+
+// End of the data that other features keep right behind the block, which has
+// to move along when a legacy block grows. By default that is VIA and the
+// dynamic keymaps, keyboards that keep data there themselves can set it.
+#ifndef EECONFIG_LEGACY_DATA_END
+#    ifdef DYNAMIC_KEYMAP_ENABLE
+#        define EECONFIG_LEGACY_DATA_END (DYNAMIC_KEYMAP_EEPROM_MAX_ADDR + 1)
+#    else
+#        define EECONFIG_LEGACY_DATA_END EECONFIG_SIZE_LEGACY
+#    endif
+#endif
+
+_Static_assert(sizeof(eeconfig_t) == EECONFIG_SIZE, "eeconfig_t doesn't match EECONFIG_SIZE");
+_Static_assert(offsetof(eeconfig_t, crc) == EECONFIG_SIZE - 2, "eeconfig_t doesn't match EECONFIG_CRC");
+
+// RAM copy of the block, loaded with a single read the first time it's used
+static eeconfig_t eeconfig;
+static bool       eeconfig_loaded = false;
+static bool       eeconfig_valid  = false;
+
+#define EECONFIG_BYTES ((uint8_t *)&eeconfig)
+
+// CRC-16/CCITT of everything up to the CRC itself
+static uint16_t eeconfig_crc(void) {
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i < offsetof(eeconfig_t, crc); i++) {
+        crc ^= EECONFIG_BYTES[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static void eeconfig_seal(void) {
+    eeconfig.crc = eeconfig_crc();
+    eeprom_cached_update_word(EECONFIG_CRC, eeconfig.crc);
+}
+
+// Brings a block written by older firmware up to date, one version at a time,
+// so that settings survive firmware updates. Fields that a version adds should
+// get the same default as in eeconfig_init_quantum().
+static void eeconfig_migrate(uint8_t version) {
+    if (version < 1) {
+        // The legacy layout has the same fields at the same addresses, only
+        // the version and CRC are new. What followed the block is moved up to
+        // stay behind it, starting from the end, which drops the last bytes
+        // before EECONFIG_LEGACY_DATA_END. A power loss part way through can
+        // leave some of it moved twice, as the block is only written after.
+        for (uint16_t addr = EECONFIG_LEGACY_DATA_END - 1; addr >= EECONFIG_SIZE; addr--) {
+            eeprom_cached_update_byte((uint8_t *)(uintptr_t)addr, eeprom_cached_read_byte((uint8_t *)(uintptr_t)(addr - (EECONFIG_SIZE - EECONFIG_SIZE_LEGACY))));
+        }
+    }
+    eeconfig.magic   = EECONFIG_MAGIC_NUMBER;
+    eeconfig.version = EECONFIG_VERSION;
+    eeconfig.crc     = eeconfig_crc();
+    eeprom_cached_update_block(&eeconfig, EECONFIG_MAGIC, sizeof(eeconfig));
+}
+
+/** \brief eeconfig load
+ *
+ * Reloads the RAM copy from EEPROM, migrating it if it was written by older
+ * firmware. Only needed if the EEPROM was changed behind eeconfig's back.
+ */
+void eeconfig_load(void) {
+    eeprom_cached_read_block(&eeconfig, EECONFIG_MAGIC, sizeof(eeconfig));
+    eeconfig_loaded = true;
+    eeconfig_valid  = false;
+    if (eeconfig.magic == EECONFIG_MAGIC_NUMBER) {
+        // A corrupt block, or one from newer firmware, can't be trusted
+        if (eeconfig.crc != eeconfig_crc() || eeconfig.version > EECONFIG_VERSION) {
+            return;
+        }
+        if (eeconfig.version < EECONFIG_VERSION) {
+            eeconfig_migrate(eeconfig.version);
+        }
+        eeconfig_valid = true;
+    } else if (eeconfig.magic == EECONFIG_MAGIC_NUMBER_LEGACY) {
+        eeconfig_migrate(0);
+        eeconfig_valid = true;
+    }
+}
+
+static inline void eeconfig_ensure_loaded(void) {
+    if (!eeconfig_loaded) {
+        eeconfig_load();
+    }
+}
+
 /** \brief eeconfig enable
  *
  * FIXME: needs doc
@@ -33,39 +126,51 @@ __attribute__((weak)) void eeconfig_init_kb(void) {
  * FIXME: needs doc
  */
 void eeconfig_init_quantum(void) {
+    // Pending writes must not land on top of the erased EEPROM
+    eeprom_cache_flush();
 #ifdef STM32_EEPROM_ENABLE
     EEPROM_Erase();
 #endif
 #if defined(EEPROM_DRIVER)
     eeprom_driver_erase();
 #endif
-    eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER);
-    eeprom_update_byte(EECONFIG_DEBUG, 0);
-    eeprom_update_byte(EECONFIG_DEFAULT_LAYER, 0);
-    default_layer_state = 0;
-    eeprom_update_byte(EECONFIG_KEYMAP_LOWER_BYTE, 0);
-    eeprom_update_byte(EECONFIG_KEYMAP_UPPER_BYTE, 0);
-    eeprom_update_byte(EECONFIG_MOUSEKEY_ACCEL, 0);
-    eeprom_update_byte(EECONFIG_BACKLIGHT, 0);
-    eeprom_update_byte(EECONFIG_AUDIO, 0xFF);  // On by default
-    eeprom_update_dword(EECONFIG_RGBLIGHT, 0);
-    eeprom_update_byte(EECONFIG_STENOMODE, 0);
-    eeprom_update_dword(EECONFIG_HAPTIC, 0);
-    eeprom_update_byte(EECONFIG_VELOCIKEY, 0);
-    eeprom_update_dword(EECONFIG_RGB_MATRIX, 0);
-    eeprom_update_byte(EECONFIG_RGB_MATRIX_SPEED, 0);
+    // Start from what the erase left behind, so that the fields
+    // which aren't reset here keep their value
+    eeprom_cached_read_block(&eeconfig, EECONFIG_MAGIC, sizeof(eeconfig));
+    eeconfig.magic            = EECONFIG_MAGIC_NUMBER;
+    eeconfig.debug            = 0;
+    eeconfig.default_layer    = 0;
+    default_layer_state       = 0;
+    eeconfig.keymap_lower     = 0;
+    eeconfig.keymap_upper     = 0;
+    eeconfig.mousekey_accel   = 0;
+    eeconfig.backlight        = 0;
+    eeconfig.audio            = 0xFF;  // On by default
+    eeconfig.rgblight         = 0;
+    eeconfig.steno_mode       = 0;
+    eeconfig.haptic           = 0;
+    eeconfig.velocikey        = 0;
+    eeconfig.rgb_matrix       = 0;
+    eeconfig.rgb_matrix_speed = 0;
 
     // TODO: Remove once ARM has a way to configure EECONFIG_HANDEDNESS
     //        within the emulated eeprom via dfu-util or another tool
 #if defined INIT_EE_HANDS_LEFT
 #    pragma message "Faking EE_HANDS for left hand"
-    eeprom_update_byte(EECONFIG_HANDEDNESS, 1);
+    eeconfig.handedness = 1;
 #elif defined INIT_EE_HANDS_RIGHT
 #    pragma message "Faking EE_HANDS for right hand"
-    eeprom_update_byte(EECONFIG_HANDEDNESS, 0);
+    eeconfig.handedness = 0;
 #endif
 
+    eeconfig.version = EECONFIG_VERSION;
+    eeconfig.crc     = eeconfig_crc();
+    eeconfig_loaded  = true;
+    eeconfig_valid   = true;
+    eeprom_cached_update_block(&eeconfig, EECONFIG_MAGIC, sizeof(eeconfig));
+
     eeconfig_init_kb();
+    eeprom_cache_flush();
 }
 
 /** \brief eeconfig initialization
@@ -78,132 +183,207 @@ void eeconfig_init(void) { eeconfig_init_quantum(); }
  *
  * FIXME: needs doc
  */
-void eeconfig_enable(void) { eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER); }
+void eeconfig_enable(void) {
+    eeconfig_ensure_loaded();
+    eeconfig.magic   = EECONFIG_MAGIC_NUMBER;
+    eeconfig.version = EECONFIG_VERSION;
+    eeprom_cached_update_word(EECONFIG_MAGIC, eeconfig.magic);
+    eeprom_cached_update_byte(EECONFIG_VERSION_BYTE, eeconfig.version);
+    eeconfig_seal();
+    eeconfig_valid = true;
+}
 
 /** \brief eeconfig disable
  *
  * FIXME: needs doc
  */
 void eeconfig_disable(void) {
+    eeprom_cache_flush();
 #ifdef STM32_EEPROM_ENABLE
     EEPROM_Erase();
 #endif
 #if defined(EEPROM_DRIVER)
     eeprom_driver_erase();
 #endif
-    eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER_OFF);
+    eeprom_cached_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER_OFF);
+    eeprom_cache_flush();
+    // Pick up the erased state the next time around
+    eeconfig_loaded = false;
 }
 
 /** \brief eeconfig is enabled
  *
  * FIXME: needs doc
  */
-bool eeconfig_is_enabled(void) { return (eeprom_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER); }
+bool eeconfig_is_enabled(void) {
+    eeconfig_ensure_loaded();
+    return eeconfig_valid;
+}
 
 /** \brief eeconfig is disabled
  *
  * FIXME: needs doc
  */
-bool eeconfig_is_disabled(void) { return (eeprom_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER_OFF); }
+bool eeconfig_is_disabled(void) {
+    eeconfig_ensure_loaded();
+    return eeconfig.magic == EECONFIG_MAGIC_NUMBER_OFF;
+}
 
 /** \brief eeconfig read debug
  *
  * FIXME: needs doc
  */
-uint8_t eeconfig_read_debug(void) { return eeprom_read_byte(EECONFIG_DEBUG); }
+uint8_t eeconfig_read_debug(void) { return eeconfig_read_byte(EECONFIG_DEBUG); }
 /** \brief eeconfig update debug
  *
  * FIXME: needs doc
  */
-void eeconfig_update_debug(uint8_t val) { eeprom_update_byte(EECONFIG_DEBUG, val); }
+void eeconfig_update_debug(uint8_t val) { eeconfig_update_byte(EECONFIG_DEBUG, val); }
 
 /** \brief eeconfig read default layer
  *
  * FIXME: needs doc
  */
-uint8_t eeconfig_read_default_layer(void) { return eeprom_read_byte(EECONFIG_DEFAULT_LAYER); }
+uint8_t eeconfig_read_default_layer(void) { return eeconfig_read_byte(EECONFIG_DEFAULT_LAYER); }
 /** \brief eeconfig update default layer
  *
  * FIXME: needs doc
  */
-void eeconfig_update_default_layer(uint8_t val) { eeprom_update_byte(EECONFIG_DEFAULT_LAYER, val); }
+void eeconfig_update_default_layer(uint8_t val) { eeconfig_update_byte(EECONFIG_DEFAULT_LAYER, val); }
 
 /** \brief eeconfig read keymap
  *
  * FIXME: needs doc
  */
-uint16_t eeconfig_read_keymap(void) { return (eeprom_read_byte(EECONFIG_KEYMAP_LOWER_BYTE) | (eeprom_read_byte(EECONFIG_KEYMAP_UPPER_BYTE) << 8)); }
+uint16_t eeconfig_read_keymap(void) { return (eeconfig_read_byte(EECONFIG_KEYMAP_LOWER_BYTE) | (eeconfig_read_byte(EECONFIG_KEYMAP_UPPER_BYTE) << 8)); }
 /** \brief eeconfig update keymap
  *
  * FIXME: needs doc
  */
 void eeconfig_update_keymap(uint16_t val) {
-    eeprom_update_byte(EECONFIG_KEYMAP_LOWER_BYTE, val & 0xFF);
-    eeprom_update_byte(EECONFIG_KEYMAP_UPPER_BYTE, (val >> 8) & 0xFF);
+    eeconfig_update_byte(EECONFIG_KEYMAP_LOWER_BYTE, val & 0xFF);
+    eeconfig_update_byte(EECONFIG_KEYMAP_UPPER_BYTE, (val >> 8) & 0xFF);
 }
 
 /** \brief eeconfig read backlight
  *
  * FIXME: needs doc
  */
-uint8_t eeconfig_read_backlight(void) { return eeprom_read_byte(EECONFIG_BACKLIGHT); }
+uint8_t eeconfig_read_backlight(void) { return eeconfig_read_byte(EECONFIG_BACKLIGHT); }
 /** \brief eeconfig update backlight
  *
  * FIXME: needs doc
  */
-void eeconfig_update_backlight(uint8_t val) { eeprom_update_byte(EECONFIG_BACKLIGHT, val); }
+void eeconfig_update_backlight(uint8_t val) { eeconfig_update_byte(EECONFIG_BACKLIGHT, val); }
 
 /** \brief eeconfig read audio
  *
  * FIXME: needs doc
  */
-uint8_t eeconfig_read_audio(void) { return eeprom_read_byte(EECONFIG_AUDIO); }
+uint8_t eeconfig_read_audio(void) { return eeconfig_read_byte(EECONFIG_AUDIO); }
 /** \brief eeconfig update audio
  *
  * FIXME: needs doc
  */
-void eeconfig_update_audio(uint8_t val) { eeprom_update_byte(EECONFIG_AUDIO, val); }
+void eeconfig_update_audio(uint8_t val) { eeconfig_update_byte(EECONFIG_AUDIO, val); }
 
 /** \brief eeconfig read kb
  *
  * FIXME: needs doc
  */
-uint32_t eeconfig_read_kb(void) { return eeprom_read_dword(EECONFIG_KEYBOARD); }
+uint32_t eeconfig_read_kb(void) { return eeconfig_read_dword(EECONFIG_KEYBOARD); }
 /** \brief eeconfig update kb
  *
  * FIXME: needs doc
  */
-void eeconfig_update_kb(uint32_t val) { eeprom_update_dword(EECONFIG_KEYBOARD, val); }
+void eeconfig_update_kb(uint32_t val) { eeconfig_update_dword(EECONFIG_KEYBOARD, val); }
 
 /** \brief eeconfig read user
  *
  * FIXME: needs doc
  */
-uint32_t eeconfig_read_user(void) { return eeprom_read_dword(EECONFIG_USER); }
+uint32_t eeconfig_read_user(void) { return eeconfig_read_dword(EECONFIG_USER); }
 /** \brief eeconfig update user
  *
  * FIXME: needs doc
  */
-void eeconfig_update_user(uint32_t val) { eeprom_update_dword(EECONFIG_USER, val); }
+void eeconfig_update_user(uint32_t val) { eeconfig_update_dword(EECONFIG_USER, val); }
 
 /** \brief eeconfig read haptic
  *
  * FIXME: needs doc
  */
-uint32_t eeconfig_read_haptic(void) { return eeprom_read_dword(EECONFIG_HAPTIC); }
+uint32_t eeconfig_read_haptic(void) { return eeconfig_read_dword(EECONFIG_HAPTIC); }
 /** \brief eeconfig update haptic
  *
  * FIXME: needs doc
  */
-void eeconfig_update_haptic(uint32_t val) { eeprom_update_dword(EECONFIG_HAPTIC, val); }
+void eeconfig_update_haptic(uint32_t val) { eeconfig_update_dword(EECONFIG_HAPTIC, val); }
 
 /** \brief eeconfig read split handedness
  *
  * FIXME: needs doc
  */
-bool eeconfig_read_handedness(void) { return !!eeprom_read_byte(EECONFIG_HANDEDNESS); }
+bool eeconfig_read_handedness(void) { return !!eeconfig_read_byte(EECONFIG_HANDEDNESS); }
 /** \brief eeconfig update split handedness
  *
  * FIXME: needs doc
  */
-void eeconfig_update_handedness(bool val) { eeprom_update_byte(EECONFIG_HANDEDNESS, !!val); }
+void eeconfig_update_handedness(bool val) { eeconfig_update_byte(EECONFIG_HANDEDNESS, !!val); }
+
+/** \brief eeconfig read block
+ *
+ * Reads from the RAM copy, addresses past the block are read from EEPROM.
+ */
+void eeconfig_read_block(void *buf, const void *addr, size_t len) {
+    uint8_t * dest   = (uint8_t *)buf;
+    uintptr_t offset = (uintptr_t)addr;
+    eeconfig_ensure_loaded();
+    for (; len > 0 && offset < EECONFIG_SIZE; len--) {
+        *dest++ = EECONFIG_BYTES[offset++];
+    }
+    if (len > 0) {
+        eeprom_cached_read_block(dest, (const void *)offset, len);
+    }
+}
+
+/** \brief eeconfig update block
+ *
+ * Updates the RAM copy, the EEPROM and the CRC. The version and CRC
+ * themselves can't be written, addresses past the block go to EEPROM.
+ */
+void eeconfig_update_block(const void *buf, void *addr, size_t len) {
+    const uint8_t *src    = (const uint8_t *)buf;
+    uintptr_t      offset = (uintptr_t)addr;
+    bool           dirty  = false;
+    eeconfig_ensure_loaded();
+    for (; len > 0 && offset < EECONFIG_SIZE; len--, offset++, src++) {
+        if (offset < offsetof(eeconfig_t, version) && EECONFIG_BYTES[offset] != *src) {
+            EECONFIG_BYTES[offset] = *src;
+            eeprom_cached_update_byte((uint8_t *)offset, *src);
+            dirty = true;
+        }
+    }
+    if (len > 0) {
+        eeprom_cached_update_block(src, (void *)offset, len);
+    }
+    if (dirty) {
+        eeconfig_seal();
+    }
+}
+
+uint8_t eeconfig_read_byte(const void *addr) {
+    uint8_t val;
+    eeconfig_read_block(&val, addr, sizeof(val));
+    return val;
+}
+
+void eeconfig_update_byte(void *addr, uint8_t val) { eeconfig_update_block(&val, addr, sizeof(val)); }
+
+uint32_t eeconfig_read_dword(const void *addr) {
+    uint32_t val;
+    eeconfig_read_block(&val, addr, sizeof(val));
+    return val;
+}
+
+void eeconfig_update_dword(void *addr, uint32_t val) { eeconfig_update_block(&val, addr, sizeof(val)); }
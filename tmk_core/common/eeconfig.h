@@ -20,11 +20,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifndef EECONFIG_MAGIC_NUMBER
-#    define EECONFIG_MAGIC_NUMBER (uint16_t)0xFEEC
+#    define EECONFIG_MAGIC_NUMBER (uint16_t)0xFEED
 #endif
 #define EECONFIG_MAGIC_NUMBER_OFF (uint16_t)0xFFFF
+// Magic of the layout from before it had a version and CRC,
+// which is migrated rather than reset
+#define EECONFIG_MAGIC_NUMBER_LEGACY (uint16_t)0xFEEC
+
+// Bump this, and add a step to eeconfig_migrate(), whenever a field
+// changes meaning or moves
+#define EECONFIG_VERSION 1
 
 /* EEPROM parameter address */
 #define EECONFIG_MAGIC (uint16_t *)0
@@ -48,8 +56,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define EECONFIG_RGB_MATRIX_SPEED (uint8_t *)32
 // TODO: Combine these into a single word and single block of EEPROM
 #define EECONFIG_KEYMAP_UPPER_BYTE (uint8_t *)33
+#define EECONFIG_VERSION_BYTE (uint8_t *)34
+// CRC16 of everything before it
+#define EECONFIG_CRC (uint16_t *)35
 // Size of EEPROM being used, other code can refer to this for available EEPROM
-#define EECONFIG_SIZE 34
+#define EECONFIG_SIZE 37
+// Size before the version and CRC were added, see eeconfig_migrate()
+#define EECONFIG_SIZE_LEGACY 34
 /* debug bit */
 #define EECONFIG_DEBUG_ENABLE (1 << 0)
 #define EECONFIG_DEBUG_MATRIX (1 << 1)
@@ -68,6 +81,30 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #define EECONFIG_KEYMAP_LOWER_BYTE EECONFIG_KEYMAP
 
+// The whole block as it is laid out in EEPROM, and mirrored in RAM
+typedef struct {
+    uint16_t magic;
+    uint8_t  debug;
+    uint8_t  default_layer;
+    uint8_t  keymap_lower;
+    uint8_t  mousekey_accel;
+    uint8_t  backlight;
+    uint8_t  audio;
+    uint32_t rgblight;
+    uint8_t  unicode_mode;
+    uint8_t  steno_mode;
+    uint8_t  handedness;
+    uint32_t keyboard;
+    uint32_t user;
+    uint8_t  velocikey;
+    uint32_t haptic;
+    uint32_t rgb_matrix;
+    uint8_t  rgb_matrix_speed;
+    uint8_t  keymap_upper;
+    uint8_t  version;
+    uint16_t crc;
+} __attribute__((packed)) eeconfig_t;
+
 bool eeconfig_is_enabled(void);
 bool eeconfig_is_disabled(void);
 
@@ -76,6 +113,8 @@ void eeconfig_init_quantum(void);
 void eeconfig_init_kb(void);
 void eeconfig_init_user(void);
 
+void eeconfig_load(void);
+
 void eeconfig_enable(void);
 
 void eeconfig_disable(void);
@@ -112,4 +151,15 @@ void     eeconfig_update_haptic(uint32_t val);
 bool eeconfig_read_handedness(void);
 void eeconfig_update_handedness(bool val);
 
+// Access to the fields by address, for features that keep their own
+// format in them. These must be used rather than the eeprom_* functions,
+// which would bypass the RAM copy and CRC. Addresses past EECONFIG_SIZE
+// go straight to EEPROM.
+uint8_t  eeconfig_read_byte(const void *addr);
+void     eeconfig_update_byte(void *addr, uint8_t val);
+uint32_t eeconfig_read_dword(const void *addr);
+void     eeconfig_update_dword(void *addr, uint32_t val);
+void     eeconfig_read_block(void *buf, const void *addr, size_t len);
+void     eeconfig_update_block(const void *buf, void *addr, size_t len);
+
 #endif
@@ -0,0 +1,140 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "eeprom_cache.h"
+#include "timer.h"
+
+#if EEPROM_CACHE_SIZE > 255
+#    error EEPROM_CACHE_SIZE must be at most 255
+#endif
+
+// Dirty bytes, sorted by address so that runs can be written as one block
+static uint16_t dirty_address[EEPROM_CACHE_SIZE];
+static uint8_t  dirty_value[EEPROM_CACHE_SIZE];
+static uint8_t  dirty_count = 0;
+static uint16_t last_update = 0;
+
+// Index of the first dirty byte at or after address
+static uint8_t lower_bound(uint16_t address) {
+    uint8_t low  = 0;
+    uint8_t high = dirty_count;
+    while (low < high) {
+        uint8_t mid = (low + high) / 2;
+        if (dirty_address[mid] < address) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+bool eeprom_cache_is_dirty(void) { return dirty_count > 0; }
+
+void eeprom_cache_flush(void) {
+    uint8_t start = 0;
+    while (start < dirty_count) {
+        uint8_t end = start + 1;
+        while (end < dirty_count && dirty_address[end] == dirty_address[end - 1] + 1) {
+            end++;
+        }
+        eeprom_update_block(&dirty_value[start], (void *)(uintptr_t)dirty_address[start], end - start);
+        start = end;
+    }
+    dirty_count = 0;
+}
+
+void eeprom_cache_task(void) {
+    if (dirty_count > 0 && timer_elapsed(last_update) >= EEPROM_CACHE_FLUSH_DELAY) {
+        eeprom_cache_flush();
+    }
+}
+
+uint8_t eeprom_cached_read_byte(const uint8_t *addr) {
+    uint16_t address = (uintptr_t)addr;
+    uint8_t  i       = lower_bound(address);
+    if (i < dirty_count && dirty_address[i] == address) {
+        return dirty_value[i];
+    }
+    return eeprom_read_byte(addr);
+}
+
+uint16_t eeprom_cached_read_word(const uint16_t *addr) {
+    const uint8_t *p = (const uint8_t *)addr;
+    return eeprom_cached_read_byte(p) | (eeprom_cached_read_byte(p + 1) << 8);
+}
+
+uint32_t eeprom_cached_read_dword(const uint32_t *addr) {
+    const uint8_t *p = (const uint8_t *)addr;
+    return eeprom_cached_read_byte(p) | (eeprom_cached_read_byte(p + 1) << 8) | ((uint32_t)eeprom_cached_read_byte(p + 2) << 16) | ((uint32_t)eeprom_cached_read_byte(p + 3) << 24);
+}
+
+void eeprom_cached_read_block(void *buf, const void *addr, size_t len) {
+    uint16_t address = (uintptr_t)addr;
+    eeprom_read_block(buf, addr, len);
+    // Overlay the dirty bytes that fall inside the block
+    for (uint8_t i = lower_bound(address); i < dirty_count && dirty_address[i] < address + len; i++) {
+        ((uint8_t *)buf)[dirty_address[i] - address] = dirty_value[i];
+    }
+}
+
+void eeprom_cached_update_byte(uint8_t *addr, uint8_t value) {
+    uint16_t address = (uintptr_t)addr;
+    uint8_t  i       = lower_bound(address);
+    last_update      = timer_read();
+    if (i < dirty_count && dirty_address[i] == address) {
+        dirty_value[i] = value;
+        return;
+    }
+    if (dirty_count == EEPROM_CACHE_SIZE) {
+        eeprom_cache_flush();
+        i = 0;
+    }
+    memmove(&dirty_address[i + 1], &dirty_address[i], (dirty_count - i) * sizeof(dirty_address[0]));
+    memmove(&dirty_value[i + 1], &dirty_value[i], dirty_count - i);
+    dirty_address[i] = address;
+    dirty_value[i]   = value;
+    dirty_count++;
+}
+
+void eeprom_cached_update_word(uint16_t *addr, uint16_t value) {
+    uint8_t *p = (uint8_t *)addr;
+    eeprom_cached_update_byte(p, value);
+    eeprom_cached_update_byte(p + 1, value >> 8);
+}
+
+void eeprom_cached_update_dword(uint32_t *addr, uint32_t value) {
+    uint8_t *p = (uint8_t *)addr;
+    eeprom_cached_update_byte(p, value);
+    eeprom_cached_update_byte(p + 1, value >> 8);
+    eeprom_cached_update_byte(p + 2, value >> 16);
+    eeprom_cached_update_byte(p + 3, value >> 24);
+}
+
+void eeprom_cached_update_block(const void *buf, void *addr, size_t len) {
+    // Bulk writes gain nothing from the cache, so write them through
+    if (len >= EEPROM_CACHE_SIZE) {
+        eeprom_cache_flush();
+        eeprom_update_block(buf, addr, len);
+        return;
+    }
+    uint8_t *      p   = (uint8_t *)addr;
+    const uint8_t *src = (const uint8_t *)buf;
+    while (len--) {
+        eeprom_cached_update_byte(p++, *src++);
+    }
+}
@@ -0,0 +1,71 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TMK_CORE_COMMON_EEPROM_CACHE_H_
+#define TMK_CORE_COMMON_EEPROM_CACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "eeprom.h"
+
+/* Write-back cache in front of the EEPROM driver.
+ *
+ * Updates are held in RAM, merged with later updates of the same bytes, and
+ * written out as contiguous blocks once no update has happened for
+ * EEPROM_CACHE_FLUSH_DELAY ms, when the cache is full, on suspend, or when
+ * eeprom_cache_flush() is called. Data that is updated through the cache must
+ * also be read through it. Without EEPROM_CACHE_ENABLE everything maps
+ * straight to the driver.
+ */
+#ifdef EEPROM_CACHE_ENABLE
+// Number of dirty bytes that can be held before the cache has to be flushed
+#    ifndef EEPROM_CACHE_SIZE
+#        define EEPROM_CACHE_SIZE 32
+#    endif
+
+#    ifndef EEPROM_CACHE_FLUSH_DELAY
+#        define EEPROM_CACHE_FLUSH_DELAY 2000
+#    endif
+
+uint8_t  eeprom_cached_read_byte(const uint8_t *addr);
+uint16_t eeprom_cached_read_word(const uint16_t *addr);
+uint32_t eeprom_cached_read_dword(const uint32_t *addr);
+void     eeprom_cached_read_block(void *buf, const void *addr, size_t len);
+void     eeprom_cached_update_byte(uint8_t *addr, uint8_t value);
+void     eeprom_cached_update_word(uint16_t *addr, uint16_t value);
+void     eeprom_cached_update_dword(uint32_t *addr, uint32_t value);
+void     eeprom_cached_update_block(const void *buf, void *addr, size_t len);
+
+bool eeprom_cache_is_dirty(void);
+void eeprom_cache_flush(void);
+void eeprom_cache_task(void);
+#else
+#    define eeprom_cached_read_byte eeprom_read_byte
+#    define eeprom_cached_read_word eeprom_read_word
+#    define eeprom_cached_read_dword eeprom_read_dword
+#    define eeprom_cached_read_block eeprom_read_block
+#    define eeprom_cached_update_byte eeprom_update_byte
+#    define eeprom_cached_update_word eeprom_update_word
+#    define eeprom_cached_update_dword eeprom_update_dword
+#    define eeprom_cached_update_block eeprom_update_block
+
+#    define eeprom_cache_is_dirty() false
+#    define eeprom_cache_flush()
+#    define eeprom_cache_task()
+#endif
+
+#endif /* TMK_CORE_COMMON_EEPROM_CACHE_H_ */
@@ -21,15 +21,40 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "host.h"
 #include "util.h"
 #include "debug.h"
+#include <string.h>
 
 #ifdef NKRO_ENABLE
 #    include "keycode_config.h"
 extern keymap_config_t keymap_config;
 #endif
+#ifdef COALESCE_MOUSE_REPORTS
+#    include "timer.h"
+#    include "wait.h"
+#endif
 
 static host_driver_t *driver;
 static uint16_t       last_system_report   = 0;
 static uint16_t       last_consumer_report = 0;
+#ifdef COALESCE_MOUSE_REPORTS
+// at most one report per polling interval, which defaults as in the USB descriptors
+#    ifndef MOUSE_REPORT_INTERVAL_MS
+#        if defined(USB_POLLING_INTERVAL_MS)
+#            define MOUSE_REPORT_INTERVAL_MS USB_POLLING_INTERVAL_MS
+#        elif defined(USB_SOF_SYNC) || defined(PROTOCOL_VUSB)
+#            define MOUSE_REPORT_INTERVAL_MS 1
+#        else
+#            define MOUSE_REPORT_INTERVAL_MS 10
+#        endif
+#    endif
+static uint8_t  mouse_source_buttons[MOUSE_SOURCE_COUNT] = {0};
+static int16_t  mouse_x = 0, mouse_y = 0, mouse_v = 0, mouse_h = 0;  // motion not sent yet
+static uint8_t  last_mouse_buttons = 0;
+static uint16_t last_mouse_time    = 0;
+#endif
+#ifdef NKRO_HYBRID
+static bool is_nkro_report = false;  // the report being sent
+static bool is_nkro_keys   = false;  // the reports the keys are sent in
+#endif
 
 void host_set_driver(host_driver_t *d) { driver = d; }
 
@@ -45,6 +70,51 @@ led_t host_keyboard_led_state(void) {
     return (led_t)((*driver->keyboard_leds)());
 }
 
+#ifdef NKRO_HYBRID
+/* sends a report in the format the driver is told it's in */
+static void send_keyboard_as(report_keyboard_t *report, bool nkro) {
+    is_nkro_report = nkro;
+    (*driver->send_keyboard)(report);
+}
+
+/* Sends an NKRO report as a 6KRO one, unless it has more keys than that. When
+ * the format changes, the new report is sent first, then an empty one in the
+ * old format, so that nothing stays pressed there. */
+static void send_hybrid_keyboard(report_keyboard_t *report) {
+    report_keyboard_t boot  = {};
+    uint8_t           count = 0;
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_BITS; i++) {
+        for (uint8_t bits = report->nkro.bits[i]; bits; bits &= bits - 1) {
+            if (count < KEYBOARD_REPORT_KEYS) {
+                boot.keys[count] = i << 3 | __builtin_ctz(bits);
+            }
+            count++;
+        }
+    }
+#    ifdef KEYBOARD_SHARED_EP
+    boot.report_id = REPORT_ID_KEYBOARD;
+#    endif
+
+    bool was_nkro = is_nkro_keys;
+    is_nkro_keys  = count > KEYBOARD_REPORT_KEYS;
+    if (is_nkro_keys) {
+        send_keyboard_as(report, true);
+        if (!was_nkro) {
+            memset(boot.keys, 0, sizeof(boot.keys));
+            send_keyboard_as(&boot, false);
+        }
+    } else {
+        boot.mods = report->nkro.mods;
+        send_keyboard_as(&boot, false);
+        if (was_nkro) {
+            report_keyboard_t empty = {};
+            empty.nkro.report_id    = REPORT_ID_NKRO;
+            send_keyboard_as(&empty, true);
+        }
+    }
+}
+#endif
+
 /* send report */
 void host_keyboard_send(report_keyboard_t *report) {
     if (!driver) return;
@@ -62,7 +132,15 @@ void host_keyboard_send(report_keyboard_t *report) {
         report->report_id = REPORT_ID_KEYBOARD;
 #endif
     }
+#ifdef NKRO_HYBRID
+    if (keyboard_protocol && keymap_config.nkro) {
+        send_hybrid_keyboard(report);
+    } else {
+        send_keyboard_as(report, false);
+    }
+#else
     (*driver->send_keyboard)(report);
+#endif
 
     if (debug_keyboard) {
         dprint("keyboard_report: ");
@@ -73,6 +151,21 @@ void host_keyboard_send(report_keyboard_t *report) {
     }
 }
 
+/** \brief Checks if the keyboard report being sent is an NKRO report
+ *
+ * For the drivers, which send NKRO reports on another endpoint. With
+ * NKRO_HYBRID this depends on the number of keys in the report.
+ */
+bool host_keyboard_nkro(void) {
+#if defined(NKRO_HYBRID)
+    return is_nkro_report;
+#elif defined(NKRO_ENABLE)
+    return keyboard_protocol && keymap_config.nkro;
+#else
+    return false;
+#endif
+}
+
 void host_mouse_send(report_mouse_t *report) {
     if (!driver) return;
 #ifdef MOUSE_SHARED_EP
@@ -81,6 +174,100 @@ void host_mouse_send(report_mouse_t *report) {
     (*driver->send_mouse)(report);
 }
 
+#ifdef COALESCE_MOUSE_REPORTS
+/* adds to motion not sent yet, which is kept from overflowing */
+static void add_mouse_motion(int16_t *motion, int8_t delta) {
+    if ((delta > 0 && *motion <= INT16_MAX - delta) || (delta < 0 && *motion >= INT16_MIN - delta)) {
+        *motion += delta;
+    }
+}
+
+/* takes as much of the motion not sent yet as fits in a report */
+static int8_t take_mouse_motion(int16_t *motion) {
+    int8_t part = *motion > 127 ? 127 : *motion < -127 ? -127 : *motion;
+    *motion -= part;
+    return part;
+}
+
+/* the buttons of all sources, with those of one source replaced */
+static uint8_t mouse_buttons_with(uint8_t source, uint8_t buttons) {
+    for (uint8_t i = 0; i < MOUSE_SOURCE_COUNT; i++) {
+        if (i != source) {
+            buttons |= mouse_source_buttons[i];
+        }
+    }
+    return buttons;
+}
+
+static uint8_t mouse_buttons(void) { return mouse_buttons_with(0, mouse_source_buttons[0]); }
+
+static bool has_mouse_motion(void) { return mouse_x || mouse_y || mouse_v || mouse_h; }
+
+static bool has_pending_mouse_report(void) { return mouse_buttons() != last_mouse_buttons || has_mouse_motion(); }
+
+/* whether the driver would send a report now, so that its motion can be taken */
+static bool mouse_ready(void) { return driver && (!driver->mouse_ready || (*driver->mouse_ready)()); }
+
+static bool send_pending_mouse_report(void) {
+    // the driver may still be sending from it after returning
+    static report_mouse_t report;
+    if (!mouse_ready()) return false;
+    report.buttons     = mouse_buttons();
+    report.x           = take_mouse_motion(&mouse_x);
+    report.y           = take_mouse_motion(&mouse_y);
+    report.v           = take_mouse_motion(&mouse_v);
+    report.h           = take_mouse_motion(&mouse_h);
+    last_mouse_buttons = report.buttons;
+    last_mouse_time    = timer_read();
+    host_mouse_send(&report);
+    return true;
+}
+#endif
+
+/** \brief Sends a mouse report from one of the mouse sources
+ *
+ * With COALESCE_MOUSE_REPORTS, the reports of all sources are merged, and
+ * sent by host_mouse_flush(): their motion is added up, and their buttons are
+ * ORed. Motion that doesn't fit in one report is sent in the next ones. A
+ * button change that would undo one not sent yet, or come after motion not
+ * sent yet, sends the merged report first, so no click is lost or moved.
+ * Motion is only taken once the driver is ready to send it: while it isn't,
+ * the motion waits for the next report.
+ */
+void host_mouse_send_from(uint8_t source, report_mouse_t *report) {
+#ifdef COALESCE_MOUSE_REPORTS
+    uint8_t buttons  = mouse_buttons();
+    uint8_t changing = mouse_buttons_with(source, report->buttons) ^ buttons;
+    if (changing && ((changing & (buttons ^ last_mouse_buttons)) || has_mouse_motion())) {
+        // waits for the driver about as long as it would itself
+        for (uint8_t timeout = 10; !send_pending_mouse_report() && timeout; timeout--) {
+            wait_ms(1);
+        }
+    }
+    mouse_source_buttons[source] = report->buttons;
+    add_mouse_motion(&mouse_x, report->x);
+    add_mouse_motion(&mouse_y, report->y);
+    add_mouse_motion(&mouse_v, report->v);
+    add_mouse_motion(&mouse_h, report->h);
+#else
+    (void)source;
+    host_mouse_send(report);
+#endif
+}
+
+/** \brief Sends what the mouse sources have sent since the last report
+ *
+ * Called at the end of the keyboard task, at most once per MOUSE_REPORT_INTERVAL_MS.
+ * While the driver isn't ready, the next call tries again.
+ */
+void host_mouse_flush(void) {
+#ifdef COALESCE_MOUSE_REPORTS
+    if (has_pending_mouse_report() && timer_elapsed(last_mouse_time) >= MOUSE_REPORT_INTERVAL_MS) {
+        send_pending_mouse_report();
+    }
+#endif
+}
+
 void host_system_send(uint16_t report) {
     if (report == last_system_report) return;
     last_system_report = report;
@@ -33,6 +33,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 extern "C" {
 #endif
 
+/* where mouse reports come from, for host_mouse_send_from() */
+enum mouse_sources {
+    MOUSE_SOURCE_MOUSEKEY,
+    MOUSE_SOURCE_POINTING_DEVICE,
+    MOUSE_SOURCE_PS2,
+    MOUSE_SOURCE_SERIAL,
+    MOUSE_SOURCE_COUNT
+};
+
 extern uint8_t keyboard_idle;
 extern uint8_t keyboard_protocol;
 
@@ -44,7 +53,10 @@ host_driver_t *host_get_driver(void);
 uint8_t host_keyboard_leds(void);
 led_t   host_keyboard_led_state(void);
 void    host_keyboard_send(report_keyboard_t *report);
+bool    host_keyboard_nkro(void);
 void    host_mouse_send(report_mouse_t *report);
+void    host_mouse_send_from(uint8_t source, report_mouse_t *report);
+void    host_mouse_flush(void);
 void    host_system_send(uint16_t data);
 void    host_consumer_send(uint16_t data);
 
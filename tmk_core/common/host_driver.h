@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define HOST_DRIVER_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "report.h"
 #ifdef MIDI_ENABLE
 #    include "midi.h"
@@ -30,6 +31,7 @@ typedef struct {
     void (*send_mouse)(report_mouse_t *);
     void (*send_system)(uint16_t);
     void (*send_consumer)(uint16_t);
+    bool (*mouse_ready)(void); /* optional: whether send_mouse would send a report now rather than drop it */
 } host_driver_t;
 
 #endif
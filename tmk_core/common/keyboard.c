@@ -30,6 +30,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "sendchar.h"
 #include "eeconfig.h"
 #include "action_layer.h"
+#include "action_util.h"
+#include "power_state.h"
 #ifdef BACKLIGHT_ENABLE
 #    include "backlight.h"
 #endif
@@ -86,6 +88,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifdef VIA_ENABLE
 #    include "via.h"
 #endif
+#ifdef EEPROM_CACHE_ENABLE
+#    include "eeprom_cache.h"
+#endif
+#ifdef USB_SOF_SYNC
+#    include "sof_sync.h"
+#endif
+#ifdef DYNAMIC_KEYMAP_ENABLE
+#    include "dynamic_keymap.h"
+#endif
 
 // Only enable this if console is enabled to print to
 #if defined(DEBUG_MATRIX_SCAN_RATE) && defined(CONSOLE_ENABLE)
@@ -98,6 +109,11 @@ void matrix_scan_perf_task(void) {
     uint32_t timer_now = timer_read32();
     if (TIMER_DIFF_32(timer_now, matrix_timer) > 1000) {
         dprintf("matrix scan frequency: %d\n", matrix_scan_count);
+#    ifdef USB_SOF_SYNC
+        sof_sync_stats_t stats = sof_sync_get_stats();
+        dprintf("scan: %uus, slack to SOF: %uus, min %uus, late: %lu\n", stats.scan_us, stats.slack_us, stats.min_slack_us, stats.late);
+        sof_sync_reset_stats();
+#    endif
 
         matrix_timer      = timer_now;
         matrix_scan_count = 0;
@@ -108,12 +124,19 @@ void matrix_scan_perf_task(void) {
 #endif
 
 #ifdef MATRIX_HAS_GHOST
+#    ifdef KEYMAP_COMPRESSION_ENABLE
+// the dense keymaps array isn't linked in, go through the compressed one
+uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key);
+#        define KEYMAP_BASE_KEY(r, c) ((uint8_t)keymap_key_to_keycode(0, (keypos_t){.row = (r), .col = (c)}))
+#    else
 extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
-static matrix_row_t   get_real_keys(uint8_t row, matrix_row_t rowdata) {
+#        define KEYMAP_BASE_KEY(r, c) pgm_read_byte(&keymaps[0][r][c])
+#    endif
+static matrix_row_t get_real_keys(uint8_t row, matrix_row_t rowdata) {
     matrix_row_t out = 0;
     for (uint8_t col = 0; col < MATRIX_COLS; col++) {
         // read each key in the row data and check if the keymap defines it as a real key
-        if (pgm_read_byte(&keymaps[0][row][col]) && (rowdata & (1 << col))) {
+        if (KEYMAP_BASE_KEY(row, col) && (rowdata & (1 << col))) {
             // this creates new row data, if a key is defined in the keymap, it will be set here
             out |= 1 << col;
         }
@@ -220,6 +243,8 @@ __attribute__((weak)) bool is_keyboard_master(void) { return true; }
 void keyboard_init(void) {
     timer_init();
     matrix_init();
+    // a legacy eeconfig block moves what follows it, before anything reads that
+    eeconfig_load();
 #ifdef VIA_ENABLE
     via_init();
 #endif
@@ -286,13 +311,32 @@ void keyboard_task(void) {
     uint8_t keys_processed = 0;
 #endif
 
+    power_state_task();
+
 #if defined(OLED_DRIVER_ENABLE) && !defined(OLED_DISABLE_TIMEOUT)
     uint8_t ret = matrix_scan();
 #else
     matrix_scan();
 #endif
 
-    if (is_keyboard_master()) {
+#ifdef DYNAMIC_KEYMAP_ENABLE
+    // keys wait until a macro has been sent, so that they don't end up in the middle of it
+    bool process_matrix = is_keyboard_master() && !dynamic_keymap_macro_is_sending();
+#else
+    bool process_matrix = is_keyboard_master();
+#endif
+    if (process_matrix) {
+        // keys that changed while the host was suspended come first, one per scan
+        keyevent_t replayed;
+        while (power_state_replay(&replayed)) {
+            matrix_row_t col_mask = (matrix_row_t)1 << replayed.key.col;
+            if (!(matrix_prev[replayed.key.row] & col_mask) != !replayed.pressed) {
+                replayed.time = (timer_read() | 1);
+                action_exec(replayed);
+                matrix_prev[replayed.key.row] ^= col_mask;
+                goto MATRIX_LOOP_END;
+            }
+        }
         for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
             matrix_row    = matrix_get_row(r);
             matrix_change = matrix_row ^ matrix_prev[r];
@@ -331,6 +375,8 @@ void keyboard_task(void) {
 
 MATRIX_LOOP_END:
 
+    flush_keyboard_report();
+
 #ifdef DEBUG_MATRIX_SCAN_RATE
     matrix_scan_perf_task();
 #endif
@@ -386,6 +432,8 @@ MATRIX_LOOP_END:
     pointing_device_task();
 #endif
 
+    host_mouse_flush();
+
 #ifdef MIDI_ENABLE
     midi_task();
 #endif
@@ -396,6 +444,10 @@ MATRIX_LOOP_END:
     }
 #endif
 
+#ifdef EEPROM_CACHE_ENABLE
+    eeprom_cache_task();
+#endif
+
     // update LED
     if (led_status != host_keyboard_leds()) {
         led_status = host_keyboard_leds();
@@ -37,7 +37,207 @@ static uint8_t        mousekey_accel  = 0;
 static uint8_t        mousekey_repeat = 0;
 static uint16_t       last_timer      = 0;
 
-#ifndef MK_3_SPEED
+#if defined(MK_KINETIC_SPEED)
+
+/*
+ * Motion is integrated one millisecond at a time from the time the keys have
+ * been held, so the distance doesn't depend on how often mousekey_task() runs.
+ * A speed in pixels per second moves that many 1/1000 pixels per millisecond,
+ * and what hasn't made a whole pixel yet is kept for the next report.
+ */
+typedef struct {
+    uint16_t base_speed;
+    uint16_t max_speed;
+    uint16_t time_to_max;
+} mk_kinetic_params_t;
+
+typedef struct {
+    int8_t   a, b;          /* direction of each axis: -1, 0 or 1 */
+    uint16_t held;          /* milliseconds held, up to time_to_max */
+    uint16_t time;          /* timer of the last step */
+    int32_t  rem_a, rem_b;  /* motion not sent yet, in 1/1000 units */
+} mk_kinetic_motion_t;
+
+static const mk_kinetic_params_t cursor_params = {MK_KINETIC_BASE_SPEED, MK_KINETIC_MAX_SPEED, MK_KINETIC_TIME_TO_MAX};
+static const mk_kinetic_params_t wheel_params  = {MK_KINETIC_WHEEL_BASE_SPEED, MK_KINETIC_WHEEL_MAX_SPEED, MK_KINETIC_WHEEL_TIME_TO_MAX};
+static mk_kinetic_motion_t       cursor;  // a is x, b is y
+static mk_kinetic_motion_t       wheel;   // a is v, b is h
+
+/* Fraction of the way from the base to the max speed after being held for
+ * held ms, out of 256. Can be overridden for other acceleration curves.
+ */
+__attribute__((weak)) uint16_t mousekey_kinetic_curve(uint16_t held, uint16_t time_to_max) {
+    if (held >= time_to_max) {
+        return 256;
+    }
+    uint32_t fraction = ((uint32_t)held << 8) / time_to_max;
+    uint32_t curve    = fraction;
+    for (uint8_t i = 1; i < MK_KINETIC_CURVE; i++) {
+        curve = (curve * fraction) >> 8;
+    }
+    return curve;
+}
+
+static uint16_t kinetic_speed(const mk_kinetic_params_t *params, uint16_t held) {
+    if (mousekey_accel & (1 << 0)) {
+        return params->max_speed / 4;
+    } else if (mousekey_accel & (1 << 1)) {
+        return params->max_speed / 2;
+    } else if (mousekey_accel & (1 << 2)) {
+        return params->max_speed;
+    }
+    uint16_t curve = mousekey_kinetic_curve(held, params->time_to_max);
+    return params->base_speed + (((uint32_t)(params->max_speed - params->base_speed) * curve) >> 8);
+}
+
+static void kinetic_step(mk_kinetic_motion_t *motion, const mk_kinetic_params_t *params) {
+    uint16_t now     = timer_read();
+    uint16_t elapsed = TIMER_DIFF_16(now, motion->time);
+    motion->time     = now;
+    if (!motion->a && !motion->b) {
+        return;
+    }
+
+    uint32_t distance = 0;
+    for (; elapsed && motion->held < params->time_to_max; elapsed--, motion->held++) {
+        distance += kinetic_speed(params, motion->held);
+    }
+    distance += (uint32_t)elapsed * kinetic_speed(params, motion->held);
+
+    /* diagonal move [1/sqrt(2)] */
+    if (motion->a && motion->b) {
+        distance = (distance * 181) >> 8;
+    }
+    motion->rem_a += motion->a * (int32_t)distance;
+    motion->rem_b += motion->b * (int32_t)distance;
+}
+
+// Takes the whole units out of the remainder, up to what fits in a report
+static int8_t kinetic_take(int32_t *rem) {
+    int32_t units = *rem / 1000;
+    if (units > 127) units = 127;
+    if (units < -127) units = -127;
+    *rem -= units * 1000;
+    return units;
+}
+
+static void kinetic_take_all(void) {
+    mouse_report.x += kinetic_take(&cursor.rem_a);
+    mouse_report.y += kinetic_take(&cursor.rem_b);
+    mouse_report.v += kinetic_take(&wheel.rem_a);
+    mouse_report.h += kinetic_take(&wheel.rem_b);
+}
+
+static void kinetic_start(mk_kinetic_motion_t *motion, int8_t *axis, int8_t direction) {
+    if (!motion->a && !motion->b) {
+        motion->held = 0;
+        motion->time = timer_read();
+    }
+    *axis = direction;
+}
+
+static void kinetic_stop(int8_t *axis, int32_t *rem, int8_t direction) {
+    if (*axis != direction) {
+        return;
+    }
+    // send the motion made up to now, and drop what is left of a pixel
+    kinetic_step(&cursor, &cursor_params);
+    kinetic_step(&wheel, &wheel_params);
+    kinetic_take_all();
+    *axis = 0;
+    *rem  = 0;
+}
+
+void mousekey_task(void) {
+    kinetic_step(&cursor, &cursor_params);
+    kinetic_step(&wheel, &wheel_params);
+    if (timer_elapsed(last_timer) < MK_KINETIC_INTERVAL) {
+        return;
+    }
+    kinetic_take_all();
+    if (mouse_report.x || mouse_report.y || mouse_report.v || mouse_report.h) {
+        mousekey_send();
+    }
+}
+
+void mousekey_on(uint8_t code) {
+    if (code == KC_MS_UP) {
+        kinetic_start(&cursor, &cursor.b, -1);
+        mouse_report.y = -MK_KINETIC_DELTA;
+    } else if (code == KC_MS_DOWN) {
+        kinetic_start(&cursor, &cursor.b, 1);
+        mouse_report.y = MK_KINETIC_DELTA;
+    } else if (code == KC_MS_LEFT) {
+        kinetic_start(&cursor, &cursor.a, -1);
+        mouse_report.x = -MK_KINETIC_DELTA;
+    } else if (code == KC_MS_RIGHT) {
+        kinetic_start(&cursor, &cursor.a, 1);
+        mouse_report.x = MK_KINETIC_DELTA;
+    } else if (code == KC_MS_WH_UP) {
+        kinetic_start(&wheel, &wheel.a, 1);
+        mouse_report.v = MK_KINETIC_WHEEL_DELTA;
+    } else if (code == KC_MS_WH_DOWN) {
+        kinetic_start(&wheel, &wheel.a, -1);
+        mouse_report.v = -MK_KINETIC_WHEEL_DELTA;
+    } else if (code == KC_MS_WH_LEFT) {
+        kinetic_start(&wheel, &wheel.b, -1);
+        mouse_report.h = -MK_KINETIC_WHEEL_DELTA;
+    } else if (code == KC_MS_WH_RIGHT) {
+        kinetic_start(&wheel, &wheel.b, 1);
+        mouse_report.h = MK_KINETIC_WHEEL_DELTA;
+    } else if (code == KC_MS_BTN1)
+        mouse_report.buttons |= MOUSE_BTN1;
+    else if (code == KC_MS_BTN2)
+        mouse_report.buttons |= MOUSE_BTN2;
+    else if (code == KC_MS_BTN3)
+        mouse_report.buttons |= MOUSE_BTN3;
+    else if (code == KC_MS_BTN4)
+        mouse_report.buttons |= MOUSE_BTN4;
+    else if (code == KC_MS_BTN5)
+        mouse_report.buttons |= MOUSE_BTN5;
+    else if (IS_MOUSEKEY_ACCEL(code)) {
+        // the speed changes from now on
+        kinetic_step(&cursor, &cursor_params);
+        kinetic_step(&wheel, &wheel_params);
+        mousekey_accel |= (1 << (code - KC_MS_ACCEL0));
+    }
+}
+
+void mousekey_off(uint8_t code) {
+    if (code == KC_MS_UP)
+        kinetic_stop(&cursor.b, &cursor.rem_b, -1);
+    else if (code == KC_MS_DOWN)
+        kinetic_stop(&cursor.b, &cursor.rem_b, 1);
+    else if (code == KC_MS_LEFT)
+        kinetic_stop(&cursor.a, &cursor.rem_a, -1);
+    else if (code == KC_MS_RIGHT)
+        kinetic_stop(&cursor.a, &cursor.rem_a, 1);
+    else if (code == KC_MS_WH_UP)
+        kinetic_stop(&wheel.a, &wheel.rem_a, 1);
+    else if (code == KC_MS_WH_DOWN)
+        kinetic_stop(&wheel.a, &wheel.rem_a, -1);
+    else if (code == KC_MS_WH_LEFT)
+        kinetic_stop(&wheel.b, &wheel.rem_b, -1);
+    else if (code == KC_MS_WH_RIGHT)
+        kinetic_stop(&wheel.b, &wheel.rem_b, 1);
+    else if (code == KC_MS_BTN1)
+        mouse_report.buttons &= ~MOUSE_BTN1;
+    else if (code == KC_MS_BTN2)
+        mouse_report.buttons &= ~MOUSE_BTN2;
+    else if (code == KC_MS_BTN3)
+        mouse_report.buttons &= ~MOUSE_BTN3;
+    else if (code == KC_MS_BTN4)
+        mouse_report.buttons &= ~MOUSE_BTN4;
+    else if (code == KC_MS_BTN5)
+        mouse_report.buttons &= ~MOUSE_BTN5;
+    else if (IS_MOUSEKEY_ACCEL(code)) {
+        kinetic_step(&cursor, &cursor_params);
+        kinetic_step(&wheel, &wheel_params);
+        mousekey_accel &= ~(1 << (code - KC_MS_ACCEL0));
+    }
+}
+
+#elif !defined(MK_3_SPEED)
 
 static uint16_t last_timer_c = 0;
 static uint16_t last_timer_w = 0;
@@ -224,7 +424,7 @@ void mousekey_off(uint8_t code) {
     if (mouse_report.x == 0 && mouse_report.y == 0 && mouse_report.v == 0 && mouse_report.h == 0) mousekey_repeat = 0;
 }
 
-#else /* #ifndef MK_3_SPEED */
+#else /* #elif !defined(MK_3_SPEED) */
 
 enum { mkspd_unmod, mkspd_0, mkspd_1, mkspd_2, mkspd_COUNT };
 #    ifndef MK_MOMENTARY_ACCEL
@@ -367,18 +567,25 @@ void mousekey_off(uint8_t code) {
 #    endif
 }
 
-#endif /* #ifndef MK_3_SPEED */
+#endif /* #if defined(MK_KINETIC_SPEED) */
 
 void mousekey_send(void) {
     mousekey_debug();
-    host_mouse_send(&mouse_report);
+    host_mouse_send_from(MOUSE_SOURCE_MOUSEKEY, &mouse_report);
     last_timer = timer_read();
+#ifdef MK_KINETIC_SPEED
+    // motion is only sent once
+    mouse_report.x = mouse_report.y = mouse_report.v = mouse_report.h = 0;
+#endif
 }
 
 void mousekey_clear(void) {
     mouse_report    = (report_mouse_t){};
     mousekey_repeat = 0;
     mousekey_accel  = 0;
+#ifdef MK_KINETIC_SPEED
+    cursor = wheel = (mk_kinetic_motion_t){};
+#endif
 }
 
 static void mousekey_debug(void) {
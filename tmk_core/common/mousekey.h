@@ -22,7 +22,45 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdbool.h>
 #include "host.h"
 
-#ifndef MK_3_SPEED
+#if defined(MK_KINETIC_SPEED)
+
+/* pixels (or scroll steps) moved at once when a key is pressed */
+#    ifndef MK_KINETIC_DELTA
+#        define MK_KINETIC_DELTA 1
+#    endif
+/* speeds are in pixels per second, times in milliseconds */
+#    ifndef MK_KINETIC_BASE_SPEED
+#        define MK_KINETIC_BASE_SPEED 100
+#    endif
+#    ifndef MK_KINETIC_MAX_SPEED
+#        define MK_KINETIC_MAX_SPEED 1000
+#    endif
+#    ifndef MK_KINETIC_TIME_TO_MAX
+#        define MK_KINETIC_TIME_TO_MAX 1000
+#    endif
+#    ifndef MK_KINETIC_WHEEL_DELTA
+#        define MK_KINETIC_WHEEL_DELTA 1
+#    endif
+/* scroll speeds are in scroll steps per second */
+#    ifndef MK_KINETIC_WHEEL_BASE_SPEED
+#        define MK_KINETIC_WHEEL_BASE_SPEED 10
+#    endif
+#    ifndef MK_KINETIC_WHEEL_MAX_SPEED
+#        define MK_KINETIC_WHEEL_MAX_SPEED 80
+#    endif
+#    ifndef MK_KINETIC_WHEEL_TIME_TO_MAX
+#        define MK_KINETIC_WHEEL_TIME_TO_MAX 4000
+#    endif
+/* power of the acceleration curve: 1 is linear, 2 quadratic, ... */
+#    ifndef MK_KINETIC_CURVE
+#        define MK_KINETIC_CURVE 1
+#    endif
+/* least time between two motion reports */
+#    ifndef MK_KINETIC_INTERVAL
+#        define MK_KINETIC_INTERVAL 8
+#    endif
+
+#elif !defined(MK_3_SPEED)
 
 /* max value on report descriptor */
 #    ifndef MOUSEKEY_MOVE_MAX
@@ -68,7 +106,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #        define MOUSEKEY_WHEEL_TIME_TO_MAX 40
 #    endif
 
-#else /* #ifndef MK_3_SPEED */
+#else /* #elif !defined(MK_3_SPEED) */
 
 #    ifndef MK_C_OFFSET_UNMOD
 #        define MK_C_OFFSET_UNMOD 16
@@ -120,7 +158,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #        define MK_W_INTERVAL_2 20
 #    endif
 
-#endif /* #ifndef MK_3_SPEED */
+#endif /* #if defined(MK_KINETIC_SPEED) */
 
 #ifdef __cplusplus
 extern "C" {
@@ -139,6 +177,10 @@ void mousekey_off(uint8_t code);
 void mousekey_clear(void);
 void mousekey_send(void);
 
+#ifdef MK_KINETIC_SPEED
+uint16_t mousekey_kinetic_curve(uint16_t held, uint16_t time_to_max);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,158 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include "power_state.h"
+#include "matrix.h"
+#include "timer.h"
+
+static power_callbacks_t *callbacks_head = NULL;
+static power_state_t      state          = POWER_STATE_ACTIVE;
+static volatile bool      resuming       = false;  // set in the USB interrupt
+
+// The matrix as of the last scan, and the keys that changed since suspending
+static matrix_row_t power_matrix[MATRIX_ROWS];
+static keyevent_t   replay[POWER_STATE_REPLAY_SIZE];
+static uint8_t      replay_head  = 0;
+static uint8_t      replay_count = 0;
+
+__attribute__((weak)) void matrix_power_up(void) {}
+__attribute__((weak)) void matrix_power_down(void) {}
+
+void power_state_register(power_callbacks_t *callbacks) {
+    power_callbacks_t **next = &callbacks_head;
+    for (power_callbacks_t *c = callbacks_head; c; c = c->next) {
+        if (c == callbacks) {
+            return;
+        }
+    }
+    while (*next && (*next)->priority <= callbacks->priority) {
+        next = &(*next)->next;
+    }
+    callbacks->next = *next;
+    *next           = callbacks;
+}
+
+power_state_t power_state_get(void) { return state; }
+
+// The list is in the order of resuming, so suspending goes through it backwards
+static void suspend_from(power_callbacks_t *callbacks) {
+    if (callbacks) {
+        suspend_from(callbacks->next);
+        if (callbacks->suspend) {
+            callbacks->suspend();
+        }
+    }
+}
+
+/** \brief Host suspended the bus
+ *
+ * Called every time the platform powers down while suspended, only the first
+ * call does anything.
+ */
+void power_state_suspend(void) {
+    // suspended again before resuming, the callbacks are still suspended
+    resuming = false;
+    if (state == POWER_STATE_SUSPENDED) {
+        return;
+    }
+    state = POWER_STATE_SUSPENDED;
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        power_matrix[r] = matrix_get_row(r);
+    }
+    replay_head  = 0;
+    replay_count = 0;
+    suspend_from(callbacks_head);
+}
+
+/** \brief Host resumed the bus
+ *
+ * May be called from the USB interrupt, so the resume callbacks are left for
+ * power_state_task().
+ */
+void power_state_resume(void) {
+    if (state == POWER_STATE_SUSPENDED) {
+        resuming = true;
+    }
+}
+
+/** \brief Resumes the features once the host has resumed the bus
+ *
+ * Called at the start of keyboard_task().
+ */
+void power_state_task(void) {
+    if (!resuming) {
+        return;
+    }
+    resuming = false;
+    state    = POWER_STATE_ACTIVE;
+    for (power_callbacks_t *c = callbacks_head; c; c = c->next) {
+        if (c->resume) {
+            c->resume();
+        }
+    }
+}
+
+/** \brief Scans the matrix while suspended
+ *
+ * Keeps the keys that changed for power_state_replay(), and returns true when
+ * any key is pressed, to wake the host up.
+ */
+bool power_state_scan(void) {
+    bool pressed = false;
+    bool record  = state == POWER_STATE_SUSPENDED;
+
+    matrix_power_up();
+    matrix_scan();
+    matrix_power_down();
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        matrix_row_t row    = matrix_get_row(r);
+        matrix_row_t change = row ^ power_matrix[r];
+        for (uint8_t c = 0; c < MATRIX_COLS && change; c++) {
+            matrix_row_t col_mask = (matrix_row_t)1 << c;
+            if (!(change & col_mask)) {
+                continue;
+            }
+            change &= ~col_mask;
+            // When full, the rest is left for keyboard_task() to find in the matrix
+            if (!record || replay_count == POWER_STATE_REPLAY_SIZE) {
+                break;
+            }
+            replay[(replay_head + replay_count++) % POWER_STATE_REPLAY_SIZE] = (keyevent_t){
+                .key = (keypos_t){.row = r, .col = c}, .pressed = (row & col_mask), .time = (timer_read() | 1) /* time should not be 0 */
+            };
+            power_matrix[r] ^= col_mask;
+        }
+        if (row) {
+            pressed = true;
+        }
+    }
+    return pressed;
+}
+
+/** \brief Takes the oldest key that changed while suspended
+ *
+ * Only once the host has resumed.
+ */
+bool power_state_replay(keyevent_t *event) {
+    if (state != POWER_STATE_ACTIVE || !replay_count) {
+        return false;
+    }
+    *event      = replay[replay_head];
+    replay_head = (replay_head + 1) % POWER_STATE_REPLAY_SIZE;
+    replay_count--;
+    return true;
+}
@@ -0,0 +1,77 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TMK_CORE_COMMON_POWER_STATE_H_
+#define TMK_CORE_COMMON_POWER_STATE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "keyboard.h"
+
+/* Tracks whether the host has suspended the keyboard, for the features that
+ * have to do something about it.
+ *
+ * A feature registers a power_callbacks_t, which it owns, with
+ * power_state_register(). When the host suspends the bus, the suspend
+ * callbacks are called once, from the highest priority number to the lowest,
+ * and when it resumes the resume callbacks are called by the next
+ * keyboard_task(), from the lowest to the highest. The keyboard state comes
+ * back first, and lighting and other slow things after it.
+ *
+ * The platform's suspend_power_down() calls power_state_suspend(), and its
+ * suspend_wakeup_init() calls power_state_resume(). The latter runs in the USB
+ * interrupt on LUFA and ChibiOS, so it only marks the resume, and
+ * keyboard_task() calls the resume callbacks with power_state_task(): they
+ * may use I2C, SPI and everything else that can't run in an interrupt. While
+ * suspended, each
+ * suspend_wakeup_condition() scans the matrix with power_state_scan(), which
+ * keeps every key pressed or released until the host is back, up to
+ * POWER_STATE_REPLAY_SIZE of them. keyboard_task() then replays them one per
+ * scan, so a key tapped while the host was waking up isn't lost.
+ */
+#ifndef POWER_STATE_REPLAY_SIZE
+#    define POWER_STATE_REPLAY_SIZE 8
+#endif
+
+// Resumed first and suspended last
+#define POWER_PRIORITY_KEYBOARD 0
+#define POWER_PRIORITY_LIGHTING 128
+#define POWER_PRIORITY_USER 192
+
+typedef enum {
+    POWER_STATE_ACTIVE,
+    POWER_STATE_SUSPENDED,
+} power_state_t;
+
+typedef struct power_callbacks {
+    void (*suspend)(void);
+    void (*resume)(void);
+    uint8_t priority;
+    // Set by power_state_register()
+    struct power_callbacks *next;
+} power_callbacks_t;
+
+void          power_state_register(power_callbacks_t *callbacks);
+power_state_t power_state_get(void);
+
+void power_state_suspend(void);
+void power_state_resume(void);
+void power_state_task(void);
+
+bool power_state_scan(void);
+bool power_state_replay(keyevent_t *event);
+
+#endif
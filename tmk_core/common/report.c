@@ -54,18 +54,7 @@ uint8_t get_first_key(report_keyboard_t* keyboard_report) {
         return i << 3 | biton(keyboard_report->nkro.bits[i]);
     }
 #endif
-#ifdef USB_6KRO_ENABLE
-    uint8_t i = cb_head;
-    do {
-        if (keyboard_report->keys[i] != 0) {
-            break;
-        }
-        i = RO_INC(i);
-    } while (i != cb_tail);
-    return keyboard_report->keys[i];
-#else
     return keyboard_report->keys[0];
-#endif
 }
 
 /** \brief Checks if a key is pressed in the report
@@ -99,50 +88,6 @@ bool is_key_pressed(report_keyboard_t* keyboard_report, uint8_t key) {
  * FIXME: Needs doc
  */
 void add_key_byte(report_keyboard_t* keyboard_report, uint8_t code) {
-#ifdef USB_6KRO_ENABLE
-    int8_t i     = cb_head;
-    int8_t empty = -1;
-    if (cb_count) {
-        do {
-            if (keyboard_report->keys[i] == code) {
-                return;
-            }
-            if (empty == -1 && keyboard_report->keys[i] == 0) {
-                empty = i;
-            }
-            i = RO_INC(i);
-        } while (i != cb_tail);
-        if (i == cb_tail) {
-            if (cb_tail == cb_head) {
-                // buffer is full
-                if (empty == -1) {
-                    // pop head when has no empty space
-                    cb_head = RO_INC(cb_head);
-                    cb_count--;
-                } else {
-                    // left shift when has empty space
-                    uint8_t offset = 1;
-                    i              = RO_INC(empty);
-                    do {
-                        if (keyboard_report->keys[i] != 0) {
-                            keyboard_report->keys[empty] = keyboard_report->keys[i];
-                            keyboard_report->keys[i]     = 0;
-                            empty                        = RO_INC(empty);
-                        } else {
-                            offset++;
-                        }
-                        i = RO_INC(i);
-                    } while (i != cb_tail);
-                    cb_tail = RO_SUB(cb_tail, offset);
-                }
-            }
-        }
-    }
-    // add to tail
-    keyboard_report->keys[cb_tail] = code;
-    cb_tail                        = RO_INC(cb_tail);
-    cb_count++;
-#else
     int8_t i     = 0;
     int8_t empty = -1;
     for (; i < KEYBOARD_REPORT_KEYS; i++) {
@@ -158,7 +103,6 @@ void add_key_byte(report_keyboard_t* keyboard_report, uint8_t code) {
             keyboard_report->keys[empty] = code;
         }
     }
-#endif
 }
 
 /** \brief del key byte
@@ -166,38 +110,11 @@ void add_key_byte(report_keyboard_t* keyboard_report, uint8_t code) {
  * FIXME: Needs doc
  */
 void del_key_byte(report_keyboard_t* keyboard_report, uint8_t code) {
-#ifdef USB_6KRO_ENABLE
-    uint8_t i = cb_head;
-    if (cb_count) {
-        do {
-            if (keyboard_report->keys[i] == code) {
-                keyboard_report->keys[i] = 0;
-                cb_count--;
-                if (cb_count == 0) {
-                    // reset head and tail
-                    cb_tail = cb_head = 0;
-                }
-                if (i == RO_DEC(cb_tail)) {
-                    // left shift when next to tail
-                    do {
-                        cb_tail = RO_DEC(cb_tail);
-                        if (keyboard_report->keys[RO_DEC(cb_tail)] != 0) {
-                            break;
-                        }
-                    } while (cb_tail != cb_head);
-                }
-                break;
-            }
-            i = RO_INC(i);
-        } while (i != cb_tail);
-    }
-#else
     for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
         if (keyboard_report->keys[i] == code) {
             keyboard_report->keys[i] = 0;
         }
     }
-#endif
 }
 
 #ifdef NKRO_ENABLE
@@ -268,3 +185,118 @@ void clear_keys_from_report(report_keyboard_t* keyboard_report) {
 #endif
     memset(keyboard_report->keys, 0, sizeof(keyboard_report->keys));
 }
+
+// Checks if the keys go into an NKRO report
+static inline bool is_nkro(void) {
+#ifdef NKRO_ENABLE
+    return keyboard_protocol && keymap_config.nkro;
+#else
+    return false;
+#endif
+}
+
+/** \brief Adds a key to the keys of a report
+ */
+void report_keys_add(report_keys_t* keys, uint8_t key) {
+    uint8_t mask = 1 << (key & 7);
+    if (key == KC_NO || keys->bits[key >> 3] & mask) {
+        return;
+    }
+#ifdef NKRO_ENABLE
+    if (is_nkro()) {
+        if ((key >> 3) >= KEYBOARD_REPORT_BITS) {
+            dprintf("report_keys_add: can't add: %02X\n", key);
+            return;
+        }
+        keys->bits[key >> 3] |= mask;
+        keys->count++;
+        return;
+    }
+#endif
+    if (keys->count == KEYBOARD_REPORT_KEYS) {
+#ifdef USB_6KRO_ENABLE
+        report_keys_del(keys, keys->order[0]);
+#else
+        return;
+#endif
+    }
+#ifdef USB_6KRO_ENABLE
+    keys->order[keys->count] = key;
+#endif
+    keys->bits[key >> 3] |= mask;
+    keys->count++;
+}
+
+/** \brief Removes a key from the keys of a report
+ */
+void report_keys_del(report_keys_t* keys, uint8_t key) {
+    uint8_t mask = 1 << (key & 7);
+    if (!(keys->bits[key >> 3] & mask)) {
+        return;
+    }
+    keys->bits[key >> 3] &= ~mask;
+    keys->count--;
+#ifdef USB_6KRO_ENABLE
+    if (!is_nkro()) {
+        uint8_t i = 0;
+        while (keys->order[i] != key) {
+            i++;
+        }
+        memmove(&keys->order[i], &keys->order[i + 1], keys->count - i);
+    }
+#endif
+}
+
+/** \brief Removes all keys from the keys of a report
+ */
+void report_keys_clear(report_keys_t* keys) { memset(keys, 0, sizeof(report_keys_t)); }
+
+/** \brief Checks if a key is in the keys of a report
+ */
+bool report_keys_has(report_keys_t* keys, uint8_t key) { return keys->bits[key >> 3] & 1 << (key & 7); }
+
+/** \brief Number of keys in the keys of a report
+ */
+uint8_t report_keys_count(report_keys_t* keys) { return keys->count; }
+
+/** \brief First key of the keys of a report
+ *
+ * The oldest with USB_6KRO_ENABLE, otherwise the lowest, or KC_NO if there are none.
+ */
+uint8_t report_keys_first(report_keys_t* keys) {
+    if (!keys->count) {
+        return KC_NO;
+    }
+#ifdef USB_6KRO_ENABLE
+    if (!is_nkro()) {
+        return keys->order[0];
+    }
+#endif
+    uint8_t i = 0;
+    while (!keys->bits[i]) {
+        i++;
+    }
+    return i << 3 | __builtin_ctz(keys->bits[i]);
+}
+
+/** \brief Writes the keys of a report into a 6KRO or NKRO report, leaving the mods
+ */
+void report_keys_write(report_keys_t* keys, report_keyboard_t* keyboard_report) {
+#ifdef NKRO_ENABLE
+    if (is_nkro()) {
+        memcpy(keyboard_report->nkro.bits, keys->bits, sizeof(keyboard_report->nkro.bits));
+        return;
+    }
+#endif
+    memset(keyboard_report->keys, 0, sizeof(keyboard_report->keys));
+#ifdef USB_6KRO_ENABLE
+    memcpy(keyboard_report->keys, keys->order, keys->count);
+#else
+    uint8_t n = 0;
+    for (uint8_t i = 0; n < keys->count; i++) {
+        for (uint8_t bits = keys->bits[i]; bits; bits &= bits - 1) {
+            keyboard_report->keys[n++] = i << 3 | __builtin_ctz(bits);
+        }
+    }
+#endif
+}
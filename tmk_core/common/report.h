@@ -104,11 +104,18 @@ enum desktop_usages {
 #        define KEYBOARD_REPORT_BITS (NKRO_EPSIZE - 1)
 #        undef NKRO_SHARED_EP
 #        undef MOUSE_SHARED_EP
+#    elif defined(PROTOCOL_TEST)
+// as on the shared endpoint of LUFA and ChibiOS
+#        define KEYBOARD_REPORT_BITS 30
 #    else
 #        error "NKRO not supported with this protocol"
 #    endif
 #endif
 
+#if defined(NKRO_HYBRID) && !(defined(NKRO_ENABLE) && defined(NKRO_SHARED_EP))
+#    error "NKRO_HYBRID needs NKRO_ENABLE, with the NKRO report on the shared endpoint"
+#endif
+
 #ifdef KEYBOARD_SHARED_EP
 #    define KEYBOARD_REPORT_SIZE 9
 #else
@@ -267,6 +274,31 @@ void add_key_to_report(report_keyboard_t* keyboard_report, uint8_t key);
 void del_key_from_report(report_keyboard_t* keyboard_report, uint8_t key);
 void clear_keys_from_report(report_keyboard_t* keyboard_report);
 
+/* Keys of a keyboard report, as a bitmap of every keycode
+ *
+ * Adding, removing and finding a key take the same time however many keys are
+ * pressed, and the 6KRO or NKRO report is only made by report_keys_write()
+ * when it's sent. In 6KRO mode at most 6 keys are kept: new keys are ignored
+ * once there are 6, or with USB_6KRO_ENABLE replace the oldest one, for which
+ * the order they were added in is kept too. The mode shouldn't change while
+ * keys are held.
+ */
+typedef struct {
+    uint8_t bits[32];
+    uint8_t count;
+#ifdef USB_6KRO_ENABLE
+    uint8_t order[KEYBOARD_REPORT_KEYS];  // oldest first
+#endif
+} report_keys_t;
+
+void    report_keys_add(report_keys_t* keys, uint8_t key);
+void    report_keys_del(report_keys_t* keys, uint8_t key);
+void    report_keys_clear(report_keys_t* keys);
+bool    report_keys_has(report_keys_t* keys, uint8_t key);
+uint8_t report_keys_count(report_keys_t* keys);
+uint8_t report_keys_first(report_keys_t* keys);
+void    report_keys_write(report_keys_t* keys, report_keyboard_t* keyboard_report);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,59 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "report_queue.h"
+
+#ifdef KEYBOARD_REPORT_QUEUE_SIZE
+
+/** \brief Adds a report to the end of the queue
+ *
+ * Returns false if the queue is full, unless KEYBOARD_REPORT_QUEUE_COLLAPSE
+ * lets the report replace the last one.
+ */
+bool keyboard_report_queue_push(keyboard_report_queue_t *queue, report_keyboard_t *report) {
+    if (keyboard_report_queue_is_full(queue)) {
+#    ifdef KEYBOARD_REPORT_QUEUE_COLLAPSE
+        queue->reports[(queue->head + queue->count - 1) % KEYBOARD_REPORT_QUEUE_SIZE] = *report;
+        return true;
+#    else
+        return false;
+#    endif
+    }
+    queue->reports[(queue->head + queue->count) % KEYBOARD_REPORT_QUEUE_SIZE] = *report;
+    queue->count++;
+    return true;
+}
+
+/** \brief Takes the oldest report from the queue
+ *
+ * Returns false if the queue is empty.
+ */
+bool keyboard_report_queue_pop(keyboard_report_queue_t *queue, report_keyboard_t *report) {
+    if (keyboard_report_queue_is_empty(queue)) {
+        return false;
+    }
+    *report     = queue->reports[queue->head];
+    queue->head = (queue->head + 1) % KEYBOARD_REPORT_QUEUE_SIZE;
+    queue->count--;
+    return true;
+}
+
+void keyboard_report_queue_clear(keyboard_report_queue_t *queue) {
+    queue->head  = 0;
+    queue->count = 0;
+}
+
+#endif
@@ -0,0 +1,52 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TMK_CORE_COMMON_REPORT_QUEUE_H_
+#define TMK_CORE_COMMON_REPORT_QUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "report.h"
+
+/* FIFO of keyboard reports waiting for their endpoint.
+ *
+ * With KEYBOARD_REPORT_QUEUE_SIZE defined, the protocol layer queues a report
+ * instead of waiting when the host hasn't taken the previous one yet, and
+ * sends the queued reports from its USB interrupts. When the queue is full,
+ * the newest report replaces the last queued one with
+ * KEYBOARD_REPORT_QUEUE_COLLAPSE, so only the latest state is kept. Otherwise
+ * the push fails, and the caller waits for room, so that the host sees every
+ * change.
+ *
+ * The queue doesn't lock, the caller has to keep the interrupts from running
+ * while it is pushing.
+ */
+#ifdef KEYBOARD_REPORT_QUEUE_SIZE
+typedef struct {
+    report_keyboard_t reports[KEYBOARD_REPORT_QUEUE_SIZE];
+    uint8_t           head;
+    uint8_t           count;
+} keyboard_report_queue_t;
+
+bool keyboard_report_queue_push(keyboard_report_queue_t *queue, report_keyboard_t *report);
+bool keyboard_report_queue_pop(keyboard_report_queue_t *queue, report_keyboard_t *report);
+void keyboard_report_queue_clear(keyboard_report_queue_t *queue);
+
+static inline bool keyboard_report_queue_is_empty(keyboard_report_queue_t *queue) { return queue->count == 0; }
+static inline bool keyboard_report_queue_is_full(keyboard_report_queue_t *queue) { return queue->count == KEYBOARD_REPORT_QUEUE_SIZE; }
+#endif
+
+#endif /* TMK_CORE_COMMON_REPORT_QUEUE_H_ */
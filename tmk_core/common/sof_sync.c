@@ -0,0 +1,130 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sof_sync.h"
+
+#ifdef USB_SOF_SYNC
+
+// Written by the SOF interrupt. sof_frame is a byte, so it's read atomically,
+// and changes whenever sof_time may have.
+static volatile uint16_t sof_time  = 0;
+static volatile uint8_t  sof_frame = 0;
+
+static bool             is_scanning  = false;
+static bool             is_slack_due = false;
+static uint8_t          scan_frame   = 0;
+static uint16_t         scan_start   = 0;
+static uint16_t         scan_end     = 0;
+static sof_sync_stats_t stats        = {.min_slack_us = UINT16_MAX};
+
+// Reads the time of the last SOF, and returns its frame
+static uint8_t read_sof(uint16_t *time) {
+    uint8_t frame;
+    do {
+        frame = sof_frame;
+        *time = sof_time;
+    } while (frame != sof_frame);
+    return frame;
+}
+
+/** \brief Forgets the frames and scans seen so far
+ */
+void sof_sync_init(void) {
+    uint16_t sof;
+    scan_frame   = read_sof(&sof);
+    is_scanning  = false;
+    is_slack_due = false;
+    stats        = (sof_sync_stats_t){.min_slack_us = UINT16_MAX};
+}
+
+/** \brief Records a start-of-frame, called from the SOF interrupt
+ */
+void sof_sync_frame(void) {
+    sof_time = sof_sync_read_us();
+    sof_frame++;
+}
+
+/** \brief Checks if the keyboard task has to run now to end before the next SOF
+ */
+bool sof_sync_is_scan_due(void) {
+    uint16_t sof;
+    uint8_t  frame = read_sof(&sof);
+    uint16_t now   = sof_sync_read_us();
+    uint16_t since = now - sof;
+
+    // the slack is only known once the next SOF has come, and only that one counts
+    if (is_slack_due && frame != scan_frame) {
+        if ((uint8_t)(frame - scan_frame) == 1) {
+            stats.slack_us = sof - scan_end;
+            if (stats.slack_us < stats.min_slack_us) {
+                stats.min_slack_us = stats.slack_us;
+            }
+            stats.scans++;
+        }
+        is_slack_due = false;
+    }
+
+    is_scanning = true;
+    scan_start  = now;
+    // no SOFs are coming, so there's nothing to wait for
+    if (since > 2 * SOF_SYNC_FRAME_US) {
+        is_slack_due = false;
+        return true;
+    }
+    // one scan per frame, as late as it can be
+    if ((frame == scan_frame && is_slack_due) || since + stats.scan_us + SOF_SYNC_MARGIN_US < SOF_SYNC_FRAME_US) {
+        is_scanning = false;
+        return false;
+    }
+    is_slack_due = true;
+    scan_frame   = frame;
+    return true;
+}
+
+/** \brief Measures the keyboard task that sof_sync_is_scan_due() allowed
+ */
+void sof_sync_scan_done(void) {
+    if (!is_scanning) {
+        return;
+    }
+    is_scanning = false;
+    scan_end    = sof_sync_read_us();
+
+    // the SOF came while scanning, so the host got the previous report
+    uint16_t sof;
+    if (is_slack_due && read_sof(&sof) != scan_frame) {
+        is_slack_due = false;
+        stats.late++;
+    }
+
+    // follow longer scans straight away, and shorter ones slowly
+    uint16_t duration = scan_end - scan_start;
+    if (duration > stats.scan_us) {
+        stats.scan_us = duration;
+    } else {
+        stats.scan_us -= (stats.scan_us - duration) / 16;
+    }
+}
+
+sof_sync_stats_t sof_sync_get_stats(void) { return stats; }
+
+void sof_sync_reset_stats(void) {
+    uint16_t scan_us = stats.scan_us;
+    stats            = (sof_sync_stats_t){.min_slack_us = UINT16_MAX};
+    stats.scan_us    = scan_us;
+}
+
+#endif
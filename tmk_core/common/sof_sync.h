@@ -0,0 +1,65 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TMK_CORE_COMMON_SOF_SYNC_H_
+#define TMK_CORE_COMMON_SOF_SYNC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Runs the keyboard task once per USB frame, timed to end just before the
+ * next start-of-frame, so the host polls a report that was made as late as
+ * possible.
+ *
+ * The protocol calls sof_sync_frame() from its SOF interrupt, and asks
+ * sof_sync_is_scan_due() before each keyboard task, which it follows with
+ * sof_sync_scan_done(). The time a scan takes is measured, and the scan is
+ * started that long plus SOF_SYNC_MARGIN_US before the next SOF is expected.
+ * Without SOFs, as while suspended, every call is a scan.
+ *
+ * The protocol provides sof_sync_read_us(), a microsecond clock that wraps at
+ * 16 bits.
+ */
+#ifdef USB_SOF_SYNC
+#    ifndef SOF_SYNC_FRAME_US
+#        define SOF_SYNC_FRAME_US 1000
+#    endif
+
+// Time left between the end of the scan and the SOF, for the scan taking longer than measured
+#    ifndef SOF_SYNC_MARGIN_US
+#        define SOF_SYNC_MARGIN_US 100
+#    endif
+
+typedef struct {
+    uint32_t scans;         // scans that ended before the SOF they were for
+    uint32_t late;          // scans that didn't
+    uint16_t slack_us;      // time from the end of the last scan to the SOF
+    uint16_t min_slack_us;  // least slack since sof_sync_reset_stats()
+    uint16_t scan_us;       // time a scan is expected to take
+} sof_sync_stats_t;
+
+uint16_t sof_sync_read_us(void);
+
+void sof_sync_init(void);
+void sof_sync_frame(void);
+bool sof_sync_is_scan_due(void);
+void sof_sync_scan_done(void);
+
+sof_sync_stats_t sof_sync_get_stats(void);
+void             sof_sync_reset_stats(void);
+#endif
+
+#endif /* TMK_CORE_COMMON_SOF_SYNC_H_ */
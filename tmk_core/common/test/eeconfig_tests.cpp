@@ -0,0 +1,226 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "eeconfig.h"
+#include "eeprom.h"
+#include "action_layer.h"
+#include "test/eeprom_test.h"
+
+layer_state_t default_layer_state;
+}
+
+#define ADDRESS(a) ((uint8_t *)(uintptr_t)(a))
+
+// Same as the firmware, so that images can be built by hand
+static uint16_t crc(const uint8_t *data, uint8_t len) {
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i < len; i++) {
+        crc ^= data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+class Eeconfig : public testing::Test {
+   public:
+    Eeconfig() {
+        for (uint16_t i = 0; i < 64; i++) {
+            eeprom_update_byte(ADDRESS(i), 0xFF);
+        }
+        eeconfig_load();
+        eeprom_test_reset_stats();
+    }
+
+    void write_image(const eeconfig_t &image) { eeprom_write_block(&image, ADDRESS(0), sizeof(image)); }
+
+    eeconfig_t read_image() {
+        eeconfig_t image;
+        eeprom_read_block(&image, ADDRESS(0), sizeof(image));
+        return image;
+    }
+
+    // A block as written by the firmware before it was versioned
+    eeconfig_t legacy_image() {
+        eeconfig_t image;
+        memset(&image, 0, sizeof(image));
+        image.magic         = EECONFIG_MAGIC_NUMBER_LEGACY;
+        image.debug         = EECONFIG_DEBUG_ENABLE;
+        image.default_layer = 2;
+        image.keymap_lower  = EECONFIG_KEYMAP_NKRO;
+        image.keymap_upper  = 0x01;
+        image.audio         = 0xFF;
+        image.rgblight      = 0x12345678;
+        image.handedness    = 1;
+        image.user          = 0xCAFEBABE;
+        // Whatever followed, VIA's magic in this case
+        image.version = 0x20;
+        image.crc     = 0x1019;
+        return image;
+    }
+
+    void seal(eeconfig_t &image) { image.crc = crc((const uint8_t *)&image, offsetof(eeconfig_t, crc)); }
+};
+
+TEST_F(Eeconfig, blank_eeprom_is_not_enabled) {
+    EXPECT_FALSE(eeconfig_is_enabled());
+    eeconfig_init();
+    EXPECT_TRUE(eeconfig_is_enabled());
+    EXPECT_EQ(eeconfig_read_byte(EECONFIG_AUDIO), 0xFF);
+    EXPECT_EQ(eeconfig_read_user(), 0u);
+
+    eeconfig_t image = read_image();
+    EXPECT_EQ(image.magic, EECONFIG_MAGIC_NUMBER);
+    EXPECT_EQ(image.version, EECONFIG_VERSION);
+    EXPECT_EQ(image.crc, crc((const uint8_t *)&image, offsetof(eeconfig_t, crc)));
+}
+
+TEST_F(Eeconfig, legacy_layout_is_migrated_keeping_settings) {
+    write_image(legacy_image());
+    eeconfig_load();
+    EXPECT_TRUE(eeconfig_is_enabled());
+    EXPECT_EQ(eeconfig_read_debug(), EECONFIG_DEBUG_ENABLE);
+    EXPECT_EQ(eeconfig_read_default_layer(), 2);
+    EXPECT_EQ(eeconfig_read_keymap(), 0x0100 | EECONFIG_KEYMAP_NKRO);
+    EXPECT_EQ(eeconfig_read_dword(EECONFIG_RGBLIGHT), 0x12345678u);
+    EXPECT_TRUE(eeconfig_read_handedness());
+    EXPECT_EQ(eeconfig_read_user(), 0xCAFEBABEu);
+
+    // Written back in the current layout, and loaded as such from then on
+    eeconfig_t image = read_image();
+    EXPECT_EQ(image.magic, EECONFIG_MAGIC_NUMBER);
+    EXPECT_EQ(image.version, EECONFIG_VERSION);
+    eeprom_test_reset_stats();
+    eeconfig_load();
+    EXPECT_TRUE(eeconfig_is_enabled());
+    EXPECT_EQ(eeprom_test_get_stats().writes, 0u);
+    EXPECT_EQ(eeconfig_read_user(), 0xCAFEBABEu);
+}
+
+TEST_F(Eeconfig, legacy_layout_migration_moves_what_follows_the_block) {
+    write_image(legacy_image());
+    for (uint16_t i = EECONFIG_SIZE; i <= 64; i++) {
+        eeprom_update_byte(ADDRESS(i), i);
+    }
+    // What followed the legacy block, like VIA's magic
+    eeprom_update_byte(ADDRESS(EECONFIG_SIZE_LEGACY), 0x20);
+    eeprom_update_byte(ADDRESS(EECONFIG_SIZE_LEGACY + 1), 0x19);
+    eeprom_update_byte(ADDRESS(EECONFIG_SIZE_LEGACY + 2), 0x10);
+
+    eeconfig_load();
+    EXPECT_TRUE(eeconfig_is_enabled());
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(EECONFIG_SIZE)), 0x20);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(EECONFIG_SIZE + 1)), 0x19);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(EECONFIG_SIZE + 2)), 0x10);
+    for (uint16_t i = EECONFIG_SIZE + 3; i < 64; i++) {
+        EXPECT_EQ(eeprom_read_byte(ADDRESS(i)), i - (EECONFIG_SIZE - EECONFIG_SIZE_LEGACY));
+    }
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(64)), 64);
+
+    // Only once
+    eeconfig_load();
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(EECONFIG_SIZE)), 0x20);
+}
+
+TEST_F(Eeconfig, older_version_is_migrated) {
+    eeconfig_t image = legacy_image();
+    image.magic      = EECONFIG_MAGIC_NUMBER;
+    image.version    = 0;
+    seal(image);
+    write_image(image);
+    eeconfig_load();
+    EXPECT_TRUE(eeconfig_is_enabled());
+    EXPECT_EQ(eeconfig_read_user(), 0xCAFEBABEu);
+    EXPECT_EQ(read_image().version, EECONFIG_VERSION);
+}
+
+TEST_F(Eeconfig, newer_version_is_not_enabled) {
+    eeconfig_t image = legacy_image();
+    image.magic      = EECONFIG_MAGIC_NUMBER;
+    image.version    = EECONFIG_VERSION + 1;
+    seal(image);
+    write_image(image);
+    eeconfig_load();
+    EXPECT_FALSE(eeconfig_is_enabled());
+}
+
+TEST_F(Eeconfig, corrupt_block_is_not_enabled) {
+    eeconfig_init();
+    eeconfig_update_user(0x55AA55AA);
+    eeconfig_load();
+    EXPECT_TRUE(eeconfig_is_enabled());
+
+    eeprom_update_byte(ADDRESS(20), 0x00);
+    eeconfig_load();
+    EXPECT_FALSE(eeconfig_is_enabled());
+}
+
+TEST_F(Eeconfig, load_is_a_single_block_read) {
+    eeconfig_init();
+    eeprom_test_reset_stats();
+    eeconfig_load();
+    EXPECT_EQ(eeprom_test_get_stats().reads, (uint32_t)EECONFIG_SIZE);
+
+    eeconfig_read_debug();
+    eeconfig_read_keymap();
+    eeconfig_read_kb();
+    eeconfig_read_user();
+    eeconfig_read_dword(EECONFIG_RGB_MATRIX);
+    EXPECT_TRUE(eeconfig_is_enabled());
+    EXPECT_EQ(eeprom_test_get_stats().reads, (uint32_t)EECONFIG_SIZE);
+}
+
+TEST_F(Eeconfig, updates_only_write_changes) {
+    eeconfig_init();
+    eeconfig_update_kb(0x01020304);
+    eeprom_test_reset_stats();
+    eeconfig_update_kb(0x01020304);
+    EXPECT_EQ(eeprom_test_get_stats().writes, 0u);
+
+    // One changed byte, and the CRC
+    eeconfig_update_kb(0x01020305);
+    EXPECT_LE(eeprom_test_get_stats().writes, 3u);
+    eeconfig_load();
+    EXPECT_TRUE(eeconfig_is_enabled());
+    EXPECT_EQ(eeconfig_read_kb(), 0x01020305u);
+}
+
+TEST_F(Eeconfig, addresses_past_the_block_go_to_eeprom) {
+    eeconfig_init();
+    eeconfig_update_byte(ADDRESS(EECONFIG_SIZE + 3), 0x42);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(EECONFIG_SIZE + 3)), 0x42);
+    EXPECT_EQ(eeconfig_read_byte(ADDRESS(EECONFIG_SIZE + 3)), 0x42);
+
+    // The version and CRC are off limits
+    eeconfig_update_byte(EECONFIG_VERSION_BYTE, 0x42);
+    eeconfig_load();
+    EXPECT_TRUE(eeconfig_is_enabled());
+}
+
+TEST_F(Eeconfig, disable_is_picked_up) {
+    eeconfig_init();
+    eeconfig_disable();
+    EXPECT_TRUE(eeconfig_is_disabled());
+    EXPECT_FALSE(eeconfig_is_enabled());
+    eeconfig_enable();
+    EXPECT_TRUE(eeconfig_is_enabled());
+    eeconfig_load();
+    EXPECT_TRUE(eeconfig_is_enabled());
+}
@@ -14,20 +14,141 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdio.h>
 #include "eeprom.h"
+#include "eeprom_test.h"
 
-#define EEPROM_SIZE 32
+// Same size as the ATmega32u4 EEPROM, which is what most features assume
+#ifndef EEPROM_SIZE
+#    define EEPROM_SIZE 1024
+#endif
 
-static uint8_t buffer[EEPROM_SIZE];
+// Byte access times of the ATmega32u4 EEPROM, an erase and write is 3.4 ms
+#ifndef EEPROM_TEST_READ_TIME_US
+#    define EEPROM_TEST_READ_TIME_US 0
+#endif
+#ifndef EEPROM_TEST_WRITE_TIME_US
+#    define EEPROM_TEST_WRITE_TIME_US 3400
+#endif
+#ifndef EEPROM_TEST_ERASE_TIME_US
+#    define EEPROM_TEST_ERASE_TIME_US 1800
+#endif
+
+static uint8_t             buffer[EEPROM_SIZE];
+static eeprom_test_stats_t stats;
+static eeprom_test_stats_t address_stats[EEPROM_SIZE];
+static eeprom_test_trace_t trace                   = NULL;
+static int32_t             writes_before_power_cut = -1;
+
+eeprom_test_stats_t eeprom_test_get_stats(void) { return stats; }
+
+eeprom_test_stats_t eeprom_test_get_address_stats(uintptr_t address) {
+    eeprom_test_stats_t none = {0};
+    return address < EEPROM_SIZE ? address_stats[address] : none;
+}
+
+void eeprom_test_reset_stats(void) {
+    eeprom_test_stats_t none = {0};
+    stats                    = none;
+    for (uint16_t i = 0; i < EEPROM_SIZE; i++) {
+        address_stats[i] = none;
+    }
+}
+
+uint16_t eeprom_test_get_size(void) { return EEPROM_SIZE; }
+
+void eeprom_test_set_trace(eeprom_test_trace_t callback) { trace = callback; }
+
+void eeprom_test_trace_print(eeprom_test_access_t access, uintptr_t address, uint8_t value) {
+    static const char names[] = {[EEPROM_TEST_READ] = 'R', [EEPROM_TEST_WRITE] = 'W', [EEPROM_TEST_ERASE] = 'E'};
+    fprintf(stderr, "eeprom %c 0x%04X 0x%02X\n", names[access], (unsigned)address, value);
+}
+
+void eeprom_test_cut_power_after(int32_t writes) { writes_before_power_cut = writes; }
+
+// Counts an access, returns false if it doesn't reach the EEPROM
+static bool eeprom_test_access(eeprom_test_access_t access, uintptr_t address, uint8_t value) {
+    if (address >= EEPROM_SIZE) {
+        stats.out_of_range++;
+        return false;
+    }
+    if (access != EEPROM_TEST_READ) {
+        if (writes_before_power_cut == 0) {
+            return false;
+        }
+        if (writes_before_power_cut > 0) {
+            writes_before_power_cut--;
+        }
+    }
+
+    eeprom_test_stats_t *at = &address_stats[address];
+    switch (access) {
+        case EEPROM_TEST_READ:
+            stats.reads++;
+            at->reads++;
+            at->time_us += EEPROM_TEST_READ_TIME_US;
+            stats.time_us += EEPROM_TEST_READ_TIME_US;
+            break;
+        case EEPROM_TEST_WRITE:
+            stats.writes++;
+            at->writes++;
+            at->time_us += EEPROM_TEST_WRITE_TIME_US;
+            stats.time_us += EEPROM_TEST_WRITE_TIME_US;
+            break;
+        case EEPROM_TEST_ERASE:
+            stats.erases++;
+            at->erases++;
+            at->time_us += EEPROM_TEST_ERASE_TIME_US;
+            stats.time_us += EEPROM_TEST_ERASE_TIME_US;
+            break;
+    }
+    if (trace) {
+        trace(access, address, value);
+    }
+    return true;
+}
+
+void eeprom_test_erase(void) {
+    for (uint16_t i = 0; i < EEPROM_SIZE; i++) {
+        if (eeprom_test_access(EEPROM_TEST_ERASE, i, 0xFF)) {
+            buffer[i] = 0xFF;
+        }
+    }
+}
+
+bool eeprom_test_load_image(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    fread(buffer, 1, EEPROM_SIZE, file);
+    bool ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
+
+bool eeprom_test_save_image(const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(buffer, 1, EEPROM_SIZE, file) == EEPROM_SIZE;
+    return fclose(file) == 0 && ok;
+}
 
 uint8_t eeprom_read_byte(const uint8_t *addr) {
     uintptr_t offset = (uintptr_t)addr;
+    if (!eeprom_test_access(EEPROM_TEST_READ, offset, offset < EEPROM_SIZE ? buffer[offset] : 0)) {
+        return 0;
+    }
     return buffer[offset];
 }
 
 void eeprom_write_byte(uint8_t *addr, uint8_t value) {
     uintptr_t offset = (uintptr_t)addr;
-    buffer[offset]   = value;
+    if (eeprom_test_access(EEPROM_TEST_WRITE, offset, value)) {
+        buffer[offset] = value;
+    }
 }
 
 uint16_t eeprom_read_word(const uint16_t *addr) {
@@ -70,26 +191,33 @@ void eeprom_write_block(const void *buf, void *addr, size_t len) {
     }
 }
 
-void eeprom_update_byte(uint8_t *addr, uint8_t value) { eeprom_write_byte(addr, value); }
+// Like avr-libc, the byte is only written if it changes. The comparison
+// happens inside the EEPROM, so it isn't counted as a read.
+void eeprom_update_byte(uint8_t *addr, uint8_t value) {
+    uintptr_t offset = (uintptr_t)addr;
+    if (offset >= EEPROM_SIZE || buffer[offset] != value) {
+        eeprom_write_byte(addr, value);
+    }
+}
 
 void eeprom_update_word(uint16_t *addr, uint16_t value) {
     uint8_t *p = (uint8_t *)addr;
-    eeprom_write_byte(p++, value);
-    eeprom_write_byte(p, value >> 8);
+    eeprom_update_byte(p++, value);
+    eeprom_update_byte(p, value >> 8);
 }
 
 void eeprom_update_dword(uint32_t *addr, uint32_t value) {
     uint8_t *p = (uint8_t *)addr;
-    eeprom_write_byte(p++, value);
-    eeprom_write_byte(p++, value >> 8);
-    eeprom_write_byte(p++, value >> 16);
-    eeprom_write_byte(p, value >> 24);
+    eeprom_update_byte(p++, value);
+    eeprom_update_byte(p++, value >> 8);
+    eeprom_update_byte(p++, value >> 16);
+    eeprom_update_byte(p, value >> 24);
 }
 
 void eeprom_update_block(const void *buf, void *addr, size_t len) {
     uint8_t *      p   = (uint8_t *)addr;
     const uint8_t *src = (const uint8_t *)buf;
     while (len--) {
-        eeprom_write_byte(p++, *src++);
+        eeprom_update_byte(p++, *src++);
     }
 }
@@ -0,0 +1,108 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "eeprom_cache.h"
+#include "test/eeprom_test.h"
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+#define ADDRESS(a) ((uint8_t *)(uintptr_t)(a))
+
+class EepromCache : public testing::Test {
+   public:
+    EepromCache() {
+        eeprom_cache_flush();
+        for (uint16_t i = 0; i < 64; i++) {
+            eeprom_update_byte(ADDRESS(i), 0xFF);
+        }
+        set_time(0);
+        eeprom_test_reset_stats();
+    }
+};
+
+TEST_F(EepromCache, coalesces_repeated_updates) {
+    for (uint32_t i = 0; i < 100; i++) {
+        eeprom_cached_update_dword((uint32_t *)ADDRESS(8), i);
+    }
+    EXPECT_EQ(eeprom_test_get_stats().writes, 0);
+    EXPECT_TRUE(eeprom_cache_is_dirty());
+    eeprom_cache_flush();
+    EXPECT_EQ(eeprom_test_get_stats().writes, 4);
+    EXPECT_EQ(eeprom_read_dword((const uint32_t *)ADDRESS(8)), 99);
+    EXPECT_FALSE(eeprom_cache_is_dirty());
+}
+
+TEST_F(EepromCache, reads_pending_updates) {
+    eeprom_cached_update_word((uint16_t *)ADDRESS(4), 0x1234);
+    eeprom_cached_update_byte(ADDRESS(7), 0x56);
+    EXPECT_EQ(eeprom_cached_read_word((const uint16_t *)ADDRESS(4)), 0x1234);
+    EXPECT_EQ(eeprom_cached_read_byte(ADDRESS(7)), 0x56);
+    EXPECT_EQ(eeprom_cached_read_byte(ADDRESS(6)), 0xFF);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(7)), 0xFF);
+
+    uint8_t block[5];
+    eeprom_cached_read_block(block, ADDRESS(3), sizeof(block));
+    uint8_t expected[5] = {0xFF, 0x34, 0x12, 0xFF, 0x56};
+    for (uint8_t i = 0; i < sizeof(block); i++) {
+        EXPECT_EQ(block[i], expected[i]);
+    }
+}
+
+TEST_F(EepromCache, flushes_after_being_idle) {
+    eeprom_cached_update_byte(ADDRESS(1), 0x12);
+    for (uint32_t i = 0; i < 10; i++) {
+        // Keep updating, which postpones the flush
+        advance_time(EEPROM_CACHE_FLUSH_DELAY / 2);
+        eeprom_cached_update_byte(ADDRESS(1), i);
+        eeprom_cache_task();
+    }
+    EXPECT_EQ(eeprom_test_get_stats().writes, 0);
+    advance_time(EEPROM_CACHE_FLUSH_DELAY - 1);
+    eeprom_cache_task();
+    EXPECT_EQ(eeprom_test_get_stats().writes, 0);
+    advance_time(1);
+    eeprom_cache_task();
+    EXPECT_EQ(eeprom_test_get_stats().writes, 1);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(1)), 9);
+}
+
+TEST_F(EepromCache, flushes_when_full) {
+    for (uint16_t i = 0; i <= EEPROM_CACHE_SIZE; i++) {
+        eeprom_cached_update_byte(ADDRESS(i), i);
+    }
+    EXPECT_EQ(eeprom_test_get_stats().writes, EEPROM_CACHE_SIZE);
+    EXPECT_EQ(eeprom_cached_read_byte(ADDRESS(EEPROM_CACHE_SIZE)), EEPROM_CACHE_SIZE);
+    eeprom_cache_flush();
+    for (uint16_t i = 0; i <= EEPROM_CACHE_SIZE; i++) {
+        EXPECT_EQ(eeprom_read_byte(ADDRESS(i)), i);
+    }
+}
+
+TEST_F(EepromCache, writes_large_blocks_through) {
+    uint8_t block[EEPROM_CACHE_SIZE];
+    for (uint8_t i = 0; i < sizeof(block); i++) {
+        block[i] = i;
+    }
+    eeprom_cached_update_byte(ADDRESS(0), 0x42);
+    eeprom_cached_update_block(block, ADDRESS(1), sizeof(block));
+    EXPECT_FALSE(eeprom_cache_is_dirty());
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(0)), 0x42);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(sizeof(block))), sizeof(block) - 1);
+}
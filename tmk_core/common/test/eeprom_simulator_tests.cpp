@@ -0,0 +1,141 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "eeprom.h"
+#include "test/eeprom_test.h"
+}
+
+#define ADDRESS(a) ((uint8_t *)(uintptr_t)(a))
+
+struct access_t {
+    eeprom_test_access_t access;
+    uintptr_t            address;
+    uint8_t              value;
+};
+
+static std::vector<access_t> traced;
+
+static void record(eeprom_test_access_t access, uintptr_t address, uint8_t value) { traced.push_back({access, address, value}); }
+
+class EepromSimulator : public testing::Test {
+   public:
+    void SetUp() override {
+        eeprom_test_cut_power_after(-1);
+        eeprom_test_erase();
+        eeprom_test_reset_stats();
+        traced.clear();
+    }
+
+    void TearDown() override { eeprom_test_set_trace(NULL); }
+};
+
+TEST_F(EepromSimulator, erase_sets_all_bytes) {
+    eeprom_update_byte(ADDRESS(3), 0x12);
+    eeprom_test_reset_stats();
+    eeprom_test_erase();
+    EXPECT_EQ(eeprom_test_get_stats().erases, EEPROM_SIZE);
+    for (uint16_t i = 0; i < EEPROM_SIZE; i++) {
+        ASSERT_EQ(eeprom_read_byte(ADDRESS(i)), 0xFF);
+    }
+}
+
+TEST_F(EepromSimulator, update_only_writes_changes) {
+    uint8_t data[4] = {0xFF, 0x01, 0xFF, 0x02};
+    eeprom_update_block(data, ADDRESS(10), sizeof(data));
+    EXPECT_EQ(eeprom_test_get_stats().writes, 2);
+    EXPECT_EQ(eeprom_test_get_stats().reads, 0);
+
+    eeprom_update_dword((uint32_t *)ADDRESS(10), 0x02FF01FF);
+    EXPECT_EQ(eeprom_test_get_stats().writes, 2);
+
+    eeprom_write_byte(ADDRESS(10), 0xFF);
+    EXPECT_EQ(eeprom_test_get_stats().writes, 3);
+}
+
+TEST_F(EepromSimulator, counts_accesses_per_address) {
+    eeprom_write_byte(ADDRESS(5), 1);
+    eeprom_write_byte(ADDRESS(5), 2);
+    eeprom_read_byte(ADDRESS(5));
+    eeprom_read_word((const uint16_t *)ADDRESS(6));
+
+    eeprom_test_stats_t at5 = eeprom_test_get_address_stats(5);
+    EXPECT_EQ(at5.writes, 2);
+    EXPECT_EQ(at5.reads, 1);
+    EXPECT_EQ(at5.time_us, 2 * 3400);
+    EXPECT_EQ(eeprom_test_get_address_stats(6).reads, 1);
+    EXPECT_EQ(eeprom_test_get_address_stats(7).reads, 1);
+    EXPECT_EQ(eeprom_test_get_address_stats(8).reads, 0);
+    EXPECT_EQ(eeprom_test_get_stats().time_us, 2 * 3400);
+}
+
+TEST_F(EepromSimulator, out_of_range_accesses_are_counted) {
+    eeprom_write_byte(ADDRESS(EEPROM_SIZE), 1);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(EEPROM_SIZE + 1)), 0);
+    EXPECT_EQ(eeprom_test_get_stats().out_of_range, 2);
+    EXPECT_EQ(eeprom_test_get_stats().writes, 0);
+    EXPECT_EQ(eeprom_test_get_stats().reads, 0);
+}
+
+TEST_F(EepromSimulator, traces_every_access) {
+    eeprom_test_set_trace(record);
+    eeprom_update_word((uint16_t *)ADDRESS(0x20), 0x12FF);
+    eeprom_read_byte(ADDRESS(0x21));
+    eeprom_test_set_trace(NULL);
+    eeprom_read_byte(ADDRESS(0x21));
+
+    ASSERT_EQ(traced.size(), 2u);
+    EXPECT_EQ(traced[0].access, EEPROM_TEST_WRITE);
+    EXPECT_EQ(traced[0].address, 0x21u);
+    EXPECT_EQ(traced[0].value, 0x12);
+    EXPECT_EQ(traced[1].access, EEPROM_TEST_READ);
+    EXPECT_EQ(traced[1].address, 0x21u);
+    EXPECT_EQ(traced[1].value, 0x12);
+}
+
+TEST_F(EepromSimulator, drops_writes_after_power_cut) {
+    eeprom_test_cut_power_after(2);
+    uint8_t data[4] = {1, 2, 3, 4};
+    eeprom_write_block(data, ADDRESS(0), sizeof(data));
+    eeprom_test_cut_power_after(-1);
+    EXPECT_EQ(eeprom_test_get_stats().writes, 2);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(1)), 2);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(2)), 0xFF);
+}
+
+TEST_F(EepromSimulator, images_round_trip) {
+    std::string path = testing::TempDir() + "eeprom_simulator_test.bin";
+    eeprom_write_byte(ADDRESS(0), 0xAB);
+    eeprom_write_byte(ADDRESS(EEPROM_SIZE - 1), 0xCD);
+    ASSERT_TRUE(eeprom_test_save_image(path.c_str()));
+
+    eeprom_test_erase();
+    eeprom_test_reset_stats();
+    ASSERT_TRUE(eeprom_test_load_image(path.c_str()));
+    EXPECT_EQ(eeprom_test_get_stats().writes, 0);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(0)), 0xAB);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(1)), 0xFF);
+    EXPECT_EQ(eeprom_read_byte(ADDRESS(EEPROM_SIZE - 1)), 0xCD);
+    std::remove(path.c_str());
+
+    EXPECT_FALSE(eeprom_test_load_image("/nonexistent/eeprom.bin"));
+}
@@ -0,0 +1,228 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "eeprom.h"
+#include "flash_stm32_mock.h"
+}
+
+class EepromStm32 : public testing::Test {
+   public:
+    EepromStm32() {
+        flash_mock_reset();
+        EEPROM_Init();
+        flash_mock_reset_stats();
+    }
+
+    // Some arbitrary but repeatable writes spread over the whole EEPROM
+    static uint16_t pattern_address(uint32_t i) { return (i * 37) % FEE_DENSITY_BYTES; }
+    static uint8_t  pattern_value(uint32_t i) { return (i * 13 + 7) % 0xFF; }
+};
+
+TEST_F(EepromStm32, reads_erased_bytes_after_formatting) {
+    for (uint16_t i = 0; i < FEE_DENSITY_BYTES; i++) {
+        EXPECT_EQ(EEPROM_ReadDataByte(i), 0xFF);
+    }
+}
+
+TEST_F(EepromStm32, keeps_written_bytes_after_reboot) {
+    EEPROM_WriteDataByte(0, 0x12);
+    EEPROM_WriteDataByte(FEE_DENSITY_BYTES - 1, 0x34);
+    EXPECT_EQ(EEPROM_ReadDataByte(0), 0x12);
+    EXPECT_EQ(EEPROM_ReadDataByte(FEE_DENSITY_BYTES - 1), 0x34);
+    EEPROM_Init();
+    EXPECT_EQ(EEPROM_ReadDataByte(0), 0x12);
+    EXPECT_EQ(EEPROM_ReadDataByte(FEE_DENSITY_BYTES - 1), 0x34);
+    EXPECT_EQ(EEPROM_ReadDataByte(1), 0xFF);
+}
+
+TEST_F(EepromStm32, ignores_writes_outside_of_the_eeprom) {
+    EXPECT_EQ(EEPROM_WriteDataByte(FEE_DENSITY_BYTES, 0x12), FLASH_BAD_ADDRESS);
+    EXPECT_EQ(EEPROM_ReadDataByte(FEE_DENSITY_BYTES), 0xFF);
+    EXPECT_EQ(flash_mock_get_stats().writes, 0);
+}
+
+TEST_F(EepromStm32, does_not_program_unchanged_bytes) {
+    EEPROM_WriteDataByte(5, 0x12);
+    flash_mock_reset_stats();
+    EEPROM_WriteDataByte(5, 0x12);
+    EXPECT_EQ(flash_mock_get_stats().writes, 0);
+}
+
+TEST_F(EepromStm32, appends_a_record_without_erasing) {
+    EEPROM_WriteDataByte(5, 0x12);
+    EEPROM_WriteDataByte(5, 0x13);
+    flash_mock_stats_t stats = flash_mock_get_stats();
+    EXPECT_EQ(stats.erases, 0);
+    EXPECT_EQ(stats.writes, 4);
+}
+
+TEST_F(EepromStm32, compacts_when_the_log_is_full) {
+    for (uint32_t i = 0; i <= FEE_LOG_RECORDS; i++) {
+        EEPROM_WriteDataByte(pattern_address(i), pattern_value(i));
+    }
+    flash_mock_stats_t stats = flash_mock_get_stats();
+    EXPECT_EQ(stats.erases, FEE_BANK_PAGES);
+    EXPECT_EQ(stats.program_errors, 0);
+    EEPROM_Init();
+    for (uint32_t i = 0; i <= FEE_LOG_RECORDS; i++) {
+        EXPECT_EQ(EEPROM_ReadDataByte(pattern_address(i)), pattern_value(i));
+    }
+}
+
+TEST_F(EepromStm32, spreads_wear_over_all_pages) {
+    const uint32_t num_writes = 20000;
+    for (uint32_t i = 0; i < num_writes; i++) {
+        EEPROM_WriteDataByte(7, i & 1 ? 0x55 : 0xAA);
+    }
+    flash_mock_stats_t stats = flash_mock_get_stats();
+    EXPECT_EQ(stats.program_errors, 0);
+    // The old page copying scheme erased a page on every write
+    EXPECT_LE(stats.erases, (num_writes / FEE_LOG_RECORDS + 1) * FEE_BANK_PAGES);
+    uint32_t min_erases = stats.page_erases[0];
+    uint32_t max_erases = stats.page_erases[0];
+    for (uint8_t page = 1; page < FEE_DENSITY_PAGES; page++) {
+        min_erases = std::min(min_erases, stats.page_erases[page]);
+        max_erases = std::max(max_erases, stats.page_erases[page]);
+    }
+    EXPECT_LE(max_erases - min_erases, 1);
+}
+
+TEST_F(EepromStm32, erase_resets_all_bytes) {
+    EEPROM_WriteDataByte(3, 0x12);
+    EEPROM_Erase();
+    EXPECT_EQ(EEPROM_ReadDataByte(3), 0xFF);
+    EEPROM_Init();
+    EXPECT_EQ(EEPROM_ReadDataByte(3), 0xFF);
+}
+
+// Writes bytes the way the previous layout did, one per half-word
+static void write_legacy_layout(uint16_t count) {
+    flash_mock_reset();
+    for (uint16_t i = 0; i < count; i++) {
+        FLASH_ProgramHalfWord(FEE_LEGACY_ADDRESS(i), 0xFF00 | (i * 7 + 1));
+    }
+}
+
+TEST_F(EepromStm32, migrates_the_previous_layout) {
+    write_legacy_layout(FEE_LEGACY_DENSITY_BYTES);
+    // What was in the pages below is overwritten
+    FLASH_ProgramHalfWord(FEE_BANK_ADDRESS(0) + FEE_SNAPSHOT_OFFSET, 0x1234);
+    EEPROM_Init();
+    ASSERT_GE(FEE_DENSITY_BYTES, FEE_LEGACY_DENSITY_BYTES);
+    for (uint16_t i = 0; i < FEE_LEGACY_DENSITY_BYTES; i++) {
+        EXPECT_EQ(EEPROM_ReadDataByte(i), (uint8_t)(i * 7 + 1));
+    }
+    EXPECT_EQ(flash_mock_get_stats().program_errors, 0);
+
+    EXPECT_EQ(EEPROM_WriteDataByte(3, 0x42), FLASH_COMPLETE);
+    EEPROM_Init();
+    EXPECT_EQ(EEPROM_ReadDataByte(3), 0x42);
+    EXPECT_EQ(EEPROM_ReadDataByte(4), (uint8_t)(4 * 7 + 1));
+    EXPECT_EQ(flash_mock_get_stats().program_errors, 0);
+}
+
+TEST_F(EepromStm32, migrates_the_previous_layout_despite_power_loss) {
+    for (int32_t cut = 0;; cut++) {
+        write_legacy_layout(FEE_LEGACY_DENSITY_BYTES);
+        flash_mock_reset_stats();
+        flash_mock_cut_power_after(cut);
+        EEPROM_Init();
+        bool power_lost = !flash_mock_has_power();
+
+        // Reboot
+        flash_mock_cut_power_after(-1);
+        EEPROM_Init();
+        for (uint16_t i = 0; i < FEE_LEGACY_DENSITY_BYTES; i++) {
+            ASSERT_EQ(EEPROM_ReadDataByte(i), (uint8_t)(i * 7 + 1)) << "power cut after " << cut << " operations";
+        }
+        EXPECT_EQ(EEPROM_WriteDataByte(3, 0x42), FLASH_COMPLETE);
+        EXPECT_EQ(flash_mock_get_stats().program_errors, 0) << "power cut after " << cut << " operations";
+
+        if (!power_lost) {
+            break;
+        }
+    }
+}
+
+TEST_F(EepromStm32, wraps_avr_style_functions) {
+    eeprom_update_dword((uint32_t *)8, 0x12345678);
+    eeprom_write_word((uint16_t *)12, 0xABCD);
+    EEPROM_Init();
+    EXPECT_EQ(eeprom_read_dword((const uint32_t *)8), 0x12345678);
+    EXPECT_EQ(eeprom_read_word((const uint16_t *)12), 0xABCD);
+    EXPECT_EQ(eeprom_read_byte((const uint8_t *)8), 0x78);
+}
+
+TEST_F(EepromStm32, survives_power_loss_at_any_point) {
+    // Enough writes to go through a compaction, starting with a partially filled log
+    const uint32_t first_write = FEE_LOG_RECORDS - 20;
+    const uint32_t num_writes  = 40;
+
+    // expected[j] is the EEPROM content after the first j of the interrupted writes
+    std::vector<uint8_t> state(FEE_DENSITY_BYTES, 0xFF);
+    for (uint32_t i = 0; i < first_write; i++) {
+        state[pattern_address(i)] = pattern_value(i);
+    }
+    std::vector<std::vector<uint8_t>> expected(1, state);
+    for (uint32_t i = first_write; i < first_write + num_writes; i++) {
+        state[pattern_address(i)] = pattern_value(i);
+        expected.push_back(state);
+    }
+
+    for (int32_t cut = 0;; cut++) {
+        flash_mock_reset();
+        EEPROM_Init();
+        for (uint32_t i = 0; i < first_write; i++) {
+            EEPROM_WriteDataByte(pattern_address(i), pattern_value(i));
+        }
+
+        flash_mock_cut_power_after(cut);
+        uint32_t completed = 0;
+        for (uint32_t i = first_write; i < first_write + num_writes; i++) {
+            EEPROM_WriteDataByte(pattern_address(i), pattern_value(i));
+            if (!flash_mock_has_power()) {
+                break;
+            }
+            completed++;
+        }
+        bool power_lost = !flash_mock_has_power();
+
+        // Reboot
+        flash_mock_cut_power_after(-1);
+        EEPROM_Init();
+        std::vector<uint8_t> actual(FEE_DENSITY_BYTES);
+        for (uint16_t i = 0; i < FEE_DENSITY_BYTES; i++) {
+            actual[i] = EEPROM_ReadDataByte(i);
+        }
+        bool before = actual == expected[completed];
+        bool after  = completed < num_writes && actual == expected[completed + 1];
+        EXPECT_TRUE(before || after) << "power cut after " << cut << " operations";
+
+        // The EEPROM is still fully usable
+        EEPROM_WriteDataByte(1, 0x42);
+        EEPROM_Init();
+        EXPECT_EQ(EEPROM_ReadDataByte(1), 0x42);
+        EXPECT_EQ(flash_mock_get_stats().program_errors, 0) << "power cut after " << cut << " operations";
+
+        if (!power_lost) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,70 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Simulated EEPROM of the test platform.
+ *
+ * It holds EEPROM_SIZE bytes, 1024 unless defined otherwise, which start out
+ * as zeros. eeprom_update_*() only write the bytes that change, like avr-libc.
+ * Every access is counted, overall and per address, along with the time the
+ * ATmega32u4 EEPROM would have taken for it, so that tests can check how much
+ * EEPROM traffic a piece of code generates. EEPROM_TEST_READ_TIME_US,
+ * EEPROM_TEST_WRITE_TIME_US and EEPROM_TEST_ERASE_TIME_US change the timing
+ * of a byte access.
+ */
+typedef struct {
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t erases;
+    // Accesses past the end of the EEPROM, which read as zero and aren't written
+    uint32_t out_of_range;
+    uint32_t time_us;
+} eeprom_test_stats_t;
+
+eeprom_test_stats_t eeprom_test_get_stats(void);
+// Counters of a single address, time_us is the time spent on it
+eeprom_test_stats_t eeprom_test_get_address_stats(uintptr_t address);
+void                eeprom_test_reset_stats(void);
+uint16_t            eeprom_test_get_size(void);
+
+typedef enum {
+    EEPROM_TEST_READ,
+    EEPROM_TEST_WRITE,
+    EEPROM_TEST_ERASE,
+} eeprom_test_access_t;
+
+// Called for every byte accessed, with the value read or written. NULL turns
+// tracing off.
+typedef void (*eeprom_test_trace_t)(eeprom_test_access_t access, uintptr_t address, uint8_t value);
+void eeprom_test_set_trace(eeprom_test_trace_t trace);
+// Trace that prints a line per access to stderr, such as "eeprom W 0x0040 0x12"
+void eeprom_test_trace_print(eeprom_test_access_t access, uintptr_t address, uint8_t value);
+
+// Sets every byte to 0xFF, as a chip erase would
+void eeprom_test_erase(void);
+
+// Images are raw dumps of the EEPROM. Loading a shorter image leaves the bytes
+// past its end as they are. Neither counts as accesses.
+bool eeprom_test_load_image(const char *path);
+bool eeprom_test_save_image(const char *path);
+
+// Drops every write and erase after the next `writes` ones, as if power was
+// lost at that point. A negative count restores power.
+void eeprom_test_cut_power_after(int32_t writes);
@@ -0,0 +1,83 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "flash_stm32.h"
+#include "flash_stm32_mock.h"
+
+uint8_t FlashBuf[MOCK_FLASH_SIZE] __attribute__((aligned(2)));
+
+static flash_mock_stats_t stats;
+static int32_t            operations_left = -1;
+
+void flash_mock_reset(void) {
+    memset(FlashBuf, 0xFF, sizeof(FlashBuf));
+    flash_mock_reset_stats();
+    operations_left = -1;
+}
+
+flash_mock_stats_t flash_mock_get_stats(void) { return stats; }
+
+void flash_mock_reset_stats(void) { memset(&stats, 0, sizeof(stats)); }
+
+void flash_mock_cut_power_after(int32_t operations) { operations_left = operations; }
+
+bool flash_mock_has_power(void) { return operations_left != 0; }
+
+static bool use_power(void) {
+    if (operations_left == 0) {
+        return false;
+    }
+    if (operations_left > 0) {
+        operations_left--;
+    }
+    return true;
+}
+
+FLASH_Status FLASH_WaitForLastOperation(uint32_t Timeout) { return FLASH_COMPLETE; }
+
+FLASH_Status FLASH_ErasePage(uint32_t Page_Address) {
+    if (Page_Address % FEE_PAGE_SIZE != 0 || Page_Address >= MOCK_FLASH_SIZE) {
+        return FLASH_BAD_ADDRESS;
+    }
+    if (!use_power()) {
+        return FLASH_TIMEOUT;
+    }
+    memset(FlashBuf + Page_Address, 0xFF, FEE_PAGE_SIZE);
+    stats.erases++;
+    stats.page_erases[Page_Address / FEE_PAGE_SIZE]++;
+    return FLASH_COMPLETE;
+}
+
+FLASH_Status FLASH_ProgramHalfWord(uint32_t Address, uint16_t Data) {
+    if (Address % 2 != 0 || Address >= MOCK_FLASH_SIZE) {
+        return FLASH_BAD_ADDRESS;
+    }
+    if (!use_power()) {
+        return FLASH_TIMEOUT;
+    }
+    if (FLASH_READ_HALF_WORD(Address) != 0xFFFF) {
+        stats.program_errors++;
+        return FLASH_ERROR_PG;
+    }
+    *(uint16_t *)(FlashBuf + Address) = Data;
+    stats.writes++;
+    return FLASH_COMPLETE;
+}
+
+void FLASH_Unlock(void) {}
+void FLASH_Lock(void) {}
+void FLASH_ClearFlag(uint32_t FLASH_FLAG) {}
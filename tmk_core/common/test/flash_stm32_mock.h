@@ -0,0 +1,40 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "eeprom_stm32.h"
+
+#define MOCK_FLASH_SIZE (FEE_PAGE_SIZE * FEE_DENSITY_PAGES)
+
+typedef struct {
+    uint32_t erases;
+    uint32_t writes;
+    // Attempts to program a half-word that was not erased, which real flash rejects
+    uint32_t program_errors;
+    uint32_t page_erases[FEE_DENSITY_PAGES];
+} flash_mock_stats_t;
+
+// Erases the whole flash, clears the statistics and restores power
+void               flash_mock_reset(void);
+flash_mock_stats_t flash_mock_get_stats(void);
+void               flash_mock_reset_stats(void);
+// Every erase or program after the next `operations` ones is silently dropped,
+// as if the power was cut. A negative value keeps the power on.
+void flash_mock_cut_power_after(int32_t operations);
+bool flash_mock_has_power(void);
@@ -0,0 +1,191 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The few definitions of LUFA that usb_descriptor.c uses, with the values of
+ * LUFA, so that its tests build without the LUFA submodule.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <wchar.h>
+#include "progmem.h"
+
+#define ATTR_PACKED __attribute__((packed))
+#define CONCAT(x, y) x##y
+#define CONCAT_EXPANDED(x, y) CONCAT(x, y)
+#define CPU_TO_LE16(x) (x)
+
+/* Core/StdDescriptors.h */
+#define NO_DESCRIPTOR 0
+#define USB_CONFIG_POWER_MA(mA) ((mA) >> 1)
+#define USB_STRING_LEN(UnicodeChars) (sizeof(USB_Descriptor_Header_t) + ((UnicodeChars) << 1))
+#define VERSION_BCD(Major, Minor, Revision) CPU_TO_LE16((((Major) / 10) << 12) | (((Major) % 10) << 8) | ((Minor) << 4) | (Revision))
+#define LANGUAGE_ID_ENG 0x0409
+#define USB_CONFIG_ATTR_RESERVED 0x80
+#define USB_CONFIG_ATTR_SELFPOWERED 0x40
+#define USB_CONFIG_ATTR_REMOTEWAKEUP 0x20
+#define ENDPOINT_ATTR_NO_SYNC (0 << 2)
+#define ENDPOINT_USAGE_DATA (0 << 4)
+#define USB_CSCP_NoDeviceClass 0x00
+#define USB_CSCP_NoDeviceSubclass 0x00
+#define USB_CSCP_NoDeviceProtocol 0x00
+#define USB_CSCP_IADDeviceClass 0xEF
+#define USB_CSCP_IADDeviceSubclass 0x02
+#define USB_CSCP_IADDeviceProtocol 0x01
+
+enum USB_DescriptorTypes_t {
+    DTYPE_Device        = 0x01,
+    DTYPE_Configuration = 0x02,
+    DTYPE_String        = 0x03,
+    DTYPE_Interface     = 0x04,
+    DTYPE_Endpoint      = 0x05,
+};
+
+typedef struct {
+    uint8_t Size;
+    uint8_t Type;
+} ATTR_PACKED USB_Descriptor_Header_t;
+
+typedef struct {
+    USB_Descriptor_Header_t Header;
+    uint16_t                USBSpecification;
+    uint8_t                 Class;
+    uint8_t                 SubClass;
+    uint8_t                 Protocol;
+    uint8_t                 Endpoint0Size;
+    uint16_t                VendorID;
+    uint16_t                ProductID;
+    uint16_t                ReleaseNumber;
+    uint8_t                 ManufacturerStrIndex;
+    uint8_t                 ProductStrIndex;
+    uint8_t                 SerialNumStrIndex;
+    uint8_t                 NumberOfConfigurations;
+} ATTR_PACKED USB_Descriptor_Device_t;
+
+typedef struct {
+    USB_Descriptor_Header_t Header;
+    uint16_t                TotalConfigurationSize;
+    uint8_t                 TotalInterfaces;
+    uint8_t                 ConfigurationNumber;
+    uint8_t                 ConfigurationStrIndex;
+    uint8_t                 ConfigAttributes;
+    uint8_t                 MaxPowerConsumption;
+} ATTR_PACKED USB_Descriptor_Configuration_Header_t;
+
+typedef struct {
+    USB_Descriptor_Header_t Header;
+    uint8_t                 InterfaceNumber;
+    uint8_t                 AlternateSetting;
+    uint8_t                 TotalEndpoints;
+    uint8_t                 Class;
+    uint8_t                 SubClass;
+    uint8_t                 Protocol;
+    uint8_t                 InterfaceStrIndex;
+} ATTR_PACKED USB_Descriptor_Interface_t;
+
+typedef struct {
+    USB_Descriptor_Header_t Header;
+    uint8_t                 EndpointAddress;
+    uint8_t                 Attributes;
+    uint16_t                EndpointSize;
+    uint8_t                 PollingIntervalMS;
+} ATTR_PACKED USB_Descriptor_Endpoint_t;
+
+typedef struct {
+    USB_Descriptor_Header_t Header;
+    wchar_t                 UnicodeString[];
+} ATTR_PACKED USB_Descriptor_String_t;
+
+/* Core/USBController.h */
+#define ENDPOINT_DIR_OUT 0x00
+#define ENDPOINT_DIR_IN 0x80
+#define EP_TYPE_CONTROL 0x00
+#define EP_TYPE_ISOCHRONOUS 0x01
+#define EP_TYPE_BULK 0x02
+#define EP_TYPE_INTERRUPT 0x03
+
+/* Class/Common/HIDClassCommon.h */
+#define HID_CSCP_HIDClass 0x03
+#define HID_CSCP_NonBootSubclass 0x00
+#define HID_CSCP_BootSubclass 0x01
+#define HID_CSCP_NonBootProtocol 0x00
+#define HID_CSCP_KeyboardBootProtocol 0x01
+#define HID_CSCP_MouseBootProtocol 0x02
+
+enum HID_Descriptor_ClassSpecific_t {
+    HID_DTYPE_HID    = 0x21,
+    HID_DTYPE_Report = 0x22,
+};
+
+typedef struct {
+    USB_Descriptor_Header_t Header;
+    uint16_t                HIDSpec;
+    uint8_t                 CountryCode;
+    uint8_t                 TotalReportDescriptors;
+    uint8_t                 HIDReportType;
+    uint16_t                HIDReportLength;
+} ATTR_PACKED USB_HID_Descriptor_HID_t;
+
+typedef uint8_t USB_Descriptor_HIDReport_Datatype_t;
+
+/* Class/Common/HIDReportData.h */
+#define HID_RI_DATA_SIZE_MASK 0x03
+#define HID_RI_TYPE_MASK 0x0C
+#define HID_RI_TAG_MASK 0xF0
+
+#define HID_RI_TYPE_MAIN 0x00
+#define HID_RI_TYPE_GLOBAL 0x04
+#define HID_RI_TYPE_LOCAL 0x08
+
+#define HID_RI_DATA_BITS_0 0x00
+#define HID_RI_DATA_BITS_8 0x01
+#define HID_RI_DATA_BITS_16 0x02
+#define HID_RI_DATA_BITS_32 0x03
+#define HID_RI_DATA_BITS(DataBits) CONCAT_EXPANDED(HID_RI_DATA_BITS_, DataBits)
+
+#define _HID_RI_ENCODE_0(Data)
+#define _HID_RI_ENCODE_8(Data) , (Data & 0xFF)
+#define _HID_RI_ENCODE_16(Data) _HID_RI_ENCODE_8(Data) _HID_RI_ENCODE_8(Data >> 8)
+#define _HID_RI_ENCODE_32(Data) _HID_RI_ENCODE_16(Data) _HID_RI_ENCODE_16(Data >> 16)
+#define _HID_RI_ENCODE(DataBits, ...) CONCAT_EXPANDED(_HID_RI_ENCODE_, DataBits(__VA_ARGS__))
+
+#define _HID_RI_ENTRY(Type, Tag, DataBits, ...) (Type | Tag | HID_RI_DATA_BITS(DataBits)) _HID_RI_ENCODE(DataBits, (__VA_ARGS__))
+
+#define HID_IOF_CONSTANT (1 << 0)
+#define HID_IOF_DATA (0 << 0)
+#define HID_IOF_VARIABLE (1 << 1)
+#define HID_IOF_ARRAY (0 << 1)
+#define HID_IOF_RELATIVE (1 << 2)
+#define HID_IOF_ABSOLUTE (0 << 2)
+#define HID_IOF_NON_VOLATILE (0 << 7)
+#define HID_IOF_VOLATILE (1 << 7)
+
+#define HID_RI_INPUT(DataBits, ...) _HID_RI_ENTRY(HID_RI_TYPE_MAIN, 0x80, DataBits, __VA_ARGS__)
+#define HID_RI_OUTPUT(DataBits, ...) _HID_RI_ENTRY(HID_RI_TYPE_MAIN, 0x90, DataBits, __VA_ARGS__)
+#define HID_RI_COLLECTION(DataBits, ...) _HID_RI_ENTRY(HID_RI_TYPE_MAIN, 0xA0, DataBits, __VA_ARGS__)
+#define HID_RI_FEATURE(DataBits, ...) _HID_RI_ENTRY(HID_RI_TYPE_MAIN, 0xB0, DataBits, __VA_ARGS__)
+#define HID_RI_END_COLLECTION(DataBits, ...) _HID_RI_ENTRY(HID_RI_TYPE_MAIN, 0xC0, DataBits, __VA_ARGS__)
+#define HID_RI_USAGE_PAGE(DataBits, ...) _HID_RI_ENTRY(HID_RI_TYPE_GLOBAL, 0x00, DataBits, __VA_ARGS__)
+#define HID_RI_LOGICAL_MINIMUM(DataBits, ...) _HID_RI_ENTRY(HID_RI_TYPE_GLOBAL, 0x10, DataBits, __VA_ARGS__)
+#define HID_RI_LOGICAL_MAXIMUM(DataBits, ...) _HID_RI_ENTRY(HID_RI_TYPE_GLOBAL, 0x20, DataBits, __VA_ARGS__)
+#define HID_RI_REPORT_SIZE(DataBits, ...) _HID_RI_ENTRY(HID_RI_TYPE_GLOBAL, 0x70, DataBits, __VA_ARGS__)
+#define HID_RI_REPORT_ID(DataBits, ...) _HID_RI_ENTRY(HID_RI_TYPE_GLOBAL, 0x80, DataBits, __VA_ARGS__)
+#define HID_RI_REPORT_COUNT(DataBits, ...) _HID_RI_ENTRY(HID_RI_TYPE_GLOBAL, 0x90, DataBits, __VA_ARGS__)
+#define HID_RI_USAGE(DataBits, ...) _HID_RI_ENTRY(HID_RI_TYPE_LOCAL, 0x00, DataBits, __VA_ARGS__)
+#define HID_RI_USAGE_MINIMUM(DataBits, ...) _HID_RI_ENTRY(HID_RI_TYPE_LOCAL, 0x10, DataBits, __VA_ARGS__)
+#define HID_RI_USAGE_MAXIMUM(DataBits, ...) _HID_RI_ENTRY(HID_RI_TYPE_LOCAL, 0x20, DataBits, __VA_ARGS__)
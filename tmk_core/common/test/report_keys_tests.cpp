@@ -0,0 +1,263 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "report.h"
+}
+
+// How the keys of a 6KRO report were kept before report_keys_t, in the report itself
+class ReferenceReport {
+   public:
+    ReferenceReport() { clear(); }
+
+    void clear() {
+        memset(keys, 0, sizeof(keys));
+        cb_head = cb_tail = cb_count = 0;
+    }
+
+#ifdef USB_6KRO_ENABLE
+#    define RO_ADD(a, b) ((a + b) % KEYBOARD_REPORT_KEYS)
+#    define RO_SUB(a, b) ((a - b + KEYBOARD_REPORT_KEYS) % KEYBOARD_REPORT_KEYS)
+#    define RO_INC(a) RO_ADD(a, 1)
+#    define RO_DEC(a) RO_SUB(a, 1)
+    void add(uint8_t code) {
+        int8_t i     = cb_head;
+        int8_t empty = -1;
+        if (cb_count) {
+            do {
+                if (keys[i] == code) {
+                    return;
+                }
+                if (empty == -1 && keys[i] == 0) {
+                    empty = i;
+                }
+                i = RO_INC(i);
+            } while (i != cb_tail);
+            if (i == cb_tail) {
+                if (cb_tail == cb_head) {
+                    if (empty == -1) {
+                        cb_head = RO_INC(cb_head);
+                        cb_count--;
+                    } else {
+                        uint8_t offset = 1;
+                        i              = RO_INC(empty);
+                        do {
+                            if (keys[i] != 0) {
+                                keys[empty] = keys[i];
+                                keys[i]     = 0;
+                                empty       = RO_INC(empty);
+                            } else {
+                                offset++;
+                            }
+                            i = RO_INC(i);
+                        } while (i != cb_tail);
+                        cb_tail = RO_SUB(cb_tail, offset);
+                    }
+                }
+            }
+        }
+        keys[cb_tail] = code;
+        cb_tail       = RO_INC(cb_tail);
+        cb_count++;
+    }
+
+    void del(uint8_t code) {
+        uint8_t i = cb_head;
+        if (cb_count) {
+            do {
+                if (keys[i] == code) {
+                    keys[i] = 0;
+                    cb_count--;
+                    if (cb_count == 0) {
+                        cb_tail = cb_head = 0;
+                    }
+                    if (i == RO_DEC(cb_tail)) {
+                        do {
+                            cb_tail = RO_DEC(cb_tail);
+                            if (keys[RO_DEC(cb_tail)] != 0) {
+                                break;
+                            }
+                        } while (cb_tail != cb_head);
+                    }
+                    break;
+                }
+                i = RO_INC(i);
+            } while (i != cb_tail);
+        }
+    }
+
+    uint8_t first() {
+        uint8_t i = cb_head;
+        do {
+            if (keys[i] != 0) {
+                break;
+            }
+            i = RO_INC(i);
+        } while (i != cb_tail);
+        return keys[i];
+    }
+#else
+    void add(uint8_t code) {
+        int8_t i     = 0;
+        int8_t empty = -1;
+        for (; i < KEYBOARD_REPORT_KEYS; i++) {
+            if (keys[i] == code) {
+                break;
+            }
+            if (empty == -1 && keys[i] == 0) {
+                empty = i;
+            }
+        }
+        if (i == KEYBOARD_REPORT_KEYS && empty != -1) {
+            keys[empty] = code;
+        }
+    }
+
+    void del(uint8_t code) {
+        for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+            if (keys[i] == code) {
+                keys[i] = 0;
+            }
+        }
+    }
+#endif
+
+    std::vector<uint8_t> sorted() {
+        std::vector<uint8_t> result;
+        for (uint8_t key : keys) {
+            if (key) {
+                result.push_back(key);
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    uint8_t keys[KEYBOARD_REPORT_KEYS];
+    int8_t  cb_head;
+    int8_t  cb_tail;
+    int8_t  cb_count;
+};
+
+class ReportKeys : public testing::Test {
+   public:
+    ReportKeys() { report_keys_clear(&keys); }
+
+    std::vector<uint8_t> sorted() {
+        report_keyboard_t report = {};
+        report_keys_write(&keys, &report);
+        std::vector<uint8_t> result;
+        for (uint8_t key : report.keys) {
+            if (key) {
+                result.push_back(key);
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    report_keys_t keys;
+};
+
+TEST_F(ReportKeys, AddsAndRemovesKeys) {
+    report_keys_add(&keys, KC_B);
+    report_keys_add(&keys, KC_A);
+    report_keys_add(&keys, KC_A);
+    EXPECT_EQ(report_keys_count(&keys), 2);
+    EXPECT_TRUE(report_keys_has(&keys, KC_A));
+    EXPECT_FALSE(report_keys_has(&keys, KC_C));
+    EXPECT_EQ(sorted(), std::vector<uint8_t>({KC_A, KC_B}));
+
+    report_keys_del(&keys, KC_B);
+    report_keys_del(&keys, KC_C);
+    EXPECT_EQ(report_keys_count(&keys), 1);
+    EXPECT_EQ(sorted(), std::vector<uint8_t>({KC_A}));
+
+    report_keys_clear(&keys);
+    EXPECT_EQ(report_keys_count(&keys), 0);
+    EXPECT_EQ(report_keys_first(&keys), KC_NO);
+    EXPECT_EQ(sorted(), std::vector<uint8_t>());
+}
+
+TEST_F(ReportKeys, IgnoresNoKey) {
+    report_keys_add(&keys, KC_NO);
+    EXPECT_EQ(report_keys_count(&keys), 0);
+    EXPECT_FALSE(report_keys_has(&keys, KC_NO));
+}
+
+TEST_F(ReportKeys, KeepsHighKeycodes) {
+    report_keys_add(&keys, 0xFF);
+    report_keys_add(&keys, KC_A);
+    EXPECT_TRUE(report_keys_has(&keys, 0xFF));
+    EXPECT_EQ(sorted(), std::vector<uint8_t>({KC_A, 0xFF}));
+}
+
+TEST_F(ReportKeys, KeepsSixKeys) {
+    for (uint8_t key = KC_A; key <= KC_G; key++) {
+        report_keys_add(&keys, key);
+    }
+    EXPECT_EQ(report_keys_count(&keys), KEYBOARD_REPORT_KEYS);
+#ifdef USB_6KRO_ENABLE
+    EXPECT_EQ(sorted(), std::vector<uint8_t>({KC_B, KC_C, KC_D, KC_E, KC_F, KC_G}));
+    EXPECT_EQ(report_keys_first(&keys), KC_B);
+#else
+    EXPECT_EQ(sorted(), std::vector<uint8_t>({KC_A, KC_B, KC_C, KC_D, KC_E, KC_F}));
+    EXPECT_EQ(report_keys_first(&keys), KC_A);
+#endif
+}
+
+TEST_F(ReportKeys, MatchesReportKeptKeys) {
+    std::mt19937    random(1);
+    ReferenceReport reference;
+    // few enough keys that the report is often full
+    const uint8_t pool[] = {KC_A, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G, KC_H, KC_1, KC_SPACE};
+
+    for (int step = 0; step < 20000; step++) {
+        uint8_t key = pool[random() % sizeof(pool)];
+        switch (random() % 16) {
+            case 0:
+                reference.clear();
+                report_keys_clear(&keys);
+                break;
+            case 1 ... 8:
+                reference.add(key);
+                report_keys_add(&keys, key);
+                break;
+            default:
+                reference.del(key);
+                report_keys_del(&keys, key);
+                break;
+        }
+
+        std::vector<uint8_t> expected = reference.sorted();
+        ASSERT_EQ(sorted(), expected) << "step " << step;
+        ASSERT_EQ(report_keys_count(&keys), expected.size()) << "step " << step;
+        ASSERT_EQ(report_keys_has(&keys, key), std::find(expected.begin(), expected.end(), key) != expected.end()) << "step " << step;
+#ifdef USB_6KRO_ENABLE
+        if (!expected.empty()) {
+            ASSERT_EQ(report_keys_first(&keys), reference.first()) << "step " << step;
+        }
+#else
+        ASSERT_EQ(report_keys_first(&keys), expected.empty() ? KC_NO : expected.front()) << "step " << step;
+#endif
+    }
+}
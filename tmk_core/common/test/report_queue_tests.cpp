@@ -0,0 +1,106 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "report_queue.h"
+}
+
+static report_keyboard_t report_with(uint8_t key) {
+    report_keyboard_t report = {};
+    report.keys[0]           = key;
+    return report;
+}
+
+class ReportQueue : public testing::Test {
+   public:
+    ReportQueue() { keyboard_report_queue_clear(&queue); }
+
+    uint8_t pop() {
+        report_keyboard_t report = {};
+        EXPECT_TRUE(keyboard_report_queue_pop(&queue, &report));
+        return report.keys[0];
+    }
+
+    bool push(uint8_t key) {
+        report_keyboard_t report = report_with(key);
+        return keyboard_report_queue_push(&queue, &report);
+    }
+
+    keyboard_report_queue_t queue;
+};
+
+TEST_F(ReportQueue, pops_in_push_order) {
+    report_keyboard_t report;
+    EXPECT_TRUE(keyboard_report_queue_is_empty(&queue));
+    EXPECT_FALSE(keyboard_report_queue_pop(&queue, &report));
+
+    EXPECT_TRUE(push(1));
+    EXPECT_TRUE(push(2));
+    EXPECT_FALSE(keyboard_report_queue_is_empty(&queue));
+    EXPECT_EQ(pop(), 1);
+    EXPECT_TRUE(push(3));
+    EXPECT_EQ(pop(), 2);
+    EXPECT_EQ(pop(), 3);
+    EXPECT_TRUE(keyboard_report_queue_is_empty(&queue));
+}
+
+TEST_F(ReportQueue, wraps_around) {
+    for (uint8_t i = 1; i <= 3 * KEYBOARD_REPORT_QUEUE_SIZE; i++) {
+        EXPECT_TRUE(push(i));
+        EXPECT_EQ(pop(), i);
+    }
+}
+
+TEST_F(ReportQueue, clear_drops_everything) {
+    push(1);
+    push(2);
+    keyboard_report_queue_clear(&queue);
+    EXPECT_TRUE(keyboard_report_queue_is_empty(&queue));
+    push(3);
+    EXPECT_EQ(pop(), 3);
+}
+
+#ifdef KEYBOARD_REPORT_QUEUE_COLLAPSE
+TEST_F(ReportQueue, full_queue_keeps_latest_state) {
+    for (uint8_t i = 1; i <= KEYBOARD_REPORT_QUEUE_SIZE; i++) {
+        push(i);
+    }
+    EXPECT_TRUE(keyboard_report_queue_is_full(&queue));
+    EXPECT_TRUE(push(100));
+    EXPECT_TRUE(push(101));
+    for (uint8_t i = 1; i < KEYBOARD_REPORT_QUEUE_SIZE; i++) {
+        EXPECT_EQ(pop(), i);
+    }
+    EXPECT_EQ(pop(), 101);
+    EXPECT_TRUE(keyboard_report_queue_is_empty(&queue));
+}
+#else
+TEST_F(ReportQueue, full_queue_refuses_reports) {
+    for (uint8_t i = 1; i <= KEYBOARD_REPORT_QUEUE_SIZE; i++) {
+        push(i);
+    }
+    EXPECT_TRUE(keyboard_report_queue_is_full(&queue));
+    EXPECT_FALSE(push(100));
+    EXPECT_EQ(pop(), 1);
+    EXPECT_TRUE(push(100));
+    for (uint8_t i = 2; i <= KEYBOARD_REPORT_QUEUE_SIZE; i++) {
+        EXPECT_EQ(pop(), i);
+    }
+    EXPECT_EQ(pop(), 100);
+}
+#endif
@@ -0,0 +1,68 @@
+eeprom_stm32_DEFS := -DFLASH_STM32_MOCKED -DEEPROM_EMU_STM32F103xB -DFEE_PAGE_BASE_ADDRESS=0
+eeprom_stm32_INC := $(TMK_PATH)/common/chibios
+eeprom_stm32_SRC := \
+	$(TMK_PATH)/common/test/eeprom_stm32_tests.cpp \
+	$(TMK_PATH)/common/test/flash_stm32_mock.c \
+	$(TMK_PATH)/common/chibios/eeprom_stm32.c
+
+eeprom_cache_DEFS := -DEEPROM_CACHE_ENABLE
+eeprom_cache_SRC := \
+	$(TMK_PATH)/common/test/eeprom_cache_tests.cpp \
+	$(TMK_PATH)/common/eeprom_cache.c \
+	$(TMK_PATH)/common/test/eeprom.c \
+	$(TMK_PATH)/common/test/timer.c
+
+eeconfig_DEFS := -DEECONFIG_LEGACY_DATA_END=64
+eeconfig_SRC := \
+	$(TMK_PATH)/common/test/eeconfig_tests.cpp \
+	$(TMK_PATH)/common/eeconfig.c \
+	$(TMK_PATH)/common/test/eeprom.c
+
+eeprom_simulator_DEFS := -DEEPROM_SIZE=512
+eeprom_simulator_SRC := \
+	$(TMK_PATH)/common/test/eeprom_simulator_tests.cpp \
+	$(TMK_PATH)/common/test/eeprom.c
+
+report_queue_DEFS := -DKEYBOARD_REPORT_QUEUE_SIZE=3
+report_queue_SRC := \
+	$(TMK_PATH)/common/test/report_queue_tests.cpp \
+	$(TMK_PATH)/common/report_queue.c
+
+report_queue_collapse_DEFS := -DKEYBOARD_REPORT_QUEUE_SIZE=3 -DKEYBOARD_REPORT_QUEUE_COLLAPSE
+report_queue_collapse_SRC := \
+	$(TMK_PATH)/common/test/report_queue_tests.cpp \
+	$(TMK_PATH)/common/report_queue.c
+
+sof_sync_DEFS := -DUSB_SOF_SYNC
+sof_sync_SRC := \
+	$(TMK_PATH)/common/test/sof_sync_tests.cpp \
+	$(TMK_PATH)/common/sof_sync.c
+
+report_keys_SRC := \
+	$(TMK_PATH)/common/test/report_keys_tests.cpp \
+	$(TMK_PATH)/common/report.c
+
+report_keys_6kro_DEFS := -DUSB_6KRO_ENABLE
+report_keys_6kro_SRC := \
+	$(TMK_PATH)/common/test/report_keys_tests.cpp \
+	$(TMK_PATH)/common/report.c
+
+# usb_descriptor.c is built with the LUFA definitions of lufa_mock, so that no submodule is needed
+USB_DESCRIPTOR_DEFS := -DPROTOCOL_TEST -DVENDOR_ID=0xFEED -DPRODUCT_ID=0x0000 -DDEVICE_VER=0x0001 -DMANUFACTURER=QMK -DPRODUCT=Test \
+	-DFIXED_CONTROL_ENDPOINT_SIZE=8 -DFIXED_NUM_CONFIGURATIONS=1
+USB_DESCRIPTOR_INC := . $(TMK_PATH)/protocol $(TMK_PATH)/common/test/lufa_mock
+USB_DESCRIPTOR_SRC := \
+	$(TMK_PATH)/common/test/usb_descriptor_tests.cpp \
+	$(TMK_PATH)/protocol/usb_descriptor.c
+
+usb_descriptor_DEFS := $(USB_DESCRIPTOR_DEFS) -DSHARED_EP_ENABLE -DMOUSE_ENABLE -DMOUSE_SHARED_EP -DEXTRAKEY_ENABLE -DNKRO_ENABLE -DRAW_ENABLE -DCONSOLE_ENABLE
+usb_descriptor_INC := $(USB_DESCRIPTOR_INC)
+usb_descriptor_SRC := $(USB_DESCRIPTOR_SRC)
+
+usb_descriptor_shared_DEFS := $(USB_DESCRIPTOR_DEFS) -DSHARED_EP_ENABLE -DKEYBOARD_SHARED_EP -DMOUSE_ENABLE -DMOUSE_SHARED_EP -DEXTRAKEY_ENABLE -DNKRO_ENABLE
+usb_descriptor_shared_INC := $(USB_DESCRIPTOR_INC)
+usb_descriptor_shared_SRC := $(USB_DESCRIPTOR_SRC)
+
+usb_descriptor_mouse_ep_DEFS := $(USB_DESCRIPTOR_DEFS) -DMOUSE_ENABLE
+usb_descriptor_mouse_ep_INC := $(USB_DESCRIPTOR_INC)
+usb_descriptor_mouse_ep_SRC := $(USB_DESCRIPTOR_SRC)
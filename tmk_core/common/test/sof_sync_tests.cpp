@@ -0,0 +1,146 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "sof_sync.h"
+
+static uint16_t now_us = 0;
+
+uint16_t sof_sync_read_us(void) { return now_us; }
+}
+
+class SofSync : public testing::Test {
+   public:
+    SofSync() {
+        sof_sync_init();
+        next_sof = now_us + SOF_SYNC_FRAME_US;
+    }
+
+    // Moves the clock on, with the host sending SOFs if it's awake
+    void advance(uint16_t us) {
+        while (us--) {
+            now_us++;
+            if (now_us == next_sof) {
+                next_sof += SOF_SYNC_FRAME_US;
+                if (is_host_awake) {
+                    sof_sync_frame();
+                    frame++;
+                }
+            }
+        }
+    }
+
+    // Runs the main loop for whole frames, and returns the scans it made in the last one
+    int run(int frames, uint16_t scan_us) {
+        int      scans = 0;
+        uint32_t last  = frame + frames - 1;
+        while (frame <= last) {
+            uint32_t scan_frame = frame;
+            if (sof_sync_is_scan_due()) {
+                advance(scan_us);
+                sof_sync_scan_done();
+                scans += scan_frame == last;
+            } else {
+                advance(10);
+            }
+        }
+        return scans;
+    }
+
+    uint16_t next_sof;
+    uint32_t frame         = 0;
+    bool     is_host_awake = true;
+};
+
+TEST_F(SofSync, ScansOncePerFrame) {
+    run(4, 200);
+    sof_sync_reset_stats();
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(run(1, 200), 1);
+    }
+    sof_sync_stats_t stats = sof_sync_get_stats();
+    EXPECT_EQ(stats.late, 0u);
+    EXPECT_GE(stats.scans, 9u);
+    EXPECT_EQ(stats.scan_us, 200);
+}
+
+TEST_F(SofSync, ScanEndsJustBeforeSof) {
+    run(4, 200);
+    sof_sync_reset_stats();
+    run(10, 200);
+    sof_sync_stats_t stats = sof_sync_get_stats();
+    EXPECT_GE(stats.min_slack_us, SOF_SYNC_MARGIN_US);
+    EXPECT_LT(stats.slack_us, SOF_SYNC_MARGIN_US + 20);
+}
+
+TEST_F(SofSync, CountsScansThatMissTheirSof) {
+    run(4, 200);
+    sof_sync_reset_stats();
+    run(3, 400);
+    sof_sync_stats_t stats = sof_sync_get_stats();
+    EXPECT_EQ(stats.late, 1u);
+    EXPECT_EQ(stats.scan_us, 400);
+}
+
+TEST_F(SofSync, FollowsLongerScansStraightAway) {
+    run(4, 200);
+    run(1, 400);
+    sof_sync_reset_stats();
+    run(10, 400);
+    sof_sync_stats_t stats = sof_sync_get_stats();
+    EXPECT_EQ(stats.late, 0u);
+    EXPECT_GE(stats.min_slack_us, SOF_SYNC_MARGIN_US);
+    EXPECT_EQ(stats.scan_us, 400);
+}
+
+TEST_F(SofSync, FollowsShorterScansSlowly) {
+    run(4, 400);
+    run(1, 100);
+    uint16_t estimate = sof_sync_get_stats().scan_us;
+    EXPECT_LT(estimate, 400);
+    EXPECT_GT(estimate, 300);
+
+    run(200, 100);
+    EXPECT_LT(sof_sync_get_stats().scan_us, 120);
+}
+
+TEST_F(SofSync, ScansFreelyWithoutSof) {
+    run(4, 200);
+    is_host_awake = false;
+    advance(3 * SOF_SYNC_FRAME_US);
+    for (int i = 0; i < 5; i++) {
+        EXPECT_TRUE(sof_sync_is_scan_due());
+        advance(200);
+        sof_sync_scan_done();
+    }
+
+    is_host_awake = true;
+    advance(SOF_SYNC_FRAME_US);
+    run(3, 200);
+    EXPECT_EQ(run(1, 200), 1);
+}
+
+TEST_F(SofSync, ResetStatsKeepsScanTime) {
+    run(4, 200);
+    sof_sync_reset_stats();
+    sof_sync_stats_t stats = sof_sync_get_stats();
+    EXPECT_EQ(stats.scans, 0u);
+    EXPECT_EQ(stats.late, 0u);
+    EXPECT_EQ(stats.min_slack_us, UINT16_MAX);
+    EXPECT_EQ(stats.scan_us, 200);
+}
@@ -13,3 +13,28 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
+
+#include "suspend.h"
+#include "power_state.h"
+#include "action.h"
+
+void suspend_idle(uint8_t time) {}
+
+__attribute__((weak)) void suspend_power_down_user(void) {}
+__attribute__((weak)) void suspend_power_down_kb(void) { suspend_power_down_user(); }
+
+void suspend_power_down(void) {
+    power_state_suspend();
+    suspend_power_down_kb();
+}
+
+bool suspend_wakeup_condition(void) { return power_state_scan(); }
+
+__attribute__((weak)) void suspend_wakeup_init_user(void) {}
+__attribute__((weak)) void suspend_wakeup_init_kb(void) { suspend_wakeup_init_user(); }
+
+void suspend_wakeup_init(void) {
+    clear_keyboard();
+    power_state_resume();
+    suspend_wakeup_init_kb();
+}
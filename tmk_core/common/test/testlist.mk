@@ -0,0 +1,13 @@
+TEST_LIST +=\
+	eeprom_stm32\
+	eeprom_cache\
+	eeconfig\
+	eeprom_simulator\
+	report_queue\
+	report_queue_collapse\
+	sof_sync\
+	report_keys\
+	report_keys_6kro\
+	usb_descriptor\
+	usb_descriptor_shared\
+	usb_descriptor_mouse_ep
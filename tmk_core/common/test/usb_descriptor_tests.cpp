@@ -0,0 +1,243 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+extern "C" {
+#include "report.h"
+#include "usb_descriptor.h"
+}
+
+// One descriptor of the configuration descriptor
+struct Descriptor {
+    uint8_t        type;
+    const uint8_t* data;
+};
+
+// Input and output report sizes in bits, by report ID (0 without IDs)
+struct HidReports {
+    std::map<uint8_t, uint16_t> input;
+    std::map<uint8_t, uint16_t> output;
+    bool                        has_ids = false;
+};
+
+class UsbDescriptor : public testing::Test {
+   public:
+    UsbDescriptor() {
+        const void* address;
+        uint16_t    size = get_usb_descriptor(DTYPE_Configuration << 8, 0, &address);
+        config.assign((const uint8_t*)address, (const uint8_t*)address + size);
+        for (uint16_t i = 0; i < size && config[i] >= 2; i += config[i]) {
+            descriptors.push_back({config[i + 1], &config[i]});
+        }
+    }
+
+    std::vector<Descriptor> of_interface(uint8_t number, uint8_t type) {
+        std::vector<Descriptor> found;
+        int                     current = -1;
+        for (auto& descriptor : descriptors) {
+            if (descriptor.type == DTYPE_Interface) {
+                current = descriptor.data[2];
+            } else if (current == number && descriptor.type == type) {
+                found.push_back(descriptor);
+            }
+        }
+        return found;
+    }
+
+    HidReports parse_hid_reports(uint8_t interface) {
+        const void* address;
+        uint16_t    size = get_usb_descriptor(HID_DTYPE_Report << 8, interface, &address);
+        auto        data = (const uint8_t*)address;
+
+        HidReports                  reports;
+        std::map<uint8_t, uint32_t> globals;  // of the current top-level collection
+        uint8_t                     report_id = 0, report_size = 0, depth = 0;
+        uint16_t                    report_count = 0;
+        uint16_t                    i            = 0;
+        while (i < size) {
+            uint8_t  prefix = data[i];
+            uint8_t  length = (prefix & 3) == 3 ? 4 : prefix & 3;
+            uint32_t value  = 0;
+            EXPECT_LE(i + 1 + length, size) << "item at " << i << " runs past the end";
+            for (uint8_t j = 0; j < length; j++) {
+                value |= (uint32_t)data[i + 1 + j] << (8 * j);
+            }
+            // Global items keep their value for the items after them
+            if ((prefix & 0x0C) == 0x04) {
+                auto global = globals.find(prefix & 0xFC);
+                EXPECT_TRUE(global == globals.end() || global->second != value) << "item at " << i << " repeats the value it already has";
+                globals[prefix & 0xFC] = value;
+            }
+            switch (prefix & 0xFC) {
+                case 0x84:  // Report ID
+                    EXPECT_NE(value, 0u);
+                    EXPECT_EQ(reports.input.count(value) + reports.output.count(value), 0u) << "report ID " << value << " is used twice";
+                    report_id       = value;
+                    reports.has_ids = true;
+                    break;
+                case 0x74:  // Report Size
+                    report_size = value;
+                    break;
+                case 0x94:  // Report Count
+                    report_count = value;
+                    break;
+                case 0x80:  // Input
+                    reports.input[report_id] += report_size * report_count;
+                    break;
+                case 0x90:  // Output
+                    reports.output[report_id] += report_size * report_count;
+                    break;
+                case 0xA0:  // Collection
+                    if (depth == 0) {
+                        globals.clear();
+                    }
+                    depth++;
+                    break;
+                case 0xC0:  // End Collection
+                    EXPECT_GT(depth, 0) << "collection ended at " << i << " was never started";
+                    depth--;
+                    break;
+            }
+            i += 1 + length;
+        }
+        EXPECT_EQ(i, size);
+        EXPECT_EQ(depth, 0) << "collections are not all ended";
+        if (reports.has_ids) {
+            EXPECT_EQ(reports.input.count(0) + reports.output.count(0), 0u) << "reports without an ID next to reports with one";
+        }
+        for (auto& report : reports.input) {
+            EXPECT_EQ(report.second % 8, 0) << "input report " << (int)report.first << " isn't whole bytes";
+        }
+        for (auto& report : reports.output) {
+            EXPECT_EQ(report.second % 8, 0) << "output report " << (int)report.first << " isn't whole bytes";
+        }
+        return reports;
+    }
+
+    std::vector<uint8_t>    config;
+    std::vector<Descriptor> descriptors;
+};
+
+TEST_F(UsbDescriptor, ConfigurationAddsUp) {
+    ASSERT_GT(config.size(), 9u);
+    EXPECT_EQ(config[2] | config[3] << 8, config.size());
+
+    uint16_t total = 0;
+    uint8_t  interfaces = 0;
+    for (auto& descriptor : descriptors) {
+        total += descriptor.data[0];
+        interfaces += descriptor.type == DTYPE_Interface && descriptor.data[3] == 0;
+    }
+    EXPECT_EQ(total, config.size());
+    EXPECT_EQ(config[4], interfaces);
+    EXPECT_EQ(interfaces, TOTAL_INTERFACES);
+}
+
+TEST_F(UsbDescriptor, InterfacesAreNumberedInOrder) {
+    uint8_t next = 0;
+    for (auto& descriptor : descriptors) {
+        if (descriptor.type == DTYPE_Interface) {
+            EXPECT_EQ(descriptor.data[2], next);
+            EXPECT_EQ(of_interface(next, DTYPE_Endpoint).size(), descriptor.data[4]) << "interface " << (int)next;
+            next++;
+        }
+    }
+}
+
+TEST_F(UsbDescriptor, EndpointsFitTheBudget) {
+    std::set<uint8_t>           addresses;
+    std::map<uint8_t, uint16_t> buffers;
+    for (auto& descriptor : descriptors) {
+        if (descriptor.type == DTYPE_Endpoint) {
+            uint8_t address = descriptor.data[2];
+            EXPECT_TRUE(addresses.insert(address).second) << "endpoint " << (int)address << " is used twice";
+            EXPECT_GE(address & 0x0F, 1);
+            EXPECT_LE(address & 0x0F, MAX_ENDPOINTS);
+            // Without ChibiOS, the console OUT endpoint has the number of the
+            // IN one, and isn't configured
+            uint16_t& buffer = buffers[address & 0x0F];
+            buffer           = std::max<uint16_t>(buffer, descriptor.data[4] | descriptor.data[5] << 8);
+        }
+    }
+    EXPECT_LE(buffers.size(), (size_t)MAX_ENDPOINTS);
+
+    uint16_t memory = 0;
+    for (auto& buffer : buffers) {
+        memory += buffer.second;
+    }
+    // the buffers checked at compile time are those of the descriptors
+    EXPECT_EQ(memory, sizeof(usb_endpoint_buffers_t));
+    EXPECT_LE(FIXED_CONTROL_ENDPOINT_SIZE + memory, USB_ENDPOINT_MEMORY);
+}
+
+TEST_F(UsbDescriptor, HidReportsFitTheirEndpoints) {
+    for (auto& interface : descriptors) {
+        if (interface.type != DTYPE_Interface || interface.data[5] != HID_CSCP_HIDClass) {
+            continue;
+        }
+        uint8_t number = interface.data[2];
+        auto    hid    = of_interface(number, HID_DTYPE_HID);
+        ASSERT_EQ(hid.size(), 1u) << "interface " << (int)number;
+
+        const void* address;
+        EXPECT_EQ(hid[0].data[7] | hid[0].data[8] << 8, get_usb_descriptor(HID_DTYPE_Report << 8, number, &address));
+
+        HidReports reports = parse_hid_reports(number);
+        for (auto& endpoint : of_interface(number, DTYPE_Endpoint)) {
+            uint16_t packet_size = endpoint.data[4] | endpoint.data[5] << 8;
+            auto&    sizes       = (endpoint.data[2] & ENDPOINT_DIR_IN) ? reports.input : reports.output;
+            for (auto& report : sizes) {
+                EXPECT_LE(report.second / 8 + reports.has_ids, packet_size) << "report " << (int)report.first << " of interface " << (int)number;
+            }
+        }
+    }
+}
+
+TEST_F(UsbDescriptor, ReportsMatchTheirStructs) {
+#ifndef KEYBOARD_SHARED_EP
+    EXPECT_EQ(parse_hid_reports(KEYBOARD_INTERFACE).input[0], KEYBOARD_REPORT_SIZE * 8);
+#endif
+#if defined(MOUSE_ENABLE) && !defined(MOUSE_SHARED_EP)
+    EXPECT_EQ(parse_hid_reports(MOUSE_INTERFACE).input[0], sizeof(report_mouse_t) * 8);
+#endif
+#ifdef SHARED_EP_ENABLE
+    HidReports shared = parse_hid_reports(SHARED_INTERFACE);
+    std::map<uint8_t, uint16_t> expected;
+#    ifdef KEYBOARD_SHARED_EP
+    expected[REPORT_ID_KEYBOARD] = KEYBOARD_REPORT_SIZE - 1;
+#    endif
+#    ifdef MOUSE_SHARED_EP
+    expected[REPORT_ID_MOUSE] = sizeof(report_mouse_t) - 1;
+#    endif
+#    ifdef EXTRAKEY_ENABLE
+    expected[REPORT_ID_SYSTEM]   = sizeof(report_extra_t) - 1;
+    expected[REPORT_ID_CONSUMER] = sizeof(report_extra_t) - 1;
+#    endif
+#    ifdef NKRO_ENABLE
+    expected[REPORT_ID_NKRO] = sizeof(report_keyboard_t::nkro) - 1;
+#    endif
+    ASSERT_EQ(shared.input.size(), expected.size());
+    for (auto& report : expected) {
+        EXPECT_EQ(shared.input[report.first], report.second * 8) << "report " << (int)report.first;
+    }
+#endif
+}
@@ -55,6 +55,7 @@
 #endif
 #include "suspend.h"
 #include "wait.h"
+#include "sof_sync.h"
 
 /* -------------------------
  *   TMK host driver defs
@@ -67,9 +68,10 @@ void    send_keyboard(report_keyboard_t *report);
 void    send_mouse(report_mouse_t *report);
 void    send_system(uint16_t data);
 void    send_consumer(uint16_t data);
+bool    mouse_ready(void);
 
 /* host struct */
-host_driver_t chibios_driver = {keyboard_leds, send_keyboard, send_mouse, send_system, send_consumer};
+host_driver_t chibios_driver = {keyboard_leds, send_keyboard, send_mouse, send_system, send_consumer, mouse_ready};
 
 #ifdef VIRTSER_ENABLE
 void virtser_task(void);
@@ -157,6 +159,9 @@ int main(void) {
 
     /* Init USB */
     init_usb_driver(&USB_DRIVER);
+#ifdef USB_SOF_SYNC
+    sof_sync_init();
+#endif
 
     /* init printf */
     init_printf(NULL, sendchar_pf);
@@ -247,7 +252,14 @@ int main(void) {
         }
 #endif
 
+#ifdef USB_SOF_SYNC
+        if (sof_sync_is_scan_due()) {
+            keyboard_task();
+            sof_sync_scan_done();
+        }
+#else
         keyboard_task();
+#endif
 #ifdef CONSOLE_ENABLE
         console_task();
 #endif
@@ -40,6 +40,8 @@
 #include "wait.h"
 #include "usb_descriptor.h"
 #include "usb_driver.h"
+#include "report_queue.h"
+#include "sof_sync.h"
 
 #ifdef NKRO_ENABLE
 #    include "keycode_config.h"
@@ -68,6 +70,11 @@ static virtual_timer_t keyboard_idle_timer;
 static void            keyboard_idle_timer_cb(void *arg);
 
 report_keyboard_t keyboard_report_sent = {{0}};
+#ifdef KEYBOARD_REPORT_QUEUE_SIZE
+/* reports waiting for the keyboard endpoint, sent from the IN and SOF callbacks */
+static keyboard_report_queue_t keyboard_report_queue;
+static bool                    keyboard_report_queue_nkro = false; /* the queued reports are all NKRO or all not */
+#endif
 #ifdef MOUSE_ENABLE
 report_mouse_t mouse_report_blank = {0};
 #endif /* MOUSE_ENABLE */
@@ -329,6 +336,11 @@ static void usb_event_cb(USBDriver *usbp, usbevent_t event) {
         case USB_EVENT_UNCONFIGURED:
             /* Falls into.*/
         case USB_EVENT_RESET:
+#ifdef KEYBOARD_REPORT_QUEUE_SIZE
+            osalSysLockFromISR();
+            keyboard_report_queue_clear(&keyboard_report_queue);
+            osalSysUnlockFromISR();
+#endif
             for (int i = 0; i < NUM_USB_DRIVERS; i++) {
                 chSysLockFromISR();
                 /* Disconnection event on suspend.*/
@@ -563,19 +575,79 @@ void init_usb_driver(USBDriver *usbp) {
  *                  Keyboard functions
  * ---------------------------------------------------------
  */
+/* the endpoint keyboard reports are sent on, the shared one for NKRO reports */
+static usbep_t keyboard_report_ep(bool nkro) {
+#ifdef NKRO_ENABLE
+    if (nkro) {
+        return SHARED_IN_EPNUM;
+    }
+#endif
+    return KEYBOARD_IN_EPNUM;
+}
+
+/* start sending keyboard_report_sent
+ * callable from ISR, in locked state, with the endpoint idle */
+static void start_keyboard_report_i(USBDriver *usbp, bool nkro) {
+#ifdef NKRO_ENABLE
+    if (nkro) { /* NKRO protocol */
+        usbStartTransmitI(usbp, SHARED_IN_EPNUM, (uint8_t *)&keyboard_report_sent, sizeof(struct nkro_report));
+        return;
+    }
+#endif
+    if (keyboard_protocol) {
+        usbStartTransmitI(usbp, KEYBOARD_IN_EPNUM, (uint8_t *)&keyboard_report_sent, KEYBOARD_REPORT_SIZE);
+    } else { /* boot protocol */
+        usbStartTransmitI(usbp, KEYBOARD_IN_EPNUM, &keyboard_report_sent.mods, 8);
+    }
+}
+
+#ifdef KEYBOARD_REPORT_QUEUE_SIZE
+/* send the oldest queued report, if the keyboard endpoint is free
+ * callable from ISR, in locked state */
+static void send_queued_keyboard_report_i(USBDriver *usbp) {
+    if (usbGetDriverStateI(usbp) != USB_ACTIVE || usbGetTransmitStatusI(usbp, keyboard_report_ep(keyboard_report_queue_nkro))) {
+        return;
+    }
+    if (keyboard_report_queue_pop(&keyboard_report_queue, &keyboard_report_sent)) {
+        start_keyboard_report_i(usbp, keyboard_report_queue_nkro);
+    }
+}
+#endif
+
 /* keyboard IN callback hander (a kbd report has made it IN) */
 #ifndef KEYBOARD_SHARED_EP
 void kbd_in_cb(USBDriver *usbp, usbep_t ep) {
-    /* STUB */
-    (void)usbp;
     (void)ep;
+#    ifdef KEYBOARD_REPORT_QUEUE_SIZE
+    osalSysLockFromISR();
+    send_queued_keyboard_report_i(usbp);
+    osalSysUnlockFromISR();
+#    else
+    (void)usbp;
+#    endif
 }
 #endif
 
 /* start-of-frame handler
- * TODO: i guess it would be better to re-implement using timers,
- *  so that this is not going to have to be checked every 1ms */
-void kbd_sof_cb(USBDriver *usbp) { (void)usbp; }
+ * sends queued reports the IN callbacks couldn't, as when the shared endpoint
+ * was busy with another report, and times the next scan from the frame */
+void kbd_sof_cb(USBDriver *usbp) {
+#ifdef USB_SOF_SYNC
+    sof_sync_frame();
+#endif
+#ifdef KEYBOARD_REPORT_QUEUE_SIZE
+    osalSysLockFromISR();
+    send_queued_keyboard_report_i(usbp);
+    osalSysUnlockFromISR();
+#else
+    (void)usbp;
+#endif
+}
+
+#ifdef USB_SOF_SYNC
+/* microseconds for sof_sync, in steps of the system tick */
+uint16_t sof_sync_read_us(void) { return (uint16_t)TIME_I2US(chVTGetSystemTimeX()); }
+#endif
 
 /* Idle requests timer code
  * callback (called from ISR, unlocked state) */
@@ -620,59 +692,81 @@ void send_keyboard(report_keyboard_t *report) {
         goto unlock;
     }
 
-#ifdef NKRO_ENABLE
-    if (keymap_config.nkro && keyboard_protocol) { /* NKRO protocol */
-        /* need to wait until the previous packet has made it through */
-        /* can rewrite this using the synchronous API, then would wait
-         * until *after* the packet has been transmitted. I think
-         * this is more efficient */
-        /* busy wait, should be short and not very common */
-        if (usbGetTransmitStatusI(&USB_DRIVER, SHARED_IN_EPNUM)) {
-            /* Need to either suspend, or loop and call unlock/lock during
-             * every iteration - otherwise the system will remain locked,
-             * no interrupts served, so USB not going through as well.
-             * Note: for suspend, need USB_USE_WAIT == TRUE in halconf.h */
-            osalThreadSuspendS(&(&USB_DRIVER)->epc[SHARED_IN_EPNUM]->in_state->thread);
-
-            /* after osalThreadSuspendS returns USB status might have changed */
-            if (usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
-                goto unlock;
-            }
+    bool    nkro = host_keyboard_nkro();
+    usbep_t ep   = keyboard_report_ep(nkro);
+#ifdef KEYBOARD_REPORT_QUEUE_SIZE
+    /* queued reports go first, the endpoint is only idle once they're sent */
+    send_queued_keyboard_report_i(&USB_DRIVER);
+    /* and the queue only holds reports for one endpoint */
+    while (!keyboard_report_queue_is_empty(&keyboard_report_queue) && keyboard_report_queue_nkro != nkro) {
+        osalThreadSuspendS(&(&USB_DRIVER)->epc[keyboard_report_ep(keyboard_report_queue_nkro)]->in_state->thread);
+
+        if (usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
+            goto unlock;
         }
-        usbStartTransmitI(&USB_DRIVER, SHARED_IN_EPNUM, (uint8_t *)report, sizeof(struct nkro_report));
-    } else
-#endif /* NKRO_ENABLE */
-    {  /* regular protocol */
-        /* need to wait until the previous packet has made it through */
-        /* busy wait, should be short and not very common */
-        if (usbGetTransmitStatusI(&USB_DRIVER, KEYBOARD_IN_EPNUM)) {
-            /* Need to either suspend, or loop and call unlock/lock during
-             * every iteration - otherwise the system will remain locked,
-             * no interrupts served, so USB not going through as well.
-             * Note: for suspend, need USB_USE_WAIT == TRUE in halconf.h */
-            osalThreadSuspendS(&(&USB_DRIVER)->epc[KEYBOARD_IN_EPNUM]->in_state->thread);
+    }
+    if (usbGetTransmitStatusI(&USB_DRIVER, ep)) {
+        /* the IN callback sends it when the reports before it are through,
+         * only wait if there's no room for it */
+        keyboard_report_queue_nkro = nkro;
+        while (!keyboard_report_queue_push(&keyboard_report_queue, report)) {
+            osalThreadSuspendS(&(&USB_DRIVER)->epc[ep]->in_state->thread);
 
             /* after osalThreadSuspendS returns USB status might have changed */
             if (usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
                 goto unlock;
             }
         }
-        uint8_t *data, size;
-        if (keyboard_protocol) {
-            data = (uint8_t *)report;
-            size = KEYBOARD_REPORT_SIZE;
-        } else { /* boot protocol */
-            data = &report->mods;
-            size = 8;
+        goto unlock;
+    }
+#else
+    /* need to wait until the previous packet has made it through */
+    /* busy wait, should be short and not very common */
+    if (usbGetTransmitStatusI(&USB_DRIVER, ep)) {
+        /* Need to either suspend, or loop and call unlock/lock during
+         * every iteration - otherwise the system will remain locked,
+         * no interrupts served, so USB not going through as well.
+         * Note: for suspend, need USB_USE_WAIT == TRUE in halconf.h */
+        osalThreadSuspendS(&(&USB_DRIVER)->epc[ep]->in_state->thread);
+
+        /* after osalThreadSuspendS returns USB status might have changed */
+        if (usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
+            goto unlock;
         }
-        usbStartTransmitI(&USB_DRIVER, KEYBOARD_IN_EPNUM, data, size);
     }
+#endif
+    /* sent from keyboard_report_sent, the report may change before the
+     * transfer is through */
     keyboard_report_sent = *report;
+    start_keyboard_report_i(&USB_DRIVER, nkro);
 
 unlock:
     osalSysUnlock();
 }
 
+#if defined(MOUSE_ENABLE) || defined(EXTRAKEY_ENABLE)
+/* wait up to 10ms until an IN endpoint is free to start a report on, false if
+ * it isn't or USB went away meanwhile
+ * the IN and SOF callbacks start queued keyboard reports on the shared
+ * endpoint, and may take it again before the waiting thread runs */
+static bool wait_for_in_endpoint_s(usbep_t ep) {
+    while (usbGetTransmitStatusI(&USB_DRIVER, ep)) {
+        /* Need to either suspend, or loop and call unlock/lock during
+         * every iteration - otherwise the system will remain locked,
+         * no interrupts served, so USB not going through as well.
+         * Note: for suspend, need USB_USE_WAIT == TRUE in halconf.h */
+        if (osalThreadSuspendTimeoutS(&(&USB_DRIVER)->epc[ep]->in_state->thread, TIME_MS2I(10)) == MSG_TIMEOUT) {
+            return false;
+        }
+        /* after osalThreadSuspendTimeoutS returns USB status might have changed */
+        if (usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
 /* ---------------------------------------------------------
  *                     Mouse functions
  * ---------------------------------------------------------
@@ -695,22 +789,27 @@ void send_mouse(report_mouse_t *report) {
         return;
     }
 
-    if (usbGetTransmitStatusI(&USB_DRIVER, MOUSE_IN_EPNUM)) {
-        /* Need to either suspend, or loop and call unlock/lock during
-         * every iteration - otherwise the system will remain locked,
-         * no interrupts served, so USB not going through as well.
-         * Note: for suspend, need USB_USE_WAIT == TRUE in halconf.h */
-        if (osalThreadSuspendTimeoutS(&(&USB_DRIVER)->epc[MOUSE_IN_EPNUM]->in_state->thread, TIME_MS2I(10)) == MSG_TIMEOUT) {
-            osalSysUnlock();
-            return;
-        }
+    if (!wait_for_in_endpoint_s(MOUSE_IN_EPNUM)) {
+        osalSysUnlock();
+        return;
     }
     usbStartTransmitI(&USB_DRIVER, MOUSE_IN_EPNUM, (uint8_t *)report, sizeof(report_mouse_t));
     osalSysUnlock();
 }
 
+/* whether send_mouse would start sending a report now rather than wait */
+bool mouse_ready(void) {
+    bool ready;
+    osalSysLock();
+    /* reports are dropped anyway while USB isn't active */
+    ready = usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE || !usbGetTransmitStatusI(&USB_DRIVER, MOUSE_IN_EPNUM);
+    osalSysUnlock();
+    return ready;
+}
+
 #else  /* MOUSE_ENABLE */
 void send_mouse(report_mouse_t *report) { (void)report; }
+bool mouse_ready(void) { return true; }
 #endif /* MOUSE_ENABLE */
 
 /* ---------------------------------------------------------
@@ -720,9 +819,14 @@ void send_mouse(report_mouse_t *report) { (void)report; }
 #ifdef SHARED_EP_ENABLE
 /* shared IN callback hander */
 void shared_in_cb(USBDriver *usbp, usbep_t ep) {
-    /* STUB */
-    (void)usbp;
     (void)ep;
+#    ifdef KEYBOARD_REPORT_QUEUE_SIZE
+    osalSysLockFromISR();
+    send_queued_keyboard_report_i(usbp);
+    osalSysUnlockFromISR();
+#    else
+    (void)usbp;
+#    endif
 }
 #endif
 
@@ -739,7 +843,16 @@ static void send_extra(uint8_t report_id, uint16_t data) {
         return;
     }
 
-    report_extra_t report = {.report_id = report_id, .usage = data};
+    /* a queued keyboard report may be on its way on the same endpoint */
+    if (!wait_for_in_endpoint_s(SHARED_IN_EPNUM)) {
+        osalSysUnlock();
+        return;
+    }
+
+    /* the transfer outlives the call, so the report can't be on the stack */
+    static report_extra_t report;
+    report.report_id = report_id;
+    report.usage     = data;
 
     usbStartTransmitI(&USB_DRIVER, SHARED_IN_EPNUM, (uint8_t *)&report, sizeof(report_extra_t));
     osalSysUnlock();
@@ -54,6 +54,8 @@
 #include "quantum.h"
 #include <util/atomic.h>
 #include "outputselect.h"
+#include "report_queue.h"
+#include "sof_sync.h"
 
 #ifdef NKRO_ENABLE
 #    include "keycode_config.h"
@@ -92,14 +94,22 @@ static uint8_t keyboard_led_stats = 0;
 
 static report_keyboard_t keyboard_report_sent;
 
+#ifdef KEYBOARD_REPORT_QUEUE_SIZE
+/* Reports waiting for the keyboard endpoint, sent from the SOF interrupt */
+static keyboard_report_queue_t keyboard_report_queue;
+static bool                    keyboard_report_queue_nkro = false; /* the queued reports are all NKRO or all not */
+static void                    send_queued_keyboard_report(void);
+#endif
+
 /* Host driver */
 static uint8_t keyboard_leds(void);
 static void    send_keyboard(report_keyboard_t *report);
 static void    send_mouse(report_mouse_t *report);
 static void    send_system(uint16_t data);
 static void    send_consumer(uint16_t data);
+static bool    mouse_ready(void);
 host_driver_t  lufa_driver = {
-    keyboard_leds, send_keyboard, send_mouse, send_system, send_consumer,
+    keyboard_leds, send_keyboard, send_mouse, send_system, send_consumer, mouse_ready,
 };
 
 #ifdef VIRTSER_ENABLE
@@ -308,7 +318,12 @@ void EVENT_USB_Device_Disconnect(void) {
  *
  * FIXME: Needs doc
  */
-void EVENT_USB_Device_Reset(void) { print("[R]"); }
+void EVENT_USB_Device_Reset(void) {
+    print("[R]");
+#ifdef KEYBOARD_REPORT_QUEUE_SIZE
+    keyboard_report_queue_clear(&keyboard_report_queue);
+#endif
+}
 
 /** \brief Event USB Device Connect
  *
@@ -316,6 +331,9 @@ void EVENT_USB_Device_Reset(void) { print("[R]"); }
  */
 void EVENT_USB_Device_Suspend() {
     print("[S]");
+#ifdef KEYBOARD_REPORT_QUEUE_SIZE
+    keyboard_report_queue_clear(&keyboard_report_queue);
+#endif
 #ifdef SLEEP_LED_ENABLE
     sleep_led_enable();
 #endif
@@ -342,13 +360,45 @@ static bool console_flush = false;
         do {                                                         \
             ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { console_flush = b; } \
         } while (0)
+#endif
 
+#ifdef USB_SOF_SYNC
+/** \brief Microseconds for sof_sync
+ *
+ * The milliseconds of the timer, plus how far timer 0 is into the next one.
+ */
+uint16_t sof_sync_read_us(void) {
+    uint16_t ms;
+    uint8_t  raw;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ms  = timer_count;
+        raw = TIMER_RAW;
+        // the timer has wrapped, but its interrupt hasn't counted it yet
+        if (TIFR0 & _BV(OCF0A)) {
+            ms++;
+            raw = TIMER_RAW;
+        }
+    }
+    return ms * 1000u + (uint32_t)raw * 1000 / (TIMER_RAW_TOP + 1);
+}
+#endif
+
+#if defined(CONSOLE_ENABLE) || defined(KEYBOARD_REPORT_QUEUE_SIZE) || defined(USB_SOF_SYNC)
 /** \brief Event USB Device Start Of Frame
  *
  * FIXME: Needs doc
  * called every 1ms
  */
 void EVENT_USB_Device_StartOfFrame(void) {
+#    ifdef USB_SOF_SYNC
+    sof_sync_frame();
+#    endif
+
+#    ifdef KEYBOARD_REPORT_QUEUE_SIZE
+    send_queued_keyboard_report();
+#    endif
+
+#    ifdef CONSOLE_ENABLE
     static uint8_t count;
     if (++count % 50) return;
     count = 0;
@@ -356,6 +406,7 @@ void EVENT_USB_Device_StartOfFrame(void) {
     if (!console_flush) return;
     Console_Task();
     console_flush = false;
+#    endif
 }
 
 #endif
@@ -547,13 +598,106 @@ void EVENT_USB_Device_ControlRequest(void) {
  */
 static uint8_t keyboard_leds(void) { return keyboard_led_stats; }
 
+#if defined(MOUSE_ENABLE) || defined(EXTRAKEY_ENABLE)
+/** \brief Send Report
+ *
+ * Writes a report to an IN endpoint once the host has taken the last one,
+ * waiting for a polling interval around 10ms. The SOF interrupt writes queued
+ * keyboard reports to the shared endpoint, so it's kept out from selecting the
+ * endpoint until the report is finalized.
+ */
+static void send_report(uint8_t endpoint, void *report, uint8_t size) {
+    uint8_t timeout = 255;
+
+    do {
+        bool done = false;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            Endpoint_SelectEndpoint(endpoint);
+            if (Endpoint_IsReadWriteAllowed()) {
+                Endpoint_Write_Stream_LE(report, size, NULL);
+                /* Finalize the stream transfer to send the last packet */
+                Endpoint_ClearIN();
+                done = true;
+            }
+        }
+        if (done) return;
+        _delay_us(40);
+    } while (timeout--);
+}
+#endif
+
+/** \brief Select Keyboard Endpoint
+ *
+ * Selects the endpoint keyboard reports are sent on, which is the shared one for NKRO reports
+ */
+static void select_keyboard_endpoint(bool nkro) {
+#ifdef NKRO_ENABLE
+    if (nkro) {
+        Endpoint_SelectEndpoint(SHARED_IN_EPNUM);
+        return;
+    }
+#endif
+    Endpoint_SelectEndpoint(KEYBOARD_IN_EPNUM);
+}
+
+/** \brief Write Keyboard Report
+ *
+ * Writes a report to the keyboard endpoint, which has to be selected and ready
+ */
+static void write_keyboard_report(report_keyboard_t *report, bool nkro) {
+    uint8_t size = KEYBOARD_REPORT_SIZE;
+#ifdef NKRO_ENABLE
+    if (nkro) {
+        size = sizeof(struct nkro_report);
+    }
+#endif
+
+    /* If we're in Boot Protocol, don't send any report ID or other funky fields */
+    if (!keyboard_protocol) {
+        Endpoint_Write_Stream_LE(&report->mods, 8, NULL);
+    } else {
+        Endpoint_Write_Stream_LE(report, size, NULL);
+    }
+
+    /* Finalize the stream transfer to send the last packet */
+    Endpoint_ClearIN();
+
+    keyboard_report_sent = *report;
+}
+
+#ifdef KEYBOARD_REPORT_QUEUE_SIZE
+/** \brief Send Queued Keyboard Report
+ *
+ * Sends the oldest queued report, if the host has taken the one before it.
+ * Called from the SOF interrupt, so the endpoint the main loop has selected is
+ * restored.
+ */
+static void send_queued_keyboard_report(void) {
+    if (USB_DeviceState != DEVICE_STATE_Configured || keyboard_report_queue_is_empty(&keyboard_report_queue)) {
+        return;
+    }
+
+    uint8_t previous_endpoint = Endpoint_GetCurrentEndpoint();
+    select_keyboard_endpoint(keyboard_report_queue_nkro);
+    if (Endpoint_IsReadWriteAllowed()) {
+        report_keyboard_t report;
+        keyboard_report_queue_pop(&keyboard_report_queue, &report);
+        write_keyboard_report(&report, keyboard_report_queue_nkro);
+    }
+    Endpoint_SelectEndpoint(previous_endpoint);
+}
+#endif
+
 /** \brief Send Keyboard
  *
- * FIXME: Needs doc
+ * Sends the report straight away if the host has taken the last one. With
+ * KEYBOARD_REPORT_QUEUE_SIZE, it's otherwise queued for the SOF interrupt, and
+ * only waited for when the queue is full.
  */
 static void send_keyboard(report_keyboard_t *report) {
     uint8_t timeout = 255;
     uint8_t where   = where_to_send();
+    bool    nkro    = host_keyboard_nkro();
 
 #ifdef BLUETOOTH_ENABLE
     if (where == OUTPUT_BLUETOOTH || where == OUTPUT_USB_AND_BT) {
@@ -583,31 +727,37 @@ static void send_keyboard(report_keyboard_t *report) {
         return;
     }
 
+#ifdef KEYBOARD_REPORT_QUEUE_SIZE
+    /* Keep the SOF interrupt out while deciding, the reports have to go in order */
+    do {
+        bool done = false;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            if (keyboard_report_queue_is_empty(&keyboard_report_queue)) {
+                keyboard_report_queue_nkro = nkro;
+                select_keyboard_endpoint(nkro);
+                if (Endpoint_IsReadWriteAllowed()) {
+                    write_keyboard_report(report, nkro);
+                    done = true;
+                }
+            }
+            /* reports for the other endpoint wait until the queue is empty */
+            if (!done && keyboard_report_queue_nkro == nkro) {
+                done = keyboard_report_queue_push(&keyboard_report_queue, report);
+            }
+        }
+        if (done) return;
+        /* The queue is full, wait for the SOF interrupt to make room */
+        _delay_us(40);
+    } while (timeout--);
+#else
     /* Select the Keyboard Report Endpoint */
-    uint8_t ep   = KEYBOARD_IN_EPNUM;
-    uint8_t size = KEYBOARD_REPORT_SIZE;
-#ifdef NKRO_ENABLE
-    if (keyboard_protocol && keymap_config.nkro) {
-        ep   = SHARED_IN_EPNUM;
-        size = sizeof(struct nkro_report);
-    }
-#endif
-    Endpoint_SelectEndpoint(ep);
+    select_keyboard_endpoint(nkro);
     /* Check if write ready for a polling interval around 10ms */
     while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
     if (!Endpoint_IsReadWriteAllowed()) return;
 
-    /* If we're in Boot Protocol, don't send any report ID or other funky fields */
-    if (!keyboard_protocol) {
-        Endpoint_Write_Stream_LE(&report->mods, 8, NULL);
-    } else {
-        Endpoint_Write_Stream_LE(report, size, NULL);
-    }
-
-    /* Finalize the stream transfer to send the last packet */
-    Endpoint_ClearIN();
-
-    keyboard_report_sent = *report;
+    write_keyboard_report(report, nkro);
+#endif
 }
 
 /** \brief Send Mouse
@@ -616,8 +766,7 @@ static void send_keyboard(report_keyboard_t *report) {
  */
 static void send_mouse(report_mouse_t *report) {
 #ifdef MOUSE_ENABLE
-    uint8_t timeout = 255;
-    uint8_t where   = where_to_send();
+    uint8_t where = where_to_send();
 
 #    ifdef BLUETOOTH_ENABLE
     if (where == OUTPUT_BLUETOOTH || where == OUTPUT_USB_AND_BT) {
@@ -642,18 +791,27 @@ static void send_mouse(report_mouse_t *report) {
         return;
     }
 
-    /* Select the Mouse Report Endpoint */
-    Endpoint_SelectEndpoint(MOUSE_IN_EPNUM);
+    send_report(MOUSE_IN_EPNUM, report, sizeof(report_mouse_t));
+#endif
+}
 
-    /* Check if write ready for a polling interval around 10ms */
-    while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-    if (!Endpoint_IsReadWriteAllowed()) return;
+/** \brief Mouse Ready
+ *
+ * Whether send_mouse would write a report to USB now rather than drop it,
+ * so that merged mouse motion is only taken once it can be sent.
+ */
+static bool mouse_ready(void) {
+#ifdef MOUSE_ENABLE
+    uint8_t where = where_to_send();
 
-    /* Write Mouse Report Data */
-    Endpoint_Write_Stream_LE(report, sizeof(report_mouse_t), NULL);
+    /* Reports that would not go to USB are not held back */
+    if (where != OUTPUT_USB && where != OUTPUT_USB_AND_BT) return true;
+    if (USB_DeviceState != DEVICE_STATE_Configured) return true;
 
-    /* Finalize the stream transfer to send the last packet */
-    Endpoint_ClearIN();
+    Endpoint_SelectEndpoint(MOUSE_IN_EPNUM);
+    return Endpoint_IsReadWriteAllowed();
+#else
+    return true;
 #endif
 }
 
@@ -663,19 +821,10 @@ static void send_mouse(report_mouse_t *report) {
  */
 #ifdef EXTRAKEY_ENABLE
 static void send_extra(uint8_t report_id, uint16_t data) {
-    uint8_t timeout = 255;
-
     if (USB_DeviceState != DEVICE_STATE_Configured) return;
 
     report_extra_t r = {.report_id = report_id, .usage = data};
-    Endpoint_SelectEndpoint(SHARED_IN_EPNUM);
-
-    /* Check if write ready for a polling interval around 10ms */
-    while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-    if (!Endpoint_IsReadWriteAllowed()) return;
-
-    Endpoint_Write_Stream_LE(&r, sizeof(report_extra_t), NULL);
-    Endpoint_ClearIN();
+    send_report(SHARED_IN_EPNUM, &r, sizeof(report_extra_t));
 }
 #endif
 
@@ -968,6 +1117,9 @@ int main(void) {
     /* init modules */
     keyboard_init();
     host_set_driver(&lufa_driver);
+#ifdef USB_SOF_SYNC
+    sof_sync_init();
+#endif
 #ifdef SLEEP_LED_ENABLE
     sleep_led_init();
 #endif
@@ -988,7 +1140,14 @@ int main(void) {
         }
 #endif
 
+#ifdef USB_SOF_SYNC
+        if (sof_sync_is_scan_due()) {
+            keyboard_task();
+            sof_sync_scan_done();
+        }
+#else
         keyboard_task();
+#endif
 
 #ifdef MIDI_ENABLE
         MIDI_Device_USBTask(&USB_MIDI_Interface);
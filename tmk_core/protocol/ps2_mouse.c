@@ -16,11 +16,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <stdbool.h>
-#include <avr/io.h>
-#include <util/delay.h>
 #include "ps2_mouse.h"
 #include "host.h"
 #include "timer.h"
+#include "wait.h"
 #include "print.h"
 #include "report.h"
 #include "debug.h"
@@ -42,7 +41,7 @@ static inline void ps2_mouse_scroll_button_task(report_mouse_t *mouse_report);
 void ps2_mouse_init(void) {
     ps2_host_init();
 
-    _delay_ms(PS2_MOUSE_INIT_DELAY);  // wait for powering up
+    wait_ms(PS2_MOUSE_INIT_DELAY);  // wait for powering up
 
     PS2_MOUSE_SEND(PS2_MOUSE_RESET, "ps2_mouse_init: sending reset");
 
@@ -102,7 +101,7 @@ void ps2_mouse_task(void) {
         // Used to debug the bytes sent to the host
         ps2_mouse_print_report(&mouse_report);
 #endif
-        host_mouse_send(&mouse_report);
+        host_mouse_send_from(MOUSE_SOURCE_PS2, &mouse_report);
     }
 
     ps2_mouse_clear_report(&mouse_report);
@@ -205,10 +204,9 @@ static inline void ps2_mouse_enable_scrolling(void) {
     PS2_MOUSE_SEND(PS2_MOUSE_SET_SAMPLE_RATE, "Set sample rate");
     PS2_MOUSE_SEND(80, "80");
     PS2_MOUSE_SEND(PS2_MOUSE_GET_DEVICE_ID, "Finished enabling scroll wheel");
-    _delay_ms(20);
+    wait_ms(20);
 }
 
-#define PRESS_SCROLL_BUTTONS mouse_report->buttons |= (PS2_MOUSE_SCROLL_BTN_MASK)
 #define RELEASE_SCROLL_BUTTONS mouse_report->buttons &= ~(PS2_MOUSE_SCROLL_BTN_MASK)
 static inline void ps2_mouse_scroll_button_task(report_mouse_t *mouse_report) {
     static enum {
@@ -245,10 +243,12 @@ static inline void ps2_mouse_scroll_button_task(report_mouse_t *mouse_report) {
 
 #if PS2_MOUSE_SCROLL_BTN_SEND
         if (scroll_state == SCROLL_BTN && timer_elapsed(scroll_button_time) < PS2_MOUSE_SCROLL_BTN_SEND) {
-            PRESS_SCROLL_BUTTONS;
-            host_mouse_send(mouse_report);
-            _delay_ms(100);
-            RELEASE_SCROLL_BUTTONS;
+            // The release goes out with the report of this packet, through the
+            // same source, so that merging mouse reports can't lose it
+            report_mouse_t click = {.buttons = mouse_report->buttons | (PS2_MOUSE_SCROLL_BTN_MASK)};
+            host_mouse_send_from(MOUSE_SOURCE_PS2, &click);
+            host_mouse_flush();
+            wait_ms(100);
         }
 #endif
         scroll_state = SCROLL_NONE;
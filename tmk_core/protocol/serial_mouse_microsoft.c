@@ -66,7 +66,7 @@ void serial_mouse_task(void) {
         report.x = report.y = 0;
 
         print_usb_data(&report);
-        host_mouse_send(&report);
+        host_mouse_send_from(MOUSE_SOURCE_SERIAL, &report);
         return;
     }
 
@@ -103,7 +103,7 @@ void serial_mouse_task(void) {
 #endif
 
     print_usb_data(&report);
-    host_mouse_send(&report);
+    host_mouse_send_from(MOUSE_SOURCE_SERIAL, &report);
 }
 
 static void print_usb_data(const report_mouse_t *report) {
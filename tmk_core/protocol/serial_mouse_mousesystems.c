@@ -72,14 +72,14 @@ void serial_mouse_task(void) {
         report.v = MAX((int8_t)buffer[2], -127);
 
         print_usb_data(&report);
-        host_mouse_send(&report);
+        host_mouse_send_from(MOUSE_SOURCE_SERIAL, &report);
 
         if (buffer[3] || buffer[4]) {
             report.h = MAX((int8_t)buffer[3], -127);
             report.v = MAX((int8_t)buffer[4], -127);
 
             print_usb_data(&report);
-            host_mouse_send(&report);
+            host_mouse_send_from(MOUSE_SOURCE_SERIAL, &report);
         }
 
         return;
@@ -101,14 +101,14 @@ void serial_mouse_task(void) {
     report.y = MAX(-(int8_t)buffer[2], -127);
 
     print_usb_data(&report);
-    host_mouse_send(&report);
+    host_mouse_send_from(MOUSE_SOURCE_SERIAL, &report);
 
     if (buffer[3] || buffer[4]) {
         report.x = MAX((int8_t)buffer[3], -127);
         report.y = MAX(-(int8_t)buffer[4], -127);
 
         print_usb_data(&report);
-        host_mouse_send(&report);
+        host_mouse_send_from(MOUSE_SOURCE_SERIAL, &report);
     }
 }
 
@@ -40,10 +40,36 @@
 #include "report.h"
 #include "usb_descriptor.h"
 
+#ifdef USB_ENDPOINT_MEMORY
+_Static_assert(FIXED_CONTROL_ENDPOINT_SIZE + sizeof(usb_endpoint_buffers_t) <= USB_ENDPOINT_MEMORY, "The endpoints don't fit in the USB memory of this MCU. Please disable one or more of the following: Mouse Keys, Extra Keys, Console, NKRO, MIDI, Serial, Raw HID");
+#endif
+
+// Every report has to fit in its endpoint
+#ifdef KEYBOARD_SHARED_EP
+_Static_assert(KEYBOARD_REPORT_SIZE <= SHARED_EPSIZE, "The keyboard report doesn't fit in SHARED_EPSIZE");
+#else
+_Static_assert(KEYBOARD_REPORT_SIZE <= KEYBOARD_EPSIZE, "The keyboard report doesn't fit in KEYBOARD_EPSIZE");
+#endif
+#ifdef NKRO_ENABLE
+_Static_assert(sizeof(struct nkro_report) <= SHARED_EPSIZE, "The NKRO report doesn't fit in SHARED_EPSIZE");
+#endif
+#ifdef MOUSE_SHARED_EP
+_Static_assert(sizeof(report_mouse_t) <= SHARED_EPSIZE, "The mouse report doesn't fit in SHARED_EPSIZE");
+#elif defined(MOUSE_ENABLE)
+_Static_assert(sizeof(report_mouse_t) <= MOUSE_EPSIZE, "The mouse report doesn't fit in MOUSE_EPSIZE");
+#endif
+#ifdef EXTRAKEY_ENABLE
+_Static_assert(sizeof(report_extra_t) <= SHARED_EPSIZE, "The extra key report doesn't fit in SHARED_EPSIZE");
+#endif
+
 // clang-format off
 
 /*
  * HID report descriptors
+ *
+ * Global items (usage page, logical range, report size and count) keep their
+ * value for the items after them in the collection, so they are only given
+ * when they change.
  */
 #ifdef KEYBOARD_SHARED_EP
 const USB_Descriptor_HIDReport_Datatype_t PROGMEM SharedReport[] = {
@@ -71,13 +97,10 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM KeyboardReport[] = {
         HID_RI_REPORT_SIZE(8, 0x08),
         HID_RI_INPUT(8, HID_IOF_CONSTANT),
         // Keycodes (6 bytes)
-        HID_RI_USAGE_PAGE(8, 0x07),    // Keyboard/Keypad
         HID_RI_USAGE_MINIMUM(8, 0x00),
         HID_RI_USAGE_MAXIMUM(8, 0xFF),
-        HID_RI_LOGICAL_MINIMUM(8, 0x00),
         HID_RI_LOGICAL_MAXIMUM(16, 0x00FF),
         HID_RI_REPORT_COUNT(8, 0x06),
-        HID_RI_REPORT_SIZE(8, 0x08),
         HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_ARRAY | HID_IOF_ABSOLUTE),
 
         // Status LEDs (5 bits)
@@ -137,18 +160,11 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM SharedReport[] = {
 
             // Vertical wheel (1 byte)
             HID_RI_USAGE(8, 0x38),         // Wheel
-            HID_RI_LOGICAL_MINIMUM(8, -127),
-            HID_RI_LOGICAL_MAXIMUM(8, 127),
             HID_RI_REPORT_COUNT(8, 0x01),
-            HID_RI_REPORT_SIZE(8, 0x08),
             HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_RELATIVE),
             // Horizontal wheel (1 byte)
             HID_RI_USAGE_PAGE(8, 0x0C),    // Consumer
             HID_RI_USAGE(16, 0x0238),      // AC Pan
-            HID_RI_LOGICAL_MINIMUM(8, -127),
-            HID_RI_LOGICAL_MAXIMUM(8, 127),
-            HID_RI_REPORT_COUNT(8, 0x01),
-            HID_RI_REPORT_SIZE(8, 0x08),
             HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_RELATIVE),
         HID_RI_END_COLLECTION(0),
     HID_RI_END_COLLECTION(0),
@@ -204,13 +220,9 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM SharedReport[] = {
         HID_RI_REPORT_SIZE(8, 0x01),
         HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
         // Keycodes
-        HID_RI_USAGE_PAGE(8, 0x07),    // Keyboard/Keypad
         HID_RI_USAGE_MINIMUM(8, 0x00),
         HID_RI_USAGE_MAXIMUM(8, KEYBOARD_REPORT_BITS * 8 - 1),
-        HID_RI_LOGICAL_MINIMUM(8, 0x00),
-        HID_RI_LOGICAL_MAXIMUM(8, 0x01),
         HID_RI_REPORT_COUNT(8, KEYBOARD_REPORT_BITS * 8),
-        HID_RI_REPORT_SIZE(8, 0x01),
         HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
 
         // Status LEDs (5 bits)
@@ -218,7 +230,6 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM SharedReport[] = {
         HID_RI_USAGE_MINIMUM(8, 0x01), // Num Lock
         HID_RI_USAGE_MAXIMUM(8, 0x05), // Kana
         HID_RI_REPORT_COUNT(8, 0x05),
-        HID_RI_REPORT_SIZE(8, 0x01),
         HID_RI_OUTPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
         // LED padding (3 bits)
         HID_RI_REPORT_COUNT(8, 0x01),
@@ -245,10 +256,6 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM RawReport[] = {
 
         // Data from host
         HID_RI_USAGE(8, 0x63),     // Vendor Defined
-        HID_RI_LOGICAL_MINIMUM(8, 0x00),
-        HID_RI_LOGICAL_MAXIMUM(16, 0x00FF),
-        HID_RI_REPORT_COUNT(8, RAW_EPSIZE),
-        HID_RI_REPORT_SIZE(8, 0x08),
         HID_RI_OUTPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
     HID_RI_END_COLLECTION(0),
 };
@@ -269,10 +276,6 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM ConsoleReport[] = {
 
         // Data from host
         HID_RI_USAGE(8, 0x76),     // Vendor Defined
-        HID_RI_LOGICAL_MINIMUM(8, 0x00),
-        HID_RI_LOGICAL_MAXIMUM(16, 0x00FF),
-        HID_RI_REPORT_COUNT(8, CONSOLE_EPSIZE),
-        HID_RI_REPORT_SIZE(8, 0x08),
         HID_RI_OUTPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
     HID_RI_END_COLLECTION(0),
 };
@@ -314,7 +317,11 @@ const USB_Descriptor_Device_t PROGMEM DeviceDescriptor = {
 #endif
 
 #ifndef USB_POLLING_INTERVAL_MS
-#    define USB_POLLING_INTERVAL_MS 10
+#    ifdef USB_SOF_SYNC
+#        define USB_POLLING_INTERVAL_MS 1
+#    else
+#        define USB_POLLING_INTERVAL_MS 10
+#    endif
 #endif
 
 /*
@@ -229,9 +229,20 @@ enum usb_endpoints {
 #ifdef PROTOCOL_LUFA
 // LUFA tells us total endpoints including control
 #    define MAX_ENDPOINTS (ENDPOINT_TOTAL_ENDPOINTS - 1)
+// The endpoint buffers are taken from the USB DPRAM when the host configures
+// the device, which fails if they don't fit
+#    if defined(__AVR_AT90USB82__) || defined(__AVR_AT90USB162__) || defined(__AVR_ATmega8U2__) || defined(__AVR_ATmega16U2__) || defined(__AVR_ATmega32U2__)
+#        define USB_ENDPOINT_MEMORY 176
+#    elif defined(__AVR_ATmega16U4__) || defined(__AVR_ATmega32U4__) || defined(__AVR_AT90USB646__) || defined(__AVR_AT90USB647__) || defined(__AVR_AT90USB1286__) || defined(__AVR_AT90USB1287__)
+#        define USB_ENDPOINT_MEMORY 832
+#    endif
 #elif defined(PROTOCOL_CHIBIOS)
 // ChibiOS gives us number of available user endpoints, not control
 #    define MAX_ENDPOINTS USB_MAX_ENDPOINTS
+#elif defined(PROTOCOL_TEST)
+// as on the ATmega32U4
+#    define MAX_ENDPOINTS 6
+#    define USB_ENDPOINT_MEMORY 832
 #endif
 
 // TODO - ARM_ATSAM
@@ -249,5 +260,39 @@ enum usb_endpoints {
 #define CDC_NOTIFICATION_EPSIZE 8
 #define CDC_EPSIZE 16
 
+/*
+ * Endpoint buffers, to check that they fit in USB_ENDPOINT_MEMORY
+ */
+typedef struct {
+#ifndef KEYBOARD_SHARED_EP
+    uint8_t keyboard_in[KEYBOARD_EPSIZE];
+#endif
+#if defined(MOUSE_ENABLE) && !defined(MOUSE_SHARED_EP)
+    uint8_t mouse_in[MOUSE_EPSIZE];
+#endif
+#ifdef RAW_ENABLE
+    uint8_t raw_in[RAW_EPSIZE];
+    uint8_t raw_out[RAW_EPSIZE];
+#endif
+#ifdef SHARED_EP_ENABLE
+    uint8_t shared_in[SHARED_EPSIZE];
+#endif
+#ifdef CONSOLE_ENABLE
+    uint8_t console_in[CONSOLE_EPSIZE];
+#    ifdef PROTOCOL_CHIBIOS
+    uint8_t console_out[CONSOLE_EPSIZE];
+#    endif
+#endif
+#ifdef MIDI_ENABLE
+    uint8_t midi_stream_in[MIDI_STREAM_EPSIZE];
+    uint8_t midi_stream_out[MIDI_STREAM_EPSIZE];
+#endif
+#ifdef VIRTSER_ENABLE
+    uint8_t cdc_notification[CDC_NOTIFICATION_EPSIZE];
+    uint8_t cdc_in[CDC_EPSIZE];
+    uint8_t cdc_out[CDC_EPSIZE];
+#endif
+} usb_endpoint_buffers_t;
+
 uint16_t get_usb_descriptor(const uint16_t wValue, const uint16_t wIndex, const void** const DescriptorAddress);
 #endif
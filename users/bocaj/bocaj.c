@@ -105,7 +105,7 @@ void eeconfig_init_user(void) {
     set_unicode_input_mode(BOCAJ_UNICODE_MODE);
     get_unicode_input_mode();
   #else
-    eeprom_update_byte(EECONFIG_UNICODEMODE, BOCAJ_UNICODE_MODE);
+    eeconfig_update_byte(EECONFIG_UNICODEMODE, BOCAJ_UNICODE_MODE);
   #endif
 }
 